@@ -0,0 +1,147 @@
+#pragma once
+
+#include <ATen/core/boxing/KernelFunction.h>
+#include <c10/core/DispatchKeySet.h>
+#include <c10/core/impl/LocalDispatchKeySet.h>
+
+#include <atomic>
+
+namespace c10 {
+namespace impl {
+
+CAFFE2_API extern std::atomic<bool> dispatch_cache_enabled;
+
+// Whether TypedOperatorHandle::call goes through the dispatch cache of the
+// handle. On by default; turning it off is meant for benchmarking.
+inline bool dispatchCacheEnabled() {
+  return dispatch_cache_enabled.load(std::memory_order_relaxed);
+}
+CAFFE2_API void setDispatchCacheEnabled(bool enabled);
+
+/**
+ * A two entry inline cache of the kernels an operator handle dispatched to,
+ * keyed on the DispatchKeySet of the arguments, the thread local included and
+ * excluded key sets, and the registration epoch of the dispatcher. On a hit
+ * Dispatcher::call skips computing the dispatch key and looking up the
+ * dispatch table. Any registration bumps the epoch, which invalidates every
+ * cache.
+ *
+ * There are two entries because a handle is commonly called with two TLS
+ * states in turn: the autograd kernel calls the same handle again under
+ * AutoNonVariableTypeMode to reach the backend kernel. A miss replaces the
+ * entry that was filled least recently.
+ *
+ * Handles are usually function statics shared by all threads, so each entry
+ * is guarded by a sequence lock: readers never block and count a torn read as
+ * a miss, and a writer only fills an entry if no other writer holds it.
+ */
+class DispatchCache final {
+public:
+  DispatchCache() = default;
+  // Copies of a handle start out with an empty cache.
+  DispatchCache(const DispatchCache&) noexcept {}
+  DispatchCache& operator=(const DispatchCache&) noexcept {
+    return *this;
+  }
+
+  // Returns the cached kernel and sets *dispatch_key, or returns nullptr.
+  const KernelFunction* lookup(
+      DispatchKeySet ks,
+      LocalDispatchKeySet local,
+      uint64_t epoch,
+      DispatchKey* dispatch_key) const {
+    const KernelFunction* kernel =
+        entries_[0].lookup(ks, local, epoch, dispatch_key);
+    if (kernel == nullptr) {
+      kernel = entries_[1].lookup(ks, local, epoch, dispatch_key);
+    }
+    return kernel;
+  }
+
+  void update(
+      DispatchKeySet ks,
+      LocalDispatchKeySet local,
+      uint64_t epoch,
+      DispatchKey dispatch_key,
+      const KernelFunction* kernel) const {
+    uint8_t victim = victim_.load(std::memory_order_relaxed);
+    if (entries_[victim].update(ks, local, epoch, dispatch_key, kernel)) {
+      victim_.store(victim ^ 1, std::memory_order_relaxed);
+    }
+  }
+
+private:
+  class Entry final {
+  public:
+    const KernelFunction* lookup(
+        DispatchKeySet ks,
+        LocalDispatchKeySet local,
+        uint64_t epoch,
+        DispatchKey* dispatch_key) const {
+      uint64_t seq = seq_.load(std::memory_order_acquire);
+      if (seq & 1) {
+        return nullptr;
+      }
+      bool hit = key_set_.load(std::memory_order_relaxed) == ks.raw_repr() &&
+          included_.load(std::memory_order_relaxed) == local.included_.raw_repr() &&
+          excluded_.load(std::memory_order_relaxed) == local.excluded_.raw_repr() &&
+          epoch_.load(std::memory_order_relaxed) == epoch;
+      if (!hit) {
+        return nullptr;
+      }
+      const KernelFunction* kernel = kernel_.load(std::memory_order_relaxed);
+      DispatchKey key = static_cast<DispatchKey>(
+          dispatch_key_.load(std::memory_order_relaxed));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (seq_.load(std::memory_order_relaxed) != seq) {
+        return nullptr;
+      }
+      *dispatch_key = key;
+      return kernel;
+    }
+
+    // Returns false if another writer holds the entry.
+    bool update(
+        DispatchKeySet ks,
+        LocalDispatchKeySet local,
+        uint64_t epoch,
+        DispatchKey dispatch_key,
+        const KernelFunction* kernel) const {
+      uint64_t seq = seq_.load(std::memory_order_relaxed);
+      if ((seq & 1) ||
+          !seq_.compare_exchange_strong(
+              seq, seq + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+        return false;
+      }
+      // Orders the odd seq before the data stores below, so a reader that
+      // sees any of the new data also sees seq change.
+      std::atomic_thread_fence(std::memory_order_release);
+      key_set_.store(ks.raw_repr(), std::memory_order_relaxed);
+      included_.store(local.included_.raw_repr(), std::memory_order_relaxed);
+      excluded_.store(local.excluded_.raw_repr(), std::memory_order_relaxed);
+      epoch_.store(epoch, std::memory_order_relaxed);
+      dispatch_key_.store(
+          static_cast<uint8_t>(dispatch_key), std::memory_order_relaxed);
+      kernel_.store(kernel, std::memory_order_relaxed);
+      seq_.store(seq + 2, std::memory_order_release);
+      return true;
+    }
+
+  private:
+    mutable std::atomic<uint64_t> seq_{0};
+    mutable std::atomic<uint64_t> key_set_{0};
+    mutable std::atomic<uint64_t> included_{0};
+    mutable std::atomic<uint64_t> excluded_{0};
+    // Epochs start at 1, so an empty entry never hits.
+    mutable std::atomic<uint64_t> epoch_{0};
+    mutable std::atomic<uint8_t> dispatch_key_{0};
+    mutable std::atomic<const KernelFunction*> kernel_{nullptr};
+  };
+
+  Entry entries_[2];
+  // The entry the next miss fills.
+  mutable std::atomic<uint8_t> victim_{0};
+};
+
+} // namespace impl
+} // namespace c10
@@ -5,6 +5,7 @@
 #include <ATen/core/jit_type.h>
 #include <c10/util/Bitset.h>
 #include <c10/core/DispatchKeySet.h>
+#include <c10/core/impl/LocalDispatchKeySet.h>
 #include <ATen/core/Variadic.h>
 #include <ATen/core/stack.h>
 
@@ -17,6 +18,21 @@ namespace impl {
 // always_included to get inlined, constexpr not necessary)
 const DispatchKeySet always_included{DispatchKey::Autograd, DispatchKey::BackendSelect};
 
+// Same as the dispatchTypeId below, with the thread local key sets already
+// read.
+static inline DispatchKey dispatchTypeId(
+    DispatchKeySet ks,
+    DispatchKeySet key_mask,
+    LocalDispatchKeySet local
+) {
+  // TODO: It's a bit irritating that we have to do logical ORs here, it would
+  // be nice to only do one.  Can always_included be folded into the TLS?  Well,
+  // it's a bit troublesome, because fastpath TLS access requires the type of
+  // the TLS in question to be zero-initialized, so you don't actually win
+  // anyting in that case.
+  return (((ks | local.included_ | always_included) - local.excluded_) & key_mask).highestPriorityTypeId();
+}
+
 // Take a DispatchKeySet for a Tensor and determine what the actual dispatch
 // DispatchKey should be, taking into account TLS, and skipping backends which
 // fall through.
@@ -39,13 +55,7 @@ static inline DispatchKey dispatchTypeId(
     // function (as opposed to just applying it to the input 'ks').
     DispatchKeySet key_mask
 ) {
-  c10::impl::LocalDispatchKeySet local = c10::impl::tls_local_dispatch_key_set();
-  // TODO: It's a bit irritating that we have to do logical ORs here, it would
-  // be nice to only do one.  Can always_included be folded into the TLS?  Well,
-  // it's a bit troublesome, because fastpath TLS access requires the type of
-  // the TLS in question to be zero-initialized, so you don't actually win
-  // anyting in that case.
-  return (((ks | local.included_ | always_included) - local.excluded_) & key_mask).highestPriorityTypeId();
+  return dispatchTypeId(ks, key_mask, c10::impl::tls_local_dispatch_key_set());
 }
 
 }
@@ -118,7 +128,9 @@ public:
     dispatch_arg_indices_reverse_ = c10::utils::bitset();
   }
 
-  DispatchKey getDispatchKeyBoxed(const torch::jit::Stack* stack) const {
+  DispatchKey getDispatchKeyBoxed(
+      const torch::jit::Stack* stack,
+      DispatchKeySet eligibleKeys = DispatchKeySet(DispatchKeySet::FULL)) const {
     DispatchKeySet ks;
     dispatch_arg_indices_reverse_.for_each_set_bit([&] (size_t reverse_arg_index) {
       const auto& ivalue = torch::jit::peek(*stack, 0, reverse_arg_index + 1);
@@ -132,7 +144,7 @@ public:
         }
       }
     });
-    return dispatchKeySetToDispatchKey_(DispatchKeySet::FULL, ks);
+    return dispatchKeySetToDispatchKey_(eligibleKeys, ks);
   }
 
   template<class... Args>
@@ -141,6 +153,21 @@ public:
     return dispatchKeySetToDispatchKey_(eligibleKeys, ks);
   }
 
+  // The two halves of getDispatchKeyUnboxed, for callers that cache the
+  // dispatch key per DispatchKeySet of the arguments and TLS state
+  template<class... Args>
+  DispatchKeySet getDispatchKeySetUnboxed(const Args&... args) const {
+    return detail::multi_dispatch_key_set(args...);
+  }
+
+  DispatchKey getDispatchKeyForKeySet(
+      DispatchKeySet eligibleKeys,
+      DispatchKeySet ks,
+      impl::LocalDispatchKeySet local
+  ) const {
+    return impl::dispatchTypeId(ks, nonFallthroughKeys_ & eligibleKeys, local);
+  }
+
   void setOperatorHasFallthroughForKey(DispatchKey k, bool has_fallthrough);
 
   std::string dumpState() const;
@@ -43,6 +43,16 @@ Dispatcher::Dispatcher()
 
 Dispatcher::~Dispatcher() {}
 
+namespace impl {
+
+std::atomic<bool> dispatch_cache_enabled{true};
+
+void setDispatchCacheEnabled(bool enabled) {
+  dispatch_cache_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+} // namespace impl
+
 C10_EXPORT Dispatcher& Dispatcher::singleton() {
   static Dispatcher _singleton;
   return _singleton;
@@ -145,6 +155,7 @@ RegistrationHandleRAII Dispatcher::registerDef(FunctionSchema schema, std::strin
   // NB: do not increment the counts until AFTER error checking
   ++op.operatorIterator_->def_count;
   ++op.operatorIterator_->def_and_impl_count;
+  bumpRegistrationEpoch_();
 
   return RegistrationHandleRAII([this, op, op_name] {
     deregisterDef_(op, op_name);
@@ -189,6 +200,7 @@ void Dispatcher::deregisterDef_(const OperatorHandle& op, const OperatorName& op
     listeners_->callOnOperatorDeregistered(op);
     op.operatorIterator_->op.deregisterSchema();
   }
+  bumpRegistrationEpoch_();
 
   cleanup(op, op_name);
 }
@@ -215,6 +227,7 @@ RegistrationHandleRAII Dispatcher::registerImpl(
   );
 
   ++op.operatorIterator_->def_and_impl_count;
+  bumpRegistrationEpoch_();
 
   return RegistrationHandleRAII([this, op, op_name, dispatch_key, handle] {
     deregisterImpl_(op, op_name, dispatch_key, handle);
@@ -225,6 +238,7 @@ void Dispatcher::deregisterImpl_(const OperatorHandle& op, const OperatorName& o
   std::lock_guard<std::mutex> lock(mutex_);
 
   op.operatorIterator_->op.deregisterKernel_(*this, dispatch_key, handle);
+  bumpRegistrationEpoch_();
 
   TORCH_INTERNAL_ASSERT(op.operator_name() == op_name);
 
@@ -277,6 +291,7 @@ RegistrationHandleRAII Dispatcher::registerFallback(DispatchKey dispatchKey, Ker
   for (auto& op : operators_) {
     op.op.updateFallback(*this, dispatchKey);
   }
+  bumpRegistrationEpoch_();
 
   return RegistrationHandleRAII([this, dispatchKey] {
     deregisterFallback_(dispatchKey);
@@ -291,6 +306,7 @@ void Dispatcher::deregisterFallback_(DispatchKey dispatchKey) {
   for (auto& op : operators_) {
     op.op.updateFallback(*this, dispatchKey);
   }
+  bumpRegistrationEpoch_();
 }
 
 
@@ -319,6 +335,7 @@ void Dispatcher::checkInvariants() const {
 void Dispatcher::setManuallyBoxedKernelFor_(const OperatorHandle& op, KernelFunction::InternalBoxedKernelFunction* func) {
   std::lock_guard<std::mutex> lock(mutex_);
   op.operatorIterator_->op.setManuallyBoxedKernel_(*this, func);
+  bumpRegistrationEpoch_();
   // NB: Do not need to set manually boxed kernel for backend fallbacks
 }
 
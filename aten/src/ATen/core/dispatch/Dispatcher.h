@@ -1,8 +1,10 @@
 #pragma once
 
 #include <ATen/SequenceNumber.h>
+#include <ATen/core/LegacyTypeDispatch.h>
 #include <ATen/core/boxing/KernelFunction.h>
 #include <ATen/core/boxing/impl/boxing.h>
+#include <ATen/core/dispatch/DispatchCache.h>
 #include <ATen/core/dispatch/OperatorEntry.h>
 #include <ATen/core/dispatch/CppSignature.h>
 #include <ATen/core/dispatch/RegistrationHandleRAII.h>
@@ -126,6 +128,10 @@ public:
   template<class Return, class... Args>
   Return callWithDispatchKey(const TypedOperatorHandle<Return (Args...)>& op, DispatchKey dispatchKey, Args... args) const;
 
+  // Like callWithDispatchKey, with the kernel for dispatchKey already looked up
+  template<class Return, class... Args>
+  Return callKernel_(const TypedOperatorHandle<Return (Args...)>& op, DispatchKey dispatchKey, const KernelFunction& kernel, Args... args) const;
+
   // Like call, but intended for use in a redispatch: you are currently
   // in some currentDispatchKey, you have finished processing the key and
   // you now want to redispatch to the next dispatch key in the chain.
@@ -229,6 +235,12 @@ private:
   void cleanup(const OperatorHandle& op, const OperatorName& op_name);
   void checkSchemaCompatibility(const OperatorHandle& op, const FunctionSchema& schema, const std::string& debug);
 
+  // Precondition: mutex_ is held. Invalidates the dispatch caches of all
+  // operator handles.
+  void bumpRegistrationEpoch_() {
+    registrationEpoch_.fetch_add(1, std::memory_order_release);
+  }
+
   std::list<OperatorDef> operators_;
   LeftRight<ska::flat_hash_map<OperatorName, OperatorHandle>> operatorLookupTable_;
   // Map from namespace to debug string (saying, e.g., where the library was defined)
@@ -238,6 +250,9 @@ private:
 
   std::unique_ptr<detail::RegistrationListenerList> listeners_;
   std::mutex mutex_;
+
+  // Bumped on every registration change, see impl::DispatchCache
+  std::atomic<uint64_t> registrationEpoch_{1};
 };
 
 /**
@@ -331,6 +346,9 @@ private:
   explicit TypedOperatorHandle(std::list<Dispatcher::OperatorDef>::iterator operatorIterator)
   : OperatorHandle(std::move(operatorIterator)) {}
   friend class OperatorHandle;
+  friend class Dispatcher;
+
+  impl::DispatchCache dispatchCache_;
 };
 
 namespace detail {
@@ -341,7 +359,12 @@ template<class Return, class... Args>
 inline Return Dispatcher::callWithDispatchKey(const TypedOperatorHandle<Return(Args...)>& op, DispatchKey dispatchKey, Args... args) const {
   detail::unused_arg_(args...);  // workaround for a false-positive warning about unused parameters in gcc 5
   const KernelFunction& kernel = op.operatorIterator_->op.lookup(dispatchKey);
+  return callKernel_<Return, Args...>(op, dispatchKey, kernel, args...);
+}
 
+template<class Return, class... Args>
+inline Return Dispatcher::callKernel_(const TypedOperatorHandle<Return(Args...)>& op, DispatchKey dispatchKey, const KernelFunction& kernel, Args... args) const {
+  detail::unused_arg_(args...);  // workaround for a false-positive warning about unused parameters in gcc 5
 #ifndef PYTORCH_DISABLE_PER_OP_PROFILING
   // Check if we need to run callbacks registered with RecordFunction
   // If true and callbacks need inputs, we box the arguments and pass
@@ -358,6 +381,16 @@ inline Return Dispatcher::callWithDispatchKey(const TypedOperatorHandle<Return(A
       if (dispatchKey == DispatchKey::Autograd && at::GradMode::is_enabled()) {
         seq_num = at::sequence_number::peek();
       }
+      // Most calls enter through an autograd kernel. Observers want to know
+      // the backend the call continues to.
+      guard.setDispatchKey(
+          at::autograd_dispatch_keys.has(dispatchKey)
+              ? op.operatorIterator_->op.dispatchKeyExtractor()
+                    .template getDispatchKeyUnboxed<Args...>(
+                        DispatchKeySet(DispatchKeySet::FULL) - at::autograd_dispatch_keys,
+                        args...)
+              : dispatchKey);
+      guard.setOperatorName(&op.operator_name());
       if (guard.needs_inputs) {
         torch::jit::Stack stack = impl::BoxedKernelWrapper<Return(Args...)>::boxArgs(args...);
         guard.before(op.schema().name(), stack, seq_num);
@@ -373,7 +406,23 @@ inline Return Dispatcher::callWithDispatchKey(const TypedOperatorHandle<Return(A
 template<class Return, class... Args>
 inline Return Dispatcher::call(const TypedOperatorHandle<Return(Args...)>& op, Args... args) const {
   detail::unused_arg_(args...);  // workaround for a false-positive warning about unused parameters in gcc 5
-  auto dispatchKey = op.operatorIterator_->op.dispatchKeyExtractor()
+  const auto& entry = op.operatorIterator_->op;
+  if (C10_LIKELY(impl::dispatchCacheEnabled())) {
+    // The arguments and the TLS are the key of the cache, a hit saves
+    // computing the dispatch key and looking up the dispatch table.
+    DispatchKeySet ks = entry.dispatchKeyExtractor().template getDispatchKeySetUnboxed<Args...>(args...);
+    impl::LocalDispatchKeySet local = impl::tls_local_dispatch_key_set();
+    uint64_t epoch = registrationEpoch_.load(std::memory_order_acquire);
+    DispatchKey dispatchKey;
+    const KernelFunction* kernel = op.dispatchCache_.lookup(ks, local, epoch, &dispatchKey);
+    if (C10_UNLIKELY(kernel == nullptr)) {
+      dispatchKey = entry.dispatchKeyExtractor().getDispatchKeyForKeySet(DispatchKeySet::FULL, ks, local);
+      kernel = &entry.lookup(dispatchKey);
+      op.dispatchCache_.update(ks, local, epoch, dispatchKey, kernel);
+    }
+    return callKernel_<Return, Args...>(op, dispatchKey, *kernel, args...);
+  }
+  auto dispatchKey = entry.dispatchKeyExtractor()
     .template getDispatchKeyUnboxed<Args...>(
       DispatchKeySet::FULL,
       args...
@@ -409,6 +458,14 @@ inline void Dispatcher::callBoxed(const OperatorHandle& op, Stack* stack) const
       if (dispatchKey == DispatchKey::Autograd && at::GradMode::is_enabled()) {
         seq_num = at::sequence_number::peek();
       }
+      // See callKernel_
+      guard.setDispatchKey(
+          at::autograd_dispatch_keys.has(dispatchKey)
+              ? entry.dispatchKeyExtractor().getDispatchKeyBoxed(
+                    stack,
+                    DispatchKeySet(DispatchKeySet::FULL) - at::autograd_dispatch_keys)
+              : dispatchKey);
+      guard.setOperatorName(&op.operator_name());
       if (guard.needs_inputs) {
         guard.before(op.schema().name(), *stack, seq_num);
       } else {
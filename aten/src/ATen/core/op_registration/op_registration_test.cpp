@@ -195,6 +195,56 @@ TEST(OperatorRegistrationTest, givenOpWithDispatchedKernelOutOfScope_whenRegiste
   EXPECT_TRUE(called);
 }
 
+TEST(OperatorRegistrationTest, givenCachedTypedHandle_whenRegisteringAndDeregisteringKernel_thenCallsCurrentKernel) {
+  bool catchall_called = false;
+  bool cpu_called = false;
+  auto registrar = c10::RegisterOperators().op("_test::dummy(Tensor dummy) -> ()", c10::RegisterOperators::options().catchAllKernel<MockKernel>(&catchall_called));
+
+  auto op = Dispatcher::singleton().findSchema({"_test::dummy", ""});
+  ASSERT_TRUE(op.has_value());
+  auto typed = op->typed<void (Tensor)>();
+  typed.call(dummyTensor(c10::DispatchKey::CPU));
+  EXPECT_TRUE(catchall_called);
+
+  {
+    auto registrar2 = c10::RegisterOperators().op("_test::dummy(Tensor dummy) -> ()", c10::RegisterOperators::options().kernel<MockKernel>(c10::DispatchKey::CPU, &cpu_called));
+    catchall_called = false;
+    typed.call(dummyTensor(c10::DispatchKey::CPU));
+    EXPECT_TRUE(cpu_called);
+    EXPECT_FALSE(catchall_called);
+  }
+
+  cpu_called = false;
+  typed.call(dummyTensor(c10::DispatchKey::CPU));
+  EXPECT_TRUE(catchall_called);
+  EXPECT_FALSE(cpu_called);
+}
+
+TEST(OperatorRegistrationTest, givenCachedTypedHandle_whenExcludingDispatchKey_thenCallsNextKernel) {
+  bool catchall_called = false;
+  bool cpu_called = false;
+  auto registrar = c10::RegisterOperators()
+    .op("_test::dummy(Tensor dummy) -> ()", c10::RegisterOperators::options().catchAllKernel<MockKernel>(&catchall_called))
+    .op("_test::dummy(Tensor dummy) -> ()", c10::RegisterOperators::options().kernel<MockKernel>(c10::DispatchKey::CPU, &cpu_called));
+
+  auto op = Dispatcher::singleton().findSchema({"_test::dummy", ""});
+  ASSERT_TRUE(op.has_value());
+  auto typed = op->typed<void (Tensor)>();
+  typed.call(dummyTensor(c10::DispatchKey::CPU));
+  EXPECT_TRUE(cpu_called);
+
+  cpu_called = false;
+  {
+    c10::impl::ExcludeDispatchKeyGuard guard(c10::DispatchKey::CPU);
+    typed.call(dummyTensor(c10::DispatchKey::CPU));
+  }
+  EXPECT_TRUE(catchall_called);
+  EXPECT_FALSE(cpu_called);
+
+  typed.call(dummyTensor(c10::DispatchKey::CPU));
+  EXPECT_TRUE(cpu_called);
+}
+
 // TODO Rewrite (since this is now allowed) and reenable
 // TEST(OperatorRegistrationTest, givenOpWithDispatchedKernel_whenRegisteringCatchallKernel_thenFails) {
 //   bool called = false;
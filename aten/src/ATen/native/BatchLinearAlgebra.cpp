@@ -10,6 +10,7 @@
 
 #include <TH/TH.h>  // for USE_LAPACK
 
+#include <algorithm>
 #include <vector>
 
 // First the required LAPACK implementations are registered here.
@@ -302,6 +303,110 @@ template<> void lapackLuSolve<float>(char trans, int n, int nrhs, float *a, int
 }
 #endif
 
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ batching ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// The functions below run the per-matrix LAPACK routines over the batch with
+// at::parallel_for, every task using its own workspace. Matrices whose
+// factorization costs about `cost` flops are grouped so that each task does at
+// least GRAIN_SIZE worth of work. Batches of large matrices are not split
+// across threads, as LAPACK is usually multithreaded for those already.
+constexpr int64_t lapack_batch_parallel_max_cost = 128 * 128 * 128;
+
+static inline int64_t lapackBatchGrainSize(int64_t batch_size, int64_t cost) {
+  if (cost > lapack_batch_parallel_max_cost) {
+    return batch_size;
+  }
+  return std::max<int64_t>(1, internal::GRAIN_SIZE / std::max<int64_t>(1, cost));
+}
+
+// For tiny systems, the overhead of a LAPACK call (argument checking, blocking
+// logic, BLAS calls for single rows) is comparable to the factorization itself.
+// Real square matrices up to this size are instead factorized by smallLu below,
+// the unblocked LU with partial pivoting that LAPACK's getf2 implements, which
+// yields the same pivots and infos. Complex matrices always go through LAPACK,
+// which picks pivots by |re| + |im|.
+constexpr int64_t small_lu_max_size = 16;
+
+template<typename scalar_t>
+static inline bool useSmallLu(int64_t n) {
+  return !c10::is_complex_t<scalar_t>::value && n <= small_lu_max_size;
+}
+
+// In-place LU factorization with partial pivoting of the column-major n x n
+// matrix a. The (0-based) pivots are stored in ipiv. Returns 0 on success, or
+// the 1-based index of the first exactly zero pivot, in which case the
+// factorization is still completed, like getrf.
+template<typename scalar_t>
+static int smallLu(int64_t n, scalar_t* a, int* ipiv) {
+  using value_t = typename c10::scalar_value_type<scalar_t>::type;
+  int info = 0;
+  for (int64_t j = 0; j < n; j++) {
+    scalar_t* a_j = a + j * n;
+    int64_t p = j;
+    value_t max_abs = zabs<scalar_t, value_t>(a_j[j]);
+    for (int64_t i = j + 1; i < n; i++) {
+      value_t abs_i = zabs<scalar_t, value_t>(a_j[i]);
+      if (abs_i > max_abs) {
+        p = i;
+        max_abs = abs_i;
+      }
+    }
+    ipiv[j] = static_cast<int>(p);
+    if (a_j[p] != scalar_t(0)) {
+      if (p != j) {
+        for (int64_t k = 0; k < n; k++) {
+          std::swap(a[j + k * n], a[p + k * n]);
+        }
+      }
+      const scalar_t pivot_inv = scalar_t(1) / a_j[j];
+      for (int64_t i = j + 1; i < n; i++) {
+        a_j[i] *= pivot_inv;
+      }
+    } else if (info == 0) {
+      info = static_cast<int>(j + 1);
+    }
+    // rank-1 update of the trailing submatrix, column by column
+    for (int64_t k = j + 1; k < n; k++) {
+      scalar_t* a_k = a + k * n;
+      const scalar_t a_jk = a_k[j];
+      for (int64_t i = j + 1; i < n; i++) {
+        a_k[i] -= a_j[i] * a_jk;
+      }
+    }
+  }
+  return info;
+}
+
+// Solves A X = B in place of the column-major n x nrhs matrix b, given the
+// factorization computed by smallLu.
+template<typename scalar_t>
+static void smallLuSolve(int64_t n, int64_t nrhs, const scalar_t* lu, const int* ipiv, scalar_t* b, int64_t ldb) {
+  for (int64_t c = 0; c < nrhs; c++) {
+    scalar_t* b_c = b + c * ldb;
+    for (int64_t j = 0; j < n; j++) {
+      if (ipiv[j] != j) {
+        std::swap(b_c[j], b_c[ipiv[j]]);
+      }
+    }
+    // L has a unit diagonal
+    for (int64_t j = 0; j < n; j++) {
+      const scalar_t* lu_j = lu + j * n;
+      const scalar_t b_j = b_c[j];
+      for (int64_t i = j + 1; i < n; i++) {
+        b_c[i] -= lu_j[i] * b_j;
+      }
+    }
+    for (int64_t j = n - 1; j >= 0; j--) {
+      const scalar_t* lu_j = lu + j * n;
+      b_c[j] /= lu_j[j];
+      const scalar_t b_j = b_c[j];
+      for (int64_t i = 0; i < j; i++) {
+        b_c[i] -= lu_j[i] * b_j;
+      }
+    }
+  }
+}
+
 // Below of the definitions of the functions operating on a batch that are going to be dispatched
 // in the main helper functions for the linear algebra operations
 
@@ -320,19 +425,29 @@ static void apply_solve(Tensor& b, Tensor& A, std::vector<int64_t>& infos) {
   auto n = A.size(-2);
   auto nrhs = b.size(-1);
 
-  auto ipiv = at::empty({n}, b.options().dtype(kInt));
-  auto ipiv_data = ipiv.data_ptr<int>();
-
-  int info;
-  for (int64_t i = 0; i < batch_size; i++) {
-    scalar_t* A_working_ptr = &A_data[i * A_mat_stride];
-    scalar_t* b_working_ptr = &b_data[i * b_mat_stride];
-    lapackSolve<scalar_t>(n, nrhs, A_working_ptr, n, ipiv_data, b_working_ptr, n, &info);
-    infos[i] = info;
-    if (info != 0) {
-      return;
+  const bool small = useSmallLu<scalar_t>(n);
+
+  at::parallel_for(0, batch_size, lapackBatchGrainSize(batch_size, n * n * (n + nrhs)), [&](int64_t start, int64_t end) {
+    std::vector<int> ipiv(n);
+    int info;
+    for (int64_t i = start; i < end; i++) {
+      scalar_t* A_working_ptr = &A_data[i * A_mat_stride];
+      scalar_t* b_working_ptr = &b_data[i * b_mat_stride];
+      if (small) {
+        // like gesv, the solution is not computed for singular matrices
+        info = smallLu<scalar_t>(n, A_working_ptr, ipiv.data());
+        if (info == 0) {
+          smallLuSolve<scalar_t>(n, nrhs, A_working_ptr, ipiv.data(), b_working_ptr, n);
+        }
+      } else {
+        lapackSolve<scalar_t>(n, nrhs, A_working_ptr, n, ipiv.data(), b_working_ptr, n, &info);
+      }
+      infos[i] = info;
+      if (info != 0) {
+        return;
+      }
     }
-  }
+  });
 #endif
 }
 
@@ -383,8 +498,29 @@ static void apply_inverse(Tensor& self, std::vector<int64_t>& infos) {
   auto batch_size = batchCount(self);
   auto n = self.size(-2);
 
-  auto ipiv = at::empty({n}, self.options().dtype(kInt));
-  auto ipiv_data = ipiv.data_ptr<int>();
+  if (useSmallLu<scalar_t>(n)) {
+    at::parallel_for(0, batch_size, lapackBatchGrainSize(batch_size, 2 * n * n * n), [&](int64_t start, int64_t end) {
+      int ipiv[small_lu_max_size];
+      scalar_t inverse[small_lu_max_size * small_lu_max_size];
+      for (int64_t i = start; i < end; i++) {
+        scalar_t* self_working_ptr = &self_data[i * self_matrix_stride];
+        int info = smallLu<scalar_t>(n, self_working_ptr, ipiv);
+        infos[i] = info;
+        if (info != 0) {
+          return;
+        }
+        std::fill(inverse, inverse + n * n, scalar_t(0));
+        for (int64_t j = 0; j < n; j++) {
+          inverse[j + j * n] = scalar_t(1);
+        }
+        smallLuSolve<scalar_t>(n, n, self_working_ptr, ipiv, inverse, n);
+        std::copy(inverse, inverse + n * n, self_working_ptr);
+      }
+    });
+    return;
+  }
+
+  std::vector<int> ipiv(n);
 
   int info;
   // Run once, first to get the optimum work size
@@ -393,26 +529,31 @@ static void apply_inverse(Tensor& self, std::vector<int64_t>& infos) {
   // and (batch_size - 1) calls to allocate and deallocate workspace using at::empty()
   int lwork = -1;
   scalar_t wkopt;
-  lapackGetri<scalar_t>(n, self_data, n, ipiv_data, &wkopt, lwork, &info);
+  lapackGetri<scalar_t>(n, self_data, n, ipiv.data(), &wkopt, lwork, &info);
   lwork = static_cast<int>(real_impl<scalar_t, value_t>(wkopt));
-  Tensor work = at::empty({lwork}, self.options());
-  auto work_data = work.data_ptr<scalar_t>();
-
-  for (int64_t i = 0; i < batch_size; i++) {
-    scalar_t* self_working_ptr = &self_data[i * self_matrix_stride];
-    lapackLu<scalar_t>(n, n, self_working_ptr, n, ipiv_data, &info);
-    infos[i] = info;
-    if (info != 0) {
-      return;
-    }
 
-    // now compute the actual inverse
-    lapackGetri<scalar_t>(n, self_working_ptr, n, ipiv_data, work_data, lwork, &info);
-    infos[i] = info;
-    if (info != 0) {
-      return;
+  at::parallel_for(0, batch_size, lapackBatchGrainSize(batch_size, 2 * n * n * n), [&](int64_t start, int64_t end) {
+    // per-task pivots and workspace
+    std::vector<int> task_ipiv(n);
+    Tensor work = at::empty({lwork}, self.options());
+    auto work_data = work.data_ptr<scalar_t>();
+    int info;
+    for (int64_t i = start; i < end; i++) {
+      scalar_t* self_working_ptr = &self_data[i * self_matrix_stride];
+      lapackLu<scalar_t>(n, n, self_working_ptr, n, task_ipiv.data(), &info);
+      infos[i] = info;
+      if (info != 0) {
+        return;
+      }
+
+      // now compute the actual inverse
+      lapackGetri<scalar_t>(n, self_working_ptr, n, task_ipiv.data(), work_data, lwork, &info);
+      infos[i] = info;
+      if (info != 0) {
+        return;
+      }
     }
-  }
+  });
 #endif
 }
 
@@ -463,16 +604,18 @@ static void apply_cholesky_solve(Tensor& b, Tensor& A, bool upper, std::vector<i
   auto n = A.size(-2);
   auto nrhs = b.size(-1);
 
-  int info;
-  for (int64_t i = 0; i < batch_size; i++) {
-    scalar_t* A_working_ptr = &A_data[i * A_mat_stride];
-    scalar_t* b_working_ptr = &b_data[i * b_mat_stride];
-    lapackCholeskySolve<scalar_t>(uplo, n, nrhs, A_working_ptr, n, b_working_ptr, n, &info);
-    infos[i] = info;
-    if (info != 0) {
-      return;
+  at::parallel_for(0, batch_size, lapackBatchGrainSize(batch_size, 2 * n * n * nrhs), [&](int64_t start, int64_t end) {
+    int info;
+    for (int64_t i = start; i < end; i++) {
+      scalar_t* A_working_ptr = &A_data[i * A_mat_stride];
+      scalar_t* b_working_ptr = &b_data[i * b_mat_stride];
+      lapackCholeskySolve<scalar_t>(uplo, n, nrhs, A_working_ptr, n, b_working_ptr, n, &info);
+      infos[i] = info;
+      if (info != 0) {
+        return;
+      }
     }
-  }
+  });
 #endif
 }
 
@@ -523,15 +666,17 @@ static void apply_cholesky(Tensor& self, bool upper, std::vector<int64_t>& infos
   auto batch_size = batchCount(self);
   auto n = self.size(-2);
 
-  int info;
-  for (int64_t i = 0; i < batch_size; i++) {
-    scalar_t* self_working_ptr = &self_data[i * self_matrix_stride];
-    lapackCholesky<scalar_t>(uplo, n, self_working_ptr, n, &info);
-    infos[i] = info;
-    if (info != 0) {
-      return;
+  at::parallel_for(0, batch_size, lapackBatchGrainSize(batch_size, n * n * n / 3), [&](int64_t start, int64_t end) {
+    int info;
+    for (int64_t i = start; i < end; i++) {
+      scalar_t* self_working_ptr = &self_data[i * self_matrix_stride];
+      lapackCholesky<scalar_t>(uplo, n, self_working_ptr, n, &info);
+      infos[i] = info;
+      if (info != 0) {
+        return;
+      }
     }
-  }
+  });
 #endif
 }
 
@@ -587,12 +732,15 @@ static void apply_lu(Tensor& self, Tensor& pivots, Tensor& infos) {
   auto m = self.size(-2);
   auto n = self.size(-1);
 
-  for (int64_t i = 0; i < batch_size; i++) {
-    scalar_t* self_working_ptr = &self_data[i * self_matrix_stride];
-    int* pivots_working_ptr = &pivots_data[i * pivots_matrix_stride];
-    int* infos_working_ptr = &infos_data[i];
-    lapackLu<scalar_t>(m, n, self_working_ptr, m, pivots_working_ptr, infos_working_ptr);
-  }
+  // lu returns 1-based pivots, so the small path is not used here
+  at::parallel_for(0, batch_size, lapackBatchGrainSize(batch_size, m * n * std::min(m, n)), [&](int64_t start, int64_t end) {
+    for (int64_t i = start; i < end; i++) {
+      scalar_t* self_working_ptr = &self_data[i * self_matrix_stride];
+      int* pivots_working_ptr = &pivots_data[i * pivots_matrix_stride];
+      int* infos_working_ptr = &infos_data[i];
+      lapackLu<scalar_t>(m, n, self_working_ptr, m, pivots_working_ptr, infos_working_ptr);
+    }
+  });
 #endif
 }
 
@@ -648,12 +796,14 @@ static void apply_triangular_solve(Tensor& b, Tensor& A, bool upper, bool transp
   auto n = A.size(-2);
   auto nrhs = b.size(-1);
 
-  int info;
-  for (int64_t i = 0; i < batch_size; i++) {
-    scalar_t* A_working_ptr = &A_data[i * A_mat_stride];
-    scalar_t* b_working_ptr = &b_data[i * b_mat_stride];
-    lapackTriangularSolve<scalar_t>(uplo, trans, diag, n, nrhs, A_working_ptr, n, b_working_ptr, n, &info);
-  }
+  at::parallel_for(0, batch_size, lapackBatchGrainSize(batch_size, n * n * nrhs), [&](int64_t start, int64_t end) {
+    int info;
+    for (int64_t i = start; i < end; i++) {
+      scalar_t* A_working_ptr = &A_data[i * A_mat_stride];
+      scalar_t* b_working_ptr = &b_data[i * b_mat_stride];
+      lapackTriangularSolve<scalar_t>(uplo, trans, diag, n, nrhs, A_working_ptr, n, b_working_ptr, n, &info);
+    }
+  });
 #endif
 }
 
@@ -712,19 +862,22 @@ static void apply_geqrf(Tensor& self, Tensor& tau, int64_t m, int64_t n,
   scalar_t wkopt;
   lapackGeqrf<scalar_t>(m, n, self_data, m, tau_data, &wkopt, lwork, &info);
   lwork = static_cast<int>(real_impl<scalar_t, value_t>(wkopt));
-  Tensor work = at::empty({lwork}, self.options());
-
-  for (int64_t i = 0; i < batch_size; i++) {
-    scalar_t* self_working_ptr = &self_data[i * self_matrix_stride];
-    scalar_t* tau_working_ptr = &tau_data[i * tau_stride];
 
-    // now compute the actual R and TAU
-    lapackGeqrf<scalar_t>(m, n, self_working_ptr, m, tau_working_ptr, work.data_ptr<scalar_t>(), lwork, &info);
-    infos[i] = info;
-    if (info != 0) {
-      return;
+  at::parallel_for(0, batch_size, lapackBatchGrainSize(batch_size, 2 * m * n * std::min(m, n)), [&](int64_t start, int64_t end) {
+    Tensor work = at::empty({lwork}, self.options());
+    int info;
+    for (int64_t i = start; i < end; i++) {
+      scalar_t* self_working_ptr = &self_data[i * self_matrix_stride];
+      scalar_t* tau_working_ptr = &tau_data[i * tau_stride];
+
+      // now compute the actual R and TAU
+      lapackGeqrf<scalar_t>(m, n, self_working_ptr, m, tau_working_ptr, work.data_ptr<scalar_t>(), lwork, &info);
+      infos[i] = info;
+      if (info != 0) {
+        return;
+      }
     }
-  }
+  });
 #endif
 }
 
@@ -750,19 +903,22 @@ static void apply_orgqr(Tensor& self, const Tensor& tau, int64_t m, int64_t n_co
   scalar_t wkopt;
   lapackOrgqr<scalar_t>(m, n_columns, k, self_data, m, tau_data, &wkopt, lwork, &info);
   lwork = static_cast<int>(real_impl<scalar_t, value_t>(wkopt));
-  Tensor work = at::empty({lwork}, self.options());
-
-  for (int64_t i = 0; i < batch_size; i++) {
-    scalar_t* self_working_ptr = &self_data[i * self_matrix_stride];
-    scalar_t* tau_working_ptr = &tau_data[i * tau_stride];
 
-    // now compute the actual Q
-    lapackOrgqr<scalar_t>(m, n_columns, k, self_working_ptr, m, tau_working_ptr, work.data_ptr<scalar_t>(), lwork, &info);
-    infos[i] = info;
-    if (info != 0) {
-      return;
+  at::parallel_for(0, batch_size, lapackBatchGrainSize(batch_size, 2 * m * n_columns * k), [&](int64_t start, int64_t end) {
+    Tensor work = at::empty({lwork}, self.options());
+    int info;
+    for (int64_t i = start; i < end; i++) {
+      scalar_t* self_working_ptr = &self_data[i * self_matrix_stride];
+      scalar_t* tau_working_ptr = &tau_data[i * tau_stride];
+
+      // now compute the actual Q
+      lapackOrgqr<scalar_t>(m, n_columns, k, self_working_ptr, m, tau_working_ptr, work.data_ptr<scalar_t>(), lwork, &info);
+      infos[i] = info;
+      if (info != 0) {
+        return;
+      }
     }
-  }
+  });
 #endif
 }
 
@@ -870,19 +1026,22 @@ static void apply_symeig(Tensor& self, Tensor& eigvals, bool eigenvectors, bool
   scalar_t wkopt;
   lapackSymeig<scalar_t>(jobz, uplo, n, self_data, n, eigvals_data, &wkopt, lwork, &info);
   lwork = static_cast<int>(real_impl<scalar_t, value_t>(wkopt));
-  Tensor work = at::empty({lwork}, self.options());
-
-  for (int64_t i = 0; i < batch_size; i++) {
-    scalar_t* self_working_ptr = &self_data[i * self_matrix_stride];
-    scalar_t* eigvals_working_ptr = &eigvals_data[i * eigvals_stride];
 
-    // now compute the eigenvalues and the eigenvectors (optionally)
-    lapackSymeig<scalar_t>(jobz, uplo, n, self_working_ptr, n, eigvals_working_ptr, work.data_ptr<scalar_t>(), lwork, &info);
-    infos[i] = info;
-    if (info != 0) {
-      return;
+  at::parallel_for(0, batch_size, lapackBatchGrainSize(batch_size, 9 * n * n * n), [&](int64_t start, int64_t end) {
+    Tensor work = at::empty({lwork}, self.options());
+    int info;
+    for (int64_t i = start; i < end; i++) {
+      scalar_t* self_working_ptr = &self_data[i * self_matrix_stride];
+      scalar_t* eigvals_working_ptr = &eigvals_data[i * eigvals_stride];
+
+      // now compute the eigenvalues and the eigenvectors (optionally)
+      lapackSymeig<scalar_t>(jobz, uplo, n, self_working_ptr, n, eigvals_working_ptr, work.data_ptr<scalar_t>(), lwork, &info);
+      infos[i] = info;
+      if (info != 0) {
+        return;
+      }
     }
-  }
+  });
 #endif
 }
 
@@ -951,13 +1110,11 @@ static void apply_svd(Tensor& self, Tensor& U, Tensor& S, Tensor& VT,
   auto m = self.size(-2);
   auto n = self.size(-1);
   auto mn = std::min(m, n);
-  Tensor iwork = at::empty({8*mn}, at::kInt);
-  auto iwork_data = iwork.data_ptr<int>();
-  Tensor rwork;
-  int* rwork_data = nullptr;
-  if (isComplexType(at::typeMetaToScalarType(self.dtype()))) {
-    auto mx = std::max(m, n);
-    int64_t lrwork; // These settings are valid for on LAPACK 3.6+
+  auto mx = std::max(m, n);
+  const bool is_complex = isComplexType(at::typeMetaToScalarType(self.dtype()));
+  int64_t lrwork = 0;
+  if (is_complex) {
+    // These settings are valid for on LAPACK 3.6+
     if (jobz == 'N'){
       lrwork = 7 * mn;
     }else if (mx > 10 * mn){
@@ -965,7 +1122,14 @@ static void apply_svd(Tensor& self, Tensor& U, Tensor& S, Tensor& VT,
     } else {
       lrwork = std::max(7 * mn * mn + 7 * mn, 2 * mx * mn + 2 *mn * mn + mn);
     }
-    rwork = at::empty({std::max(int64_t(1), lrwork)}, at::kInt);
+    lrwork = std::max(int64_t(1), lrwork);
+  }
+  Tensor iwork = at::empty({8*mn}, at::kInt);
+  auto iwork_data = iwork.data_ptr<int>();
+  Tensor rwork;
+  int* rwork_data = nullptr;
+  if (is_complex) {
+    rwork = at::empty({lrwork}, at::kInt);
     rwork_data = rwork.data_ptr<int>();
   }
 
@@ -977,23 +1141,31 @@ static void apply_svd(Tensor& self, Tensor& U, Tensor& S, Tensor& VT,
   scalar_t wkopt;
   lapackSvd<scalar_t, value_t>(jobz, m, n, self_data, m, S_data, U_data, m, VT_data, n, &wkopt, lwork, rwork_data, iwork_data, &info);
   lwork = static_cast<int>(real_impl<scalar_t, value_t>(wkopt));
-  Tensor work = at::empty({lwork}, self.options());
-  auto work_data = work.data_ptr<scalar_t>();
-
-  for (int64_t i = 0; i < batchsize; i++) {
-    scalar_t* self_working_ptr = &self_data[i * self_stride];
-    value_t* S_working_ptr = &S_data[i * S_stride];
-    scalar_t* U_working_ptr = &U_data[i * U_stride];
-    scalar_t* VT_working_ptr = &VT_data[i * VT_stride];
-    
-    // Compute S, U (optionally) and VT (optionally)
-    lapackSvd<scalar_t, value_t>(jobz, m, n, self_working_ptr, m,
-                        S_working_ptr, U_working_ptr, m, VT_working_ptr, n, work_data, lwork, rwork_data, iwork_data, &info);
-    infos[i] = info;
-    if (info != 0) {
-      return;
+
+  at::parallel_for(0, batchsize, lapackBatchGrainSize(batchsize, 12 * mx * mn * mn), [&](int64_t start, int64_t end) {
+    // per-task workspaces, the ones above were only needed for the query
+    Tensor work = at::empty({lwork}, self.options());
+    auto work_data = work.data_ptr<scalar_t>();
+    Tensor task_iwork = at::empty({8*mn}, at::kInt);
+    Tensor task_rwork = is_complex ? at::empty({lrwork}, at::kInt) : Tensor();
+    int* task_rwork_data = is_complex ? task_rwork.data_ptr<int>() : nullptr;
+    int info;
+    for (int64_t i = start; i < end; i++) {
+      scalar_t* self_working_ptr = &self_data[i * self_stride];
+      value_t* S_working_ptr = &S_data[i * S_stride];
+      scalar_t* U_working_ptr = &U_data[i * U_stride];
+      scalar_t* VT_working_ptr = &VT_data[i * VT_stride];
+
+      // Compute S, U (optionally) and VT (optionally)
+      lapackSvd<scalar_t, value_t>(jobz, m, n, self_working_ptr, m,
+                          S_working_ptr, U_working_ptr, m, VT_working_ptr, n, work_data, lwork,
+                          task_rwork_data, task_iwork.data_ptr<int>(), &info);
+      infos[i] = info;
+      if (info != 0) {
+        return;
+      }
     }
-  }
+  });
 #endif
 }
 
@@ -1071,18 +1243,20 @@ static void apply_lu_solve(Tensor& b, const Tensor& lu, const Tensor& pivots, st
   auto n = lu.size(-2);
   auto nrhs = b.size(-1);
 
-  int info;
-  for (int64_t i = 0; i < batch_size; i++) {
-    scalar_t* b_working_ptr = &b_data[i * b_stride];
-    scalar_t* lu_working_ptr = &lu_data[i * lu_stride];
-    int* pivots_working_ptr = &pivots_data[i * pivots_stride];
-    lapackLuSolve<scalar_t>('N', n, nrhs, lu_working_ptr, n, pivots_working_ptr,
-                            b_working_ptr, n, &info);
-    infos[i] = info;
-    if (info != 0) {
-      return;
+  at::parallel_for(0, batch_size, lapackBatchGrainSize(batch_size, 2 * n * n * nrhs), [&](int64_t start, int64_t end) {
+    int info;
+    for (int64_t i = start; i < end; i++) {
+      scalar_t* b_working_ptr = &b_data[i * b_stride];
+      scalar_t* lu_working_ptr = &lu_data[i * lu_stride];
+      int* pivots_working_ptr = &pivots_data[i * pivots_stride];
+      lapackLuSolve<scalar_t>('N', n, nrhs, lu_working_ptr, n, pivots_working_ptr,
+                              b_working_ptr, n, &info);
+      infos[i] = info;
+      if (info != 0) {
+        return;
+      }
     }
-  }
+  });
 #endif
 }
 
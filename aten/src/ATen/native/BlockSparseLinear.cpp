@@ -0,0 +1,215 @@
+#include <ATen/native/BlockSparseLinear.h>
+
+#include <ATen/ATen.h>
+#include <torch/custom_class.h>
+#include <torch/library.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace at { namespace native {
+
+DEFINE_DISPATCH(block_sparse_linear_stub);
+DEFINE_DISPATCH(block_sparse_linear_int8_stub);
+
+void check_block_sparse_shape(
+    int64_t rows,
+    int64_t cols,
+    int64_t out_block,
+    int64_t in_block) {
+  TORCH_CHECK(
+      out_block > 0 && out_block <= kBlockSparseMaxOutBlock && in_block > 0,
+      "block sparse linear: expected 0 < out_block <= ",
+      kBlockSparseMaxOutBlock,
+      " and in_block > 0, got ",
+      out_block,
+      "x",
+      in_block);
+  TORCH_CHECK(
+      rows % out_block == 0 && cols % in_block == 0,
+      "block sparse linear: a ",
+      rows,
+      "x",
+      cols,
+      " weight can not be cut into ",
+      out_block,
+      "x",
+      in_block,
+      " blocks");
+  TORCH_CHECK(
+      (rows / out_block) * (cols / in_block) <=
+          std::numeric_limits<int32_t>::max(),
+      "block sparse linear: too many blocks");
+}
+
+double block_sparsity(
+    const Tensor& weight,
+    int64_t out_block,
+    int64_t in_block) {
+  TORCH_CHECK(weight.dim() == 2, "block_sparsity expects a 2D weight");
+  const int64_t rows = weight.size(0);
+  const int64_t cols = weight.size(1);
+  check_block_sparse_shape(rows, cols, out_block, in_block);
+  if (rows == 0 || cols == 0) {
+    return 0;
+  }
+
+  // A block is zero when none of its elements differ from their zero point.
+  Tensor nonzero;
+  if (weight.is_quantized()) {
+    TORCH_CHECK(
+        weight.qscheme() == kPerTensorAffine ||
+            weight.qscheme() == kPerChannelAffine,
+        "block_sparsity: unsupported qscheme ",
+        toString(weight.qscheme()));
+    Tensor zero_points = weight.qscheme() == kPerTensorAffine
+        ? at::full({rows, 1}, weight.q_zero_point(), at::kLong)
+        : weight.q_per_channel_zero_points().to(at::kLong).view({rows, 1});
+    nonzero = weight.int_repr().to(at::kLong).ne(zero_points);
+  } else {
+    nonzero = weight.ne(0);
+  }
+  const int64_t blocks = (rows / out_block) * (cols / in_block);
+  const int64_t nonzero_blocks =
+      nonzero.view({rows / out_block, out_block, cols / in_block, in_block})
+          .any(3)
+          .any(1)
+          .sum()
+          .item<int64_t>();
+  return static_cast<double>(blocks - nonzero_blocks) / blocks;
+}
+
+c10::intrusive_ptr<BlockSparseLinearOpContext>
+BlockSparseLinearOpContext::create_context(
+    Tensor weight,
+    c10::optional<Tensor> bias,
+    int64_t out_block,
+    int64_t in_block) {
+  TORCH_CHECK(
+      weight.dim() == 2 && weight.scalar_type() == at::kFloat,
+      "sparse::linear_block_sparse_prepack expects a 2D float weight");
+  const int64_t rows = weight.size(0);
+  const int64_t cols = weight.size(1);
+  if (bias.has_value()) {
+    TORCH_CHECK(
+        bias->dim() == 1 && bias->size(0) == rows &&
+            bias->scalar_type() == at::kFloat,
+        "sparse::linear_block_sparse_prepack: bias should be a float vector "
+        "with ",
+        rows,
+        " elements");
+    bias = bias->contiguous();
+  }
+
+  Tensor weight_contig = weight.contiguous();
+  auto packed = pack_block_sparse<float>(
+      weight_contig.data_ptr<float>(),
+      rows,
+      cols,
+      out_block,
+      in_block,
+      [](int64_t /* row */, float v) { return v == 0; },
+      [](int64_t /* row */, float v) { return v; });
+  return c10::make_intrusive<BlockSparseLinearOpContext>(
+      std::move(packed), std::move(bias));
+}
+
+Tensor BlockSparseLinearOpContext::run(const Tensor& input) {
+  TORCH_CHECK(
+      input.dim() >= 1 && input.size(-1) == weight_.cols,
+      "sparse::linear_block_sparse_run: expected an input with ",
+      weight_.cols,
+      " features");
+  TORCH_CHECK(
+      input.scalar_type() == at::kFloat,
+      "sparse::linear_block_sparse_run expects a float input");
+  Tensor input_contig = input.contiguous();
+  const int64_t M = weight_.cols == 0 ? 0 : input.numel() / weight_.cols;
+
+  std::vector<int64_t> out_sizes = input.sizes().vec();
+  out_sizes.back() = weight_.rows;
+  Tensor output = at::empty(out_sizes, input.options());
+  if (output.numel() == 0) {
+    return output;
+  }
+  if (M == 0 || weight_.cols == 0) {
+    return bias_.has_value() ? output.copy_(bias_->expand_as(output))
+                             : output.zero_();
+  }
+  block_sparse_linear_stub(
+      kCPU,
+      weight_,
+      bias_.has_value() ? bias_->data_ptr<float>() : nullptr,
+      input_contig.data_ptr<float>(),
+      M,
+      output.data_ptr<float>());
+  return output;
+}
+
+SerializationTypeBlockSparseLinear BlockSparseLinearOpContext::unpack() {
+  Tensor weight = at::zeros({weight_.rows, weight_.cols}, at::kFloat);
+  float* weight_data = weight.data_ptr<float>();
+  const int64_t ob = weight_.out_block;
+  const int64_t ib = weight_.in_block;
+  for (int64_t br = 0; br < weight_.block_rows(); ++br) {
+    for (int32_t p = weight_.row_ptr[br]; p < weight_.row_ptr[br + 1]; ++p) {
+      for (int64_t i = 0; i < ob; ++i) {
+        std::copy_n(
+            weight_.values.data() + (p * ob + i) * ib,
+            ib,
+            weight_data + (br * ob + i) * weight_.cols +
+                weight_.col_idx[p] * ib);
+      }
+    }
+  }
+  return std::make_tuple(weight, bias_, ob, ib);
+}
+
+namespace {
+
+Tensor linear_block_sparse_run(
+    const Tensor& input,
+    const c10::intrusive_ptr<BlockSparseLinearOpContext>& op_context) {
+  return op_context->run(input);
+}
+
+double weight_block_sparsity(
+    const Tensor& weight,
+    int64_t out_block,
+    int64_t in_block) {
+  return block_sparsity(weight, out_block, in_block);
+}
+
+} // namespace
+
+TORCH_LIBRARY(sparse, m) {
+  m.class_<BlockSparseLinearOpContext>("BlockSparseLinearOpContext")
+    .def_pickle(
+        [](const c10::intrusive_ptr<BlockSparseLinearOpContext>& op_context)
+            -> SerializationTypeBlockSparseLinear { // __getstate__
+          return op_context->unpack();
+        },
+        [](SerializationTypeBlockSparseLinear state)
+            -> c10::intrusive_ptr<BlockSparseLinearOpContext> { // __setstate__
+          return BlockSparseLinearOpContext::create_context(
+              std::move(std::get<0>(state)),
+              std::move(std::get<1>(state)),
+              std::get<2>(state),
+              std::get<3>(state));
+        });
+
+  m.def("linear_block_sparse_prepack(Tensor W, Tensor? B=None, int out_block=1, int in_block=4) -> __torch__.torch.classes.sparse.BlockSparseLinearOpContext");
+  m.def("linear_block_sparse_run(Tensor X, __torch__.torch.classes.sparse.BlockSparseLinearOpContext W_prepack) -> Tensor Y");
+  m.def("block_sparsity(Tensor W, int out_block=1, int in_block=4) -> float");
+}
+
+TORCH_LIBRARY_IMPL(sparse, CPU, m) {
+  m.impl("linear_block_sparse_prepack", TORCH_FN(BlockSparseLinearOpContext::create_context));
+  m.impl("linear_block_sparse_run", TORCH_FN(linear_block_sparse_run));
+}
+
+TORCH_LIBRARY_IMPL(sparse, CatchAll, m) {
+  m.impl("block_sparsity", TORCH_FN(weight_block_sparsity));
+}
+
+}} // namespace at::native
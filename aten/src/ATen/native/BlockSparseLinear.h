@@ -0,0 +1,143 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/core/ivalue.h>
+#include <ATen/native/DispatchStub.h>
+
+#include <vector>
+
+namespace at { namespace native {
+
+// The weight of a linear layer stored as a block compressed sparse row (BSR)
+// matrix. The rows x cols matrix is cut into out_block x in_block blocks and
+// only the blocks with a non-zero element are kept, so that structurally
+// pruned models (1x4 or 4x4 blocks) skip the work of the pruned weights.
+template <typename T>
+struct BlockSparseMatrix {
+  int64_t rows = 0;
+  int64_t cols = 0;
+  int64_t out_block = 1;
+  int64_t in_block = 1;
+  // The non-zero blocks of block row r are row_ptr[r] .. row_ptr[r + 1] - 1.
+  std::vector<int32_t> row_ptr;
+  // The block column of each non-zero block.
+  std::vector<int32_t> col_idx;
+  // The out_block x in_block values of each non-zero block, row major.
+  std::vector<T> values;
+
+  int64_t block_rows() const {
+    return rows / out_block;
+  }
+};
+
+// Largest out_block supported by the kernels, which keep one accumulator per
+// row of a block.
+constexpr int64_t kBlockSparseMaxOutBlock = 16;
+
+CAFFE2_API void check_block_sparse_shape(
+    int64_t rows,
+    int64_t cols,
+    int64_t out_block,
+    int64_t in_block);
+
+// Packs the row major rows x cols matrix src. is_zero(row, value) tells
+// whether an element is a zero of the matrix, and convert(row, value) gives
+// the value to store for the elements of the kept blocks.
+template <typename T, typename S, typename IsZero, typename Convert>
+BlockSparseMatrix<T> pack_block_sparse(
+    const S* src,
+    int64_t rows,
+    int64_t cols,
+    int64_t out_block,
+    int64_t in_block,
+    IsZero is_zero,
+    Convert convert) {
+  check_block_sparse_shape(rows, cols, out_block, in_block);
+  BlockSparseMatrix<T> packed;
+  packed.rows = rows;
+  packed.cols = cols;
+  packed.out_block = out_block;
+  packed.in_block = in_block;
+  packed.row_ptr.reserve(rows / out_block + 1);
+  packed.row_ptr.push_back(0);
+  for (int64_t br = 0; br < rows / out_block; ++br) {
+    for (int64_t bc = 0; bc < cols / in_block; ++bc) {
+      bool all_zero = true;
+      for (int64_t i = 0; i < out_block && all_zero; ++i) {
+        const int64_t row = br * out_block + i;
+        for (int64_t j = 0; j < in_block && all_zero; ++j) {
+          all_zero = is_zero(row, src[row * cols + bc * in_block + j]);
+        }
+      }
+      if (all_zero) {
+        continue;
+      }
+      packed.col_idx.push_back(bc);
+      for (int64_t i = 0; i < out_block; ++i) {
+        const int64_t row = br * out_block + i;
+        for (int64_t j = 0; j < in_block; ++j) {
+          packed.values.push_back(
+              convert(row, src[row * cols + bc * in_block + j]));
+        }
+      }
+    }
+    packed.row_ptr.push_back(packed.col_idx.size());
+  }
+  return packed;
+}
+
+// The fraction of the out_block x in_block blocks of the 2D weight that are
+// entirely zero. For quantized weights an element is zero when it equals the
+// zero point of its row.
+CAFFE2_API double block_sparsity(
+    const Tensor& weight,
+    int64_t out_block,
+    int64_t in_block);
+
+// output (M x rows) = input (M x cols) * weight^T + bias; bias may be null.
+using block_sparse_linear_fn = void (*)(
+    const BlockSparseMatrix<float>& weight,
+    const float* bias,
+    const float* input,
+    int64_t M,
+    float* output);
+// output (M x rows) = (input (M x cols) - input_zero_point) * weight^T, where
+// weight already has its zero points subtracted.
+using block_sparse_linear_int8_fn = void (*)(
+    const BlockSparseMatrix<int16_t>& weight,
+    const uint8_t* input,
+    int64_t M,
+    int32_t input_zero_point,
+    int32_t* output);
+
+DECLARE_DISPATCH(block_sparse_linear_fn, block_sparse_linear_stub);
+DECLARE_DISPATCH(block_sparse_linear_int8_fn, block_sparse_linear_int8_stub);
+
+using SerializationTypeBlockSparseLinear =
+    std::tuple<Tensor, c10::optional<Tensor>, int64_t, int64_t>;
+
+// Prepacked fp32 block-sparse linear, the sparse::linear_block_sparse_prepack
+// / sparse::linear_block_sparse_run counterpart of the XNNPACK LinearOpContext.
+class CAFFE2_API BlockSparseLinearOpContext
+    : public torch::jit::CustomClassHolder {
+ public:
+  BlockSparseLinearOpContext(
+      BlockSparseMatrix<float>&& weight,
+      c10::optional<Tensor>&& bias)
+      : weight_(std::move(weight)), bias_(std::move(bias)) {}
+
+  Tensor run(const Tensor& input);
+  SerializationTypeBlockSparseLinear unpack();
+
+  static c10::intrusive_ptr<BlockSparseLinearOpContext> create_context(
+      Tensor weight,
+      c10::optional<Tensor> bias,
+      int64_t out_block,
+      int64_t in_block);
+
+ private:
+  BlockSparseMatrix<float> weight_;
+  c10::optional<Tensor> bias_;
+};
+
+}} // namespace at::native
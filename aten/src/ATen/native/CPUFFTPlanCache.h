@@ -0,0 +1,183 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/native/utils/ParamsHash.h>
+
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace at { namespace native { namespace detail {
+
+// Plan cache for the CPU FFT backends (MKL DFTI descriptors or pocketfft
+// plans), modeled after the cuFFT plan cache in native/cuda/CuFFTPlanCache.h.
+// Creating a plan involves factorizing the signal sizes and computing twiddle
+// tables, which dominates small, repeated transforms.
+
+constexpr int64_t cpu_fft_max_rank = 3;
+
+// This POD struct is used to let us easily compute hashes of the
+// parameters.
+// It will be the **key** to the plan cache.
+struct CPUFFTParams
+{
+  at::ScalarType scalar_type_;
+  int64_t input_sizes_[cpu_fft_max_rank + 2];
+  int64_t input_strides_[cpu_fft_max_rank + 2];
+  uint8_t signal_ndim_;  // between 1 and cpu_fft_max_rank
+  bool complex_input_;
+  bool complex_output_;
+  bool inverse_;
+  bool normalized_;
+  bool onesided_;
+  int64_t signal_sizes_[cpu_fft_max_rank];
+};
+
+// NB: This can't be a constructor, because then CPUFFTParams
+// would not be a POD anymore.
+static inline void setCPUFFTParams(CPUFFTParams* params,
+    const Tensor& input, int64_t signal_ndim, bool complex_input,
+    bool complex_output, bool inverse, IntArrayRef checked_signal_sizes,
+    bool normalized, bool onesided) {
+
+  memset(params, 0, sizeof(CPUFFTParams));
+  params->scalar_type_ = input.scalar_type();
+  for (int i = 0; i != input.dim(); ++i) {
+    params->input_sizes_[i] = input.size(i);
+    if (input.size(i) != 1) {
+      params->input_strides_[i] = input.stride(i);
+    }
+  }
+  params->signal_ndim_ = (uint8_t) signal_ndim;
+  params->complex_input_ = complex_input;
+  params->complex_output_ = complex_output;
+  params->inverse_ = inverse;
+  params->normalized_ = normalized;
+  params->onesided_ = onesided;
+  for (size_t i = 0; i != checked_signal_sizes.size(); ++i) {
+    params->signal_sizes_[i] = checked_signal_sizes[i];
+  }
+}
+
+// Arbitrary, like CUFFT_DEFAULT_CACHE_SIZE. Users can always configure it via
+// _fft_cpu_set_plan_cache_max_size.
+constexpr size_t CPU_FFT_DEFAULT_CACHE_SIZE = 4096;
+
+// LRU cache from CPUFFTParams to plans.
+//
+// Unlike the cuFFT cache, values are handed out as shared_ptrs so that the
+// lock is only held for the lookup: several threads can execute the same plan
+// concurrently, and a plan evicted while in use stays alive until the last
+// user is done with it. The Config type must therefore be safe to use from
+// multiple threads once constructed.
+template <typename Config>
+class CPUFFTParamsLRUCache {
+public:
+  using value_t = std::shared_ptr<const Config>;
+  using kv_t = typename std::pair<CPUFFTParams, value_t>;
+  using map_t = typename std::unordered_map<std::reference_wrapper<CPUFFTParams>,
+                                            typename std::list<kv_t>::iterator,
+                                            ParamsHash<CPUFFTParams>,
+                                            ParamsEqual<CPUFFTParams>>;
+  using map_kkv_iter_t = typename map_t::iterator;
+
+  CPUFFTParamsLRUCache() : CPUFFTParamsLRUCache(CPU_FFT_DEFAULT_CACHE_SIZE) {}
+
+  CPUFFTParamsLRUCache(int64_t max_size) {
+    _set_max_size(max_size);
+  }
+
+  // If key is in this cache, return the cached config. Otherwise, construct
+  // the config from value_args, insert it (if the cache is enabled) and
+  // return it. The config is constructed without holding the lock.
+  template<class ...VArgs>
+  value_t get_or_create(const CPUFFTParams& key, VArgs&&... value_args) {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      if (_max_size == 0) {
+        return std::make_shared<const Config>(std::forward<VArgs>(value_args)...);
+      }
+      map_kkv_iter_t map_it = _cache_map.find(const_cast<CPUFFTParams&>(key));
+      // Hit, put to list front
+      if (map_it != _cache_map.end()) {
+        _usage_list.splice(_usage_list.begin(), _usage_list, map_it->second);
+        return map_it->second->second;
+      }
+    }
+
+    // Miss. Another thread may insert the same key meanwhile, in which case
+    // we keep the entry that is already there.
+    value_t config = std::make_shared<const Config>(std::forward<VArgs>(value_args)...);
+
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (_max_size == 0) {
+      return config;
+    }
+    map_kkv_iter_t map_it = _cache_map.find(const_cast<CPUFFTParams&>(key));
+    if (map_it != _cache_map.end()) {
+      _usage_list.splice(_usage_list.begin(), _usage_list, map_it->second);
+      return map_it->second->second;
+    }
+    // remove if needed
+    if (_usage_list.size() >= _max_size) {
+      auto last = _usage_list.end();
+      last--;
+      _cache_map.erase(last->first);
+      _usage_list.pop_back();
+    }
+    // construct new plan at list front, then insert into _cache_map
+    _usage_list.emplace_front(key, config);
+    auto kv_it = _usage_list.begin();
+    _cache_map.emplace(std::piecewise_construct,
+                std::forward_as_tuple(kv_it->first),
+                std::forward_as_tuple(kv_it));
+    return config;
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    _cache_map.clear();
+    _usage_list.clear();
+  }
+
+  void resize(int64_t new_size) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    _set_max_size(new_size);
+    auto cur_size = _usage_list.size();
+    if (cur_size > _max_size) {
+      auto delete_it = _usage_list.end();
+      for (size_t i = 0; i < cur_size - _max_size; i++) {
+        delete_it--;
+        _cache_map.erase(delete_it->first);
+      }
+      _usage_list.erase(delete_it, _usage_list.end());
+    }
+  }
+
+  size_t size() const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return _cache_map.size();
+  }
+
+  size_t max_size() const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return _max_size;
+  }
+
+private:
+  // Only sets size and does value check. Does not resize the data structures.
+  void _set_max_size(int64_t new_size) {
+    TORCH_CHECK(new_size >= 0,
+             "CPU FFT plan cache size must be non-negative, but got ", new_size);
+    _max_size = static_cast<size_t>(new_size);
+  }
+
+  mutable std::mutex mutex_;
+  std::list<kv_t> _usage_list;
+  map_t _cache_map;
+  size_t _max_size;
+};
+
+}}} // namespace at::native::detail
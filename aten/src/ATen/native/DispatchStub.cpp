@@ -3,28 +3,20 @@
 #include <c10/util/Exception.h>
 
 #include <cpuinfo.h>
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 
 namespace at { namespace native {
 
-static CPUCapability compute_cpu_capability() {
-  auto envar = std::getenv("ATEN_CPU_CAPABILITY");
-  if (envar) {
-    if (strcmp(envar, "avx2") == 0) {
-      return CPUCapability::AVX2;
-    }
-    if (strcmp(envar, "avx") == 0) {
-      return CPUCapability::AVX;
-    }
-    if (strcmp(envar, "default") == 0) {
-      return CPUCapability::DEFAULT;
-    }
-    TORCH_WARN("ignoring invalid value for ATEN_CPU_CAPABILITY: ", envar);
-  }
-
+static CPUCapability detect_cpu_capability() {
 #if !defined(__powerpc__) && !defined(__s390x__)
   if (cpuinfo_initialize()) {
+    if (cpuinfo_has_x86_avx512f() && cpuinfo_has_x86_avx512bw() &&
+        cpuinfo_has_x86_avx512vl() && cpuinfo_has_x86_avx512dq() &&
+        cpuinfo_has_x86_fma3()) {
+      return CPUCapability::AVX512;
+    }
     if (cpuinfo_has_x86_avx2() && cpuinfo_has_x86_fma3()) {
       return CPUCapability::AVX2;
     }
@@ -36,6 +28,30 @@ static CPUCapability compute_cpu_capability() {
   return CPUCapability::DEFAULT;
 }
 
+// ATEN_CPU_CAPABILITY caps the capability at the given level; it never
+// selects kernels the CPU cannot run.
+static CPUCapability compute_cpu_capability() {
+  auto detected = detect_cpu_capability();
+  auto envar = std::getenv("ATEN_CPU_CAPABILITY");
+  if (envar) {
+    auto requested = CPUCapability::NUM_OPTIONS;
+    if (strcmp(envar, "avx512") == 0) {
+      requested = CPUCapability::AVX512;
+    } else if (strcmp(envar, "avx2") == 0) {
+      requested = CPUCapability::AVX2;
+    } else if (strcmp(envar, "avx") == 0) {
+      requested = CPUCapability::AVX;
+    } else if (strcmp(envar, "default") == 0) {
+      requested = CPUCapability::DEFAULT;
+    }
+    if (requested != CPUCapability::NUM_OPTIONS) {
+      return std::min(requested, detected);
+    }
+    TORCH_WARN("ignoring invalid value for ATEN_CPU_CAPABILITY: ", envar);
+  }
+  return detected;
+}
+
 CPUCapability get_cpu_capability() {
   static CPUCapability capability = compute_cpu_capability();
   return capability;
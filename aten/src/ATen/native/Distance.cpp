@@ -10,6 +10,7 @@ namespace at { namespace native {
 DEFINE_DISPATCH(pdist_forward_stub);
 DEFINE_DISPATCH(pdist_backward_stub);
 DEFINE_DISPATCH(cdist_stub);
+DEFINE_DISPATCH(cdist_topk_stub);
 DEFINE_DISPATCH(cdist_backward_stub);
 
 Tensor pairwise_distance(const Tensor& x1, const Tensor& x2, double p, double eps, bool keepdim) {
@@ -40,25 +41,12 @@ Tensor _euclidean_dist(const Tensor& x1, const Tensor& x2) {
   return result;
 }
 
-static Tensor cdist_impl(const Tensor& x1, const Tensor& x2, const double p, c10::optional<int64_t> compute_mode) {
-  TORCH_CHECK(at::isFloatingType(x1.scalar_type()), "cdist only supports floating-point dtypes, X1 got: ", x1.scalar_type());
-  auto device1 = x1.device().type();
-  TORCH_CHECK(device1 == kCPU || device1 == kCUDA, "cdist only supports CPU and CUDA devices, X1 got: ", device1);
-  TORCH_CHECK(at::isFloatingType(x1.scalar_type()), "cdist only supports floating-point dtypes, X2 got: ", x2.scalar_type());
-  auto device2 = x2.device().type();
-  TORCH_CHECK(device2 == kCPU || device2 == kCUDA, "cdist only supports CPU and CUDA devices, X2 got: ", device2);
-  TORCH_CHECK(p >= 0, "cdist only supports non-negative p values");
-  TORCH_CHECK(device1 == device2, "X1 and X2 must have the same device type. X1: ", device1, " X2: ", device2);
-  TORCH_CHECK(!x1.is_cuda() || x1.get_device() == x2.get_device(), "device of X1 (", x1.get_device(), ") must match device of X2 (", x2.get_device(), ")");
+// Broadcasts the batch dimensions of x1 (..., r1, c) and x2 (..., r2, c) and
+// collapses them into one. Returns x1 and x2 as contiguous (B, r1, c) and
+// (B, r2, c) tensors, and the broadcast batch shape.
+static std::tuple<Tensor, Tensor, std::vector<int64_t>> cdist_expand_batch(const Tensor& x1, const Tensor& x2) {
   int64_t c1 = x1.size(-1);
   int64_t c2 = x2.size(-1);
-  // 0 - default value. If p = 2 and r1 > 25 or r2 > 25 (these values are based on performance metrics),
-  // it will try to compute distance using matrix multiplication approach
-  // 1 - force to use matrix multiplication for p = 2
-  // 2 - do not use matrix multiplication for p = 2
-  int64_t mode = compute_mode.value_or(0);
-  TORCH_CHECK(mode >= 0 && mode <= 2, "possible modes: 0, 1, 2, but was: ", mode);
-
   int64_t r1 = x1.size(-2);
   int64_t r2 = x2.size(-2);
   auto dim1 = x1.dim();
@@ -80,6 +68,34 @@ static Tensor cdist_impl(const Tensor& x1, const Tensor& x2, const double p, c10
 
   Tensor tensor1_expanded = x1.expand(tensor1_expand_size).contiguous().view(tensor1_view);
   Tensor tensor2_expanded = x2.expand(tensor2_expand_size).contiguous().view(tensor2_view);
+  return std::make_tuple(tensor1_expanded, tensor2_expanded, expand_batch_portion);
+}
+
+static Tensor cdist_impl(const Tensor& x1, const Tensor& x2, const double p, c10::optional<int64_t> compute_mode) {
+  TORCH_CHECK(at::isFloatingType(x1.scalar_type()), "cdist only supports floating-point dtypes, X1 got: ", x1.scalar_type());
+  auto device1 = x1.device().type();
+  TORCH_CHECK(device1 == kCPU || device1 == kCUDA, "cdist only supports CPU and CUDA devices, X1 got: ", device1);
+  TORCH_CHECK(at::isFloatingType(x1.scalar_type()), "cdist only supports floating-point dtypes, X2 got: ", x2.scalar_type());
+  auto device2 = x2.device().type();
+  TORCH_CHECK(device2 == kCPU || device2 == kCUDA, "cdist only supports CPU and CUDA devices, X2 got: ", device2);
+  TORCH_CHECK(p >= 0, "cdist only supports non-negative p values");
+  TORCH_CHECK(device1 == device2, "X1 and X2 must have the same device type. X1: ", device1, " X2: ", device2);
+  TORCH_CHECK(!x1.is_cuda() || x1.get_device() == x2.get_device(), "device of X1 (", x1.get_device(), ") must match device of X2 (", x2.get_device(), ")");
+  int64_t c1 = x1.size(-1);
+  // 0 - default value. If p = 2 and r1 > 25 or r2 > 25 (these values are based on performance metrics),
+  // it will try to compute distance using matrix multiplication approach
+  // 1 - force to use matrix multiplication for p = 2
+  // 2 - do not use matrix multiplication for p = 2
+  int64_t mode = compute_mode.value_or(0);
+  TORCH_CHECK(mode >= 0 && mode <= 2, "possible modes: 0, 1, 2, but was: ", mode);
+
+  int64_t r1 = x1.size(-2);
+  int64_t r2 = x2.size(-2);
+
+  Tensor tensor1_expanded, tensor2_expanded;
+  std::vector<int64_t> expand_batch_portion;
+  std::tie(tensor1_expanded, tensor2_expanded, expand_batch_portion) = cdist_expand_batch(x1, x2);
+  int64_t expand_batch_product = tensor1_expanded.size(0);
 
   std::vector<int64_t> output_shape(expand_batch_portion);
   output_shape.insert(output_shape.end(), {r1, r2});
@@ -135,6 +151,40 @@ Tensor _cdist_forward(const Tensor& x1, const Tensor& x2, const double p, c10::o
   return result;
 }
 
+std::tuple<Tensor, Tensor> cdist_topk_cpu(const Tensor& x1, const Tensor& x2, int64_t k, const double p, bool largest) {
+  TORCH_CHECK(x1.dim() >= 2, "cdist_topk only supports at least 2D tensors, X1 got: ", x1.dim(), "D");
+  TORCH_CHECK(x2.dim() >= 2, "cdist_topk only supports at least 2D tensors, X2 got: ", x2.dim(), "D");
+  TORCH_CHECK(x1.size(-1) == x2.size(-1), "X1 and X2 must have the same number of columns. X1: ", x1.size(-1), " X2: ", x2.size(-1));
+  TORCH_CHECK(at::isFloatingType(x1.scalar_type()), "cdist_topk only supports floating-point dtypes, X1 got: ", x1.scalar_type());
+  TORCH_CHECK(x1.scalar_type() == x2.scalar_type(), "X1 and X2 must have the same dtype. X1: ", x1.scalar_type(), " X2: ", x2.scalar_type());
+  TORCH_CHECK(x2.device().is_cpu(), "X1 and X2 must have the same device type. X1: ", x1.device().type(), " X2: ", x2.device().type());
+  TORCH_CHECK(p >= 0, "cdist_topk only supports non-negative p values");
+  int64_t r1 = x1.size(-2);
+  int64_t r2 = x2.size(-2);
+  TORCH_CHECK(k >= 0 && k <= r2, "cdist_topk: k (", k, ") must be between 0 and the number of rows of X2 (", r2, ")");
+
+  // Only the k selected distances of each row are ever stored, the (..., r1, r2)
+  // distance matrix is not materialized.
+  Tensor tensor1_expanded, tensor2_expanded;
+  std::vector<int64_t> output_shape;
+  std::tie(tensor1_expanded, tensor2_expanded, output_shape) = cdist_expand_batch(x1, x2);
+  output_shape.insert(output_shape.end(), {r1, k});
+  int64_t expand_batch_product = tensor1_expanded.size(0);
+
+  Tensor values = at::empty({expand_batch_product, r1, k}, x1.options());
+  Tensor indices = at::empty({expand_batch_product, r1, k}, x1.options().dtype(kLong));
+  if (r1 == 0 || k == 0) {
+    // nothing to do
+  } else if (x1.size(-1) == 0) {
+    // all distances are 0, ties are broken by index
+    values.zero_();
+    indices.copy_(at::arange(k, indices.options()));
+  } else {
+    cdist_topk_stub(kCPU, values, indices, tensor1_expanded, tensor2_expanded, p, largest);
+  }
+  return std::make_tuple(values.view(output_shape), indices.view(output_shape));
+}
+
 Tensor _cdist_backward(const Tensor& grad, const Tensor& x1, const Tensor& x2, const double p, const Tensor& cdist) {
   TORCH_CHECK(x1.is_contiguous(), "_cdist_backward requires X1 to be contiguous");
   TORCH_CHECK(x2.is_contiguous(), "_cdist_backward requires X2 to be contiguous");
@@ -0,0 +1,620 @@
+#pragma once
+
+// A header-only, mixed-radix FFT used by the CPU spectral ops when ATen is
+// built without MKL.
+//
+// The design follows pocketfft (https://gitlab.mpcdf.mpg.de/mtr/pocketfft):
+//   1. A plan is computed once per transform length. It holds the
+//      factorization and all twiddle tables, so executing a plan never
+//      evaluates a trigonometric function.
+//   2. Complex transforms use a Stockham autosort scheme (no bit reversal
+//      pass) with specialized radix-4, radix-2 and radix-3 butterflies and a
+//      generic butterfly for the remaining prime factors. The innermost loop
+//      of every butterfly runs over contiguous elements so that it is
+//      vectorized by the compiler.
+//   3. Lengths with large prime factors are computed with Bluestein's
+//      algorithm on top of a power-of-two transform.
+//   4. Real transforms of even length n are computed with a complex
+//      transform of length n / 2 plus a post-processing step.
+//   5. Multi-dimensional transforms are applied one signal dimension at a
+//      time, and every 1-D pass is parallelized over all lines (batch and
+//      remaining signal dimensions) with at::parallel_for.
+//
+// Plans are immutable after construction and can be shared between threads.
+
+#include <ATen/Parallel.h>
+#include <c10/util/Exception.h>
+#include <c10/util/complex.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+namespace at { namespace native { namespace pocketfft {
+
+template <typename T>
+using cmplx = c10::complex<T>;
+
+namespace detail {
+
+constexpr double kPi = 3.141592653589793238462643383279502884;
+
+// Returns exp(-2 * pi * i * k / n). Twiddles are always computed in double
+// precision so that float plans only suffer from the final rounding.
+template <typename T>
+inline cmplx<T> unit_root(int64_t k, int64_t n) {
+  k %= n;
+  const double angle = -2.0 * kPi * static_cast<double>(k) / static_cast<double>(n);
+  return cmplx<T>(static_cast<T>(std::cos(angle)), static_cast<T>(std::sin(angle)));
+}
+
+// Multiplies by -i (forward) or +i (backward).
+template <bool Forward, typename T>
+inline cmplx<T> rot90(const cmplx<T>& a) {
+  return Forward ? cmplx<T>(a.imag(), -a.real()) : cmplx<T>(-a.imag(), a.real());
+}
+
+template <bool Forward, typename T>
+inline cmplx<T> twiddle(const cmplx<T>& w) {
+  return Forward ? w : std::conj(w);
+}
+
+inline std::vector<int64_t> factorize(int64_t n) {
+  std::vector<int64_t> factors;
+  while ((n & 3) == 0) {
+    factors.push_back(4);
+    n >>= 2;
+  }
+  if ((n & 1) == 0) {
+    factors.push_back(2);
+    n >>= 1;
+  }
+  for (int64_t p = 3; p * p <= n; p += 2) {
+    while (n % p == 0) {
+      factors.push_back(p);
+      n /= p;
+    }
+  }
+  if (n > 1) {
+    factors.push_back(n);
+  }
+  return factors;
+}
+
+// Rough operation count of a Stockham transform of length n.
+inline double stockham_cost(int64_t n) {
+  double cost = 0;
+  for (auto p : factorize(n)) {
+    cost += static_cast<double>(n) * (p <= 4 ? 1.0 : static_cast<double>(p));
+  }
+  return cost;
+}
+
+inline int64_t next_pow2(int64_t n) {
+  int64_t m = 1;
+  while (m < n) {
+    m <<= 1;
+  }
+  return m;
+}
+
+// Complex transform of any length, computed with the Stockham autosort
+// algorithm. For a pass of radix p over a sub-transform of length p * m
+// with stride s, element (q, pp + r * m) of the input contributes to
+// element (q, p * pp + k) of the output, q < s being the index of the
+// interleaved sub-transform. See NOTE [ Stockham Autosort ] below.
+template <typename T>
+class StockhamPlan {
+ public:
+  explicit StockhamPlan(int64_t n) : n_(n) {
+    int64_t s = 1;
+    int64_t len = n;
+    for (auto p : factorize(n)) {
+      Pass pass;
+      pass.radix = p;
+      pass.m = len / p;
+      pass.s = s;
+      // tw[(k - 1) * m + pp] = W_len^(k * pp)
+      pass.tw.resize((p - 1) * pass.m);
+      for (int64_t k = 1; k < p; k++) {
+        for (int64_t pp = 0; pp < pass.m; pp++) {
+          pass.tw[(k - 1) * pass.m + pp] = unit_root<T>(k * pp, len);
+        }
+      }
+      if (p > 4) {
+        pass.roots.resize(p);
+        for (int64_t j = 0; j < p; j++) {
+          pass.roots[j] = unit_root<T>(j, p);
+        }
+      }
+      passes_.push_back(std::move(pass));
+      s *= p;
+      len /= p;
+    }
+  }
+
+  int64_t length() const {
+    return n_;
+  }
+
+  // Transforms `data` in place. `scratch` must hold length() elements.
+  template <bool Forward>
+  void exec(cmplx<T>* data, cmplx<T>* scratch) const {
+    cmplx<T>* x = data;
+    cmplx<T>* y = scratch;
+    for (const auto& pass : passes_) {
+      switch (pass.radix) {
+        case 2: pass2<Forward>(pass, x, y); break;
+        case 3: pass3<Forward>(pass, x, y); break;
+        case 4: pass4<Forward>(pass, x, y); break;
+        default: passg<Forward>(pass, x, y); break;
+      }
+      std::swap(x, y);
+    }
+    if (x != data) {
+      std::copy(x, x + n_, data);
+    }
+  }
+
+ private:
+  // NOTE [ Stockham Autosort ]
+  //
+  // Let len = p * m be the length of the sub-transforms handled by a pass,
+  // and s = n / len the number of them, stored interleaved. Writing the time
+  // index as t = pp + r * m and the frequency index as f = k + p * f2,
+  //
+  //   X[k + p * f2] = sum_pp W_m^(f2 * pp) * (W_len^(k * pp) * sum_r x[pp + r * m] * W_p^(k * r)),
+  //
+  // i.e., after the butterfly and twiddle multiplication, the p sequences
+  // y_k[pp] are independent transforms of length m. Storing y_k[pp] at
+  // q + s * (p * pp + k) makes them the interleaved inputs of the next pass
+  // (with stride s * p), and leaves the final result in natural order.
+  struct Pass {
+    int64_t radix;
+    int64_t m;
+    int64_t s;
+    std::vector<cmplx<T>> tw;
+    std::vector<cmplx<T>> roots;
+  };
+
+  template <bool Forward>
+  static void pass2(const Pass& ps, const cmplx<T>* x, cmplx<T>* y) {
+    const int64_t m = ps.m, s = ps.s;
+    for (int64_t pp = 0; pp < m; pp++) {
+      const cmplx<T> w1 = twiddle<Forward>(pp == 0 ? cmplx<T>(1) : ps.tw[pp]);
+      const cmplx<T>* x0 = x + s * pp;
+      const cmplx<T>* x1 = x + s * (pp + m);
+      cmplx<T>* y0 = y + s * (2 * pp);
+      cmplx<T>* y1 = y0 + s;
+      for (int64_t q = 0; q < s; q++) {
+        const cmplx<T> a = x0[q], b = x1[q];
+        y0[q] = a + b;
+        y1[q] = (a - b) * w1;
+      }
+    }
+  }
+
+  template <bool Forward>
+  static void pass3(const Pass& ps, const cmplx<T>* x, cmplx<T>* y) {
+    const int64_t m = ps.m, s = ps.s;
+    const T half = static_cast<T>(0.5);
+    const T sin60 = static_cast<T>(0.866025403784438646763723170752936183);
+    for (int64_t pp = 0; pp < m; pp++) {
+      const cmplx<T> w1 = twiddle<Forward>(ps.tw[pp]);
+      const cmplx<T> w2 = twiddle<Forward>(ps.tw[m + pp]);
+      const cmplx<T>* x0 = x + s * pp;
+      const cmplx<T>* x1 = x + s * (pp + m);
+      const cmplx<T>* x2 = x + s * (pp + 2 * m);
+      cmplx<T>* y0 = y + s * (3 * pp);
+      cmplx<T>* y1 = y0 + s;
+      cmplx<T>* y2 = y1 + s;
+      for (int64_t q = 0; q < s; q++) {
+        const cmplx<T> a0 = x0[q], a1 = x1[q], a2 = x2[q];
+        const cmplx<T> t1 = a1 + a2;
+        const cmplx<T> t2 = a0 - t1 * half;
+        const cmplx<T> t3 = rot90<Forward>((a1 - a2) * sin60);
+        y0[q] = a0 + t1;
+        y1[q] = (t2 + t3) * w1;
+        y2[q] = (t2 - t3) * w2;
+      }
+    }
+  }
+
+  template <bool Forward>
+  static void pass4(const Pass& ps, const cmplx<T>* x, cmplx<T>* y) {
+    const int64_t m = ps.m, s = ps.s;
+    for (int64_t pp = 0; pp < m; pp++) {
+      const cmplx<T> w1 = twiddle<Forward>(ps.tw[pp]);
+      const cmplx<T> w2 = twiddle<Forward>(ps.tw[m + pp]);
+      const cmplx<T> w3 = twiddle<Forward>(ps.tw[2 * m + pp]);
+      const cmplx<T>* x0 = x + s * pp;
+      const cmplx<T>* x1 = x + s * (pp + m);
+      const cmplx<T>* x2 = x + s * (pp + 2 * m);
+      const cmplx<T>* x3 = x + s * (pp + 3 * m);
+      cmplx<T>* y0 = y + s * (4 * pp);
+      cmplx<T>* y1 = y0 + s;
+      cmplx<T>* y2 = y1 + s;
+      cmplx<T>* y3 = y2 + s;
+      for (int64_t q = 0; q < s; q++) {
+        const cmplx<T> a0 = x0[q], a1 = x1[q], a2 = x2[q], a3 = x3[q];
+        const cmplx<T> t0 = a0 + a2;
+        const cmplx<T> t1 = a0 - a2;
+        const cmplx<T> t2 = a1 + a3;
+        const cmplx<T> t3 = rot90<Forward>(a1 - a3);
+        y0[q] = t0 + t2;
+        y1[q] = (t1 + t3) * w1;
+        y2[q] = (t0 - t2) * w2;
+        y3[q] = (t1 - t3) * w3;
+      }
+    }
+  }
+
+  template <bool Forward>
+  static void passg(const Pass& ps, const cmplx<T>* x, cmplx<T>* y) {
+    const int64_t p = ps.radix, m = ps.m, s = ps.s;
+    for (int64_t pp = 0; pp < m; pp++) {
+      for (int64_t k = 0; k < p; k++) {
+        cmplx<T>* yk = y + s * (p * pp + k);
+        const cmplx<T>* x0 = x + s * pp;
+        for (int64_t q = 0; q < s; q++) {
+          yk[q] = x0[q];
+        }
+        for (int64_t r = 1; r < p; r++) {
+          const cmplx<T> root = twiddle<Forward>(ps.roots[(r * k) % p]);
+          const cmplx<T>* xr = x + s * (pp + r * m);
+          for (int64_t q = 0; q < s; q++) {
+            yk[q] += xr[q] * root;
+          }
+        }
+        if (k > 0) {
+          const cmplx<T> w = twiddle<Forward>(ps.tw[(k - 1) * m + pp]);
+          for (int64_t q = 0; q < s; q++) {
+            yk[q] *= w;
+          }
+        }
+      }
+    }
+  }
+
+  int64_t n_;
+  std::vector<Pass> passes_;
+};
+
+// Bluestein's algorithm: a transform of length n is rewritten as a circular
+// convolution of length m >= 2 * n - 1, m being a power of two, using
+//   k * t = (t^2 + k^2 - (k - t)^2) / 2.
+template <typename T>
+class BluesteinPlan {
+ public:
+  explicit BluesteinPlan(int64_t n)
+      : n_(n), m_(next_pow2(2 * n - 1)), plan_(m_), chirp_(n), bk_(m_) {
+    // chirp[t] = exp(-pi * i * t^2 / n), with t^2 reduced modulo 2n to keep
+    // the angle accurate for large t.
+    for (int64_t t = 0; t < n; t++) {
+      const int64_t t2 = (t * t) % (2 * n);
+      const double angle = -kPi * static_cast<double>(t2) / static_cast<double>(n);
+      chirp_[t] = cmplx<T>(static_cast<T>(std::cos(angle)), static_cast<T>(std::sin(angle)));
+    }
+    // bk = FFT(conj(chirp)) / m, with the chirp mirrored for negative lags
+    std::vector<cmplx<T>> scratch(m_);
+    const T fct = static_cast<T>(1) / static_cast<T>(m_);
+    std::fill(bk_.begin(), bk_.end(), cmplx<T>(0));
+    bk_[0] = std::conj(chirp_[0]) * fct;
+    for (int64_t t = 1; t < n; t++) {
+      bk_[t] = bk_[m_ - t] = std::conj(chirp_[t]) * fct;
+    }
+    plan_.template exec<true>(bk_.data(), scratch.data());
+  }
+
+  int64_t scratch_size() const {
+    return 2 * m_;
+  }
+
+  template <bool Forward>
+  void exec(cmplx<T>* data, cmplx<T>* scratch) const {
+    // The backward transform is conj(FFT(conj(x))).
+    cmplx<T>* a = scratch;
+    cmplx<T>* tmp = scratch + m_;
+    for (int64_t t = 0; t < n_; t++) {
+      const cmplx<T> v = Forward ? data[t] : std::conj(data[t]);
+      a[t] = v * chirp_[t];
+    }
+    std::fill(a + n_, a + m_, cmplx<T>(0));
+    plan_.template exec<true>(a, tmp);
+    for (int64_t k = 0; k < m_; k++) {
+      a[k] *= bk_[k];
+    }
+    plan_.template exec<false>(a, tmp);
+    for (int64_t k = 0; k < n_; k++) {
+      const cmplx<T> v = a[k] * chirp_[k];
+      data[k] = Forward ? v : std::conj(v);
+    }
+  }
+
+  static double cost(int64_t n) {
+    const int64_t m = next_pow2(2 * n - 1);
+    // two transforms of length m plus three pointwise products
+    return 2.0 * stockham_cost(m) + 3.0 * static_cast<double>(m);
+  }
+
+ private:
+  int64_t n_;
+  int64_t m_;
+  StockhamPlan<T> plan_;
+  std::vector<cmplx<T>> chirp_;
+  std::vector<cmplx<T>> bk_;
+};
+
+} // namespace detail
+
+// Complex-to-complex transform of length n.
+template <typename T>
+class CFFTPlan {
+ public:
+  explicit CFFTPlan(int64_t n) : n_(n) {
+    TORCH_CHECK(n >= 1, "pocketfft: invalid transform length ", n);
+    // Bluestein has a large constant factor, only use it when the direct
+    // transform would be dominated by a large prime factor.
+    if (n > 64 && detail::stockham_cost(n) > 1.5 * detail::BluesteinPlan<T>::cost(n)) {
+      blue_ = std::make_unique<detail::BluesteinPlan<T>>(n);
+    } else {
+      direct_ = std::make_unique<detail::StockhamPlan<T>>(n);
+    }
+  }
+
+  int64_t length() const {
+    return n_;
+  }
+
+  // Number of cmplx<T> elements `exec` needs as scratch space.
+  int64_t scratch_size() const {
+    return blue_ ? blue_->scratch_size() : n_;
+  }
+
+  // Transforms `data` in place and multiplies the result by `fct`.
+  void exec(cmplx<T>* data, cmplx<T>* scratch, bool forward, T fct) const {
+    if (blue_) {
+      forward ? blue_->template exec<true>(data, scratch)
+              : blue_->template exec<false>(data, scratch);
+    } else {
+      forward ? direct_->template exec<true>(data, scratch)
+              : direct_->template exec<false>(data, scratch);
+    }
+    if (fct != static_cast<T>(1)) {
+      for (int64_t i = 0; i < n_; i++) {
+        data[i] *= fct;
+      }
+    }
+  }
+
+ private:
+  int64_t n_;
+  std::unique_ptr<detail::StockhamPlan<T>> direct_;
+  std::unique_ptr<detail::BluesteinPlan<T>> blue_;
+};
+
+// Real-to-complex (forward) and complex-to-real (backward) transforms of a
+// real signal of length n. The complex side only holds the n / 2 + 1
+// non-redundant values. See NOTE [ Fourier Transform Conjugate Symmetry ] in
+// native/SpectralOpsUtils.h.
+template <typename T>
+class RFFTPlan {
+ public:
+  explicit RFFTPlan(int64_t n)
+      : n_(n), plan_((n % 2 == 0) ? n / 2 : n) {
+    if (n_ % 2 == 0) {
+      const int64_t h = n_ / 2;
+      tw_.resize(h + 1);
+      for (int64_t k = 0; k <= h; k++) {
+        tw_[k] = detail::unit_root<T>(k, n_);
+      }
+    }
+  }
+
+  int64_t length() const {
+    return n_;
+  }
+
+  int64_t scratch_size() const {
+    return plan_.length() + plan_.scratch_size();
+  }
+
+  // in: n real values, out: n / 2 + 1 complex values
+  void forward(const T* in, cmplx<T>* out, cmplx<T>* scratch, T fct) const {
+    const int64_t h = n_ / 2;
+    cmplx<T>* z = scratch;
+    cmplx<T>* tmp = scratch + plan_.length();
+    if (n_ % 2 != 0) {
+      for (int64_t t = 0; t < n_; t++) {
+        z[t] = cmplx<T>(in[t], 0);
+      }
+      plan_.exec(z, tmp, /*forward=*/true, fct);
+      std::copy(z, z + h + 1, out);
+      return;
+    }
+    // Pack even and odd samples as the real and imaginary parts of a half
+    // length signal z = e + i * o, then split Z into E and O using
+    // E[k] = (Z[k] + conj(Z[h - k])) / 2, O[k] = (Z[k] - conj(Z[h - k])) / 2i,
+    // and combine X[k] = E[k] + W_n^k * O[k].
+    for (int64_t t = 0; t < h; t++) {
+      z[t] = cmplx<T>(in[2 * t], in[2 * t + 1]);
+    }
+    plan_.exec(z, tmp, /*forward=*/true, 1);
+    const T half = static_cast<T>(0.5) * fct;
+    for (int64_t k = 0; k <= h; k++) {
+      const cmplx<T> zk = z[k == h ? 0 : k];
+      const cmplx<T> zc = std::conj(z[k == 0 ? 0 : h - k]);
+      const cmplx<T> e = (zk + zc) * half;
+      const cmplx<T> o = detail::rot90<true>(zk - zc) * half;
+      out[k] = e + tw_[k] * o;
+    }
+  }
+
+  // in: n / 2 + 1 complex values, out: n real values
+  void backward(const cmplx<T>* in, T* out, cmplx<T>* scratch, T fct) const {
+    const int64_t h = n_ / 2;
+    cmplx<T>* z = scratch;
+    cmplx<T>* tmp = scratch + plan_.length();
+    if (n_ % 2 != 0) {
+      z[0] = in[0];
+      for (int64_t k = 1; k <= h; k++) {
+        z[k] = in[k];
+        z[n_ - k] = std::conj(in[k]);
+      }
+      plan_.exec(z, tmp, /*forward=*/false, fct);
+      for (int64_t t = 0; t < n_; t++) {
+        out[t] = z[t].real();
+      }
+      return;
+    }
+    // Inverse of the packing in `forward`: rebuild Z = 2 * (E + i * O) and
+    // run a half length backward transform. The factor 2 makes the result
+    // match an unnormalized backward transform of length n.
+    for (int64_t k = 0; k < h; k++) {
+      const cmplx<T> xk = in[k];
+      const cmplx<T> xc = std::conj(in[h - k]);
+      const cmplx<T> e = xk + xc;
+      const cmplx<T> o = (xk - xc) * std::conj(tw_[k]);
+      z[k] = e + detail::rot90<false>(o);
+    }
+    plan_.exec(z, tmp, /*forward=*/false, fct);
+    for (int64_t t = 0; t < h; t++) {
+      out[2 * t] = z[t].real();
+      out[2 * t + 1] = z[t].imag();
+    }
+  }
+
+ private:
+  int64_t n_;
+  CFFTPlan<T> plan_;
+  std::vector<cmplx<T>> tw_;
+};
+
+// Multi-dimensional drivers. Arrays are described by a shape and element
+// strides (in units of the element type, i.e., cmplx<T> for complex arrays).
+// The 1-D transform along `axis` is applied to every line of the array, and
+// lines are distributed over threads.
+
+namespace detail {
+
+// Offset of the start of line `line` when enumerating all dimensions but
+// `axis` in row-major order.
+inline int64_t line_offset(int64_t line, const std::vector<int64_t>& shape,
+                           const std::vector<int64_t>& strides, int64_t axis) {
+  int64_t offset = 0;
+  for (int64_t d = static_cast<int64_t>(shape.size()) - 1; d >= 0; d--) {
+    if (d == axis) {
+      continue;
+    }
+    offset += (line % shape[d]) * strides[d];
+    line /= shape[d];
+  }
+  return offset;
+}
+
+template <typename Func>
+inline void parallel_lines(const std::vector<int64_t>& shape, int64_t axis,
+                           int64_t work_per_line, const Func& f) {
+  int64_t nlines = 1;
+  for (size_t d = 0; d < shape.size(); d++) {
+    if (static_cast<int64_t>(d) != axis) {
+      nlines *= shape[d];
+    }
+  }
+  const int64_t grain = std::max<int64_t>(1, 32768 / std::max<int64_t>(1, work_per_line));
+  at::parallel_for(0, nlines, grain, f);
+}
+
+} // namespace detail
+
+// Complex-to-complex transform along `axis`. `in` and `out` may alias.
+template <typename T>
+void c2c(const cmplx<T>* in, const std::vector<int64_t>& istrides,
+         cmplx<T>* out, const std::vector<int64_t>& ostrides,
+         const std::vector<int64_t>& shape, int64_t axis,
+         const CFFTPlan<T>& plan, bool forward, T fct) {
+  const int64_t len = shape[axis];
+  const int64_t is = istrides[axis], os = ostrides[axis];
+  detail::parallel_lines(shape, axis, len, [&](int64_t begin, int64_t end) {
+    std::vector<cmplx<T>> buf(len + plan.scratch_size());
+    cmplx<T>* line = buf.data();
+    cmplx<T>* scratch = buf.data() + len;
+    for (int64_t l = begin; l < end; l++) {
+      const cmplx<T>* src = in + detail::line_offset(l, shape, istrides, axis);
+      cmplx<T>* dst = out + detail::line_offset(l, shape, ostrides, axis);
+      if (src == dst && os == 1) {
+        plan.exec(dst, scratch, forward, fct);
+        continue;
+      }
+      for (int64_t i = 0; i < len; i++) {
+        line[i] = src[i * is];
+      }
+      plan.exec(line, scratch, forward, fct);
+      for (int64_t i = 0; i < len; i++) {
+        dst[i * os] = line[i];
+      }
+    }
+  });
+}
+
+// Real-to-complex forward transform along `axis`. `shape` is the shape of
+// the real input; the output has shape[axis] / 2 + 1 elements along `axis`.
+template <typename T>
+void r2c(const T* in, const std::vector<int64_t>& istrides,
+         cmplx<T>* out, const std::vector<int64_t>& ostrides,
+         const std::vector<int64_t>& shape, int64_t axis,
+         const RFFTPlan<T>& plan, T fct) {
+  const int64_t len = shape[axis];
+  const int64_t olen = len / 2 + 1;
+  const int64_t is = istrides[axis], os = ostrides[axis];
+  detail::parallel_lines(shape, axis, len, [&](int64_t begin, int64_t end) {
+    std::vector<T> rbuf(len);
+    std::vector<cmplx<T>> cbuf(olen + plan.scratch_size());
+    cmplx<T>* line = cbuf.data();
+    cmplx<T>* scratch = cbuf.data() + olen;
+    for (int64_t l = begin; l < end; l++) {
+      const T* src = in + detail::line_offset(l, shape, istrides, axis);
+      cmplx<T>* dst = out + detail::line_offset(l, shape, ostrides, axis);
+      for (int64_t i = 0; i < len; i++) {
+        rbuf[i] = src[i * is];
+      }
+      plan.forward(rbuf.data(), line, scratch, fct);
+      for (int64_t i = 0; i < olen; i++) {
+        dst[i * os] = line[i];
+      }
+    }
+  });
+}
+
+// Complex-to-real backward transform along `axis`. `shape` is the shape of
+// the real output; only the first shape[axis] / 2 + 1 input elements along
+// `axis` are read.
+template <typename T>
+void c2r(const cmplx<T>* in, const std::vector<int64_t>& istrides,
+         T* out, const std::vector<int64_t>& ostrides,
+         const std::vector<int64_t>& shape, int64_t axis,
+         const RFFTPlan<T>& plan, T fct) {
+  const int64_t len = shape[axis];
+  const int64_t ilen = len / 2 + 1;
+  const int64_t is = istrides[axis], os = ostrides[axis];
+  detail::parallel_lines(shape, axis, len, [&](int64_t begin, int64_t end) {
+    std::vector<T> rbuf(len);
+    std::vector<cmplx<T>> cbuf(ilen + plan.scratch_size());
+    cmplx<T>* line = cbuf.data();
+    cmplx<T>* scratch = cbuf.data() + ilen;
+    for (int64_t l = begin; l < end; l++) {
+      const cmplx<T>* src = in + detail::line_offset(l, shape, istrides, axis);
+      T* dst = out + detail::line_offset(l, shape, ostrides, axis);
+      for (int64_t i = 0; i < ilen; i++) {
+        line[i] = src[i * is];
+      }
+      plan.backward(line, rbuf.data(), scratch, fct);
+      for (int64_t i = 0; i < len; i++) {
+        dst[i * os] = rbuf[i];
+      }
+    }
+  });
+}
+
+}}} // namespace at::native::pocketfft
@@ -1,14 +1,21 @@
 #include <ATen/native/RNN.h>
 
 #include <ATen/ATen.h>
+#include <ATen/Config.h>
 #include <ATen/NativeFunctions.h>
+#include <ATen/core/grad_mode.h>
 #include <ATen/core/op_registration/op_registration.h>
 #include <ATen/cpp_custom_type_hack.h>
+#include <ATen/native/CPUBlas.h>
 #include <ATen/native/quantized/cpu/packed_params.h>
 #include <ATen/native/quantized/cpu/fbgemm_utils.h>
 #include <ATen/native/quantized/cpu/qnnpack_utils.h>
 #include <torch/custom_class.h>
 
+#if AT_MKL_ENABLED()
+#include <mkl.h>
+#endif
+
 torch::class_<LinearPackedParamsBase> register_linear_params();
 
 namespace at { namespace native {
@@ -768,6 +775,257 @@ struct LayerOutput {
   hidden_type final_hidden;
 };
 
+////////////////////////////////////////////////////////////////////////////////
+// FUSED CPU CELLS
+//
+// NOTE [ Fused CPU RNN cells ]
+//
+// On CPU, the cells above run every timestep as a handful of separate ATen
+// calls (linear, chunk, sigmoid, tanh, mul, add), each of which goes through
+// the dispatcher and allocates its result. For small batches this overhead
+// dominates the actual math. When no gradient is needed, FullLayer instead
+// runs LSTM and GRU layers through the loops below, which for each timestep
+//   1. accumulate h @ w_hh^T into a preallocated gates buffer with one gemm
+//      against a recurrent weight that is prepacked once per forward, and
+//   2. apply all gate nonlinearities and the state update in one vectorized
+//      pass (lstm_cell_pointwise_stub / gru_cell_pointwise_stub in
+//      native/cpu/RNNKernel.cpp), writing the new hidden state directly into
+//      the layer output.
+// No tensor is allocated inside the timestep loop.
+
+// Recurrent weight prepared for the per-step product h @ w_hh^T, where h is
+// [batch, hidden] and w_hh is [gates * hidden, hidden]. With MKL, float
+// weights are converted once into MKL's packed GEMM format, so that the
+// weight is not reformatted by every timestep's gemm.
+template <typename scalar_t>
+struct PackedRecurrentWeight {
+  PackedRecurrentWeight(const Tensor& w_hh, int64_t batch)
+      : weight_(w_hh.contiguous()),
+        batch_(batch),
+        gates_(w_hh.size(0)),
+        hidden_(w_hh.size(1)) {}
+
+  // out[batch, gates * hidden] = beta * out + h @ w_hh^T
+  void addmm_(scalar_t* out, const scalar_t* h, scalar_t beta) const {
+    // column-major: out^T = w_hh * h^T
+    cpublas::gemm(
+        cpublas::Transpose, cpublas::NoTranspose,
+        gates_, batch_, hidden_,
+        static_cast<scalar_t>(1),
+        weight_.data_ptr<scalar_t>(), hidden_,
+        h, hidden_,
+        beta,
+        out, gates_);
+  }
+
+  Tensor weight_;
+  int64_t batch_;
+  int64_t gates_;
+  int64_t hidden_;
+};
+
+#if AT_MKL_ENABLED()
+template <>
+struct PackedRecurrentWeight<float> {
+  PackedRecurrentWeight(const Tensor& w_hh, int64_t batch)
+      : batch_(batch), gates_(w_hh.size(0)), hidden_(w_hh.size(1)) {
+    auto weight = w_hh.contiguous();
+    const size_t packed_size = cblas_sgemm_pack_get_size(
+        CblasBMatrix, batch_, gates_, hidden_);
+    packed_ = at::empty(
+        {static_cast<int64_t>((packed_size + sizeof(float) - 1) / sizeof(float))},
+        w_hh.options());
+    // row-major: out = h * B with B = w_hh^T, packed with alpha = 1
+    cblas_sgemm_pack(
+        CblasRowMajor, CblasBMatrix, CblasTrans,
+        batch_, gates_, hidden_,
+        1.0f, weight.data_ptr<float>(), hidden_,
+        packed_.data_ptr<float>());
+  }
+
+  void addmm_(float* out, const float* h, float beta) const {
+    cblas_sgemm_compute(
+        CblasRowMajor, CblasNoTrans, CblasPacked,
+        batch_, gates_, hidden_,
+        h, hidden_,
+        packed_.data_ptr<float>(), gates_,
+        beta,
+        out, gates_);
+  }
+
+  Tensor packed_;
+  int64_t batch_;
+  int64_t gates_;
+  int64_t hidden_;
+};
+#endif
+
+bool use_fused_cpu_cell(
+    const Tensor& inputs_w,
+    const Tensor& hx,
+    const Tensor& cx,
+    const CellParams& params,
+    int64_t num_gates) {
+  if (!inputs_w.device().is_cpu() || inputs_w.dim() != 3 || hx.dim() != 2 ||
+      params.w_hh.dim() != 2) {
+    return false;
+  }
+  // Shape errors are left to the unfused path, which reports them properly.
+  const int64_t batch = inputs_w.size(1);
+  const int64_t hidden = hx.size(1);
+  if (batch == 0 || hidden == 0 || hx.size(0) != batch ||
+      inputs_w.size(2) != num_gates * hidden ||
+      params.w_hh.size(0) != num_gates * hidden ||
+      params.w_hh.size(1) != hidden ||
+      (cx.defined() && !cx.sizes().equals(hx.sizes())) ||
+      (params.b_hh_.defined() && params.b_hh_.numel() != num_gates * hidden)) {
+    return false;
+  }
+  const auto dtype = inputs_w.scalar_type();
+  if (dtype != kFloat && dtype != kDouble) {
+    return false;
+  }
+  const bool grad_mode = at::GradMode::is_enabled();
+  for (const Tensor* t : {&inputs_w, &hx, &cx, &params.w_hh, &params.b_hh_}) {
+    if (!t->defined()) {
+      continue;
+    }
+    if (t->layout() != kStrided || t->scalar_type() != dtype ||
+        !t->device().is_cpu() || (grad_mode && t->requires_grad())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename scalar_t>
+LayerOutput<Tensor, tpair_of<Tensor>> fused_lstm_layer_cpu(
+    const Tensor& inputs_w,
+    const tpair_of<Tensor>& input_hidden,
+    const CellParams& params,
+    bool reverse) {
+  const int64_t seq_len = inputs_w.size(0);
+  const int64_t batch = inputs_w.size(1);
+  const int64_t hidden = std::get<0>(input_hidden).size(1);
+  const int64_t gates_size = 4 * hidden;
+
+  const PackedRecurrentWeight<scalar_t> w_hh(params.w_hh, batch);
+  // input projections of all steps with both biases folded in, the recurrent
+  // projection is accumulated into it step by step
+  Tensor gates = at::empty({seq_len, batch, gates_size}, inputs_w.options());
+  if (params.b_hh_.defined()) {
+    at::add_out(gates, inputs_w, params.b_hh_);
+  } else {
+    gates.copy_(inputs_w);
+  }
+  Tensor output = at::empty({seq_len, batch, hidden}, inputs_w.options());
+  Tensor hx = std::get<0>(input_hidden).contiguous();
+  Tensor cy = std::get<1>(input_hidden).clone(at::MemoryFormat::Contiguous);
+
+  scalar_t* gates_data = gates.data_ptr<scalar_t>();
+  scalar_t* output_data = output.data_ptr<scalar_t>();
+  scalar_t* cy_data = cy.data_ptr<scalar_t>();
+  const scalar_t* h_prev = hx.data_ptr<scalar_t>();
+  int64_t t = reverse ? seq_len - 1 : 0;
+  for (int64_t step = 0; step < seq_len; step++) {
+    scalar_t* step_gates = gates_data + t * batch * gates_size;
+    scalar_t* hy = output_data + t * batch * hidden;
+    w_hh.addmm_(step_gates, h_prev, static_cast<scalar_t>(1));
+    lstm_cell_pointwise_stub(
+        kCPU, inputs_w.scalar_type(), batch, hidden, step_gates, cy_data,
+        hy, cy_data);
+    h_prev = hy;
+    t += reverse ? -1 : 1;
+  }
+  const int64_t last = reverse ? 0 : seq_len - 1;
+  Tensor hy = seq_len > 0 ? output.select(0, last) : hx;
+  return {output, std::make_tuple(std::move(hy), std::move(cy))};
+}
+
+template <typename scalar_t>
+LayerOutput<Tensor, Tensor> fused_gru_layer_cpu(
+    const Tensor& inputs_w,
+    const Tensor& input_hidden,
+    const CellParams& params,
+    bool reverse) {
+  const int64_t seq_len = inputs_w.size(0);
+  const int64_t batch = inputs_w.size(1);
+  const int64_t hidden = input_hidden.size(1);
+  const int64_t gates_size = 3 * hidden;
+
+  const PackedRecurrentWeight<scalar_t> w_hh(params.w_hh, batch);
+  // b_hh can't be folded into the input projection because the reset gate
+  // multiplies the hidden part of the new gate, so it is added by the kernel
+  Tensor igates = inputs_w.contiguous();
+  Tensor b_hh = params.b_hh_.defined() ? params.b_hh_.contiguous() : Tensor();
+  Tensor hgates = at::empty({batch, gates_size}, inputs_w.options());
+  Tensor output = at::empty({seq_len, batch, hidden}, inputs_w.options());
+  Tensor hx = input_hidden.contiguous();
+
+  const scalar_t* igates_data = igates.data_ptr<scalar_t>();
+  const scalar_t* b_hh_data = b_hh.defined() ? b_hh.data_ptr<scalar_t>() : nullptr;
+  scalar_t* hgates_data = hgates.data_ptr<scalar_t>();
+  scalar_t* output_data = output.data_ptr<scalar_t>();
+  const scalar_t* h_prev = hx.data_ptr<scalar_t>();
+  int64_t t = reverse ? seq_len - 1 : 0;
+  for (int64_t step = 0; step < seq_len; step++) {
+    scalar_t* hy = output_data + t * batch * hidden;
+    w_hh.addmm_(hgates_data, h_prev, static_cast<scalar_t>(0));
+    gru_cell_pointwise_stub(
+        kCPU, inputs_w.scalar_type(), batch, hidden,
+        igates_data + t * batch * gates_size, hgates_data, b_hh_data,
+        h_prev, hy);
+    h_prev = hy;
+    t += reverse ? -1 : 1;
+  }
+  const int64_t last = reverse ? 0 : seq_len - 1;
+  Tensor hy = seq_len > 0 ? output.select(0, last) : hx;
+  return {output, std::move(hy)};
+}
+
+// Runs a whole layer through the fused path if `cell` and the arguments allow
+// it. `inputs_w` holds the input projections of all steps. Steps run in
+// reverse order if `reverse` is set, outputs are always in input order.
+template <typename hidden_type, typename cell_params>
+c10::optional<LayerOutput<Tensor, hidden_type>> fused_cpu_layer(
+    const Cell<hidden_type, cell_params>& /* cell */,
+    const Tensor& /* inputs_w */,
+    const hidden_type& /* input_hidden */,
+    const cell_params& /* params */,
+    bool /* reverse */) {
+  return c10::nullopt;
+}
+
+c10::optional<LayerOutput<Tensor, tpair_of<Tensor>>> fused_cpu_layer(
+    const Cell<tpair_of<Tensor>, CellParams>& cell,
+    const Tensor& inputs_w,
+    const tpair_of<Tensor>& input_hidden,
+    const CellParams& params,
+    bool reverse) {
+  if (!dynamic_cast<const LSTMCell<CellParams>*>(&cell) ||
+      !use_fused_cpu_cell(inputs_w, std::get<0>(input_hidden), std::get<1>(input_hidden), params, 4)) {
+    return c10::nullopt;
+  }
+  return AT_DISPATCH_FLOATING_TYPES(inputs_w.scalar_type(), "fused_lstm_layer_cpu", [&] {
+    return fused_lstm_layer_cpu<scalar_t>(inputs_w, input_hidden, params, reverse);
+  });
+}
+
+c10::optional<LayerOutput<Tensor, Tensor>> fused_cpu_layer(
+    const Cell<Tensor, CellParams>& cell,
+    const Tensor& inputs_w,
+    const Tensor& input_hidden,
+    const CellParams& params,
+    bool reverse) {
+  if (!dynamic_cast<const GRUCell<CellParams>*>(&cell) ||
+      !use_fused_cpu_cell(inputs_w, input_hidden, Tensor(), params, 3)) {
+    return c10::nullopt;
+  }
+  return AT_DISPATCH_FLOATING_TYPES(inputs_w.scalar_type(), "fused_gru_layer_cpu", [&] {
+    return fused_gru_layer_cpu<scalar_t>(inputs_w, input_hidden, params, reverse);
+  });
+}
+
 template<typename io_type, typename hidden_type, typename param_type>
 struct Layer {
   using output_type = LayerOutput<io_type, hidden_type>;
@@ -803,16 +1061,35 @@ struct FullLayer : Layer<Tensor, hidden_type, cell_params> {
     return {step_outputs, hidden};
   }
 
+  // CPU path: the input projections of all steps have been computed with a
+  // single linear call. Steps run in reverse order if `reverse` is set,
+  // outputs are always in input order.
+  output_type precomputed_input(
+      const Tensor& inputs_w,
+      const hidden_type& input_hidden,
+      const cell_params& params,
+      bool reverse = false) const {
+    if (auto fused = fused_cpu_layer(cell_, inputs_w, input_hidden, params, reverse)) {
+      return std::move(*fused);
+    }
+    auto step_inputs = inputs_w.unbind(0);
+    if (reverse) {
+      std::reverse(step_inputs.begin(), step_inputs.end());
+    }
+    auto unstacked_output = (*this)(step_inputs, input_hidden, params, true);
+    if (reverse) {
+      std::reverse(unstacked_output.outputs.begin(), unstacked_output.outputs.end());
+    }
+    return {at::stack(unstacked_output.outputs, 0),
+            unstacked_output.final_hidden};
+  }
+
   output_type operator()(
       const Tensor& inputs,
       const hidden_type& input_hidden,
       const cell_params& params) const override {
     if (inputs.device().is_cpu()) {
-      const auto inputs_w = params.linear_ih(inputs);
-      auto unstacked_output =
-          (*this)(inputs_w.unbind(0), input_hidden, params, true);
-      return {at::stack(unstacked_output.outputs, 0),
-              unstacked_output.final_hidden};
+      return precomputed_input(params.linear_ih(inputs), input_hidden, params);
     }
     auto unstacked_output = (*this)(inputs.unbind(0), input_hidden, params);
     return {at::stack(unstacked_output.outputs, 0),
@@ -838,19 +1115,12 @@ struct FullBidirectionalLayer
       const param_type& params) const override {
     std::vector<Tensor> step_inputs;
     if (input.device().is_cpu()) {
-      auto input_w = params.first.linear_ih(input);
-      step_inputs = input_w.unbind(0);
-      auto fw_result = layer_(
-          step_inputs, input_hidden.first, params.first, true);
-      auto fw_output = at::stack(fw_result.outputs, 0);
-      input_w = params.second.linear_ih(input);
-      step_inputs = input_w.unbind(0);
-      auto rev_step_inputs = reverse(std::move(step_inputs));
-      auto rev_result =
-          layer_(rev_step_inputs, input_hidden.second, params.second, true);
-      std::reverse(rev_result.outputs.begin(), rev_result.outputs.end());
-      auto rev_output = at::stack(rev_result.outputs, 0);
-      return {at::cat({fw_output, rev_output}, fw_output.dim() - 1),
+      auto fw_result = layer_.precomputed_input(
+          params.first.linear_ih(input), input_hidden.first, params.first);
+      auto rev_result = layer_.precomputed_input(
+          params.second.linear_ih(input), input_hidden.second, params.second,
+          /*reverse=*/true);
+      return {at::cat({fw_result.outputs, rev_result.outputs}, fw_result.outputs.dim() - 1),
               std::make_pair(fw_result.final_hidden, rev_result.final_hidden)};
     }
 
@@ -1383,6 +1653,9 @@ ONE_HIDDEN_RNN(rnn_tanh, tanf_cell_type)
 using relu_cell_type = SimpleCell<relu_f, CellParams>;
 ONE_HIDDEN_RNN(rnn_relu, relu_cell_type);
 
+DEFINE_DISPATCH(lstm_cell_pointwise_stub);
+DEFINE_DISPATCH(gru_cell_pointwise_stub);
+
 DEFINE_DISPATCH(lstm_cudnn_stub);
 DEFINE_DISPATCH(lstm_packed_cudnn_stub);
 DEFINE_DISPATCH(lstm_miopen_stub);
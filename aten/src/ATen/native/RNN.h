@@ -27,6 +27,16 @@ DECLARE_DISPATCH(rnn_packed_fn, rnn_tanh_packed_miopen_stub);
 DECLARE_DISPATCH(rnn_packed_fn, rnn_relu_packed_cudnn_stub);
 DECLARE_DISPATCH(rnn_packed_fn, rnn_relu_packed_miopen_stub);
 
+// Pointwise part of the fused CPU LSTM and GRU cells, operating on contiguous
+// [batch, gates * hidden] buffers. See NOTE [ Fused CPU RNN cells ] in RNN.cpp.
+//   lstm: (dtype, batch, hidden, gates, cx, hy, cy), cy may alias cx
+//   gru: (dtype, batch, hidden, igates, hgates, b_hh (nullable), hx, hy)
+using lstm_cell_pointwise_fn = void(*)(ScalarType, int64_t, int64_t, const void*, const void*, void*, void*);
+using gru_cell_pointwise_fn = void(*)(ScalarType, int64_t, int64_t, const void*, const void*, const void*, const void*, void*);
+
+DECLARE_DISPATCH(lstm_cell_pointwise_fn, lstm_cell_pointwise_stub);
+DECLARE_DISPATCH(gru_cell_pointwise_fn, gru_cell_pointwise_stub);
+
 inline void check_device(const Tensor& input, const TensorList& params, const TensorList& hiddens) {
   auto input_device = input.device();
 
@@ -29,7 +29,8 @@ Tensor fft_fft(const Tensor& self) {
 
 // This is a pass-through wrapper function that does the size check and
 // inferences. The actual forward implementation function is called
-// at::_fft_with_size which dispatches to _fft_cufft (CUDA) or _fft_mkl (CPU).
+// at::_fft_with_size which dispatches to _fft_cufft (CUDA) or _fft_mkl (CPU,
+// which falls back to pocketfft when ATen is not compiled with MKL).
 static inline Tensor _fft(const Tensor &self, const int64_t signal_ndim,
            const bool complex_input, const bool complex_output,
            const bool inverse, IntArrayRef signal_sizes, const bool normalized,
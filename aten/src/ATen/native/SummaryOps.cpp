@@ -2,11 +2,163 @@
 
 #include <ATen/ATen.h>
 #include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <tuple>
+#include <vector>
 
 namespace at { namespace native {
 
+///////////////// histogram engine /////////////////
+namespace {
+
+// NOTE [ CPU histogram engine ]
+//
+// bincount, histc and histogramdd all reduce to the same loop: every sample
+// of every row of the input is mapped to a flat bin index (or to -1 if it
+// falls outside of all bins) and its weight, or 1 if there are no weights, is
+// added to that bin of the row's histogram.
+//
+// histogram_cpu_kernel parallelizes that loop in one of two ways:
+//   - With at least as many rows as threads, whole rows are distributed over
+//     the threads. Every row is accumulated serially into its own histogram,
+//     so there is nothing to merge.
+//   - Otherwise every row is split into a fixed number of chunks, each of
+//     which is accumulated into private bins, which are summed into the
+//     row's histogram at the end. The chunking only depends on the number of
+//     threads, so results are deterministic for a given thread count. Private
+//     bins are only used if the row is large compared to the number of bins;
+//     initializing and merging them would dominate otherwise.
+
+// bin_fn(row, i) returns the bin of sample i of the given row, or -1.
+template <typename hist_t, typename BinFn>
+inline void histogram_accumulate(
+    hist_t* hist,
+    const hist_t* weights,
+    int64_t row,
+    int64_t begin,
+    int64_t end,
+    const BinFn& bin_fn) {
+  if (weights) {
+    for (int64_t i = begin; i < end; i++) {
+      const int64_t bin = bin_fn(row, i);
+      if (bin >= 0) {
+        hist[bin] += weights[i];
+      }
+    }
+  } else {
+    for (int64_t i = begin; i < end; i++) {
+      const int64_t bin = bin_fn(row, i);
+      if (bin >= 0) {
+        hist[bin] += 1;
+      }
+    }
+  }
+}
+
+// Accumulates `rows` histograms of `nbins` bins each into hist, which must be
+// zero initialized. weights is either nullptr or holds rows * row_size
+// weights. See NOTE [ CPU histogram engine ].
+template <typename hist_t, typename BinFn>
+void histogram_cpu_kernel(
+    hist_t* hist,
+    int64_t rows,
+    int64_t row_size,
+    int64_t nbins,
+    const hist_t* weights,
+    const BinFn& bin_fn) {
+  if (rows == 0 || row_size == 0) {
+    return;
+  }
+  const int64_t num_threads = at::get_num_threads();
+  if (rows >= num_threads) {
+    const int64_t grain_size = divup(internal::GRAIN_SIZE, row_size);
+    at::parallel_for(0, rows, grain_size, [&](int64_t start, int64_t end) {
+      for (int64_t row = start; row < end; row++) {
+        histogram_accumulate(
+            hist + row * nbins,
+            weights ? weights + row * row_size : nullptr,
+            row, 0, row_size, bin_fn);
+      }
+    });
+    return;
+  }
+
+  const int64_t num_chunks =
+      std::min(num_threads, divup(row_size, internal::GRAIN_SIZE));
+  if (num_chunks <= 1 || nbins * num_chunks > row_size) {
+    for (int64_t row = 0; row < rows; row++) {
+      histogram_accumulate(
+          hist + row * nbins,
+          weights ? weights + row * row_size : nullptr,
+          row, 0, row_size, bin_fn);
+    }
+    return;
+  }
+
+  const int64_t chunk_size = divup(row_size, num_chunks);
+  std::vector<hist_t> private_hist(num_chunks * nbins);
+  for (int64_t row = 0; row < rows; row++) {
+    std::fill(private_hist.begin(), private_hist.end(), hist_t(0));
+    const hist_t* row_weights = weights ? weights + row * row_size : nullptr;
+    at::parallel_for(0, num_chunks, 1, [&](int64_t start, int64_t end) {
+      for (int64_t chunk = start; chunk < end; chunk++) {
+        const int64_t begin = chunk * chunk_size;
+        histogram_accumulate(
+            private_hist.data() + chunk * nbins, row_weights, row,
+            begin, std::min(row_size, begin + chunk_size), bin_fn);
+      }
+    });
+    hist_t* row_hist = hist + row * nbins;
+    at::parallel_for(0, nbins, divup(internal::GRAIN_SIZE, num_chunks), [&](int64_t start, int64_t end) {
+      for (int64_t bin = start; bin < end; bin++) {
+        hist_t sum = row_hist[bin];
+        for (int64_t chunk = 0; chunk < num_chunks; chunk++) {
+          sum += private_hist[chunk * nbins + bin];
+        }
+        row_hist[bin] = sum;
+      }
+    });
+  }
+}
+
+// nbins bins of equal width over [min, max]. The last bin includes max.
+template <typename scalar_t>
+struct UniformBinner {
+  scalar_t min_;
+  scalar_t max_;
+  int64_t nbins_;
+
+  int64_t operator()(scalar_t x) const {
+    if (!(x >= min_ && x <= max_)) {
+      return -1;
+    }
+    const int64_t bin = static_cast<int64_t>((x - min_) / (max_ - min_) * nbins_);
+    return std::min(bin, nbins_ - 1);
+  }
+};
+
+// Bins given by nbins + 1 increasing edges; bin i is [edges[i], edges[i + 1]),
+// except for the last bin, which includes its right edge.
+template <typename scalar_t>
+struct EdgesBinner {
+  const scalar_t* edges_;
+  int64_t nbins_;
+
+  int64_t operator()(scalar_t x) const {
+    if (!(x >= edges_[0] && x <= edges_[nbins_])) {
+      return -1;
+    }
+    const int64_t bin = std::upper_bound(edges_, edges_ + nbins_ + 1, x) - edges_ - 1;
+    return std::min(bin, nbins_ - 1);
+  }
+};
+
+} // namespace
+
 ///////////////// bincount /////////////////
 namespace {
 
@@ -36,19 +188,18 @@ Tensor _bincount_cpu_template(
   nbins = std::max(nbins, minlength); // at least minlength # of bins
 
   const input_t* self_p = self.data_ptr<input_t>();
+  auto bin_fn = [self_p](int64_t /* row */, int64_t i) {
+    return static_cast<int64_t>(self_p[i]);
+  };
   if (has_weights) {
     output = native::zeros({nbins}, weights.options());
-    weights_t* output_p = output.data_ptr<weights_t>();
-    const weights_t* weights_p = weights.data_ptr<weights_t>();
-    for (int64_t i = 0; i < self_size; i++) {
-      output_p[self_p[i]] += weights_p[i];
-    }
+    histogram_cpu_kernel<weights_t>(
+        output.data_ptr<weights_t>(), 1, self_size, nbins,
+        weights.data_ptr<weights_t>(), bin_fn);
   } else {
     output = native::zeros({nbins}, kLong);
-    int64_t* output_p = output.data_ptr<int64_t>();
-    for (int64_t i = 0; i < self_size; i++) {
-      output_p[self_p[i]] += 1L;
-    }
+    histogram_cpu_kernel<int64_t>(
+        output.data_ptr<int64_t>(), 1, self_size, nbins, nullptr, bin_fn);
   }
   return output;
 }
@@ -65,4 +216,236 @@ _bincount_cpu(const Tensor& self, const Tensor& weights, int64_t minlength) {
   });
 }
 
+///////////////// histc /////////////////
+namespace {
+
+// Writes the histogram into result, which must be a contiguous tensor of nbins
+// elements of the input's dtype.
+template <typename input_t>
+void _histc_cpu_template(
+    Tensor& result,
+    const Tensor& self,
+    int64_t nbins,
+    input_t min,
+    input_t max) {
+  input_t minvalue = min;
+  input_t maxvalue = max;
+  if (min == max) {
+    minvalue = *self.min().data_ptr<input_t>();
+    maxvalue = *self.max().data_ptr<input_t>();
+  }
+  if (minvalue == maxvalue) {
+    minvalue = minvalue - 1;
+    maxvalue = maxvalue + 1;
+  }
+
+  TORCH_CHECK(
+      !(std::isinf(minvalue) || std::isinf(maxvalue) || std::isnan(minvalue) ||
+        std::isnan(maxvalue)),
+      "range of [",
+      minvalue,
+      ", ",
+      maxvalue,
+      "] is not finite");
+  TORCH_CHECK(minvalue < maxvalue, "max must be larger than min");
+
+  const Tensor input = self.contiguous();
+  const input_t* input_p = input.data_ptr<input_t>();
+  const UniformBinner<input_t> binner{minvalue, maxvalue, nbins};
+  result.zero_();
+  histogram_cpu_kernel<input_t>(
+      result.data_ptr<input_t>(), 1, input.numel(), nbins, nullptr,
+      [&](int64_t /* row */, int64_t i) { return binner(input_p[i]); });
+}
+} // namespace
+
+Tensor histogram_histc_cpu(const Tensor& self, int64_t bins, Scalar min, Scalar max) {
+  Tensor result = at::empty({0}, self.options());
+  histogram_histc_cpu_out(result, self, bins, min, max);
+  return result;
+}
+
+Tensor& histogram_histc_cpu_out(Tensor& result, const Tensor& self, int64_t bins, Scalar min, Scalar max) {
+  if (bins <= 0) {
+    AT_ERROR("bins must be > 0");
+  }
+  // Only go through a temporary if result aliases the input or can not hold
+  // the histogram as is.
+  bool direct = !result.is_alias_of(self) &&
+      result.scalar_type() == self.scalar_type();
+  if (direct) {
+    result.resize_({bins});
+    direct = result.is_contiguous();
+  }
+  Tensor output = direct ? result : at::empty({bins}, self.options());
+  AT_DISPATCH_FLOATING_TYPES(self.scalar_type(), "histc_cpu", [&] {
+    _histc_cpu_template<scalar_t>(
+        output, self, bins, min.to<scalar_t>(), max.to<scalar_t>());
+  });
+  if (!direct) {
+    result.resize_({bins});
+    result.copy_(output);
+  }
+  return result;
+}
+
+///////////////// histogramdd /////////////////
+namespace {
+
+// Checks self and weight, returns the number of rows and the number of
+// samples per row. self holds samples of D values each, either as (N, D) or,
+// in batched mode, as (B, N, D) where every one of the B rows gets its own
+// histogram.
+std::tuple<int64_t, int64_t> histogramdd_check_inputs(
+    const Tensor& self,
+    const Tensor& weight,
+    int64_t num_bin_dims) {
+  TORCH_CHECK(self.dim() == 2 || self.dim() == 3,
+      "histogramdd: expected input of shape (N, D) or (B, N, D), but got ", self.sizes());
+  TORCH_CHECK(at::isFloatingType(self.scalar_type()),
+      "histogramdd: expected a floating point input, but got ", self.scalar_type());
+  TORCH_CHECK(num_bin_dims == self.size(-1),
+      "histogramdd: expected bins for each of the ", self.size(-1),
+      " dimensions of the samples, but got ", num_bin_dims);
+  if (weight.defined()) {
+    TORCH_CHECK(weight.sizes() == self.sizes().slice(0, self.dim() - 1),
+        "histogramdd: expected weight of shape ", self.sizes().slice(0, self.dim() - 1),
+        ", but got ", weight.sizes());
+    TORCH_CHECK(weight.scalar_type() == self.scalar_type(),
+        "histogramdd: expected weight to have dtype ", self.scalar_type(),
+        ", but got ", weight.scalar_type());
+  }
+  const int64_t rows = self.dim() == 3 ? self.size(0) : 1;
+  return std::make_tuple(rows, self.size(-2));
+}
+
+template <typename scalar_t, typename Binner>
+Tensor histogramdd_cpu_template(
+    const Tensor& self,
+    const Tensor& weight,
+    const std::vector<Binner>& binners,
+    IntArrayRef bin_counts) {
+  int64_t rows, row_size;
+  std::tie(rows, row_size) = histogramdd_check_inputs(self, weight, bin_counts.size());
+  const int64_t num_dims = bin_counts.size();
+
+  std::vector<int64_t> hist_sizes;
+  if (self.dim() == 3) {
+    hist_sizes.push_back(rows);
+  }
+  int64_t nbins = 1;
+  for (int64_t count : bin_counts) {
+    TORCH_CHECK(count > 0, "histogramdd: bins must be > 0, but got ", bin_counts);
+    TORCH_CHECK(nbins <= std::numeric_limits<int64_t>::max() / count,
+        "histogramdd: too many bins ", bin_counts);
+    nbins *= count;
+    hist_sizes.push_back(count);
+  }
+  Tensor hist = at::zeros(hist_sizes, self.options());
+
+  const Tensor input = self.contiguous();
+  const Tensor weights = weight.defined() ? weight.contiguous() : Tensor();
+  const scalar_t* input_p = input.data_ptr<scalar_t>();
+  histogram_cpu_kernel<scalar_t>(
+      hist.data_ptr<scalar_t>(), rows, row_size, nbins,
+      weights.defined() ? weights.data_ptr<scalar_t>() : nullptr,
+      [&](int64_t row, int64_t i) {
+        const scalar_t* sample = input_p + (row * row_size + i) * num_dims;
+        int64_t bin = 0;
+        for (int64_t d = 0; d < num_dims; d++) {
+          const int64_t dim_bin = binners[d](sample[d]);
+          if (dim_bin < 0) {
+            return int64_t(-1);
+          }
+          bin = bin * bin_counts[d] + dim_bin;
+        }
+        return bin;
+      });
+  return hist;
+}
+
+} // namespace
+
+Tensor histogramdd_cpu(
+    const Tensor& self,
+    IntArrayRef bins,
+    c10::optional<ArrayRef<double>> range,
+    const Tensor& weight) {
+  histogramdd_check_inputs(self, weight, bins.size());
+  const int64_t num_dims = bins.size();
+
+  // per dimension [min, max], from the samples of all rows unless given
+  std::vector<double> bounds(2 * num_dims);
+  if (range.has_value()) {
+    TORCH_CHECK(range->size() == 2 * bins.size(),
+        "histogramdd: expected a range of 2 values for each of the ", num_dims,
+        " dimensions, but got ", range->size(), " values");
+    std::copy(range->begin(), range->end(), bounds.begin());
+  } else if (self.numel() == 0) {
+    for (int64_t d = 0; d < num_dims; d++) {
+      bounds[2 * d] = 0;
+      bounds[2 * d + 1] = 1;
+    }
+  } else {
+    const Tensor samples = self.reshape({-1, num_dims});
+    const Tensor mins = std::get<0>(samples.min(0)).to(kDouble);
+    const Tensor maxs = std::get<0>(samples.max(0)).to(kDouble);
+    for (int64_t d = 0; d < num_dims; d++) {
+      bounds[2 * d] = mins[d].item<double>();
+      bounds[2 * d + 1] = maxs[d].item<double>();
+      // like histc
+      if (bounds[2 * d] == bounds[2 * d + 1]) {
+        bounds[2 * d] -= 1;
+        bounds[2 * d + 1] += 1;
+      }
+    }
+  }
+  for (int64_t d = 0; d < num_dims; d++) {
+    TORCH_CHECK(std::isfinite(bounds[2 * d]) && std::isfinite(bounds[2 * d + 1]),
+        "histogramdd: range of [", bounds[2 * d], ", ", bounds[2 * d + 1],
+        "] of dimension ", d, " is not finite");
+    TORCH_CHECK(bounds[2 * d] < bounds[2 * d + 1],
+        "histogramdd: max must be larger than min for dimension ", d);
+  }
+
+  return AT_DISPATCH_FLOATING_TYPES(self.scalar_type(), "histogramdd_cpu", [&] {
+    std::vector<UniformBinner<scalar_t>> binners;
+    for (int64_t d = 0; d < num_dims; d++) {
+      binners.push_back({static_cast<scalar_t>(bounds[2 * d]),
+                         static_cast<scalar_t>(bounds[2 * d + 1]),
+                         bins[d]});
+    }
+    return histogramdd_cpu_template<scalar_t>(self, weight, binners, bins);
+  });
+}
+
+Tensor histogramdd_edges_cpu(const Tensor& self, TensorList bins, const Tensor& weight) {
+  histogramdd_check_inputs(self, weight, bins.size());
+  std::vector<Tensor> edges;
+  std::vector<int64_t> bin_counts;
+  for (size_t d = 0; d < bins.size(); d++) {
+    TORCH_CHECK(bins[d].dim() == 1 && bins[d].size(0) >= 2,
+        "histogramdd: expected 1-d bin edges with at least 2 elements for dimension ",
+        d, ", but got a tensor of shape ", bins[d].sizes());
+    TORCH_CHECK(bins[d].scalar_type() == self.scalar_type() && bins[d].device().is_cpu(),
+        "histogramdd: expected bin edges of dimension ", d, " to be a CPU tensor of dtype ",
+        self.scalar_type());
+    edges.push_back(bins[d].contiguous());
+    bin_counts.push_back(bins[d].size(0) - 1);
+  }
+
+  return AT_DISPATCH_FLOATING_TYPES(self.scalar_type(), "histogramdd_cpu", [&] {
+    std::vector<EdgesBinner<scalar_t>> binners;
+    for (size_t d = 0; d < edges.size(); d++) {
+      const scalar_t* edges_p = edges[d].data_ptr<scalar_t>();
+      for (int64_t i = 0; i < bin_counts[d]; i++) {
+        TORCH_CHECK(edges_p[i] < edges_p[i + 1],
+            "histogramdd: bin edges of dimension ", d, " must be strictly increasing");
+      }
+      binners.push_back({edges_p, bin_counts[d]});
+    }
+    return histogramdd_cpu_template<scalar_t>(self, weight, binners, bin_counts);
+  });
+}
+
 }} // namespace at::native
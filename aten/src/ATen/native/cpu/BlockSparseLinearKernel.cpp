@@ -0,0 +1,148 @@
+#include <ATen/native/BlockSparseLinear.h>
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec256/functional.h>
+#include <ATen/cpu/vec256/vec256.h>
+
+namespace at { namespace native { namespace {
+
+// Below this batch size the kernels walk the input rows directly. From it on
+// they work on the transposed input, so that every weight value updates a
+// contiguous run of outputs that vectorizes over the batch.
+constexpr int64_t kBlockSparseTransposeBatch = 8;
+
+// y (M x rows) = x (M x cols) * w^T, accumulated in scalar_t.
+template <typename scalar_t, typename weight_t>
+void block_sparse_gemm(
+    const BlockSparseMatrix<weight_t>& w,
+    const scalar_t* x,
+    int64_t M,
+    scalar_t* y) {
+  const int64_t N = w.rows;
+  const int64_t K = w.cols;
+  const int64_t ob = w.out_block;
+  const int64_t ib = w.in_block;
+  const int32_t* row_ptr = w.row_ptr.data();
+  const int32_t* col_idx = w.col_idx.data();
+  const weight_t* values = w.values.data();
+
+  if (M < kBlockSparseTransposeBatch) {
+    at::parallel_for(0, w.block_rows(), 1, [&](int64_t begin, int64_t end) {
+      for (int64_t br = begin; br < end; ++br) {
+        for (int64_t m = 0; m < M; ++m) {
+          std::array<scalar_t, kBlockSparseMaxOutBlock> acc{};
+          const scalar_t* x_row = x + m * K;
+          for (int32_t p = row_ptr[br]; p < row_ptr[br + 1]; ++p) {
+            const weight_t* block = values + p * ob * ib;
+            const scalar_t* x_block = x_row + col_idx[p] * ib;
+            for (int64_t i = 0; i < ob; ++i) {
+              for (int64_t j = 0; j < ib; ++j) {
+                acc[i] += static_cast<scalar_t>(block[i * ib + j]) * x_block[j];
+              }
+            }
+          }
+          std::copy(acc.begin(), acc.begin() + ob, y + m * N + br * ob);
+        }
+      }
+    });
+    return;
+  }
+
+  using Vec = vec256::Vec256<scalar_t>;
+  std::vector<scalar_t> x_t(K * M);
+  std::vector<scalar_t> y_t(N * M, scalar_t(0));
+  at::parallel_for(0, K, 16, [&](int64_t begin, int64_t end) {
+    for (int64_t k = begin; k < end; ++k) {
+      for (int64_t m = 0; m < M; ++m) {
+        x_t[k * M + m] = x[m * K + k];
+      }
+    }
+  });
+
+  at::parallel_for(0, w.block_rows(), 1, [&](int64_t begin, int64_t end) {
+    for (int64_t br = begin; br < end; ++br) {
+      for (int32_t p = row_ptr[br]; p < row_ptr[br + 1]; ++p) {
+        const weight_t* block = values + p * ob * ib;
+        for (int64_t i = 0; i < ob; ++i) {
+          scalar_t* y_row = y_t.data() + (br * ob + i) * M;
+          for (int64_t j = 0; j < ib; ++j) {
+            const scalar_t w_val = static_cast<scalar_t>(block[i * ib + j]);
+            if (w_val == scalar_t(0)) {
+              continue;
+            }
+            const scalar_t* x_row = x_t.data() + (col_idx[p] * ib + j) * M;
+            const Vec w_vec(w_val);
+            int64_t m = 0;
+            for (; m + Vec::size() <= M; m += Vec::size()) {
+              (Vec::loadu(y_row + m) + w_vec * Vec::loadu(x_row + m))
+                  .store(y_row + m);
+            }
+            for (; m < M; ++m) {
+              y_row[m] += w_val * x_row[m];
+            }
+          }
+        }
+      }
+    }
+  });
+
+  at::parallel_for(0, M, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t m = begin; m < end; ++m) {
+      for (int64_t n = 0; n < N; ++n) {
+        y[m * N + n] = y_t[n * M + m];
+      }
+    }
+  });
+}
+
+void block_sparse_linear_kernel(
+    const BlockSparseMatrix<float>& weight,
+    const float* bias,
+    const float* input,
+    int64_t M,
+    float* output) {
+  block_sparse_gemm<float, float>(weight, input, M, output);
+  if (bias) {
+    const int64_t N = weight.rows;
+    at::parallel_for(0, M, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t m = begin; m < end; ++m) {
+        float* out_row = output + m * N;
+        vec256::map2(
+            [](vec256::Vec256<float> y, vec256::Vec256<float> b) { return y + b; },
+            out_row,
+            out_row,
+            bias,
+            N);
+      }
+    });
+  }
+}
+
+void block_sparse_linear_int8_kernel(
+    const BlockSparseMatrix<int16_t>& weight,
+    const uint8_t* input,
+    int64_t M,
+    int32_t input_zero_point,
+    int32_t* output) {
+  // Widen the input once, with its zero point removed, so that the GEMM only
+  // deals with int32.
+  const int64_t K = weight.cols;
+  std::vector<int32_t> input_int32(M * K);
+  at::parallel_for(0, M * K, 4096, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      input_int32[i] = static_cast<int32_t>(input[i]) - input_zero_point;
+    }
+  });
+  block_sparse_gemm<int32_t, int16_t>(weight, input_int32.data(), M, output);
+}
+
+} // anonymous namespace
+
+REGISTER_DISPATCH(block_sparse_linear_stub, &block_sparse_linear_kernel);
+REGISTER_DISPATCH(block_sparse_linear_int8_stub, &block_sparse_linear_int8_kernel);
+
+}} // namespace at::native
@@ -3,6 +3,8 @@
 #include <numeric>
 #include <iterator>
 #include <algorithm>
+#include <utility>
+#include <vector>
 
 #include <ATen/Dispatch.h>
 #include <ATen/Parallel.h>
@@ -10,6 +12,10 @@
 
 namespace at { namespace native { namespace {
 
+// Tile sizes of the forward cdist kernels, see Dist::cdist_tile_rows2.
+constexpr int64_t cdist_tile_rows1 = 16;
+constexpr int64_t cdist_tile_bytes = 32 * 1024;
+
 template<typename scalar_t>
 struct Dist {
   using Vec = vec256::Vec256<scalar_t>;
@@ -193,6 +199,30 @@ struct Dist {
     }
   }
 
+  // Computes the aggregates (the distances before F::finish) between rows
+  // [0, n1) of x1 and rows [0, n2) of x2 into out, which has leading
+  // dimension ld.
+  template <typename F>
+  inline static void cdist_tile(const scalar_t * x1, int64_t n1, const scalar_t * x2, int64_t n2, int64_t m, const Vec& pvec, scalar_t * out, int64_t ld) {
+    for (int64_t i = 0; i < n1; i++) {
+      const scalar_t * x1_i = x1 + i * m;
+      scalar_t * out_i = out + i * ld;
+      for (int64_t j = 0; j < n2; j++) {
+        out_i[j] = vec256::map2_reduce_all<scalar_t>(
+          [&pvec](Vec a, Vec b) { return F::map((a - b).abs(), pvec); },
+          F::red, x1_i, x2 + j * m, m);
+      }
+    }
+  }
+
+  // The distances are computed in tiles of cdist_tile_rows1 rows of x1 by
+  // cdist_tile_rows2(m) rows of x2. Each task owns a block of rows of x1 of
+  // one batch and sweeps over x2 tile by tile, so a tile of x2 is loaded into
+  // cache once and reused for every row of the block.
+  static int64_t cdist_tile_rows2(int64_t m) {
+    return std::max<int64_t>(1, cdist_tile_bytes / (m * static_cast<int64_t>(sizeof(scalar_t))));
+  }
+
   template <typename F>
   static void run_parallel_cdist(Tensor& result, const Tensor& t1, const Tensor& t2, const scalar_t p) {
     const scalar_t * const t1_start = t1.data_ptr<scalar_t>();
@@ -203,57 +233,137 @@ struct Dist {
     int64_t m = t1.size(-1);
 
     scalar_t * const res_start = result.data_ptr<scalar_t>();
-    int64_t combs = r1 * r2;
-    int64_t size1 = r1 * m;
-    int64_t size2 = r2 * m;
+    const int64_t rows2 = cdist_tile_rows2(m);
+    const int64_t blocks1 = divup(r1, cdist_tile_rows1);
 
-    parallel_for(0, combs * d, internal::GRAIN_SIZE / (16 * m), [=](int64_t start, int64_t end) {
-      scalar_t * res = res_start + start;
-      const scalar_t * const res_end = res_start + end;
-      int64_t l = start / combs;
-      int64_t k = start % combs;
-      int64_t i = k / r2;
-      int64_t j = k % r2;
-      i = i * m;
-      j = j * m;
+    parallel_for(0, d * blocks1, divup(internal::GRAIN_SIZE, cdist_tile_rows1 * r2 * m), [=](int64_t start, int64_t end) {
+      const Vec pvec(p);
+      for (int64_t b = start; b < end; b++) {
+        const int64_t l = b / blocks1;
+        const int64_t i = (b % blocks1) * cdist_tile_rows1;
+        const int64_t n1 = std::min(cdist_tile_rows1, r1 - i);
+        const scalar_t * x1 = t1_start + (l * r1 + i) * m;
+        scalar_t * res = res_start + (l * r1 + i) * r2;
+        for (int64_t j = 0; j < r2; j += rows2) {
+          cdist_tile<F>(x1, n1, t2_start + (l * r2 + j) * m, std::min(rows2, r2 - j), m, pvec, res + j, r2);
+        }
+        for (scalar_t * const res_end = res + n1 * r2; res != res_end; res++) {
+          *res = F::finish(*res, p);
+        }
+      }
+    });
+  }
 
-      while (res != res_end) {
-        const scalar_t * self_i = t1_start + size1 * l + i;
-        const scalar_t * self_j = t2_start + size2 * l + j;
-
-        scalar_t agg = 0;
-        for (int x = 0; x < m; x++) {
-          scalar_t a = *(self_i + x);
-          scalar_t b = *(self_j + x);
-          agg = F::red(agg, F::map(std::abs(a-b), p));
+  static void apply_cdist(Tensor& result, const Tensor& x1, const Tensor& x2, const scalar_t p) {
+    if (p == 0.0) {
+      run_parallel_cdist<zdist_calc<Vec>>(result, x1, x2, p);
+    } else if (p == 1.0) {
+      run_parallel_cdist<odist_calc<Vec>>(result, x1, x2, p);
+    } else if (p == 2.0) {
+      run_parallel_cdist<tdist_calc<Vec>>(result, x1, x2, p);
+    } else if (std::isinf(p)) {
+      run_parallel_cdist<idist_calc<Vec>>(result, x1, x2, p);
+    } else {
+      run_parallel_cdist<pdist_calc<Vec>>(result, x1, x2, p);
+    }
+  }
+
+  // Same tiling as run_parallel_cdist, but instead of writing out the
+  // distances, each row of x1 keeps the k best (distance, index) pairs seen so
+  // far in a heap whose front is the worst of them. All finish functions are
+  // monotonic, so candidates are compared before F::finish, which is only
+  // applied to the k selected distances of each row.
+  template <typename F>
+  static void run_parallel_cdist_topk(Tensor& values, Tensor& indices, const Tensor& t1, const Tensor& t2, const scalar_t p, bool largest) {
+    using candidate_t = std::pair<scalar_t, int64_t>;
+    const scalar_t * const t1_start = t1.data_ptr<scalar_t>();
+    const scalar_t * const t2_start = t2.data_ptr<scalar_t>();
+    int64_t d = t1.size(0);
+    int64_t r1 = t1.size(-2);
+    int64_t r2 = t2.size(-2);
+    int64_t m = t1.size(-1);
+    int64_t k = values.size(-1);
+
+    scalar_t * const values_start = values.data_ptr<scalar_t>();
+    int64_t * const indices_start = indices.data_ptr<int64_t>();
+    const int64_t rows2 = cdist_tile_rows2(m);
+    const int64_t blocks1 = divup(r1, cdist_tile_rows1);
+
+    // a is ranked before b; ties are broken by index and NaN is larger than
+    // any other distance, like topk does
+    auto before = [largest](const candidate_t& a, const candidate_t& b) {
+      if (a.first != b.first) {
+        const bool a_nan = std::isnan(a.first);
+        const bool b_nan = std::isnan(b.first);
+        if (!a_nan && !b_nan) {
+          return largest ? a.first > b.first : a.first < b.first;
+        }
+        if (a_nan != b_nan) {
+          return largest ? a_nan : b_nan;
         }
-        *res = F::finish(agg, p);
+      }
+      return a.second < b.second;
+    };
 
-        res += 1;
-        j += m;
-        if (j == size2) {
-          j = 0;
-          i += m;
-          if (i == size1) {
-            i = 0;
-            l += 1;
+    parallel_for(0, d * blocks1, divup(internal::GRAIN_SIZE, cdist_tile_rows1 * r2 * m), [&](int64_t start, int64_t end) {
+      const Vec pvec(p);
+      std::vector<scalar_t> agg(cdist_tile_rows1 * rows2);
+      std::vector<std::vector<candidate_t>> heaps(cdist_tile_rows1);
+      for (auto& heap : heaps) {
+        heap.reserve(k);
+      }
+      for (int64_t b = start; b < end; b++) {
+        const int64_t l = b / blocks1;
+        const int64_t i = (b % blocks1) * cdist_tile_rows1;
+        const int64_t n1 = std::min(cdist_tile_rows1, r1 - i);
+        const scalar_t * x1 = t1_start + (l * r1 + i) * m;
+        for (auto& heap : heaps) {
+          heap.clear();
+        }
+        for (int64_t j = 0; j < r2; j += rows2) {
+          const int64_t n2 = std::min(rows2, r2 - j);
+          cdist_tile<F>(x1, n1, t2_start + (l * r2 + j) * m, n2, m, pvec, agg.data(), n2);
+          for (int64_t row = 0; row < n1; row++) {
+            auto& heap = heaps[row];
+            const scalar_t * agg_row = agg.data() + row * n2;
+            for (int64_t col = 0; col < n2; col++) {
+              const candidate_t candidate(agg_row[col], j + col);
+              if (static_cast<int64_t>(heap.size()) < k) {
+                heap.push_back(candidate);
+                std::push_heap(heap.begin(), heap.end(), before);
+              } else if (before(candidate, heap.front())) {
+                std::pop_heap(heap.begin(), heap.end(), before);
+                heap.back() = candidate;
+                std::push_heap(heap.begin(), heap.end(), before);
+              }
+            }
+          }
+        }
+        for (int64_t row = 0; row < n1; row++) {
+          auto& heap = heaps[row];
+          std::sort_heap(heap.begin(), heap.end(), before);
+          scalar_t * values_row = values_start + (l * r1 + i + row) * k;
+          int64_t * indices_row = indices_start + (l * r1 + i + row) * k;
+          for (int64_t c = 0; c < k; c++) {
+            values_row[c] = F::finish(heap[c].first, p);
+            indices_row[c] = heap[c].second;
           }
         }
       }
     });
   }
 
-  static void apply_cdist(Tensor& result, const Tensor& x1, const Tensor& x2, const scalar_t p) {
+  static void apply_cdist_topk(Tensor& values, Tensor& indices, const Tensor& x1, const Tensor& x2, const scalar_t p, bool largest) {
     if (p == 0.0) {
-      run_parallel_cdist<zdist_calc<scalar_t>>(result, x1, x2, p);
+      run_parallel_cdist_topk<zdist_calc<Vec>>(values, indices, x1, x2, p, largest);
     } else if (p == 1.0) {
-      run_parallel_cdist<odist_calc<scalar_t>>(result, x1, x2, p);
+      run_parallel_cdist_topk<odist_calc<Vec>>(values, indices, x1, x2, p, largest);
     } else if (p == 2.0) {
-      run_parallel_cdist<tdist_calc<scalar_t>>(result, x1, x2, p);
+      run_parallel_cdist_topk<tdist_calc<Vec>>(values, indices, x1, x2, p, largest);
     } else if (std::isinf(p)) {
-      run_parallel_cdist<idist_calc<scalar_t>>(result, x1, x2, p);
+      run_parallel_cdist_topk<idist_calc<Vec>>(values, indices, x1, x2, p, largest);
     } else {
-      run_parallel_cdist<pdist_calc<scalar_t>>(result, x1, x2, p);
+      run_parallel_cdist_topk<pdist_calc<Vec>>(values, indices, x1, x2, p, largest);
     }
   }
 
@@ -426,6 +536,12 @@ static void cdist_kernel_impl(Tensor& result, const Tensor& x1, const Tensor& x2
   });
 }
 
+static void cdist_topk_kernel_impl(Tensor& values, Tensor& indices, const Tensor& x1, const Tensor& x2, const double p, bool largest) {
+  AT_DISPATCH_FLOATING_TYPES(values.scalar_type(), "cdist_topk", [&] {
+    Dist<scalar_t>::apply_cdist_topk(values, indices, x1, x2, p, largest);
+  });
+}
+
 static void cdist_backward_kernel_impl(Tensor& result, const Tensor& grad, const Tensor& x1, const Tensor& x2, const double p, const Tensor& dist) {
   AT_DISPATCH_FLOATING_TYPES(result.scalar_type(), "cdist_backward", [&] {
     Dist<scalar_t>::apply_backward_cdist(result, grad, x1, x2, p, dist);
@@ -438,6 +554,7 @@ static void cdist_backward_kernel_impl(Tensor& result, const Tensor& grad, const
 REGISTER_DISPATCH(pdist_forward_stub, &pdist_forward_kernel_impl);
 REGISTER_DISPATCH(pdist_backward_stub, &pdist_backward_kernel_impl);
 REGISTER_DISPATCH(cdist_stub, &cdist_kernel_impl);
+REGISTER_DISPATCH(cdist_topk_stub, &cdist_topk_kernel_impl);
 REGISTER_DISPATCH(cdist_backward_stub, &cdist_backward_kernel_impl);
 
 }}  // namespace at::native
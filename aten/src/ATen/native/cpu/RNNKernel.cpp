@@ -0,0 +1,159 @@
+#include <ATen/native/RNN.h>
+
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec256/vec256.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace at { namespace native {
+
+namespace {
+
+using namespace vec256;
+
+template <typename scalar_t>
+inline Vec256<scalar_t> sigmoid(Vec256<scalar_t> a) {
+  using Vec = Vec256<scalar_t>;
+  return (Vec(static_cast<scalar_t>(1)) + a.neg().exp()).reciprocal();
+}
+
+template <typename scalar_t>
+inline scalar_t sigmoid(scalar_t a) {
+  return static_cast<scalar_t>(1) / (static_cast<scalar_t>(1) + std::exp(-a));
+}
+
+// gates: [batch, 4 * hidden] holding the (input, forget, cell, output) gate
+// pre-activations, cx/hy/cy: [batch, hidden]
+template <typename scalar_t>
+void lstm_cell_pointwise_impl(
+    int64_t batch,
+    int64_t hidden,
+    const scalar_t* gates,
+    const scalar_t* cx,
+    scalar_t* hy,
+    scalar_t* cy) {
+  using Vec = Vec256<scalar_t>;
+  const int64_t grain_size = std::max<int64_t>(1, 16384 / (4 * hidden));
+  at::parallel_for(0, batch, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t b = begin; b < end; b++) {
+      const scalar_t* ig = gates + b * 4 * hidden;
+      const scalar_t* fg = ig + hidden;
+      const scalar_t* gg = fg + hidden;
+      const scalar_t* og = gg + hidden;
+      const scalar_t* c_prev = cx + b * hidden;
+      scalar_t* h_out = hy + b * hidden;
+      scalar_t* c_out = cy + b * hidden;
+      int64_t j = 0;
+      for (; j + Vec::size() <= hidden; j += Vec::size()) {
+        const Vec i = sigmoid(Vec::loadu(ig + j));
+        const Vec f = sigmoid(Vec::loadu(fg + j));
+        const Vec g = Vec::loadu(gg + j).tanh();
+        const Vec o = sigmoid(Vec::loadu(og + j));
+        const Vec c = f * Vec::loadu(c_prev + j) + i * g;
+        c.store(c_out + j);
+        (o * c.tanh()).store(h_out + j);
+      }
+      for (; j < hidden; j++) {
+        const scalar_t c = sigmoid(fg[j]) * c_prev[j] + sigmoid(ig[j]) * std::tanh(gg[j]);
+        c_out[j] = c;
+        h_out[j] = sigmoid(og[j]) * std::tanh(c);
+      }
+    }
+  });
+}
+
+// igates/hgates: [batch, 3 * hidden] holding the (reset, input, new) gate
+// projections of the input and of the hidden state, b_hh: [3 * hidden] or
+// nullptr, hx/hy: [batch, hidden]
+template <typename scalar_t>
+void gru_cell_pointwise_impl(
+    int64_t batch,
+    int64_t hidden,
+    const scalar_t* igates,
+    const scalar_t* hgates,
+    const scalar_t* b_hh,
+    const scalar_t* hx,
+    scalar_t* hy) {
+  using Vec = Vec256<scalar_t>;
+  const int64_t grain_size = std::max<int64_t>(1, 16384 / (3 * hidden));
+  at::parallel_for(0, batch, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t b = begin; b < end; b++) {
+      const scalar_t* ir = igates + b * 3 * hidden;
+      const scalar_t* iz = ir + hidden;
+      const scalar_t* in = iz + hidden;
+      const scalar_t* hr = hgates + b * 3 * hidden;
+      const scalar_t* hz = hr + hidden;
+      const scalar_t* hn = hz + hidden;
+      const scalar_t* h_prev = hx + b * hidden;
+      scalar_t* h_out = hy + b * hidden;
+      auto bias = [&](int64_t gate, int64_t j) {
+        return b_hh ? b_hh[gate * hidden + j] : static_cast<scalar_t>(0);
+      };
+      auto bias_vec = [&](int64_t gate, int64_t j) {
+        return b_hh ? Vec::loadu(b_hh + gate * hidden + j) : Vec(static_cast<scalar_t>(0));
+      };
+      int64_t j = 0;
+      for (; j + Vec::size() <= hidden; j += Vec::size()) {
+        const Vec r = sigmoid(Vec::loadu(ir + j) + Vec::loadu(hr + j) + bias_vec(0, j));
+        const Vec z = sigmoid(Vec::loadu(iz + j) + Vec::loadu(hz + j) + bias_vec(1, j));
+        const Vec n = (Vec::loadu(in + j) + r * (Vec::loadu(hn + j) + bias_vec(2, j))).tanh();
+        (n + z * (Vec::loadu(h_prev + j) - n)).store(h_out + j);
+      }
+      for (; j < hidden; j++) {
+        const scalar_t r = sigmoid(ir[j] + hr[j] + bias(0, j));
+        const scalar_t z = sigmoid(iz[j] + hz[j] + bias(1, j));
+        const scalar_t n = std::tanh(in[j] + r * (hn[j] + bias(2, j)));
+        h_out[j] = n + z * (h_prev[j] - n);
+      }
+    }
+  });
+}
+
+void lstm_cell_pointwise_kernel(
+    ScalarType dtype,
+    int64_t batch,
+    int64_t hidden,
+    const void* gates,
+    const void* cx,
+    void* hy,
+    void* cy) {
+  AT_DISPATCH_FLOATING_TYPES(dtype, "lstm_cell_pointwise_cpu", [&] {
+    lstm_cell_pointwise_impl<scalar_t>(
+        batch,
+        hidden,
+        static_cast<const scalar_t*>(gates),
+        static_cast<const scalar_t*>(cx),
+        static_cast<scalar_t*>(hy),
+        static_cast<scalar_t*>(cy));
+  });
+}
+
+void gru_cell_pointwise_kernel(
+    ScalarType dtype,
+    int64_t batch,
+    int64_t hidden,
+    const void* igates,
+    const void* hgates,
+    const void* b_hh,
+    const void* hx,
+    void* hy) {
+  AT_DISPATCH_FLOATING_TYPES(dtype, "gru_cell_pointwise_cpu", [&] {
+    gru_cell_pointwise_impl<scalar_t>(
+        batch,
+        hidden,
+        static_cast<const scalar_t*>(igates),
+        static_cast<const scalar_t*>(hgates),
+        static_cast<const scalar_t*>(b_hh),
+        static_cast<const scalar_t*>(hx),
+        static_cast<scalar_t*>(hy));
+  });
+}
+
+} // anonymous namespace
+
+REGISTER_DISPATCH(lstm_cell_pointwise_stub, &lstm_cell_pointwise_kernel);
+REGISTER_DISPATCH(gru_cell_pointwise_stub, &gru_cell_pointwise_kernel);
+
+}} // namespace at::native
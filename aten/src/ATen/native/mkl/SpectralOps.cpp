@@ -1,46 +1,31 @@
-#include <ATen/ATen.h>
-#include <ATen/NativeFunctions.h>
-#include <ATen/native/SpectralOpsUtils.h>
-#include <ATen/Config.h>
-
-#if !AT_MKL_ENABLED()
-
-namespace at { namespace native {
-
-Tensor _fft_mkl(const Tensor& input, int64_t signal_ndim,
-                bool complex_input, bool complex_output,
-                bool inverse, IntArrayRef checked_signal_sizes,
-                bool normalized, bool onesided,
-                IntArrayRef output_sizes) {
-  AT_ERROR("fft: ATen not compiled with MKL support");
-}
-
-}}
-
-#else // AT_MKL_ENABLED
-
 #include <ATen/ATen.h>
 #include <ATen/Config.h>
 #include <ATen/Dispatch.h>
 #include <ATen/NativeFunctions.h>
 #include <ATen/Parallel.h>
 #include <ATen/Utils.h>
+#include <ATen/native/CPUFFTPlanCache.h>
+#include <ATen/native/SpectralOpsUtils.h>
 
 #include <algorithm>
 #include <vector>
 #include <numeric>
 #include <cmath>
 
+#if AT_MKL_ENABLED()
 #include <mkl_dfti.h>
 #include <ATen/mkl/Exceptions.h>
 #include <ATen/mkl/Descriptors.h>
 #include <ATen/mkl/Limits.h>
+#else
+#include <ATen/native/PocketFFT.h>
+#endif
 
 
 namespace at { namespace native {
 
-// In real-to-complex transform, MKL FFT only fills half of the values due to
-// conjugate symmetry. See native/SpectralUtils.h for more details.
+// In real-to-complex transform, MKL FFT and pocketfft only fill half of the
+// values due to conjugate symmetry. See native/SpectralUtils.h for more details.
 // The following structs are used to fill in the other half with symmetry in
 // case of real-to-complex transform with onesided=False flag.
 // See NOTE [ Fourier Transform Conjugate Symmetry ] in native/SpectralOpsUtils.h.
@@ -144,13 +129,209 @@ static inline void _fft_fill_with_conjugate_symmetry_(Tensor& input,
   });
 }
 
+#if AT_MKL_ENABLED()
+
+// This class contains a committed MKL DFTI descriptor, i.e., everything needed
+// to run a transform with given sizes, strides, direction and scaling.
+//
+// This class will be the **value** in the plan cache. Committed descriptors
+// are not modified by DftiCompute{Forward,Backward}, so one descriptor can be
+// used by several threads at the same time.
+class DftiConfig {
+public:
+  DftiConfig(const Tensor& input, int64_t signal_ndim, bool complex_input,
+             bool complex_output, bool inverse, IntArrayRef checked_signal_sizes,
+             bool normalized, IntArrayRef output_sizes) {
+    int64_t batch = input.size(0);
+    // precision
+    DFTI_CONFIG_VALUE prec;
+    if (input.scalar_type() == ScalarType::Float) {
+      prec = DFTI_SINGLE;
+    } else if (input.scalar_type() == ScalarType::Double) {
+      prec = DFTI_DOUBLE;
+    } else {
+      std::ostringstream ss;
+      ss << "MKL FFT doesn't support tensor of type: "
+         << toString(input.scalar_type());
+      AT_ERROR(ss.str());
+    }
+    // signal type
+    DFTI_CONFIG_VALUE signal_type;
+    if (!inverse) {
+      signal_type = complex_input ? DFTI_COMPLEX : DFTI_REAL;
+    } else {
+      signal_type = complex_output ? DFTI_COMPLEX : DFTI_REAL;
+    }
+    // create descriptor with signal size
+    std::vector<MKL_LONG> mkl_signal_sizes(checked_signal_sizes.begin(), checked_signal_sizes.end());
+    descriptor_.init(prec, signal_type, signal_ndim, mkl_signal_sizes.data());
+    // out of place FFT
+    MKL_DFTI_CHECK(DftiSetValue(descriptor_.get(), DFTI_PLACEMENT, DFTI_NOT_INPLACE));
+    // batch mode
+    MKL_DFTI_CHECK(DftiSetValue(descriptor_.get(), DFTI_NUMBER_OF_TRANSFORMS, batch));
+
+    auto istrides = input.strides();
+    // the output is always a new contiguous tensor of output_sizes
+    std::vector<int64_t> ostrides(output_sizes.size());
+    int64_t ostride = 1;
+    for (int64_t i = output_sizes.size() - 1; i >= 0; i--) {
+      ostrides[i] = ostride;
+      ostride *= output_sizes[i];
+    }
+    // batch dim stride, i.e., dist between each data
+    MKL_LONG idist = complex_input ? istrides[0] >> 1 : istrides[0];
+    MKL_LONG odist = complex_output ? ostrides[0] >> 1 : ostrides[0];
+    MKL_DFTI_CHECK(DftiSetValue(descriptor_.get(), DFTI_INPUT_DISTANCE, idist));
+    MKL_DFTI_CHECK(DftiSetValue(descriptor_.get(), DFTI_OUTPUT_DISTANCE, odist));
+    // signal strides
+    // first val is offset, set to zero (ignored)
+    std::vector<MKL_LONG> mkl_istrides(1 + signal_ndim, 0), mkl_ostrides(1 + signal_ndim, 0);
+    for (int64_t i = 1; i <= signal_ndim; i++) {
+      mkl_istrides[i] = complex_input ? istrides[i] >> 1 : istrides[i];
+      mkl_ostrides[i] = complex_output ? ostrides[i] >> 1 : ostrides[i];
+    }
+    MKL_DFTI_CHECK(DftiSetValue(descriptor_.get(), DFTI_INPUT_STRIDES, mkl_istrides.data()));
+    MKL_DFTI_CHECK(DftiSetValue(descriptor_.get(), DFTI_OUTPUT_STRIDES, mkl_ostrides.data()));
+    // if conjugate domain of real is involved, set standard CCE storage type
+    // this will become default in MKL in future
+    if (!complex_input || !complex_output) {
+      MKL_DFTI_CHECK(DftiSetValue(descriptor_.get(), DFTI_CONJUGATE_EVEN_STORAGE, DFTI_COMPLEX_COMPLEX));
+    }
+    // rescale if needed by normalized flag or inverse transform
+    if (normalized || inverse) {
+      auto signal_numel = at::prod_intlist(checked_signal_sizes);
+      double double_scale;
+      if (normalized) {
+        double_scale = 1.0 / std::sqrt(static_cast<double>(signal_numel));
+      } else {
+        double_scale = 1.0 / static_cast<double>(signal_numel);
+      }
+      MKL_DFTI_CHECK(DftiSetValue(descriptor_.get(),
+        inverse ? DFTI_BACKWARD_SCALE : DFTI_FORWARD_SCALE,
+        prec == DFTI_DOUBLE ? double_scale : static_cast<float>(double_scale)));
+    }
+    // finalize
+    MKL_DFTI_CHECK(DftiCommitDescriptor(descriptor_.get()));
+  }
+
+  DFTI_DESCRIPTOR *descriptor() const { return descriptor_.get(); }
+
+private:
+  DftiDescriptor descriptor_;
+};
+
+using CPUFFTConfig = DftiConfig;
+
+#else // AT_MKL_ENABLED
+
+template <typename T>
+struct PocketFFTPlans {
+  // one complex plan per signal dimension, nullptr for the last signal
+  // dimension of real-to-complex and complex-to-real transforms
+  std::vector<std::unique_ptr<pocketfft::CFFTPlan<T>>> c2c;
+  // plan for the last signal dimension of real-to-complex and
+  // complex-to-real transforms
+  std::unique_ptr<pocketfft::RFFTPlan<T>> real;
+};
+
+// This class contains the pocketfft plans (factorizations and twiddle tables)
+// for every signal dimension of a transform.
+//
+// This class will be the **value** in the plan cache. Plans are immutable and
+// can be used by several threads at the same time.
+class PocketFFTConfig {
+public:
+  PocketFFTConfig(const Tensor& input, int64_t signal_ndim, bool complex_input,
+                  bool complex_output, bool inverse, IntArrayRef checked_signal_sizes,
+                  bool normalized, IntArrayRef output_sizes) {
+    const bool is_real = !complex_input || !complex_output;
+    if (input.scalar_type() == ScalarType::Float) {
+      make_plans(float_plans_, signal_ndim, is_real, checked_signal_sizes);
+    } else if (input.scalar_type() == ScalarType::Double) {
+      make_plans(double_plans_, signal_ndim, is_real, checked_signal_sizes);
+    } else {
+      AT_ERROR("pocketfft doesn't support tensor of type: ", toString(input.scalar_type()));
+    }
+  }
+
+  template <typename T>
+  const PocketFFTPlans<T>& plans() const;
+
+private:
+  template <typename T>
+  static void make_plans(PocketFFTPlans<T>& plans, int64_t signal_ndim,
+                         bool is_real, IntArrayRef checked_signal_sizes) {
+    for (int64_t i = 0; i < signal_ndim; i++) {
+      if (is_real && i == signal_ndim - 1) {
+        plans.c2c.emplace_back(nullptr);
+        plans.real = std::make_unique<pocketfft::RFFTPlan<T>>(checked_signal_sizes[i]);
+      } else {
+        plans.c2c.emplace_back(std::make_unique<pocketfft::CFFTPlan<T>>(checked_signal_sizes[i]));
+      }
+    }
+  }
+
+  PocketFFTPlans<float> float_plans_;
+  PocketFFTPlans<double> double_plans_;
+};
+
+template <>
+const PocketFFTPlans<float>& PocketFFTConfig::plans<float>() const {
+  return float_plans_;
+}
+
+template <>
+const PocketFFTPlans<double>& PocketFFTConfig::plans<double>() const {
+  return double_plans_;
+}
+
+using CPUFFTConfig = PocketFFTConfig;
+
+#endif // AT_MKL_ENABLED
+
+using CPUFFTParamsLRUCache = detail::CPUFFTParamsLRUCache<CPUFFTConfig>;
+
+static CPUFFTParamsLRUCache& cpu_fft_get_plan_cache() {
+  static CPUFFTParamsLRUCache plan_cache;
+  return plan_cache;
+}
+
+int64_t _fft_cpu_get_plan_cache_max_size() {
+  return cpu_fft_get_plan_cache().max_size();
+}
+
+void _fft_cpu_set_plan_cache_max_size(int64_t max_size) {
+  cpu_fft_get_plan_cache().resize(max_size);
+}
+
+int64_t _fft_cpu_get_plan_cache_size() {
+  return cpu_fft_get_plan_cache().size();
+}
+
+void _fft_cpu_clear_plan_cache() {
+  cpu_fft_get_plan_cache().clear();
+}
+
+static std::shared_ptr<const CPUFFTConfig> cpu_fft_get_plan(
+    const Tensor& input, int64_t signal_ndim, bool complex_input,
+    bool complex_output, bool inverse, IntArrayRef checked_signal_sizes,
+    bool normalized, bool onesided, IntArrayRef output_sizes) {
+  detail::CPUFFTParams params;
+  detail::setCPUFFTParams(&params, input, signal_ndim, complex_input,
+      complex_output, inverse, checked_signal_sizes, normalized, onesided);
+  return cpu_fft_get_plan_cache().get_or_create(params, input, signal_ndim,
+      complex_input, complex_output, inverse, checked_signal_sizes, normalized,
+      output_sizes);
+}
+
+#if AT_MKL_ENABLED()
+
 // MKL DFTI
 Tensor _fft_mkl(const Tensor& self, int64_t signal_ndim,
                 bool complex_input, bool complex_output,
                 bool inverse, IntArrayRef checked_signal_sizes,
                 bool normalized, bool onesided,
                 IntArrayRef output_sizes) {
-  int64_t batch = self.size(0);
   Tensor input = self;
   // real/imag dimension must aligned when viewed as of complex type
   if (complex_input) {
@@ -194,76 +375,149 @@ Tensor _fft_mkl(const Tensor& self, int64_t signal_ndim,
   }
   Tensor output = at::empty(output_sizes, input.options());
 
-  // precision
-  DFTI_CONFIG_VALUE prec;
-  if (input.scalar_type() == ScalarType::Float) {
-    prec = DFTI_SINGLE;
-  } else if (input.scalar_type() == ScalarType::Double) {
-    prec = DFTI_DOUBLE;
-  } else {
-    std::ostringstream ss;
-    ss << "MKL FFT doesn't support tensor of type: "
-       << toString(input.scalar_type());
-    AT_ERROR(ss.str());
-  }
-  // signal type
-  DFTI_CONFIG_VALUE signal_type;
+  // the committed descriptor is looked up in (or added to) the plan cache
+  auto config = cpu_fft_get_plan(input, signal_ndim, complex_input,
+      complex_output, inverse, checked_signal_sizes, normalized, onesided,
+      output_sizes);
+  // run
   if (!inverse) {
-    signal_type = complex_input ? DFTI_COMPLEX : DFTI_REAL;
+    MKL_DFTI_CHECK(DftiComputeForward(config->descriptor(), input.data_ptr(), output.data_ptr()));
   } else {
-    signal_type = complex_output ? DFTI_COMPLEX : DFTI_REAL;
+    MKL_DFTI_CHECK(DftiComputeBackward(config->descriptor(), input.data_ptr(), output.data_ptr()));
   }
-  // create descriptor with signal size
-  std::vector<MKL_LONG> mkl_signal_sizes(checked_signal_sizes.begin(), checked_signal_sizes.end());
-  DftiDescriptor descriptor;
-  descriptor.init(prec, signal_type, signal_ndim, mkl_signal_sizes.data());
-  // out of place FFT
-  MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_PLACEMENT, DFTI_NOT_INPLACE));
-  // batch mode
-  MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_NUMBER_OF_TRANSFORMS, batch));
-
-  auto istrides = input.strides();
-  auto ostrides = output.strides();
-  // batch dim stride, i.e., dist between each data
-  MKL_LONG idist = complex_input ? istrides[0] >> 1 : istrides[0];
-  MKL_LONG odist = complex_output ? ostrides[0] >> 1 : ostrides[0];
-  MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_INPUT_DISTANCE, idist));
-  MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_OUTPUT_DISTANCE, odist));
-  // signal strides
-  // first val is offset, set to zero (ignored)
-  std::vector<MKL_LONG> mkl_istrides(1 + signal_ndim, 0), mkl_ostrides(1 + signal_ndim, 0);
-  for (int64_t i = 1; i <= signal_ndim; i++) {
-    mkl_istrides[i] = complex_input ? istrides[i] >> 1 : istrides[i];
-    mkl_ostrides[i] = complex_output ? ostrides[i] >> 1 : ostrides[i];
+  // now if needed, fill out the other half using Hermitian symmetry dim
+  if (!complex_input && complex_output && !onesided) {
+    auto size_last_signal_dim = checked_signal_sizes[signal_ndim - 1];
+    auto start_slice = infer_ft_real_to_complex_onesided_size(size_last_signal_dim);
+    _fft_fill_with_conjugate_symmetry_(output, signal_ndim, size_last_signal_dim, start_slice);
   }
-  MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_INPUT_STRIDES, mkl_istrides.data()));
-  MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_OUTPUT_STRIDES, mkl_ostrides.data()));
-  // if conjugate domain of real is involved, set standard CCE storage type
-  // this will become default in MKL in future
-  if (!complex_input || !complex_output) {
-    MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_CONJUGATE_EVEN_STORAGE, DFTI_COMPLEX_COMPLEX));
+  return output;
+}
+
+#else // AT_MKL_ENABLED
+
+// Shape and element strides of the first `ndim` dimensions of `t`. For
+// complex tensors, i.e., with a trailing dimension of size 2, strides are in
+// units of complex numbers.
+static void _pocketfft_layout(const Tensor& t, int64_t ndim, bool is_complex,
+                              std::vector<int64_t>& shape,
+                              std::vector<int64_t>& strides) {
+  shape.assign(t.sizes().begin(), t.sizes().begin() + ndim);
+  strides.assign(t.strides().begin(), t.strides().begin() + ndim);
+  if (is_complex) {
+    for (auto& s : strides) {
+      s /= 2;
+    }
   }
-  // rescale if needed by normalized flag or inverse transform
+}
+
+template <typename scalar_t>
+static void _fft_pocketfft_kernel(const PocketFFTPlans<scalar_t>& plans,
+                                  const Tensor& input, Tensor& output,
+                                  int64_t signal_ndim, bool complex_input,
+                                  bool complex_output, bool inverse,
+                                  IntArrayRef checked_signal_sizes,
+                                  bool normalized) {
+  using cmplx = pocketfft::cmplx<scalar_t>;
+  // batch dim followed by signal dims
+  const int64_t ndim = signal_ndim + 1;
+  const int64_t last = ndim - 1;
+  const bool forward = !inverse;
+
+  // rescale if needed by normalized flag or inverse transform; the factor is
+  // folded into the last 1-D pass
+  scalar_t fct = 1;
   if (normalized || inverse) {
     auto signal_numel = at::prod_intlist(checked_signal_sizes);
-    double double_scale;
     if (normalized) {
-      double_scale = 1.0 / std::sqrt(static_cast<double>(signal_numel));
+      fct = static_cast<scalar_t>(1.0 / std::sqrt(static_cast<double>(signal_numel)));
     } else {
-      double_scale = 1.0 / static_cast<double>(signal_numel);
+      fct = static_cast<scalar_t>(1.0 / static_cast<double>(signal_numel));
     }
-    MKL_DFTI_CHECK(DftiSetValue(descriptor.get(),
-      inverse ? DFTI_BACKWARD_SCALE : DFTI_FORWARD_SCALE,
-      prec == DFTI_DOUBLE ? double_scale : static_cast<float>(double_scale)));
   }
-  // finalize
-  MKL_DFTI_CHECK(DftiCommitDescriptor(descriptor.get()));
-  // run
-  if (!inverse) {
-    MKL_DFTI_CHECK(DftiComputeForward(descriptor.get(), input.data_ptr(), output.data_ptr()));
+
+  std::vector<int64_t> shape, strides;
+  if (complex_input && complex_output) {
+    // complex-to-complex: copy into output and transform in place, one
+    // signal dim at a time
+    output.copy_(input);
+    _pocketfft_layout(output, ndim, /*is_complex=*/true, shape, strides);
+    auto data = reinterpret_cast<cmplx*>(output.data_ptr<scalar_t>());
+    for (int64_t d = last; d >= 1; d--) {
+      pocketfft::c2c(data, strides, data, strides, shape, d,
+                     *plans.c2c[d - 1], forward, d == 1 ? fct : scalar_t(1));
+    }
+  } else if (!complex_input) {
+    // real-to-complex: transform the last signal dim straight from the
+    // (possibly strided) input, then the remaining signal dims on the
+    // onesided half of the output
+    std::vector<int64_t> ishape, istrides;
+    _pocketfft_layout(input, ndim, /*is_complex=*/false, ishape, istrides);
+    _pocketfft_layout(output, ndim, /*is_complex=*/true, shape, strides);
+    auto data = reinterpret_cast<cmplx*>(output.data_ptr<scalar_t>());
+    pocketfft::r2c(input.data_ptr<scalar_t>(), istrides, data, strides,
+                   ishape, last, *plans.real, ndim == 2 ? fct : scalar_t(1));
+    if (!forward) {
+      // for a real signal, the backward transform is the conjugate of the
+      // forward one
+      output.narrow(last, 0, infer_ft_real_to_complex_onesided_size(ishape[last]))
+            .select(-1, 1).neg_();
+    }
+    shape[last] = infer_ft_real_to_complex_onesided_size(ishape[last]);
+    for (int64_t d = last - 1; d >= 1; d--) {
+      pocketfft::c2c(data, strides, data, strides, shape, d,
+                     *plans.c2c[d - 1], forward, d == 1 ? fct : scalar_t(1));
+    }
   } else {
-    MKL_DFTI_CHECK(DftiComputeBackward(descriptor.get(), input.data_ptr(), output.data_ptr()));
+    // complex-to-real: transform all but the last signal dim on a copy of the
+    // onesided half of the input, then the last signal dim into the output
+    const int64_t onesided_size = infer_ft_real_to_complex_onesided_size(checked_signal_sizes[signal_ndim - 1]);
+    Tensor work = input.narrow(last, 0, onesided_size).clone(at::MemoryFormat::Contiguous);
+    _pocketfft_layout(work, ndim, /*is_complex=*/true, shape, strides);
+    auto data = reinterpret_cast<cmplx*>(work.data_ptr<scalar_t>());
+    for (int64_t d = 1; d < last; d++) {
+      pocketfft::c2c(data, strides, data, strides, shape, d,
+                     *plans.c2c[d - 1], forward, scalar_t(1));
+    }
+    if (forward) {
+      // a real result of the forward transform is the backward transform of
+      // the conjugate
+      work.select(-1, 1).neg_();
+    }
+    std::vector<int64_t> oshape, ostrides;
+    _pocketfft_layout(output, ndim, /*is_complex=*/false, oshape, ostrides);
+    pocketfft::c2r(data, strides, output.data_ptr<scalar_t>(), ostrides,
+                   oshape, last, *plans.real, fct);
+  }
+}
+
+// pocketfft, used when ATen is not compiled with MKL. Keeps the _fft_mkl name
+// so that the CPU dispatch of _fft_with_size does not depend on the build.
+Tensor _fft_mkl(const Tensor& self, int64_t signal_ndim,
+                bool complex_input, bool complex_output,
+                bool inverse, IntArrayRef checked_signal_sizes,
+                bool normalized, bool onesided,
+                IntArrayRef output_sizes) {
+  TORCH_CHECK(self.scalar_type() == ScalarType::Float || self.scalar_type() == ScalarType::Double,
+           "pocketfft doesn't support tensor of type: ", toString(self.scalar_type()));
+  Tensor input = self;
+  // real/imag components must be adjacent when viewed as of complex type
+  if (complex_input && input.stride(-1) != 1) {
+    input = input.contiguous();
   }
+  Tensor output = at::empty(output_sizes, input.options());
+  if (output.numel() == 0) {
+    return output;
+  }
+
+  auto config = cpu_fft_get_plan(input, signal_ndim, complex_input,
+      complex_output, inverse, checked_signal_sizes, normalized, onesided,
+      output_sizes);
+  AT_DISPATCH_FLOATING_TYPES(input.scalar_type(), "_fft_pocketfft", [&] {
+    _fft_pocketfft_kernel<scalar_t>(config->plans<scalar_t>(), input, output,
+        signal_ndim, complex_input, complex_output, inverse,
+        checked_signal_sizes, normalized);
+  });
   // now if needed, fill out the other half using Hermitian symmetry dim
   if (!complex_input && complex_output && !onesided) {
     auto size_last_signal_dim = checked_signal_sizes[signal_ndim - 1];
@@ -273,6 +527,6 @@ Tensor _fft_mkl(const Tensor& self, int64_t signal_ndim,
   return output;
 }
 
-}} // namespace at::native
+#endif // AT_MKL_ENABLED
 
-#endif
+}} // namespace at::native
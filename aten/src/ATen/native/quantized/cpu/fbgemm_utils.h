@@ -52,6 +52,8 @@ struct CAFFE2_API PackedLinearWeight : public LinearPackedParamsBase {
 
   at::Tensor apply_dynamic(at::Tensor input, bool reduce_range=false) override;
   at::Tensor apply_dynamic_relu(at::Tensor input, bool reduce_range=false) override;
+  at::Tensor apply_dynamic_per_token(at::Tensor input, bool reduce_range=false) override;
+  at::Tensor apply_dynamic_per_token_relu(at::Tensor input, bool reduce_range=false) override;
 
   std::tuple<at::Tensor, c10::optional<at::Tensor>> unpack() override;
 
@@ -72,6 +74,9 @@ struct CAFFE2_API PackedLinearWeight : public LinearPackedParamsBase {
 
   template <bool ReluFused>
   at::Tensor apply_dynamic_impl(at::Tensor input, bool reduce_range=false);
+
+  template <bool ReluFused>
+  at::Tensor apply_dynamic_per_token_impl(at::Tensor input, bool reduce_range=false);
 };
 
 struct CAFFE2_API PackedLinearWeightFp16 : public LinearPackedParamsBase {
@@ -1,6 +1,7 @@
 #include <ATen/ATen.h>
 #include <ATen/Dispatch.h>
 #include <ATen/Parallel.h>
+#include <ATen/cpu/vec256/functional.h>
 #include <ATen/native/SortingUtils.h>
 #include <ATen/native/TensorIterator.h>
 #include <ATen/native/UpSample.h>
@@ -163,7 +164,7 @@ int64_t hsum(const uint8_t* A, int len) {
   int64_t row_sum = 0;
   int i = 0;
 
-#ifdef CPU_CAPABILITY_AVX2
+#if defined(CPU_CAPABILITY_AVX2) || defined(CPU_CAPABILITY_AVX512)
   __m256i sum_v = _mm256_setzero_si256();
   __m256i one_epi16_v = _mm256_set1_epi16(1);
   __m256i one_epi8_v = _mm256_set1_epi8(1);
@@ -184,7 +185,7 @@ int64_t hsum(const uint8_t* A, int len) {
   for (int k = 0; k < 8; ++k) {
     row_sum += temp[k];
   }
-#endif // CPU_CAPABILITY_AVX2
+#endif // CPU_CAPABILITY_AVX2 || CPU_CAPABILITY_AVX512
 
   // scalar
   for (; i < len; ++i) {
@@ -199,7 +200,7 @@ int64_t hsum(const int8_t* A, int len) {
   int64_t row_sum = 0;
   int i = 0;
 
-#ifdef CPU_CAPABILITY_AVX2
+#if defined(CPU_CAPABILITY_AVX2) || defined(CPU_CAPABILITY_AVX512)
   __m256i sum_v = _mm256_setzero_si256();
   __m256i one_epi16_v = _mm256_set1_epi16(1);
   __m256i one_epi8_v = _mm256_set1_epi8(1);
@@ -220,7 +221,7 @@ int64_t hsum(const int8_t* A, int len) {
   for (int k = 0; k < 8; ++k) {
     row_sum += temp[k];
   }
-#endif // CPU_CAPABILITY_AVX2
+#endif // CPU_CAPABILITY_AVX2 || CPU_CAPABILITY_AVX512
 
   // scalar
   for (; i < len; ++i) {
@@ -235,7 +236,7 @@ int64_t hsum(const int32_t* A, int len) {
   int64_t row_sum = 0;
   int i = 0;
 
-#ifdef CPU_CAPABILITY_AVX2
+#if defined(CPU_CAPABILITY_AVX2) || defined(CPU_CAPABILITY_AVX512)
   __m256i sum_epi64 = _mm256_setzero_si256();
   // vectorized
   for (; i < len / 8 * 8; i += 8) {
@@ -255,7 +256,7 @@ int64_t hsum(const int32_t* A, int len) {
   for (int k = 0; k < 4; ++k) {
     row_sum += temp[k];
   }
-#endif // CPU_CAPABILITY_AVX2
+#endif // CPU_CAPABILITY_AVX2 || CPU_CAPABILITY_AVX512
 
   // scalar
   for (; i < len; ++i) {
@@ -270,7 +271,7 @@ int64_t hsum_sq(const uint8_t* A, int len) {
   int64_t row_sum = 0;
   int i = 0;
 
-#ifdef CPU_CAPABILITY_AVX2
+#if defined(CPU_CAPABILITY_AVX2) || defined(CPU_CAPABILITY_AVX512)
   __m256i sum_v_epu32 = _mm256_setzero_si256();
   // vectorized
   for (; i < len / 16 * 16; i += 16) {
@@ -296,7 +297,7 @@ int64_t hsum_sq(const uint8_t* A, int len) {
   for (int k = 0; k < 8; ++k) {
     row_sum += temp[k];
   }
-#endif // CPU_CAPABILITY_AVX2
+#endif // CPU_CAPABILITY_AVX2 || CPU_CAPABILITY_AVX512
 
   // scalar
   for (; i < len; ++i) {
@@ -311,7 +312,7 @@ int64_t hsum_sq(const int8_t* A, int len) {
   int64_t row_sum = 0;
   int i = 0;
 
-#ifdef CPU_CAPABILITY_AVX2
+#if defined(CPU_CAPABILITY_AVX2) || defined(CPU_CAPABILITY_AVX512)
   __m256i sum_v_epi32 = _mm256_setzero_si256();
   // vectorized
   for (; i < len / 16 * 16; i += 16) {
@@ -337,7 +338,7 @@ int64_t hsum_sq(const int8_t* A, int len) {
   for (int k = 0; k < 8; ++k) {
     row_sum += temp[k];
   }
-#endif // CPU_CAPABILITY_AVX2
+#endif // CPU_CAPABILITY_AVX2 || CPU_CAPABILITY_AVX512
 
   // scalar
   for (; i < len; ++i) {
@@ -353,7 +354,7 @@ float hsum_sq(const int32_t* A, int len) {
   float row_sum = 0;
   int i = 0;
 
-#ifdef CPU_CAPABILITY_AVX2
+#if defined(CPU_CAPABILITY_AVX2) || defined(CPU_CAPABILITY_AVX512)
   __m256 sum_ps = _mm256_setzero_ps();
   // vectorized
   for (; i < len / 8 * 8; i += 8) {
@@ -367,7 +368,7 @@ float hsum_sq(const int32_t* A, int len) {
   for (int k = 0; k < 8; ++k) {
     row_sum += static_cast<float>(temp[k]);
   }
-#endif // CPU_CAPABILITY_AVX2
+#endif // CPU_CAPABILITY_AVX2 || CPU_CAPABILITY_AVX512
 
   // scalar
   for (; i < len; ++i) {
@@ -1166,7 +1167,7 @@ void do_avg_pool_nhwc_on_AVX2(
     int hsize,
     int wsize,
     int csize) {
-#if defined(CPU_CAPABILITY_AVX2) && !defined(_MSC_VER)
+#if (defined(CPU_CAPABILITY_AVX2) || defined(CPU_CAPABILITY_AVX512)) && !defined(_MSC_VER)
   // buffer for channel accumulator, used to interchange channel-loop
   // to inner-most, so that memory access of the input tensor data is
   // continuous.
@@ -1176,7 +1177,7 @@ void do_avg_pool_nhwc_on_AVX2(
   Vec256<int32_t> acc_buffer[cb_size];
   Vec256<float> acc_buffer_fp[cb_size];
 
-  if (vec_width == 8) {
+  if (vec_width == Vec256<int32_t>::size()) {
     for (int c = c_start; c < csize; c += cb_step) {
       int cend = std::min(cb_size, (csize - c) / vec_width);
       // initialize loop
@@ -1204,7 +1205,11 @@ void do_avg_pool_nhwc_on_AVX2(
 
       // first quantize using AVX using 32 lanes, then 8, finally falls
       // back to single
+#ifdef CPU_CAPABILITY_AVX512
+      QuantizeAvx512<T>(
+#else
       QuantizeAvx2<T>(
+#endif
           (float*)acc_buffer_fp,
           o_p + c,
           cend * vec_width,
@@ -1236,9 +1241,9 @@ void do_avg_pool_on_AVX2(
     int64_t stride_D,
     int64_t stride_H,
     int64_t stride_W) {
-#if defined(CPU_CAPABILITY_AVX2) && !defined(_MSC_VER)
+#if (defined(CPU_CAPABILITY_AVX2) || defined(CPU_CAPABILITY_AVX512)) && !defined(_MSC_VER)
   constexpr auto vec_width = Vec256<T>::size() / 4;
-  if (vec_width == 8) {
+  if (vec_width == Vec256<int32_t>::size()) {
     for (; c + vec_width <= channel_size; c += vec_width) {
       int64_t tcntr = 0;
 
@@ -1672,9 +1677,9 @@ int64_t do_quantized_bilinear_on_AVX2(
     const int64_t h1p,
     const int64_t w1p) {
   int64_t c = 0;
-#if defined(CPU_CAPABILITY_AVX2) && !defined(_MSC_VER)
+#if (defined(CPU_CAPABILITY_AVX2) || defined(CPU_CAPABILITY_AVX512)) && !defined(_MSC_VER)
   constexpr auto vec_width = Vec256<T>::size() / 4;
-  if (vec_width == 8) {
+  if (vec_width == Vec256<int32_t>::size()) {
     for (; c + vec_width <= channels; c += vec_width) {
       Vec256<float> pos1_fp_v[4];
       Vec256<int32_t> pos1_int_v[4];
@@ -1690,7 +1695,7 @@ int64_t do_quantized_bilinear_on_AVX2(
         float pos1_fp[vec_width];
         pos1_int_v[i].store(pos1_int);
         vec256::convert(pos1_int, pos1_fp, vec_width);
-        pos1_fp_v[i] = Vec256<float>::loadu(pos1_fp, 8);
+        pos1_fp_v[i] = Vec256<float>::loadu(pos1_fp, vec_width);
       }
       Vec256<float> h0lambda_v(h0lambda);
       Vec256<float> h1lambda_v(h1lambda);
@@ -1936,7 +1941,7 @@ void q_batch_norm_kernel(
         reinterpret_cast<scalar_t::underlying*>(input.data_ptr());
     scalar_t::underlying* Y = reinterpret_cast<scalar_t::underlying*>(output.data_ptr());
 
-    constexpr int kVLen = 8;
+    constexpr int kVLen = Vec256<float>::size();
     const int64_t outer_size = N * HxW;
     using Vec = Vec256<scalar_t>;
     // Hoisted variables
@@ -1970,7 +1975,7 @@ void q_batch_norm_kernel(
       // for channel between 8 and 32, still use 32 width for performance
       // Benchmark shows it is faster than doing 8 channels each time
       int64_t elem_size = C - ch;
-      if ((lanes == 32) && elem_size >= kVLen) {
+      if ((lanes == 4 * kVLen) && elem_size >= kVLen) {
         int64_t vec_num = elem_size / kVLen;
         std::vector<typename scalar_t::underlying> buf_in(lanes);
         memcpy(buf_in.data(), X_ptr + ch, vec_num * kVLen); // 3 cycles
@@ -2207,7 +2212,7 @@ void quantized_normalize_kernel(
     float y_scale = Y->q_scale();
     float y_inv_scale = 1.0f / y_scale;
 
-    constexpr int kFloatVLen = 8;
+    constexpr int kFloatVLen = Vec256<float>::size();
     int64_t kIntVLen = kFloatVLen * qVec::float_num_vecs();
     int64_t kNumIntVecInLayer = N / kIntVLen;
     int64_t kNonVecRemInLayer = N % kIntVLen;
@@ -2634,6 +2639,299 @@ void dequantize_tensor_per_channel_float_qparams_cpu(
       });
 }
 
+// Copies a [rows, cols] block of quantized values into int16 with the zero
+// point subtracted, transposing it to [cols, rows] if requested. This is the
+// operand layout of the int16 dot products below.
+template <typename scalar_t>
+void qpack_s16(
+    const scalar_t* src,
+    int64_t rows,
+    int64_t cols,
+    int64_t zero_point,
+    bool transpose,
+    int16_t* dst) {
+  if (!transpose) {
+    for (int64_t i = 0; i < rows * cols; ++i) {
+      dst[i] = static_cast<int16_t>(src[i].val_ - zero_point);
+    }
+    return;
+  }
+  for (int64_t r = 0; r < rows; ++r) {
+    for (int64_t c = 0; c < cols; ++c) {
+      dst[c * rows + r] = static_cast<int16_t>(src[r * cols + c].val_ - zero_point);
+    }
+  }
+}
+
+// dot product of two int16 vectors, accumulated in int32
+int32_t qdot_s16(const int16_t* A, const int16_t* B, int64_t len) {
+  int32_t sum = 0;
+  int64_t i = 0;
+
+#if defined(CPU_CAPABILITY_AVX2) || defined(CPU_CAPABILITY_AVX512)
+  __m256i sum_v = _mm256_setzero_si256();
+  // vectorized
+  for (; i < len / 16 * 16; i += 16) {
+    __m256i a_v = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(A + i));
+    __m256i b_v = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(B + i));
+    sum_v = _mm256_add_epi32(sum_v, _mm256_madd_epi16(a_v, b_v));
+  }
+
+  alignas(64) int32_t temp[8];
+  _mm256_store_si256(reinterpret_cast<__m256i*>(temp), sum_v);
+  for (int k = 0; k < 8; ++k) {
+    sum += temp[k];
+  }
+#endif // CPU_CAPABILITY_AVX2 || CPU_CAPABILITY_AVX512
+
+  // scalar
+  for (; i < len; ++i) {
+    sum += static_cast<int32_t>(A[i]) * static_cast<int32_t>(B[i]);
+  }
+
+  return sum;
+}
+
+// out[j] = lut[x_max - x[j]] for 8-bit values x, returns the sum of out
+template <typename underlying_t>
+float qsoftmax_exp_lut(
+    const underlying_t* x,
+    underlying_t x_max,
+    const float* lut,
+    float* out,
+    int64_t len) {
+  static_assert(sizeof(underlying_t) == 1, "expected 8-bit values");
+  float sum = 0;
+  int64_t j = 0;
+
+#if defined(CPU_CAPABILITY_AVX2) || defined(CPU_CAPABILITY_AVX512)
+  const __m256i x_max_v = _mm256_set1_epi32(x_max);
+  __m256 sum_v = _mm256_setzero_ps();
+  // vectorized
+  for (; j < len / 8 * 8; j += 8) {
+    __m128i x_v = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(x + j));
+    __m256i x_s32 = std::is_signed<underlying_t>::value
+        ? _mm256_cvtepi8_epi32(x_v)
+        : _mm256_cvtepu8_epi32(x_v);
+    __m256 exp_v = _mm256_i32gather_ps(
+        lut, _mm256_sub_epi32(x_max_v, x_s32), sizeof(float));
+    _mm256_storeu_ps(out + j, exp_v);
+    sum_v = _mm256_add_ps(sum_v, exp_v);
+  }
+
+  alignas(32) float temp[8];
+  _mm256_store_ps(temp, sum_v);
+  for (int k = 0; k < 8; ++k) {
+    sum += temp[k];
+  }
+#endif // CPU_CAPABILITY_AVX2 || CPU_CAPABILITY_AVX512
+
+  // scalar
+  for (; j < len; ++j) {
+    out[j] = lut[x_max - x[j]];
+    sum += out[j];
+  }
+  return sum;
+}
+
+void qsoftmax_kernel(const Tensor& qx, Tensor& qy) {
+  const int64_t dim_size = qx.size(-1);
+  if (qx.numel() == 0) {
+    return;
+  }
+  const int64_t rows = qx.numel() / dim_size;
+  const double input_scale = qx.q_scale();
+  const double output_scale = qy.q_scale();
+  const int64_t output_zero_point = qy.q_zero_point();
+
+  AT_DISPATCH_QINT_BYTE_TYPES(qx.scalar_type(), "qsoftmax", [&]() {
+    // softmax only depends on the distance of each value to the maximum of
+    // its row, which for 8-bit inputs takes at most 256 values. Tabulate the
+    // exponentials once, like QNNPACK's softargmax does.
+    constexpr int64_t qmin = std::numeric_limits<underlying_t>::min();
+    constexpr int64_t qmax = std::numeric_limits<underlying_t>::max();
+    std::vector<float> exp_lut(qmax - qmin + 1);
+    for (int64_t d = 0; d <= qmax - qmin; ++d) {
+      exp_lut[d] = std::exp(-static_cast<double>(d) * input_scale);
+    }
+
+    const scalar_t* x_data = qx.data_ptr<scalar_t>();
+    scalar_t* y_data = qy.data_ptr<scalar_t>();
+    const int64_t grain_size =
+        std::max<int64_t>(1, internal::GRAIN_SIZE / dim_size);
+    at::parallel_for(0, rows, grain_size, [&](int64_t begin, int64_t end) {
+      using Vec = Vec256<float>;
+      std::vector<float> buffer(dim_size);
+      for (int64_t row = begin; row < end; ++row) {
+        const underlying_t* x =
+            reinterpret_cast<const underlying_t*>(x_data + row * dim_size);
+        scalar_t* y = y_data + row * dim_size;
+        const underlying_t x_max = *std::max_element(x, x + dim_size);
+        const float sum = qsoftmax_exp_lut(
+            x, x_max, exp_lut.data(), buffer.data(), dim_size);
+        const Vec inv_sum(1.0f / sum);
+        vec256::map(
+            [&inv_sum](Vec v) { return v * inv_sum; },
+            buffer.data(),
+            buffer.data(),
+            dim_size);
+        quantize_vec<scalar_t>(
+            output_scale, output_zero_point, buffer.data(), y, dim_size);
+      }
+    });
+  });
+}
+
+// Number of rows of A that share each column of B in qmatmul_kernel.
+constexpr int64_t qmatmul_block_rows = 8;
+
+void qmatmul_kernel(const Tensor& qa, const Tensor& qb, Tensor& qc) {
+  const int64_t batches = qa.size(0);
+  const int64_t M = qa.size(1);
+  const int64_t K = qa.size(2);
+  const int64_t N = qb.size(2);
+  const int64_t a_zero_point = qa.q_zero_point();
+  const int64_t b_zero_point = qb.q_zero_point();
+  const int64_t c_zero_point = qc.q_zero_point();
+  const double multiplier = qa.q_scale() * qb.q_scale() / qc.q_scale();
+
+  AT_DISPATCH_QINT_TYPES(qa.scalar_type(), "qmatmul", [&]() {
+    const scalar_t* a_data = qa.data_ptr<scalar_t>();
+    const scalar_t* b_data = qb.data_ptr<scalar_t>();
+    scalar_t* c_data = qc.data_ptr<scalar_t>();
+
+    // B^T for every batch, so that every output element is a contiguous dot
+    // product.
+    std::vector<int16_t> bt(batches * N * K);
+    at::parallel_for(0, batches, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t b = begin; b < end; ++b) {
+        qpack_s16(
+            b_data + b * K * N, K, N, b_zero_point, /*transpose=*/true,
+            bt.data() + b * N * K);
+      }
+    });
+
+    const int64_t row_blocks = divup(M, qmatmul_block_rows);
+    at::parallel_for(0, batches * row_blocks, 1, [&](int64_t begin, int64_t end) {
+      std::vector<int16_t> a_rows(qmatmul_block_rows * K);
+      for (int64_t task = begin; task < end; ++task) {
+        const int64_t b = task / row_blocks;
+        const int64_t m_begin = (task % row_blocks) * qmatmul_block_rows;
+        const int64_t m_end = std::min(m_begin + qmatmul_block_rows, M);
+        qpack_s16(
+            a_data + (b * M + m_begin) * K, m_end - m_begin, K, a_zero_point,
+            /*transpose=*/false, a_rows.data());
+        const int16_t* bt_batch = bt.data() + b * N * K;
+        for (int64_t n = 0; n < N; ++n) {
+          const int16_t* b_col = bt_batch + n * K;
+          for (int64_t m = m_begin; m < m_end; ++m) {
+            const int32_t acc =
+                qdot_s16(a_rows.data() + (m - m_begin) * K, b_col, K);
+            c_data[(b * M + m) * N + n] =
+                requantize_from_int<scalar_t>(multiplier, c_zero_point, acc);
+          }
+        }
+      }
+    });
+  });
+}
+
+void qattention_kernel(
+    const Tensor& q,
+    const Tensor& k,
+    const Tensor& v,
+    const Tensor& mask,
+    double scale,
+    Tensor& out) {
+  const int64_t batches = q.size(0);
+  const int64_t L = q.size(1);
+  const int64_t E = q.size(2);
+  const int64_t S = k.size(1);
+  const int64_t Ev = v.size(2);
+  const int64_t q_zero_point = q.q_zero_point();
+  const int64_t k_zero_point = k.q_zero_point();
+  const int64_t v_zero_point = v.q_zero_point();
+  const int64_t out_zero_point = out.q_zero_point();
+  const float score_multiplier = q.q_scale() * k.q_scale() * scale;
+  // The attention weights are kept as int16 fixed point numbers in [0, 1],
+  // so that the weighted sum of the values is an int16 dot product as well.
+  // The accumulator is bounded by 255 * (prob_one + S / 2).
+  constexpr float prob_one = std::numeric_limits<int16_t>::max();
+  const double out_multiplier = v.q_scale() / prob_one / out.q_scale();
+
+  const float* mask_data = mask.defined() ? mask.data_ptr<float>() : nullptr;
+  const int64_t mask_stride_b = mask.defined() ? mask.stride(0) : 0;
+  const int64_t mask_stride_l = mask.defined() ? mask.stride(1) : 0;
+  const int64_t mask_stride_s = mask.defined() ? mask.stride(2) : 0;
+
+  AT_DISPATCH_QINT_TYPES(q.scalar_type(), "qattention", [&]() {
+    const scalar_t* q_data = q.data_ptr<scalar_t>();
+    const scalar_t* k_data = k.data_ptr<scalar_t>();
+    const scalar_t* v_data = v.data_ptr<scalar_t>();
+    scalar_t* out_data = out.data_ptr<scalar_t>();
+
+    std::vector<int16_t> k_packed(batches * S * E);
+    std::vector<int16_t> vt_packed(batches * Ev * S);
+    at::parallel_for(0, batches, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t b = begin; b < end; ++b) {
+        qpack_s16(
+            k_data + b * S * E, S, E, k_zero_point, /*transpose=*/false,
+            k_packed.data() + b * S * E);
+        qpack_s16(
+            v_data + b * S * Ev, S, Ev, v_zero_point, /*transpose=*/true,
+            vt_packed.data() + b * Ev * S);
+      }
+    });
+
+    // One query row per task: its scores and weights never leave the
+    // per-thread buffers.
+    const int64_t grain_size =
+        std::max<int64_t>(1, internal::GRAIN_SIZE / std::max<int64_t>(1, S * (E + Ev)));
+    at::parallel_for(0, batches * L, grain_size, [&](int64_t begin, int64_t end) {
+      std::vector<int16_t> q_row(E);
+      std::vector<float> scores(S);
+      std::vector<int16_t> probs(S);
+      for (int64_t task = begin; task < end; ++task) {
+        const int64_t b = task / L;
+        const int64_t l = task % L;
+        qpack_s16(
+            q_data + task * E, 1, E, q_zero_point, /*transpose=*/false,
+            q_row.data());
+        const int16_t* k_batch = k_packed.data() + b * S * E;
+        float max_score = -std::numeric_limits<float>::infinity();
+        for (int64_t s = 0; s < S; ++s) {
+          float score = qdot_s16(q_row.data(), k_batch + s * E, E) * score_multiplier;
+          if (mask_data) {
+            score += mask_data[b * mask_stride_b + l * mask_stride_l + s * mask_stride_s];
+          }
+          scores[s] = score;
+          max_score = std::max(max_score, score);
+        }
+        if (max_score == -std::numeric_limits<float>::infinity()) {
+          // Every key is masked out: attend to nothing.
+          std::fill(probs.begin(), probs.end(), 0);
+        } else {
+          float sum = 0;
+          for (int64_t s = 0; s < S; ++s) {
+            scores[s] = std::exp(scores[s] - max_score);
+            sum += scores[s];
+          }
+          const float prob_multiplier = prob_one / sum;
+          for (int64_t s = 0; s < S; ++s) {
+            probs[s] = static_cast<int16_t>(std::nearbyint(scores[s] * prob_multiplier));
+          }
+        }
+        const int16_t* vt_batch = vt_packed.data() + b * Ev * S;
+        for (int64_t j = 0; j < Ev; ++j) {
+          const int32_t acc = qdot_s16(probs.data(), vt_batch + j * S, S);
+          out_data[task * Ev + j] =
+              requantize_from_int<scalar_t>(out_multiplier, out_zero_point, acc);
+        }
+      }
+    });
+  });
+}
+
 } // namespace
 
 REGISTER_DISPATCH(dequantize_tensor_per_channel_affine_stub,
@@ -2658,6 +2956,7 @@ REGISTER_DISPATCH(qadd_relu_stub, &qadd_kernel<true>);
 REGISTER_DISPATCH(qadd_scalar_relu_stub, &qadd_scalar_kernel<true>);
 REGISTER_DISPATCH(qadd_scalar_stub, &qadd_scalar_kernel<false>);
 REGISTER_DISPATCH(qadd_stub, &qadd_kernel<false>);
+REGISTER_DISPATCH(qattention_stub, &qattention_kernel);
 REGISTER_DISPATCH(qavg_pool2d_nhwc_stub, &qavg_pool2d_nhwc_kernel);
 REGISTER_DISPATCH(qavg_pool3d_nhwc_stub, &qavg_pool3d_nhwc_kernel);
 REGISTER_DISPATCH(qbatch_norm_relu_stub, &q_batch_norm_kernel<true>);
@@ -2668,6 +2967,7 @@ REGISTER_DISPATCH(qclamp_stub, &qclamp_kernel);
 REGISTER_DISPATCH(qelu_stub, &qelu_kernel);
 REGISTER_DISPATCH(qhardsigmoid_stub, &qhardsigmoid_kernel);
 REGISTER_DISPATCH(qhardswish_stub, &qhardswish_kernel);
+REGISTER_DISPATCH(qmatmul_stub, &qmatmul_kernel);
 REGISTER_DISPATCH(qmaxpool_2d_nhwc_stub, &qmaxpool_2d_nhwc_kernel);
 REGISTER_DISPATCH(qmul_relu_stub, &qmul_kernel<true>);
 REGISTER_DISPATCH(qmul_stub, &qmul_kernel<false>);
@@ -2675,6 +2975,7 @@ REGISTER_DISPATCH(qrelu6_stub, &qrelu6_kernel);
 REGISTER_DISPATCH(qrelu_leaky_stub, &leaky_qrelu_out_kernel);
 REGISTER_DISPATCH(qrelu_stub, &qrelu_kernel);
 REGISTER_DISPATCH(qsigmoid_stub, &qsigmoid_kernel);
+REGISTER_DISPATCH(qsoftmax_stub, &qsoftmax_kernel);
 REGISTER_DISPATCH(qtanh_stub, &qtanh_kernel);
 REGISTER_DISPATCH(qthreshold_stub, &qthreshold_kernel);
 REGISTER_DISPATCH(qtopk_stub, &qtopk_kernel);
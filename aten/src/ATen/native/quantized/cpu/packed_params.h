@@ -15,6 +15,23 @@ struct LinearPackedParamsBase : public torch::jit::CustomClassHolder {
   virtual at::Tensor apply_dynamic(at::Tensor input, bool reduce_range=false) = 0;
   virtual at::Tensor apply_dynamic_relu(at::Tensor input, bool reduce_range=false) = 0;
 
+  // Dynamic quantization with one set of activation qparams per row (token)
+  // of the input instead of one for the whole tensor.
+  virtual at::Tensor apply_dynamic_per_token(
+      at::Tensor input,
+      bool reduce_range = false) {
+    throw std::runtime_error(
+        "apply_dynamic_per_token is not implemented for this packed "
+        "parameter type");
+  }
+  virtual at::Tensor apply_dynamic_per_token_relu(
+      at::Tensor input,
+      bool reduce_range = false) {
+    throw std::runtime_error(
+        "apply_dynamic_per_token_relu is not implemented for this packed "
+        "parameter type");
+  }
+
   virtual std::tuple<at::Tensor, c10::optional<at::Tensor>> unpack() = 0;
 
   virtual c10::optional<at::Tensor> bias() = 0;
@@ -0,0 +1,141 @@
+#include <ATen/ATen.h>
+#include <ATen/ExpandUtils.h>
+#include <torch/library.h>
+#include <ATen/quantized/Quantizer.h>
+#include <ATen/native/quantized/cpu/quantized_ops.h>
+
+#include <limits>
+
+namespace at {
+namespace native {
+
+DEFINE_DISPATCH(qattention_stub);
+
+namespace {
+
+// Fused softmax(query x key^T * scale + attn_mask) x value.
+//
+// query is [..., L, E], key is [..., S, E] and value is [..., S, Ev], and the
+// leading dimensions are broadcast as in torch.matmul. attn_mask is
+// broadcastable to [..., L, S]; a float mask is added to the scores, and a
+// bool mask marks the positions that are not allowed to attend, as in
+// nn.MultiheadAttention.
+//
+// 1D inputs follow torch.matmul as well: a 1D query is a single row and a 1D
+// value a single column, and their added dimension is removed from the
+// result. The exception is a 1D query against a batched key, where the batch
+// dimensions of the scores become the rows of the second product; that case
+// is computed on the dequantized inputs.
+//
+// Unlike the quantized::matmul / quantized::softmax / quantized::matmul
+// sequence, the scores and attention weights are never materialized as
+// quantized tensors, so there are no intermediate quantization parameters to
+// calibrate.
+Tensor quantized_scaled_dot_product_attention(
+    Tensor query,
+    Tensor key,
+    Tensor value,
+    double scale,
+    double output_scale,
+    int64_t output_zero_point,
+    c10::optional<Tensor> attn_mask) {
+  for (const Tensor* t : {&query, &key, &value}) {
+    TORCH_CHECK(t->qscheme() == kPerTensorAffine,
+                "quantized::scaled_dot_product_attention only supports per tensor quantized inputs");
+    TORCH_CHECK(t->scalar_type() == query.scalar_type(),
+                "quantized::scaled_dot_product_attention: query, key and value should have the same dtype");
+  }
+  TORCH_CHECK(query.scalar_type() == kQUInt8 || query.scalar_type() == kQInt8,
+              "quantized::scaled_dot_product_attention only supports quint8 and qint8 inputs, got ",
+              toString(query.scalar_type()));
+  TORCH_CHECK(query.dim() >= 1 && key.dim() >= 2 && value.dim() >= 1,
+              "quantized::scaled_dot_product_attention: query and value should have at least 1 "
+              "dimension and key at least 2, got ", query.dim(), "D, ", key.dim(), "D and ",
+              value.dim(), "D");
+
+  Tensor mask;
+  if (attn_mask.has_value() && attn_mask->defined()) {
+    mask = *attn_mask;
+    if (mask.scalar_type() == kBool) {
+      mask = at::zeros(mask.sizes(), mask.options().dtype(kFloat))
+                 .masked_fill_(mask, -std::numeric_limits<float>::infinity());
+    }
+    TORCH_CHECK(mask.scalar_type() == kFloat,
+                "quantized::scaled_dot_product_attention: attn_mask should be a bool or float tensor, got ",
+                mask.scalar_type());
+  }
+
+  if (query.dim() == 1 && key.dim() > 2) {
+    auto scores = at::matmul(query.dequantize(), key.dequantize().transpose(-2, -1)).mul_(scale);
+    if (mask.defined()) {
+      scores = scores + mask;
+    }
+    auto out = at::matmul(at::softmax(scores, -1), value.dequantize());
+    return at::quantize_per_tensor(out, output_scale, output_zero_point, query.scalar_type());
+  }
+
+  const bool query_vector = query.dim() == 1;
+  const bool value_vector = value.dim() == 1;
+  if (query_vector) {
+    query = query.reshape({1, query.size(0)});
+  }
+  if (value_vector) {
+    value = value.reshape({value.size(0), 1});
+  }
+  const int64_t L = query.size(-2);
+  const int64_t E = query.size(-1);
+  const int64_t S = key.size(-2);
+  const int64_t Ev = value.size(-1);
+  TORCH_CHECK(key.size(-1) == E && value.size(-2) == S,
+              "quantized::scaled_dot_product_attention: shape mismatch, got query ", query.sizes(),
+              ", key ", key.sizes(), " and value ", value.sizes());
+
+  IntArrayRef query_batch(query.sizes().data(), query.dim() - 2);
+  IntArrayRef key_batch(key.sizes().data(), key.dim() - 2);
+  IntArrayRef value_batch(value.sizes().data(), value.dim() - 2);
+  std::vector<int64_t> batch =
+      infer_size(infer_size(query_batch, key_batch), value_batch);
+  const int64_t batches = prod_intlist(batch);
+  // Broadcast batch dimensions are expanded with zero strides and flattened
+  // without copying wherever the strides allow it.
+  auto flatten = [&](const Tensor& t, int64_t rows, int64_t cols) {
+    std::vector<int64_t> sizes(batch);
+    sizes.insert(sizes.end(), {rows, cols});
+    return t.expand(sizes).reshape({batches, rows, cols});
+  };
+
+  if (mask.defined()) {
+    mask = flatten(mask, L, S);
+  }
+
+  std::vector<int64_t> out_sizes(batch);
+  if (!query_vector) {
+    out_sizes.push_back(L);
+  }
+  if (!value_vector) {
+    out_sizes.push_back(Ev);
+  }
+  auto out = at::_empty_affine_quantized(
+      {batches, L, Ev},
+      at::device(kCPU).dtype(query.scalar_type()),
+      output_scale,
+      output_zero_point);
+  if (out.numel() > 0) {
+    qattention_stub(
+        query.device().type(),
+        flatten(query, L, E).contiguous(),
+        flatten(key, S, E).contiguous(),
+        flatten(value, S, Ev).contiguous(),
+        mask,
+        scale,
+        out);
+  }
+  return out.view(out_sizes);
+}
+
+TORCH_LIBRARY_IMPL(quantized, QuantizedCPU, m) {
+  m.impl("scaled_dot_product_attention", TORCH_FN(quantized_scaled_dot_product_attention));
+}
+
+} // namespace
+}}  // namespace at::native
@@ -9,6 +9,10 @@
 
 #include <ATen/Parallel.h>
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
 torch::class_<EmbeddingPackedParamsBase> register_embedding_params();
 
 at::Tensor PackedEmbeddingBagWeight::embeddingbag_byte(
@@ -109,6 +113,107 @@ namespace at {
 namespace native {
 namespace {
 
+// Returns the compressed_indices_mapping data if the table is row-wise
+// pruned. Like the Caffe2 SparseLengths*RowwiseSparse ops, a mapping of [0]
+// indicates that the table was not pruned and the dense kernels are used.
+const int32_t* get_compressed_indices_mapping(
+    const c10::optional<Tensor>& compressed_indices_mapping,
+    int64_t* compressed_index_size) {
+  *compressed_index_size = 0;
+  if (!compressed_indices_mapping.has_value()) {
+    return nullptr;
+  }
+  const Tensor& mapping = compressed_indices_mapping.value();
+  TORCH_CHECK(
+      mapping.scalar_type() == at::kInt && mapping.dim() == 1 &&
+          mapping.is_contiguous(),
+      "compressed_indices_mapping must be a contiguous 1D int32 tensor");
+  const int32_t* mapping_data = mapping.data_ptr<int32_t>();
+  if (mapping.numel() == 1 && mapping_data[0] == 0) {
+    return nullptr;
+  }
+  *compressed_index_size = mapping.numel();
+  return mapping_data;
+}
+
+// Reference implementation of the row-wise quantized embedding bag (sum mode),
+// used when FBGEMM is not available. Each row of weight holds bit_width-bit
+// values, NUM_ELEM_PER_BYTE to a byte, followed by the row's scale and bias:
+// fp32 for 8-bit rows and fp16 for the sub-byte ones. With a
+// compressed_indices_mapping, indices refer to rows of the unpruned table and
+// are remapped to rows of weight, skipping the pruned ones (-1).
+template <typename OffsetType>
+void embedding_bag_rowwise_fallback(
+    const int bit_width,
+    const Tensor& weight,
+    const int64_t* indices_data,
+    const int64_t index_size,
+    const OffsetType* offsets_data, // output_size + 1 entries
+    const int64_t output_size,
+    const float* per_sample_weights_data,
+    const int32_t* compressed_indices_mapping_data,
+    const int64_t compressed_index_size,
+    const int64_t block_size,
+    float* output_data) {
+  const int64_t N = weight.size(0);
+  const int64_t row_bytes = weight.size(1);
+  const uint8_t* weight_data = weight.data_ptr<uint8_t>();
+  const int NUM_ELEM_PER_BYTE = 8 / bit_width;
+  const int64_t scale_bias_offset =
+      (block_size + NUM_ELEM_PER_BYTE - 1) / NUM_ELEM_PER_BYTE;
+
+  at::parallel_for(0, output_size, 1, [&](int64_t start_idx, int64_t end_idx) {
+    for (int64_t m = start_idx; m < end_idx; ++m) {
+      float* output_row = output_data + m * block_size;
+      std::fill(output_row, output_row + block_size, 0.f);
+      TORCH_CHECK(
+          offsets_data[m] <= offsets_data[m + 1] &&
+              offsets_data[m + 1] <= index_size,
+          "Expect the lengths data to be less than indices size");
+
+      for (int64_t current = offsets_data[m]; current < offsets_data[m + 1];
+           ++current) {
+        int64_t idx = indices_data[current];
+        if (compressed_indices_mapping_data) {
+          TORCH_CHECK(
+              idx >= 0 && idx < compressed_index_size,
+              "Invalid indices data for Sparse Op.");
+          idx = compressed_indices_mapping_data[idx];
+          if (idx == -1) {
+            continue;
+          }
+        }
+        TORCH_CHECK(idx >= 0 && idx < N, "Invalid indices data");
+        const uint8_t* input_row = weight_data + idx * row_bytes;
+
+        float scale, bias;
+        if (bit_width == 8) {
+          const float* scale_bias =
+              reinterpret_cast<const float*>(input_row + scale_bias_offset);
+          scale = scale_bias[0];
+          bias = scale_bias[1];
+        } else {
+          const at::Half* scale_bias =
+              reinterpret_cast<const at::Half*>(input_row + scale_bias_offset);
+          scale = scale_bias[0];
+          bias = scale_bias[1];
+        }
+        if (per_sample_weights_data) {
+          scale *= per_sample_weights_data[current];
+          bias *= per_sample_weights_data[current];
+        }
+
+        for (int64_t j = 0; j < block_size; ++j) {
+          uint8_t quantized = input_row[j / NUM_ELEM_PER_BYTE];
+          quantized >>= (j % NUM_ELEM_PER_BYTE) * bit_width;
+          quantized &= (1 << bit_width) - 1;
+          output_row[j] = fma(scale, quantized, output_row[j] + bias);
+        }
+      } // for each index
+    } // for each bag
+  });
+}
+
 Tensor embedding_bag_byte_rowwise_offsets(
     const Tensor& weight,
     const Tensor& indices,
@@ -117,16 +222,23 @@ Tensor embedding_bag_byte_rowwise_offsets(
     const int64_t /* mode */,
     bool /* sparse */,
     const c10::optional<Tensor>& per_sample_weights_,
-    bool include_last_offset) {
+    bool include_last_offset,
+    const c10::optional<Tensor>& compressed_indices_mapping) {
   TORCH_CHECK(weight.scalar_type() == at::kByte);
   TORCH_CHECK(weight.ndimension() == 2);
   TORCH_CHECK(offsets_in.has_value(), "embedding_bag_byte_rowwise_offsets expects offsets to be set");
 
   auto offsets = offsets_in.value();
   auto offsets_data = offsets.data_ptr<int64_t>();
-  const auto weight_data = weight.data_ptr<uint8_t>();
+  const auto weight_contig = weight.contiguous();
+  const auto weight_data = weight_contig.data_ptr<uint8_t>();
   const auto indices_data = indices.data_ptr<int64_t>();
 
+  int64_t compressed_index_size = 0;
+  const int32_t* compressed_indices_mapping_data =
+      get_compressed_indices_mapping(
+          compressed_indices_mapping, &compressed_index_size);
+
   const int64_t N = weight.size(0);
   const int64_t D = weight.size(1) - 8; // NB: -8 to account for scale and bias
   const int64_t M = offsets.size(0);
@@ -137,10 +249,12 @@ Tensor embedding_bag_byte_rowwise_offsets(
   if (!include_last_offset) {
     output_size = M;
     offsets_include_last.resize(M + 1);
-    std::memcpy(
-        offsets_include_last.data(),
-        offsets.data_ptr<int64_t>(),
-        sizeof(int64_t) * M);
+    if (M > 0) {
+      std::memcpy(
+          offsets_include_last.data(),
+          offsets.data_ptr<int64_t>(),
+          sizeof(int64_t) * M);
+    }
     offsets_include_last[M] = indices.numel();
     offsets_data = offsets_include_last.data();
   }
@@ -148,19 +262,21 @@ Tensor embedding_bag_byte_rowwise_offsets(
   std::vector<int64_t> shape = {output_size, D};
   auto output = at::empty(shape, weight.options().dtype(at::kFloat));
   auto* output_data = output.data_ptr<float>();
+  const float* per_sample_weights_data = per_sample_weights_.has_value()
+      ? per_sample_weights_.value().data_ptr<float>()
+      : nullptr;
 
 #ifdef USE_FBGEMM
+  if (!compressed_indices_mapping_data) {
+    auto kernel_i8_i64 =
+        fbgemm::GenerateEmbeddingSpMDM<uint8_t, int64_t, int64_t>(
+            /*block_size=*/D,
+            /*has_weight=*/per_sample_weights_.has_value(),
+            /*normalize_by_lengths=*/false,
+            /*prefetch=*/16, // NOLINT(cppcoreguidelines-avoid-magic-numbers)
+            /*is_weight_positional=*/false,
+            /*use_offsets=*/true);
 
-  auto kernel_i8_i64 =
-      fbgemm::GenerateEmbeddingSpMDM<uint8_t, int64_t, int64_t>(
-          /*block_size=*/D,
-          /*has_weight=*/per_sample_weights_.has_value(),
-          /*normalize_by_lengths=*/false,
-          /*prefetch=*/16, // NOLINT(cppcoreguidelines-avoid-magic-numbers)
-          /*is_weight_positional=*/false,
-          /*use_offsets=*/true);
-
-  if (weight.is_contiguous()) {
     at::parallel_for(
         0, output_size, 1, [&](int64_t start_idx, int64_t end_idx) {
           bool success = kernel_i8_i64(
@@ -171,9 +287,8 @@ Tensor embedding_bag_byte_rowwise_offsets(
               /*indices=*/indices_data + offsets_data[start_idx],
               /*offsets_or_lengths=*/offsets_data + start_idx,
               /*weights=*/
-              per_sample_weights_
-                  ? per_sample_weights_.value().data_ptr<float>() +
-                      offsets_data[start_idx]
+              per_sample_weights_data
+                  ? per_sample_weights_data + offsets_data[start_idx]
                   : nullptr,
               /*out=*/output_data + start_idx * D);
 
@@ -182,44 +297,79 @@ Tensor embedding_bag_byte_rowwise_offsets(
               "FBGEMM GenerateEmbeddingSpMDM kernel failed for 8-bit input");
         });
   } else {
-    auto weight_contig = weight.contiguous();
-    const auto weight_data_contig = weight_contig.data_ptr<uint8_t>();
+    // The row-wise sparse kernels expect int32 offsets.
+    TORCH_CHECK(
+        offsets_data[output_size] <= std::numeric_limits<int32_t>::max(),
+        "embedding_bag_byte_rowwise_offsets with compressed_indices_mapping "
+        "supports at most ",
+        std::numeric_limits<int32_t>::max(),
+        " indices, got ",
+        offsets_data[output_size]);
+    std::vector<int32_t> offsets_int(
+        offsets_data, offsets_data + output_size + 1);
+    auto kernel_i8_i64 =
+        fbgemm::GenerateEmbeddingSpMDMRowWiseSparse<uint8_t, int64_t>(
+            /*block_size=*/D,
+            /*has_weight=*/per_sample_weights_.has_value(),
+            /*normalize_by_lengths=*/false,
+            /*prefetch=*/16, // NOLINT(cppcoreguidelines-avoid-magic-numbers)
+            /*is_weight_positional=*/false,
+            /*use_offsets=*/true);
+
     at::parallel_for(
         0, output_size, 1, [&](int64_t start_idx, int64_t end_idx) {
           bool success = kernel_i8_i64(
               /*output_size=*/end_idx - start_idx,
-              /*index_size=*/offsets_data[end_idx] - offsets_data[start_idx],
-              /*data_size=*/N,
-              /*input=*/weight_data_contig,
-              /*indices=*/indices_data + offsets_data[start_idx],
-              /*offsets_or_lengths=*/offsets_data + start_idx,
+              /*index_size=*/offsets_int[end_idx] - offsets_int[start_idx],
+              /*uncompressed_data_size=*/compressed_index_size,
+              /*input=*/weight_data,
+              /*indices=*/indices_data + offsets_int[start_idx],
+              /*offsets_or_lengths=*/offsets_int.data() + start_idx,
               /*weights=*/
-              per_sample_weights_
-                  ? per_sample_weights_.value().data_ptr<float>() +
-                      offsets_data[start_idx]
+              per_sample_weights_data
+                  ? per_sample_weights_data + offsets_int[start_idx]
                   : nullptr,
-              /*out=*/output_data + start_idx * D);
+              /*out=*/output_data + start_idx * D,
+              /*compressed_indices_table=*/compressed_indices_mapping_data);
+
           TORCH_CHECK(
               success,
-              "FBGEMM GenerateEmbeddingSpMDM kernel failed for 8-bit input");
+              "FBGEMM GenerateEmbeddingSpMDMRowWiseSparse kernel failed for 8-bit input");
         });
   }
+#else
+  embedding_bag_rowwise_fallback<int64_t>(
+      /*bit_width=*/8,
+      weight_contig,
+      indices_data,
+      indices.numel(),
+      offsets_data,
+      output_size,
+      per_sample_weights_data,
+      compressed_indices_mapping_data,
+      compressed_index_size,
+      D,
+      output_data);
 #endif
   return output;
 }
 
-Tensor embedding_bag_4bit_rowwise_offsets(
+// Shared implementation of the 4-bit and 2-bit row-wise embedding bags. Each
+// packed row holds D / (8 / bit_width) bytes of data followed by an fp16
+// scale and an fp16 bias (see qembeddingbag_nbit_prepack_helper).
+Tensor embedding_bag_nbit_helper(
+    const int bit_width,
     const Tensor& weight,
     const Tensor& indices,
     const c10::optional<Tensor>& offsets_in,
-    const bool /* scale_grad_by_freq */,
-    const int64_t /* mode */,
-    bool sparse,
     const c10::optional<Tensor>& per_sample_weights_,
     const c10::optional<Tensor>& compressed_indices_mapping,
     bool include_last_offset) {
-  TORCH_CHECK(offsets_in.has_value(), "embedding_bag_4bit_rowwise_offsets expects offsets to be set");
+  TORCH_CHECK(
+      offsets_in.has_value(),
+      "embedding_bag_", bit_width, "bit_rowwise_offsets expects offsets to be set");
 
+  TORCH_CHECK(weight.scalar_type() == at::kByte);
   TORCH_CHECK(weight.ndimension() == 2);
   TORCH_CHECK(indices.ndimension() == 1);
 
@@ -227,31 +377,23 @@ Tensor embedding_bag_4bit_rowwise_offsets(
   TORCH_CHECK(offsets.ndimension() == 1);
 
   // FBGEMM expects the offsets to be of int type.
-  at::Tensor offsets_new = offsets.toType(ScalarType::Int);
-
+  at::Tensor offsets_new = offsets.toType(ScalarType::Int).contiguous();
   auto offsets_data = offsets_new.data_ptr<int>();
-  const auto weight_data = weight.data_ptr<uint8_t>();
-  uint8_t* input_data = nullptr;
-  if (!weight.is_contiguous()) {
-    auto weight_contig = weight.contiguous();
-    input_data = weight_contig.data_ptr<uint8_t>();
-  } else {
-    input_data = weight.data_ptr<uint8_t>();
-  }
 
-  // Get compressed indices for sparse op.
-  int32_t* compressed_indices_mapping_data = nullptr;
-  int compressed_index_size = 0;
-  if (sparse) {
-    compressed_index_size = compressed_indices_mapping.value().numel();
-    compressed_indices_mapping_data =
-        compressed_indices_mapping.value().data_ptr<int32_t>();
-  }
+  const auto weight_contig = weight.contiguous();
+  const uint8_t* input_data = weight_contig.data_ptr<uint8_t>();
+
+  // Get compressed indices for the row-wise pruned (sparse) op.
+  int64_t compressed_index_size = 0;
+  const int32_t* compressed_indices_mapping_data =
+      get_compressed_indices_mapping(
+          compressed_indices_mapping, &compressed_index_size);
 
   const auto indices_data = indices.data_ptr<int64_t>();
+  const int NUM_ELEM_PER_BYTE = 8 / bit_width;
   const int64_t N = weight.size(0);
-  const int64_t D =
-      (weight.size(1) - 4) * 2; // NB: 2-byte fp16 scale and 2-byte zero_offset
+  const int64_t D = (weight.size(1) - 2 * sizeof(at::Half)) *
+      NUM_ELEM_PER_BYTE; // NB: 2-byte fp16 scale and 2-byte zero_offset
   const int64_t M = offsets.size(0);
 
   int64_t output_size = M - 1;
@@ -273,14 +415,18 @@ Tensor embedding_bag_4bit_rowwise_offsets(
   auto output = at::empty(shape, weight.options().dtype(at::kFloat));
   auto* output_data = output.data_ptr<float>();
   const int64_t block_size = output.size(1);
-  TORCH_CHECK(block_size % 2 == 0, "block size must be divisible by 2");
-  const int index_size = indices.numel();
+  TORCH_CHECK(
+      block_size % NUM_ELEM_PER_BYTE == 0,
+      "block size must be divisible by ", NUM_ELEM_PER_BYTE);
+  const float* per_sample_weights_data = per_sample_weights_.has_value()
+      ? per_sample_weights_.value().data_ptr<float>()
+      : nullptr;
   constexpr int prefetch_distance = 16;
 #ifdef USE_FBGEMM
-  if (!sparse) {
+  if (!compressed_indices_mapping_data) {
     // Generate the fbgemm kernel
     auto kernel_64_ = fbgemm::GenerateEmbeddingSpMDMNBit<std::int64_t>(
-        /*bit rate=*/4,
+        /*bit rate=*/bit_width,
         /*block size=*/block_size,
         /*has weights=*/per_sample_weights_.has_value(),
         /*normalize_by_lengths=*/false,
@@ -288,115 +434,118 @@ Tensor embedding_bag_4bit_rowwise_offsets(
         /*is_weight_positional=*/false,
         /*use_offsets=*/true);
 
-    bool success = kernel_64_(
-        /*output_size=*/output_size,
-        /*index_size=*/index_size,
-        /*data_size=*/N,
-        /*input=*/input_data,
-        /*indices=*/indices_data,
-        /*offsets=*/offsets_data,
-        /*weights=*/
-        per_sample_weights_.has_value()
-            ? per_sample_weights_.value().data_ptr<float>()
-            : nullptr,
-        /*output=*/output_data);
+    at::parallel_for(
+        0, output_size, 1, [&](int64_t start_idx, int64_t end_idx) {
+          bool success = kernel_64_(
+              /*output_size=*/end_idx - start_idx,
+              /*index_size=*/offsets_data[end_idx] - offsets_data[start_idx],
+              /*data_size=*/N,
+              /*input=*/input_data,
+              /*indices=*/indices_data + offsets_data[start_idx],
+              /*offsets=*/offsets_data + start_idx,
+              /*weights=*/
+              per_sample_weights_data
+                  ? per_sample_weights_data + offsets_data[start_idx]
+                  : nullptr,
+              /*output=*/output_data + start_idx * block_size);
 
-    TORCH_CHECK(
-        success,
-        "FBGEMM GenerateEmbeddingSpMDMNBit kernel failed for 4-bit input");
+          TORCH_CHECK(
+              success,
+              "FBGEMM GenerateEmbeddingSpMDMNBit kernel failed for ",
+              bit_width,
+              "-bit input");
+        });
   } else {
     auto kernel_64_ =
         fbgemm::GenerateEmbeddingSpMDMNBitRowWiseSparse<std::int64_t>(
-            /*bit rate=*/4,
+            /*bit rate=*/bit_width,
             /*block_size=*/block_size,
             /*has weights=*/per_sample_weights_.has_value(),
             /*normalize_by_lengths=*/false,
             /*prefetch distance*/ prefetch_distance,
             /*is_weight_positional*/ false,
             /*use_offsets*/ true);
-    bool success = kernel_64_(
-        /*output_size=*/output_size,
-        /*index_size=*/index_size,
-        /*data_size=*/compressed_index_size,
-        /*input=*/weight_data,
-        /*indices=*/indices_data,
-        /*offsets=*/offsets_data,
-        /*weights=*/
-        per_sample_weights_.has_value()
-            ? per_sample_weights_.value().data_ptr<float>()
-            : nullptr,
-        /*output=*/output_data,
-        /*compressed_indices_table=*/compressed_indices_mapping_data);
-    TORCH_CHECK(
-        success,
-        "FBGEMM GenerateEmbeddingSpMDMNBitRowWiseSparse kernel failed for 4-bit input");
-  }
-#else
-
-  auto accessor = offsets.accessor<int64_t, 1>();
-  std::vector<int> lengths_data;
 
-  int64_t lower = accessor[0];
-  for (int64_t i = 1; i < offsets.numel(); ++i) {
-    lengths_data.push_back(accessor[i] - lower);
-    lower = accessor[i];
-  }
-  if (!include_last_offset) {
-    lengths_data.push_back(indices.numel() - lower);
-  }
+    at::parallel_for(
+        0, output_size, 1, [&](int64_t start_idx, int64_t end_idx) {
+          bool success = kernel_64_(
+              /*output_size=*/end_idx - start_idx,
+              /*index_size=*/offsets_data[end_idx] - offsets_data[start_idx],
+              /*data_size=*/compressed_index_size,
+              /*input=*/input_data,
+              /*indices=*/indices_data + offsets_data[start_idx],
+              /*offsets=*/offsets_data + start_idx,
+              /*weights=*/
+              per_sample_weights_data
+                  ? per_sample_weights_data + offsets_data[start_idx]
+                  : nullptr,
+              /*output=*/output_data + start_idx * block_size,
+              /*compressed_indices_table=*/compressed_indices_mapping_data);
 
-  int64_t current = 0;
-  float* per_sample_weights_data;
-  if (per_sample_weights_.has_value()) {
-    per_sample_weights_data = per_sample_weights_.value().data_ptr<float>();
+          TORCH_CHECK(
+              success,
+              "FBGEMM GenerateEmbeddingSpMDMNBitRowWiseSparse kernel failed for ",
+              bit_width,
+              "-bit input");
+        });
   }
-  for (int m = 0; m < output_size; ++m) {
-    memset(output_data, 0, block_size * sizeof(float));
-    TORCH_CHECK(
-        current + lengths_data[m] <= index_size,
-        "Expect the lengths data to be less than indices size");
-
-    for (int i = 0; i < lengths_data[m]; ++i, ++current) {
-      int64_t idx;
-      if (!sparse) {
-        idx = indices_data[current];
-        TORCH_CHECK((idx >= 0 && idx < N), "Invalid indices data");
-      } else {
-        int64_t uncompressed_idx = indices_data[current];
-        TORCH_CHECK(
-            uncompressed_idx >= 0 && uncompressed_idx < compressed_index_size,
-            "Invalid indices data for Sparse Op.")
-        idx = compressed_indices_mapping_data[uncompressed_idx];
-        if (idx == -1) {
-          continue;
-        }
-      }
-      const at::Half* scale_bias = reinterpret_cast<const at::Half*>(
-          input_data + (idx + 1) * weight.size(1) - 2 * sizeof(at::Half));
-
-      float weight_val = 1.0f;
-      if (per_sample_weights_.has_value()) {
-        weight_val = per_sample_weights_data[current];
-      }
-      const float scale = weight_val * scale_bias[0];
-      const float bias = weight_val * scale_bias[1];
-
-      for (int j = 0; j < block_size; ++j) {
-        uint8_t quantized =
-            input_data[idx * weight.size(1) + j / /*NUM_ELEM_PER_BYTE*/ 2];
-        quantized >>= (j % 2) * 4;
-        quantized &= (1 << 4) - 1;
-
-        output_data[j] = fma(scale, quantized, output_data[j] + bias);
-      }
-    } // for each i
-    output_data += block_size;
-  } // for each m
-
+#else
+  embedding_bag_rowwise_fallback<int>(
+      bit_width,
+      weight_contig,
+      indices_data,
+      indices.numel(),
+      offsets_data,
+      output_size,
+      per_sample_weights_data,
+      compressed_indices_mapping_data,
+      compressed_index_size,
+      block_size,
+      output_data);
 #endif
   return output;
 }
 
+Tensor embedding_bag_4bit_rowwise_offsets(
+    const Tensor& weight,
+    const Tensor& indices,
+    const c10::optional<Tensor>& offsets_in,
+    const bool /* scale_grad_by_freq */,
+    const int64_t /* mode */,
+    bool /* sparse */,
+    const c10::optional<Tensor>& per_sample_weights_,
+    const c10::optional<Tensor>& compressed_indices_mapping,
+    bool include_last_offset) {
+  return embedding_bag_nbit_helper(
+      4 /*bit_width*/,
+      weight,
+      indices,
+      offsets_in,
+      per_sample_weights_,
+      compressed_indices_mapping,
+      include_last_offset);
+}
+
+Tensor embedding_bag_2bit_rowwise_offsets(
+    const Tensor& weight,
+    const Tensor& indices,
+    const c10::optional<Tensor>& offsets_in,
+    const bool /* scale_grad_by_freq */,
+    const int64_t /* mode */,
+    bool /* sparse */,
+    const c10::optional<Tensor>& per_sample_weights_,
+    const c10::optional<Tensor>& compressed_indices_mapping,
+    bool include_last_offset) {
+  return embedding_bag_nbit_helper(
+      2 /*bit_width*/,
+      weight,
+      indices,
+      offsets_in,
+      per_sample_weights_,
+      compressed_indices_mapping,
+      include_last_offset);
+}
+
 template <int bit_rate>
 class QEmbeddingBag final {
  public:
@@ -429,6 +578,8 @@ TORCH_LIBRARY_IMPL(quantized, CPU, m) {
       "embedding_bag_byte_rowwise_offsets", embedding_bag_byte_rowwise_offsets);
   m.impl(
       "embedding_bag_4bit_rowwise_offsets", embedding_bag_4bit_rowwise_offsets);
+  m.impl(
+      "embedding_bag_2bit_rowwise_offsets", embedding_bag_2bit_rowwise_offsets);
 }
 } // namespace
 } // namespace native
@@ -87,12 +87,15 @@ Tensor qembeddingbag_byte_unpack(const Tensor& packed_weight) {
   return output;
 }
 
-Tensor qembeddingbag_4bit_unpack(const Tensor& packed_weight) {
+// Inverse of qembeddingbag_nbit_prepack_helper: each packed row holds
+// 8 / bit_width values per byte followed by an fp16 scale and bias.
+Tensor qembeddingbag_nbit_unpack_helper(
+    const Tensor& packed_weight,
+    int BIT_RATE) {
   const auto input_rows = packed_weight.size(0);
   const auto input_columns = packed_weight.size(1);
   const auto* input_data = packed_weight.data_ptr<uint8_t>();
-  constexpr int NUM_ELEM_PER_BYTE = 2;
-  constexpr int BIT_RATE = 4;
+  const int NUM_ELEM_PER_BYTE = 8 / BIT_RATE;
 
   // The last 4 bytes per row are two fp16 scale and zero_point.
   // The rest of input_columns is the number of values in the original row.
@@ -107,25 +110,35 @@ Tensor qembeddingbag_4bit_unpack(const Tensor& packed_weight) {
       packed_weight.suggest_memory_format());
   float* output_data = output.data_ptr<float>();
   auto output_columns = output_dimensions[1];
-  for (size_t row = 0; row < input_rows; ++row) {
-    float* output_row = output_data + row * output_columns;
-    const std::uint8_t* input_row = input_data + row * input_columns;
-    const at::Half* input_row_scale_zp = reinterpret_cast<const at::Half*>(
-        input_row +
-        (output_columns + NUM_ELEM_PER_BYTE - 1) / NUM_ELEM_PER_BYTE);
-    float scale = input_row_scale_zp[0];
-    float zero_point = input_row_scale_zp[1];
-
-    for (int col = 0; col < output_columns; ++col) {
-      std::uint8_t quantized = input_row[col / NUM_ELEM_PER_BYTE];
-      quantized >>= (col % NUM_ELEM_PER_BYTE) * BIT_RATE;
-      quantized &= (1 << BIT_RATE) - 1;
-      output_row[col] = scale * quantized + zero_point;
-    } // output_columns
-  } // input_rows
+  at::parallel_for(0, input_rows, 1, [&](int64_t start_idx, int64_t end_idx) {
+    for (int64_t row = start_idx; row < end_idx; ++row) {
+      float* output_row = output_data + row * output_columns;
+      const std::uint8_t* input_row = input_data + row * input_columns;
+      const at::Half* input_row_scale_zp = reinterpret_cast<const at::Half*>(
+          input_row +
+          (output_columns + NUM_ELEM_PER_BYTE - 1) / NUM_ELEM_PER_BYTE);
+      float scale = input_row_scale_zp[0];
+      float zero_point = input_row_scale_zp[1];
+
+      for (int col = 0; col < output_columns; ++col) {
+        std::uint8_t quantized = input_row[col / NUM_ELEM_PER_BYTE];
+        quantized >>= (col % NUM_ELEM_PER_BYTE) * BIT_RATE;
+        quantized &= (1 << BIT_RATE) - 1;
+        output_row[col] = scale * quantized + zero_point;
+      } // output_columns
+    } // input_rows
+  });
   return output;
 }
 
+Tensor qembeddingbag_4bit_unpack(const Tensor& packed_weight) {
+  return qembeddingbag_nbit_unpack_helper(packed_weight, 4 /*BIT_RATE*/);
+}
+
+Tensor qembeddingbag_2bit_unpack(const Tensor& packed_weight) {
+  return qembeddingbag_nbit_unpack_helper(packed_weight, 2 /*BIT_RATE*/);
+}
+
 class QEmbeddingUnpackWeights final {
  public:
   static at::Tensor run(
@@ -137,6 +150,7 @@ class QEmbeddingUnpackWeights final {
 TORCH_LIBRARY_IMPL(quantized, CPU, m) {
   m.impl("embedding_bag_byte_unpack", qembeddingbag_byte_unpack);
   m.impl("embedding_bag_4bit_unpack", qembeddingbag_4bit_unpack);
+  m.impl("embedding_bag_2bit_unpack", qembeddingbag_2bit_unpack);
 }
 
 TORCH_LIBRARY_IMPL(quantized, CatchAll, m) {
@@ -0,0 +1,355 @@
+#include <ATen/ATen.h>
+#include <ATen/Parallel.h>
+#include <ATen/native/BlockSparseLinear.h>
+#include <ATen/native/quantized/affine_quantizer.h>
+#include <ATen/native/quantized/cpu/packed_params.h>
+#include <ATen/native/quantized/cpu/quant_utils.h>
+#include <torch/custom_class.h>
+#include <torch/library.h>
+
+#include <algorithm>
+
+torch::class_<LinearPackedParamsBase> register_linear_params();
+
+namespace at {
+namespace native {
+namespace {
+
+// Block-sparse int8 linear weight, usable with quantized::linear,
+// quantized::linear_dynamic and their relu variants like the FBGEMM and
+// QNNPACK packed weights. The kept blocks store weight - zero_point, so the
+// kernel only accumulates (x - x_zp) * (w - w_zp) over the non-zero blocks.
+//
+// NB: pickling goes through LinearPackedParamsBase, whose __setstate__
+// repacks the unpacked weight densely for the current engine. Run the block
+// sparse prepack again (or the JIT pass) after loading a model.
+struct PackedLinearWeightBlockSparse : public LinearPackedParamsBase {
+  PackedLinearWeightBlockSparse(
+      BlockSparseMatrix<int16_t> w,
+      c10::optional<at::Tensor> bias,
+      std::vector<float> w_scale,
+      std::vector<int32_t> w_zp,
+      c10::QScheme q_scheme)
+      : w(std::move(w)),
+        bias_(std::move(bias)),
+        w_scale(std::move(w_scale)),
+        w_zp(std::move(w_zp)),
+        q_scheme(q_scheme) {}
+  BlockSparseMatrix<int16_t> w;
+  c10::optional<at::Tensor> bias_;
+  std::vector<float> w_scale;
+  std::vector<int32_t> w_zp;
+  c10::QScheme q_scheme;
+
+  at::Tensor apply(
+      at::Tensor input,
+      double output_scale,
+      int64_t output_zero_point) override {
+    return apply_impl<false>(
+        std::move(input), output_scale, output_zero_point);
+  }
+  at::Tensor apply_relu(
+      at::Tensor input,
+      double output_scale,
+      int64_t output_zero_point) override {
+    return apply_impl<true>(std::move(input), output_scale, output_zero_point);
+  }
+
+  at::Tensor apply_dynamic(at::Tensor input, bool reduce_range = false)
+      override {
+    return apply_dynamic_impl<false>(std::move(input), reduce_range);
+  }
+  at::Tensor apply_dynamic_relu(at::Tensor input, bool reduce_range = false)
+      override {
+    return apply_dynamic_impl<true>(std::move(input), reduce_range);
+  }
+
+  std::tuple<at::Tensor, c10::optional<at::Tensor>> unpack() override;
+
+  c10::optional<at::Tensor> bias() override {
+    return bias_;
+  }
+
+  void set_bias(c10::optional<at::Tensor> bias) override {
+    bias_ = std::move(bias);
+  }
+
+  static c10::intrusive_ptr<LinearPackedParamsBase> prepack(
+      at::Tensor weight,
+      c10::optional<at::Tensor> bias,
+      int64_t out_block,
+      int64_t in_block);
+
+ private:
+  float scale_of(int64_t n) const {
+    return w_scale[q_scheme == c10::kPerTensorAffine ? 0 : n];
+  }
+
+  // Computes the int32 accumulators of the quantized input (M x K) and calls
+  // epilogue(m, n, real_value) for each output element.
+  template <typename Epilogue>
+  void run(
+      const at::Tensor& input_contig,
+      double input_scale,
+      int64_t input_zero_point,
+      Epilogue epilogue);
+
+  template <bool ReluFused>
+  at::Tensor apply_impl(
+      at::Tensor input,
+      double output_scale,
+      int64_t output_zero_point);
+
+  template <bool ReluFused>
+  at::Tensor apply_dynamic_impl(at::Tensor input, bool reduce_range);
+};
+
+c10::intrusive_ptr<LinearPackedParamsBase>
+PackedLinearWeightBlockSparse::prepack(
+    at::Tensor weight,
+    c10::optional<at::Tensor> bias,
+    int64_t out_block,
+    int64_t in_block) {
+  TORCH_CHECK(
+      weight.dim() == 2,
+      "The weight tensor for quantized::linear_prepack_block_sparse should be "
+      "2-dimensional.");
+  TORCH_CHECK(
+      weight.scalar_type() == c10::kQInt8,
+      "quantized::linear_prepack_block_sparse expects a qint8 weight");
+  const auto qtype = weight.qscheme();
+  TORCH_CHECK(
+      qtype == c10::kPerTensorAffine || qtype == c10::kPerChannelAffine,
+      "Unsupported qscheme: ",
+      toString(qtype));
+  const int64_t N = weight.size(0);
+  const int64_t K = weight.size(1);
+
+  std::vector<float> w_scale;
+  std::vector<int32_t> w_zp;
+  if (qtype == c10::kPerTensorAffine) {
+    w_scale = {static_cast<float>(weight.q_scale())};
+    w_zp = {static_cast<int32_t>(weight.q_zero_point())};
+  } else {
+    TORCH_CHECK(
+        weight.q_per_channel_axis() == 0,
+        "quantized::linear_prepack_block_sparse expects per channel "
+        "quantization along the output channels");
+    auto scales = weight.q_per_channel_scales().to(at::kFloat).contiguous();
+    auto zero_points =
+        weight.q_per_channel_zero_points().to(at::kInt).contiguous();
+    w_scale.assign(
+        scales.data_ptr<float>(), scales.data_ptr<float>() + N);
+    w_zp.assign(
+        zero_points.data_ptr<int32_t>(),
+        zero_points.data_ptr<int32_t>() + N);
+  }
+
+  if (bias.has_value()) {
+    TORCH_CHECK(
+        bias->dim() == 1 && bias->size(0) == N &&
+            bias->scalar_type() == at::kFloat,
+        "bias should be a float vector (1D Tensor) with N elements: " +
+            std::to_string(N));
+    bias = bias->contiguous();
+  }
+
+  auto weight_contig = weight.contiguous();
+  const int8_t* weight_data =
+      reinterpret_cast<int8_t*>(weight_contig.data_ptr<c10::qint8>());
+  const bool per_tensor = qtype == c10::kPerTensorAffine;
+  auto zp_of = [&](int64_t row) { return w_zp[per_tensor ? 0 : row]; };
+  auto packed = pack_block_sparse<int16_t>(
+      weight_data,
+      N,
+      K,
+      out_block,
+      in_block,
+      [&](int64_t row, int8_t v) { return v == zp_of(row); },
+      [&](int64_t row, int8_t v) {
+        return static_cast<int16_t>(v - zp_of(row));
+      });
+
+  return c10::make_intrusive<PackedLinearWeightBlockSparse>(
+      std::move(packed),
+      std::move(bias),
+      std::move(w_scale),
+      std::move(w_zp),
+      qtype);
+}
+
+std::tuple<at::Tensor, c10::optional<at::Tensor>>
+PackedLinearWeightBlockSparse::unpack() {
+  const int64_t N = w.rows;
+  const int64_t K = w.cols;
+  at::Tensor weight;
+  if (q_scheme == c10::kPerTensorAffine) {
+    weight = at::_empty_affine_quantized(
+        {N, K}, at::device(c10::kCPU).dtype(c10::kQInt8), w_scale[0], w_zp[0]);
+  } else {
+    weight = at::_empty_per_channel_affine_quantized(
+        {N, K},
+        at::tensor(std::vector<double>(w_scale.begin(), w_scale.end()), at::kDouble),
+        at::tensor(std::vector<int64_t>(w_zp.begin(), w_zp.end()), at::kLong),
+        0,
+        at::device(c10::kCPU).dtype(c10::kQInt8));
+  }
+  int8_t* weight_data = reinterpret_cast<int8_t*>(weight.data_ptr<c10::qint8>());
+  const bool per_tensor = q_scheme == c10::kPerTensorAffine;
+  for (int64_t n = 0; n < N; ++n) {
+    std::fill_n(weight_data + n * K, K, w_zp[per_tensor ? 0 : n]);
+  }
+  const int64_t ob = w.out_block;
+  const int64_t ib = w.in_block;
+  for (int64_t br = 0; br < w.block_rows(); ++br) {
+    for (int32_t p = w.row_ptr[br]; p < w.row_ptr[br + 1]; ++p) {
+      for (int64_t i = 0; i < ob; ++i) {
+        const int64_t n = br * ob + i;
+        for (int64_t j = 0; j < ib; ++j) {
+          weight_data[n * K + w.col_idx[p] * ib + j] = static_cast<int8_t>(
+              w.values[(p * ob + i) * ib + j] + w_zp[per_tensor ? 0 : n]);
+        }
+      }
+    }
+  }
+  return std::make_tuple(weight, bias_);
+}
+
+template <typename Epilogue>
+void PackedLinearWeightBlockSparse::run(
+    const at::Tensor& input_contig,
+    double input_scale,
+    int64_t input_zero_point,
+    Epilogue epilogue) {
+  const int64_t N = w.rows;
+  const int64_t K = w.cols;
+  const int64_t M = K == 0 ? 0 : input_contig.numel() / K;
+  std::vector<int32_t> acc(M * N, 0);
+  if (M > 0 && K > 0) {
+    block_sparse_linear_int8_stub(
+        kCPU,
+        w,
+        reinterpret_cast<uint8_t*>(input_contig.data_ptr<c10::quint8>()),
+        M,
+        static_cast<int32_t>(input_zero_point),
+        acc.data());
+  }
+  const float* bias_ptr =
+      bias_.has_value() ? bias_->data_ptr<float>() : nullptr;
+  at::parallel_for(0, M, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t m = begin; m < end; ++m) {
+      for (int64_t n = 0; n < N; ++n) {
+        float y = static_cast<float>(input_scale) * scale_of(n) *
+            acc[m * N + n];
+        if (bias_ptr) {
+          y += bias_ptr[n];
+        }
+        epilogue(m, n, y);
+      }
+    }
+  });
+}
+
+template <bool ReluFused>
+at::Tensor PackedLinearWeightBlockSparse::apply_impl(
+    at::Tensor input,
+    double output_scale,
+    int64_t output_zero_point) {
+  TORCH_CHECK(
+      input.dim() >= 2,
+      "The dimension of input tensor should be larger than or equal to 2");
+  TORCH_CHECK(
+      input.scalar_type() == c10::kQUInt8 &&
+          input.qscheme() == c10::kPerTensorAffine,
+      "quantized::linear (block sparse) expects a per tensor quint8 input");
+  TORCH_CHECK(
+      input.size(input.dim() - 1) == w.cols,
+      "The number of rows in the packed weight should be equal to K: " +
+          std::to_string(input.size(input.dim() - 1)));
+  auto input_contig = input.contiguous();
+
+  std::vector<int64_t> out_sizes = input.sizes().vec();
+  out_sizes.back() = w.rows;
+  auto output = at::_empty_affine_quantized(
+      out_sizes,
+      at::device(c10::kCPU).dtype(c10::kQUInt8),
+      output_scale,
+      output_zero_point);
+  c10::quint8* output_data = output.data_ptr<c10::quint8>();
+  const int64_t N = w.rows;
+  run(input_contig,
+      input.q_scale(),
+      input.q_zero_point(),
+      [&](int64_t m, int64_t n, float y) {
+        output_data[m * N + n] = quantize_val<c10::quint8>(
+            output_scale, output_zero_point, ReluFused ? std::max(y, 0.f) : y);
+      });
+  return output;
+}
+
+template <bool ReluFused>
+at::Tensor PackedLinearWeightBlockSparse::apply_dynamic_impl(
+    at::Tensor input,
+    bool reduce_range) {
+  TORCH_CHECK(
+      input.dim() >= 2,
+      "The dimension of input tensor should be larger than or equal to 2");
+  TORCH_CHECK(
+      input.size(input.dim() - 1) == w.cols,
+      "The number of rows in the packed weight should be equal to K: " +
+          std::to_string(input.size(input.dim() - 1)));
+  auto input_contig = input.contiguous();
+
+  // Calculate statistics for quantization of the input Tensor
+  float x_min = 0;
+  float x_max = 0;
+  if (input.numel() > 0) {
+    x_min = input_contig.min().item<float>();
+    x_max = input_contig.max().item<float>();
+  }
+  auto q_params = quant_utils::ChooseQuantizationParams(
+      /*min=*/x_min,
+      /*max=*/x_max,
+      /*qmin=*/0,
+      /*qmax=*/255,
+      /*preserve_sparsity=*/false,
+      /*force_scale_power_of_two=*/false,
+      /*reduce_range=*/reduce_range);
+  auto q_input = at::quantize_per_tensor(
+      input_contig, q_params.scale, q_params.zero_point, c10::kQUInt8);
+
+  std::vector<int64_t> out_sizes = input.sizes().vec();
+  out_sizes.back() = w.rows;
+  auto output = at::empty(out_sizes, input.options().dtype(at::kFloat));
+  float* output_data = output.data_ptr<float>();
+  const int64_t N = w.rows;
+  run(q_input,
+      q_params.scale,
+      q_params.zero_point,
+      [&](int64_t m, int64_t n, float y) {
+        output_data[m * N + n] = ReluFused ? std::max(y, 0.f) : y;
+      });
+  return output;
+}
+
+class QLinearPackWeightInt8BlockSparse final {
+ public:
+  static c10::intrusive_ptr<LinearPackedParamsBase> run(
+      at::Tensor weight,
+      c10::optional<Tensor> bias,
+      int64_t out_block,
+      int64_t in_block) {
+    return PackedLinearWeightBlockSparse::prepack(
+        std::move(weight), std::move(bias), out_block, in_block);
+  }
+};
+
+TORCH_LIBRARY_IMPL(quantized, QuantizedCPU, m) {
+  m.impl(
+      "linear_prepack_block_sparse",
+      TORCH_FN(QLinearPackWeightInt8BlockSparse::run));
+}
+
+} // namespace
+} // namespace native
+} // namespace at
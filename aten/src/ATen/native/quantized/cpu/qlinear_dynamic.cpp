@@ -207,6 +207,154 @@ at::Tensor PackedLinearWeight::apply_dynamic_impl(at::Tensor input, bool reduce_
   return output;
 }
 
+template <bool ReluFused>
+at::Tensor PackedLinearWeight::apply_dynamic_per_token_impl(
+    at::Tensor input,
+    bool reduce_range) {
+  using at::Tensor;
+  // fp32 * int8 -> fp32, where every row of the input (every token for NLP
+  // models) is quantized with its own scale and zero point, so that a few
+  // outlier rows do not flatten the quantization range of all the others.
+  //
+  // Rather than separate passes for the range, the quantization and the
+  // dequantization, each task walks its rows in blocks: it finds the range of
+  // each row, quantizes it and accumulates its row offset in one go, runs the
+  // integer GEMM on the block and dequantizes the int32 results straight into
+  // the fp32 output, adding the bias and applying the ReLU. The quantized
+  // activations and the accumulators of a block stay in cache throughout.
+  TORCH_CHECK(
+      fbgemm::fbgemmSupportedCPU(), "Your CPU does not support FBGEMM.");
+  TORCH_CHECK(
+      input.dim() >= 2,
+      "The dimension of input tensor should be larger than or equal to 2");
+
+  auto input_contig = input.contiguous();
+  const auto* input_ptr = input_contig.data_ptr<float>();
+
+  // C(output) = A(input) x B(weight), where C, A, B are M x N, M x K, K x N
+  // matrices, respectively.
+  const int64_t M = size_to_dim_(input.dim() - 1, input.sizes());
+  auto packB = w.get();
+  const int64_t N = static_cast<int64_t>(packB->numCols());
+  const int64_t K = input.size(input.dim() - 1);
+  TORCH_CHECK(
+      K == static_cast<int64_t>(packB->numRows()),
+      "The number of rows in the packB should be equal to K: " +
+          std::to_string(K));
+
+  const float* bias_ptr = nullptr;
+  at::Tensor bias_contig;
+  if (bias_.has_value()) {
+    TORCH_CHECK(bias_->dim() == 1, "bias should be a vector (1D Tensor)");
+    TORCH_CHECK(
+        bias_->size(0) == N,
+        "bias should have N elements: " + std::to_string(N));
+    bias_contig = bias_->contiguous();
+    bias_ptr = bias_contig.data_ptr<float>();
+  }
+
+  std::vector<int64_t> out_sizes = input.sizes().vec();
+  out_sizes.back() = N;
+  auto output = at::empty(out_sizes, input.options().dtype(at::kFloat));
+  float* output_ptr = output.data_ptr<float>();
+
+  // Input tensor is quantized as 8-bit unsigned values
+  static constexpr int precision = 8;
+  static constexpr int64_t kRowBlock = 32;
+  const bool per_channel = q_scheme == c10::kPerChannelAffine;
+
+  at::parallel_for(0, M, kRowBlock, [&](int64_t begin, int64_t end) {
+    std::vector<uint8_t> input_q(kRowBlock * K);
+    std::vector<int32_t> output_int32(kRowBlock * N);
+    std::vector<float> row_scales(kRowBlock);
+    std::vector<int32_t> row_zero_points(kRowBlock);
+    std::vector<int32_t> row_offsets(kRowBlock);
+    fbgemm::memCopy<> memCopyObj{};
+
+    for (int64_t row_begin = begin; row_begin < end; row_begin += kRowBlock) {
+      const int64_t rows = std::min(kRowBlock, end - row_begin);
+
+      for (int64_t r = 0; r < rows; ++r) {
+        const float* input_row = input_ptr + (row_begin + r) * K;
+        uint8_t* input_q_row = input_q.data() + r * K;
+
+        float x_min, x_max;
+        fbgemm::FindMinMax(
+            /*m=*/input_row,
+            /*min=*/&x_min,
+            /*max=*/&x_max,
+            /*len=*/K);
+        auto q_params = quant_utils::ChooseQuantizationParams(
+            /*min=*/x_min,
+            /*max=*/x_max,
+            /*qmin=*/0,
+            /*qmax=*/(1 << precision) - 1,
+            /*preserve_sparsity=*/false,
+            /*force_scale_power_of_two=*/false,
+            /*reduce_range=*/reduce_range);
+
+        fbgemm::Quantize<uint8_t, false /*LEGACY*/>(
+            input_row,
+            input_q_row,
+            K,
+            fbgemm::TensorQuantizationParams{
+                static_cast<float>(q_params.scale),
+                q_params.zero_point,
+                precision});
+
+        int32_t row_sum = 0;
+        for (int64_t k = 0; k < K; ++k) {
+          row_sum += input_q_row[k];
+        }
+        row_scales[r] = q_params.scale;
+        row_zero_points[r] = q_params.zero_point;
+        row_offsets[r] = row_sum;
+      }
+
+      // The uint8 * int8 GEMM of the block, kept in int32.
+      fbgemm::PackAMatrix<uint8_t> packA(
+          /*trans=*/fbgemm::matrix_op_t::NoTranspose,
+          /*nRow=*/rows,
+          /*nCol=*/K,
+          /*smat=*/input_q.data(),
+          /*ld=*/K,
+          /*pmat=*/nullptr);
+      fbgemm::fbgemmPacked(
+          /*packA=*/packA,
+          /*packB=*/*packB,
+          /*C=*/output_int32.data(),
+          /*C_buffer=*/output_int32.data(),
+          /*ldc=*/N,
+          /*outProcess=*/memCopyObj,
+          /*thread_id=*/0,
+          /*num_threads=*/1);
+
+      // Add in the row and column offsets, dequantize with the row and weight
+      // scales and add the bias. col_offsets already include the
+      // B_zero_point * K term (see calc_col_offsets_transpose).
+      for (int64_t r = 0; r < rows; ++r) {
+        const int32_t* acc_row = output_int32.data() + r * N;
+        float* output_row = output_ptr + (row_begin + r) * N;
+        const float row_scale = row_scales[r];
+        const int32_t row_zero_point = row_zero_points[r];
+        const int32_t row_offset = row_offsets[r];
+        for (int64_t n = 0; n < N; ++n) {
+          const int64_t w_idx = per_channel ? n : 0;
+          const int32_t acc = acc_row[n] - row_zero_point * col_offsets[n] -
+              w_zp[w_idx] * row_offset;
+          float y = row_scale * w_scale[w_idx] * acc;
+          if (bias_ptr) {
+            y += bias_ptr[n];
+          }
+          output_row[n] = ReluFused ? std::max(y, 0.f) : y;
+        }
+      }
+    }
+  });
+
+  return output;
+}
+
 at::Tensor PackedLinearWeight::apply_dynamic(at::Tensor input, bool reduce_range) {
   return apply_dynamic_impl</*ReluFused=*/false>(std::move(input), reduce_range);
 }
@@ -215,6 +363,16 @@ at::Tensor PackedLinearWeight::apply_dynamic_relu(at::Tensor input, bool reduce_
   return apply_dynamic_impl</*ReluFused=*/true>(std::move(input), reduce_range);
 }
 
+at::Tensor PackedLinearWeight::apply_dynamic_per_token(at::Tensor input, bool reduce_range) {
+  return apply_dynamic_per_token_impl</*ReluFused=*/false>(
+      std::move(input), reduce_range);
+}
+
+at::Tensor PackedLinearWeight::apply_dynamic_per_token_relu(at::Tensor input, bool reduce_range) {
+  return apply_dynamic_per_token_impl</*ReluFused=*/true>(
+      std::move(input), reduce_range);
+}
+
 #endif // USE_FBGEMM
 
 #ifdef USE_PYTORCH_QNNPACK
@@ -425,6 +583,23 @@ class QLinearDynamicInt8 final {
   }
 };
 
+template <bool ReluFused>
+class QLinearDynamicInt8PerToken final {
+ public:
+  static at::Tensor run(
+      at::Tensor input,
+      const c10::intrusive_ptr<LinearPackedParamsBase>& packed_weight,
+      bool reduce_range) {
+    if (ReluFused) {
+      return packed_weight->apply_dynamic_per_token_relu(
+          std::move(input), reduce_range);
+    } else {
+      return packed_weight->apply_dynamic_per_token(
+          std::move(input), reduce_range);
+    }
+  }
+};
+
 template <bool ReluFused>
 class QLinearDynamicFp16 final {
  public:
@@ -457,6 +632,12 @@ class QLinearDynamicFp16 final {
 TORCH_LIBRARY_IMPL(quantized, CPU, m) {
   m.impl("linear_dynamic", TORCH_FN(QLinearDynamicInt8<false>::run));
   m.impl("linear_relu_dynamic", TORCH_FN(QLinearDynamicInt8<true>::run));
+  m.impl(
+      "linear_dynamic_per_token",
+      TORCH_FN(QLinearDynamicInt8PerToken<false>::run));
+  m.impl(
+      "linear_relu_dynamic_per_token",
+      TORCH_FN(QLinearDynamicInt8PerToken<true>::run));
   m.impl("linear_dynamic_fp16", TORCH_FN(QLinearDynamicFp16<false>::run));
 }
 
@@ -0,0 +1,112 @@
+#include <ATen/ATen.h>
+#include <ATen/ExpandUtils.h>
+#include <torch/library.h>
+#include <ATen/quantized/Quantizer.h>
+#include <ATen/native/quantized/cpu/quantized_ops.h>
+
+namespace at {
+namespace native {
+
+DEFINE_DISPATCH(qmatmul_stub);
+
+namespace {
+
+void check_inputs(const char* name, const Tensor& qa, const Tensor& qb) {
+  TORCH_CHECK(qa.qscheme() == kPerTensorAffine && qb.qscheme() == kPerTensorAffine,
+              name, " only supports per tensor quantized inputs");
+  TORCH_CHECK(qa.scalar_type() == qb.scalar_type(),
+              name, ": both inputs should have the same dtype, got ",
+              toString(qa.scalar_type()), " and ", toString(qb.scalar_type()));
+  TORCH_CHECK(qa.scalar_type() == kQUInt8 || qa.scalar_type() == kQInt8,
+              name, " only supports quint8 and qint8 inputs, got ",
+              toString(qa.scalar_type()));
+}
+
+// qa and qb are [B, M, K] and [B, K, N].
+Tensor qmatmul_3d(
+    const Tensor& qa,
+    const Tensor& qb,
+    double output_scale,
+    int64_t output_zero_point) {
+  auto qc = at::_empty_affine_quantized(
+      {qa.size(0), qa.size(1), qb.size(2)},
+      at::device(kCPU).dtype(qa.scalar_type()),
+      output_scale,
+      output_zero_point);
+  if (qc.numel() > 0) {
+    qmatmul_stub(qa.device().type(), qa.contiguous(), qb.contiguous(), qc);
+  }
+  return qc;
+}
+
+class QMatmul final {
+ public:
+  // Batched matrix product with the usual broadcasting of the batch
+  // dimensions. As in torch.matmul, a 1D first input is a row vector and a
+  // 1D second input is a column vector, and the added dimension is removed
+  // from the result.
+  static Tensor run(Tensor qa, Tensor qb, double scale, int64_t zero_point) {
+    check_inputs("quantized::matmul", qa, qb);
+    TORCH_CHECK(qa.dim() >= 1 && qb.dim() >= 1,
+                "quantized::matmul: both inputs should have at least 1 dimension, got ",
+                qa.dim(), "D and ", qb.dim(), "D");
+    const bool a_vector = qa.dim() == 1;
+    const bool b_vector = qb.dim() == 1;
+    if (a_vector) {
+      qa = qa.reshape({1, qa.size(0)});
+    }
+    if (b_vector) {
+      qb = qb.reshape({qb.size(0), 1});
+    }
+    const int64_t M = qa.size(-2);
+    const int64_t K = qa.size(-1);
+    const int64_t N = qb.size(-1);
+    TORCH_CHECK(qb.size(-2) == K,
+                "quantized::matmul: size mismatch, got ", qa.sizes(), " and ", qb.sizes());
+
+    IntArrayRef a_batch(qa.sizes().data(), qa.dim() - 2);
+    IntArrayRef b_batch(qb.sizes().data(), qb.dim() - 2);
+    std::vector<int64_t> batch = infer_size(a_batch, b_batch);
+    const int64_t batches = prod_intlist(batch);
+
+    std::vector<int64_t> a_sizes(batch);
+    a_sizes.insert(a_sizes.end(), {M, K});
+    std::vector<int64_t> b_sizes(batch);
+    b_sizes.insert(b_sizes.end(), {K, N});
+    auto qc = qmatmul_3d(
+        qa.expand(a_sizes).reshape({batches, M, K}),
+        qb.expand(b_sizes).reshape({batches, K, N}),
+        scale,
+        zero_point);
+
+    std::vector<int64_t> c_sizes(batch);
+    if (!a_vector) {
+      c_sizes.push_back(M);
+    }
+    if (!b_vector) {
+      c_sizes.push_back(N);
+    }
+    return qc.view(c_sizes);
+  }
+};
+
+class QBmm final {
+ public:
+  static Tensor run(Tensor qa, Tensor qb, double scale, int64_t zero_point) {
+    check_inputs("quantized::bmm", qa, qb);
+    TORCH_CHECK(qa.dim() == 3 && qb.dim() == 3,
+                "quantized::bmm: both inputs should be 3D, got ",
+                qa.dim(), "D and ", qb.dim(), "D");
+    TORCH_CHECK(qa.size(0) == qb.size(0) && qa.size(2) == qb.size(1),
+                "quantized::bmm: size mismatch, got ", qa.sizes(), " and ", qb.sizes());
+    return qmatmul_3d(qa, qb, scale, zero_point);
+  }
+};
+
+TORCH_LIBRARY_IMPL(quantized, QuantizedCPU, m) {
+  m.impl("matmul", TORCH_FN(QMatmul::run));
+  m.impl("bmm",    TORCH_FN(QBmm::run));
+}
+
+} // namespace
+}}  // namespace at::native
@@ -0,0 +1,107 @@
+#include <ATen/ATen.h>
+#include <ATen/WrapDimUtils.h>
+#include <torch/library.h>
+#include <ATen/quantized/Quantizer.h>
+#include <ATen/native/quantized/cpu/quantized_ops.h>
+#include <ATen/native/quantized/cpu/init_qnnpack.h>
+#include <ATen/native/quantized/cpu/qnnpack_utils.h>
+#include <caffe2/utils/threadpool/pthreadpool-cpp.h>
+
+namespace at {
+namespace native {
+
+DEFINE_DISPATCH(qsoftmax_stub);
+
+namespace {
+
+#ifdef USE_PYTORCH_QNNPACK
+// QNNPACK's softargmax only supports quint8 outputs with scale=1.0/256, zp=0.
+// qx must be contiguous, with the softmax computed over its last dimension.
+Tensor qnnpack_softmax(const Tensor& qx) {
+  constexpr float output_scale = 1.0f / 256.0f;
+  constexpr int32_t output_zero_point = 0;
+
+  initQNNPACK();
+
+  const int64_t channels = qx.size(-1);
+  const int64_t batch_size = qx.numel() / channels;
+
+  pytorch_qnnp_operator_t softargmax_op{nullptr};
+  const pytorch_qnnp_status createStatus = pytorch_qnnp_create_softargmax_nc_q8(
+    channels /* channels */,
+    qx.q_scale() /* input scale */,
+    output_zero_point /* output zero point */,
+    output_scale /* output scale */,
+    0 /* flags */,
+    &softargmax_op);
+  TORCH_INTERNAL_ASSERT(createStatus == pytorch_qnnp_status_success,
+                        "failed to create QNNPACK softargmax operator");
+  std::unique_ptr<pytorch_qnnp_operator, QnnpackOperatorDeleter>
+      qnnpack_uniq_ptr(softargmax_op);
+
+  Tensor qy = at::_empty_affine_quantized(
+    qx.sizes(),
+    at::device(kCPU).dtype(kQUInt8),
+    output_scale,
+    output_zero_point);
+
+  const pytorch_qnnp_status setupStatus = pytorch_qnnp_setup_softargmax_nc_q8(
+    softargmax_op,
+    batch_size /* batch size */,
+    (uint8_t*)qx.data_ptr<c10::quint8>() /* input data */,
+    channels /* input stride */,
+    (uint8_t*)qy.data_ptr<c10::quint8>() /* output data */,
+    channels /* output stride */);
+  TORCH_INTERNAL_ASSERT(setupStatus == pytorch_qnnp_status_success,
+                        "failed to setup QNNPACK softargmax operator");
+
+  pthreadpool_t threadpool = caffe2::pthreadpool_();
+  const pytorch_qnnp_status runStatus =
+    pytorch_qnnp_run_operator(softargmax_op, threadpool);
+  TORCH_INTERNAL_ASSERT(runStatus == pytorch_qnnp_status_success,
+                        "failed to run QNNPACK softargmax operator");
+  return qy;
+}
+#endif  // USE_PYTORCH_QNNPACK
+
+Tensor quantized_softmax(
+    Tensor qx,
+    int64_t dim,
+    double output_scale,
+    int64_t output_zero_point) {
+  TORCH_CHECK(qx.qscheme() == kPerTensorAffine,
+              "quantized::softmax only supports per tensor quantized inputs");
+  TORCH_CHECK(qx.scalar_type() == kQUInt8 || qx.scalar_type() == kQInt8,
+              "quantized::softmax only supports quint8 and qint8 inputs, got ",
+              toString(qx.scalar_type()));
+  TORCH_CHECK(qx.dim() > 0, "quantized::softmax: expected a non-scalar input");
+  dim = maybe_wrap_dim(dim, qx.dim());
+
+  // The kernels work on rows, move the softmax dimension last.
+  const bool last_dim = dim == qx.dim() - 1;
+  Tensor qx_contig = last_dim ? qx.contiguous() : qx.transpose(dim, -1).contiguous();
+  Tensor qy;
+#ifdef USE_PYTORCH_QNNPACK
+  if (at::globalContext().qEngine() == at::QEngine::QNNPACK &&
+      qx.scalar_type() == kQUInt8 && qx.numel() > 0 &&
+      output_scale == 1.0 / 256 && output_zero_point == 0) {
+    qy = qnnpack_softmax(qx_contig);
+  }
+#endif  // USE_PYTORCH_QNNPACK
+  if (!qy.defined()) {
+    qy = at::_empty_affine_quantized(
+        qx_contig.sizes(),
+        at::device(kCPU).dtype(qx.scalar_type()),
+        output_scale,
+        output_zero_point);
+    qsoftmax_stub(qx.device().type(), qx_contig, qy);
+  }
+  return last_dim ? qy : qy.transpose(dim, -1);
+}
+
+TORCH_LIBRARY_IMPL(quantized, QuantizedCPU, m) {
+  m.impl("softmax", TORCH_FN(quantized_softmax));
+}
+
+} // namespace
+}}  // namespace at::native
@@ -138,6 +138,24 @@ using qcat_nhwc_fn = Tensor (*)(
     int64_t zero_point);
 using qtopk_fn = void(*)(Tensor&, Tensor&, const Tensor&, int64_t, int64_t, bool, bool);
 
+// Softmax over the last dimension of a contiguous quantized tensor. qy is
+// preallocated with the output quantization parameters.
+using qsoftmax_fn = void (*)(const Tensor& /*qx*/, Tensor& /*qy*/);
+// qc[b] = qa[b] x qb[b] for contiguous [B, M, K] and [B, K, N] inputs, with
+// the int32 accumulators requantized to the parameters of qc.
+using qmatmul_fn =
+    void (*)(const Tensor& /*qa*/, const Tensor& /*qb*/, Tensor& /*qc*/);
+// out[b] = softmax(q[b] x k[b]^T * scale + mask[b]) x v[b] for contiguous
+// [B, L, E], [B, S, E] and [B, S, Ev] inputs. mask is either undefined or a
+// float [B, L, S] tensor, possibly with zero strides.
+using qattention_fn = void (*)(
+    const Tensor& /*q*/,
+    const Tensor& /*k*/,
+    const Tensor& /*v*/,
+    const Tensor& /*mask*/,
+    double /*scale*/,
+    Tensor& /*out*/);
+
 using qbatch_norm_fn = void(*)(int64_t, int64_t, int64_t, int64_t, int64_t, const Tensor&, const Tensor&, const Tensor&, Tensor&);
 
 using qnormalize_fn = void (*)(
@@ -156,6 +174,7 @@ DECLARE_DISPATCH(qadaptive_avg_pool2d_fn, qadaptive_avg_pool2d_nhwc_stub);
 DECLARE_DISPATCH(qadaptive_avg_pool3d_fn, qadaptive_avg_pool3d_ndhwc_stub);
 DECLARE_DISPATCH(qadd_scalar_fn, qadd_scalar_relu_stub);
 DECLARE_DISPATCH(qadd_scalar_fn, qadd_scalar_stub);
+DECLARE_DISPATCH(qattention_fn, qattention_stub);
 DECLARE_DISPATCH(qavg_pool2d_fn, qavg_pool2d_nhwc_stub);
 DECLARE_DISPATCH(qavg_pool3d_fn, qavg_pool3d_nhwc_stub);
 DECLARE_DISPATCH(qbatch_norm_fn, qbatch_norm_relu_stub);
@@ -170,12 +189,14 @@ DECLARE_DISPATCH(qclamp_fn, qclamp_stub);
 DECLARE_DISPATCH(qelu_fn, qelu_stub);
 DECLARE_DISPATCH(qhardsigmoid_fn, qhardsigmoid_stub);
 DECLARE_DISPATCH(qhardswish_fn, qhardswish_stub);
+DECLARE_DISPATCH(qmatmul_fn, qmatmul_stub);
 DECLARE_DISPATCH(qmaxpool_2d_fn, qmaxpool_2d_nhwc_stub);
 DECLARE_DISPATCH(qnormalize_fn, quantized_normalize_stub);
 DECLARE_DISPATCH(qrelu_fn, qrelu6_stub);
 DECLARE_DISPATCH(qrelu_fn, qrelu_stub);
 DECLARE_DISPATCH(qrelu_leaky_fn, qrelu_leaky_stub);
 DECLARE_DISPATCH(qsigmoid_fn, qsigmoid_stub);
+DECLARE_DISPATCH(qsoftmax_fn, qsoftmax_stub);
 DECLARE_DISPATCH(qtanh_fn, qtanh_stub);
 DECLARE_DISPATCH(qthreshold_fn, qthreshold_stub);
 DECLARE_DISPATCH(qtopk_fn, qtopk_stub);
@@ -1,12 +1,17 @@
 #pragma once
 
 #include <ATen/core/ivalue.h>
+#include <c10/core/DispatchKey.h>
 #include <c10/util/SmallVector.h>
 #include <c10/macros/Export.h>
 #include <memory>
 
 #include <functional>
 
+namespace c10 {
+struct OperatorName;
+}
+
 namespace at {
 
 // Kind of record function scope;
@@ -114,6 +119,28 @@ struct TORCH_API RecordFunction {
     return scope_;
   }
 
+  // The backend dispatch key of an operator call, Undefined for scopes not
+  // recorded by the dispatcher. Calls of an autograd kernel carry the key of
+  // the backend kernel they continue to.
+  inline c10::DispatchKey dispatchKey() const {
+    return dispatch_key_;
+  }
+
+  inline void setDispatchKey(c10::DispatchKey dispatch_key) {
+    dispatch_key_ = dispatch_key;
+  }
+
+  // The name of the operator for calls recorded by the dispatcher, null
+  // otherwise. It lives as long as the operator is registered, so observers
+  // can tell operators apart by its address instead of comparing names.
+  inline const c10::OperatorName* operatorName() const {
+    return operator_name_;
+  }
+
+  inline void setOperatorName(const c10::OperatorName* operator_name) {
+    operator_name_ = operator_name;
+  }
+
   // Returns logical thread_id for the current thread
   static uint64_t currentThreadId();
 
@@ -182,6 +209,9 @@ struct TORCH_API RecordFunction {
   // Kind of scope this RecordFunction is observing
   const RecordScope scope_;
 
+  c10::DispatchKey dispatch_key_ = c10::DispatchKey::Undefined;
+  const c10::OperatorName* operator_name_ = nullptr;
+
   // The logical thread_id that this RecordFunction was created with
   uint64_t thread_id_ = 0;
 
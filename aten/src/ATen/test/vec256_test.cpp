@@ -2,8 +2,10 @@
 
 #include <ATen/cpu/vec256/vec256.h>
 #include <ATen/ATen.h>
+#include <ATen/native/DispatchStub.h>
 
 #include <functional>
+#include <iostream>
 
 using namespace at::vec256;
 
@@ -350,12 +352,12 @@ TEST(Vec256TestFloat, CopyTest) {
 }
 
 TEST(Vec256TestFloat, arangeTest) {
-  at::Tensor arange_output_ref = at::zeros({8});
-  at::Tensor arange_output_vectorized = at::zeros({8});
+  at::Tensor arange_output_ref = at::zeros({Vec256<float>::size()});
+  at::Tensor arange_output_vectorized = at::zeros({Vec256<float>::size()});
   float base = 7.f;
   float step = 5.f;
   float* ref_output_ptr = arange_output_ref.data_ptr<float>();
-  for (int64_t i = 0; i < 8; ++i) {
+  for (int64_t i = 0; i < Vec256<float>::size(); ++i) {
     ref_output_ptr[i] = base + i * step;
   }
   float* vec_output_ptr = arange_output_vectorized.data_ptr<float>();
@@ -413,10 +415,14 @@ TEST(Vec256TestFloat, Blend) {
   int32_t full_int_mask = 0xFFFFFFFF;
   float* full_ptr = reinterpret_cast<float*>(&full_int_mask);
   float full_float_mask = *full_ptr;
-  Vec256<float> float_mask(full_float_mask, 0.f, full_float_mask, 0.f,
-                           0.f, full_float_mask, 0.f, 0.f);
+  // The same 8-lane pattern repeated over the vector width.
+  const float mask_pattern[8] = {full_float_mask, 0.f, full_float_mask, 0.f,
+                                 0.f, full_float_mask, 0.f, 0.f};
   float float_mask_array[Vec256<float>::size()];
-  float_mask.store(float_mask_array);
+  for (int i = 0; i < Vec256<float>::size(); ++i) {
+    float_mask_array[i] = mask_pattern[i % 8];
+  }
+  auto float_mask = Vec256<float>::loadu(float_mask_array);
   ref_res_ptr = ref_res.data_ptr<float>();
   for (size_t i = 0; i < num_els; ++i) {
     if (float_mask_array[i % Vec256<float>::size()] != 0) {
@@ -664,8 +670,63 @@ TEST(Vec256TestFloat, check_fmadd) {
   ASSERT_TRUE(check_almost_equal(ref_res, vec_res, 1e-6));
 }
 
+TEST(Vec256TestQuantized, check_roundtrip) {
+  static_assert(
+      std::is_same<Vectorized<float>, Vec256<float>>::value,
+      "Vectorized must alias Vec256");
+  ASSERT_EQ(Vec256<float>::size() * sizeof(float), VECTOR_WIDTH);
+  ASSERT_EQ(Vec256<c10::qint8>::size(),
+            Vec256<c10::qint8>::float_num_vecs() * Vec256<float>::size());
+  ASSERT_EQ(Vec256<c10::qint32>::size(), Vec256<float>::size());
+
+  constexpr int kSize = Vec256<c10::qint8>::size();
+  int8_t src[kSize];
+  for (int i = 0; i < kSize; ++i) {
+    src[i] = static_cast<int8_t>(i * 3 - 90);
+  }
+  const float scale = 0.5f;
+  const int32_t zero_point = 3;
+  Vec256<float> scale_v(scale);
+  Vec256<float> zero_point_v(zero_point);
+  Vec256<float> premul_v(-scale * zero_point);
+  auto dequantized = Vec256<c10::qint8>::loadu(src).dequantize(
+      scale_v, zero_point_v, premul_v);
+  float dequantized_vals[kSize];
+  for (int i = 0; i < Vec256<c10::qint8>::float_num_vecs(); ++i) {
+    dequantized[i].store(dequantized_vals + i * Vec256<float>::size());
+  }
+  for (int i = 0; i < kSize; ++i) {
+    ASSERT_FLOAT_EQ(dequantized_vals[i], scale * (src[i] - zero_point));
+  }
+  c10::qint8 requantized[kSize];
+  Vec256<c10::qint8>::quantize(dequantized, scale, zero_point, 1.0f / scale)
+      .store(requantized);
+  for (int i = 0; i < kSize; ++i) {
+    ASSERT_EQ(requantized[i].val_, src[i]);
+  }
+}
+
+// The build uses the instructions of its CPU_CAPABILITY; a CPU that cannot
+// run them has nothing to test.
+static bool cpu_runs_capability() {
+  using at::native::CPUCapability;
+#if defined(CPU_CAPABILITY_AVX512)
+  return at::native::get_cpu_capability() >= CPUCapability::AVX512;
+#elif defined(CPU_CAPABILITY_AVX2)
+  return at::native::get_cpu_capability() >= CPUCapability::AVX2;
+#elif defined(CPU_CAPABILITY_AVX)
+  return at::native::get_cpu_capability() >= CPUCapability::AVX;
+#else
+  return true;
+#endif
+}
+
 int main(int argc, char* argv[]) {
   ::testing::InitGoogleTest(&argc, argv);
+  if (!cpu_runs_capability()) {
+    std::cout << "skipping, the CPU does not support this build's capability" << std::endl;
+    return 0;
+  }
   at::manual_seed(42);
   return RUN_ALL_TESTS();
 }
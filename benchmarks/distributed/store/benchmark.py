@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+#
+# Measure TCPStore rendezvous time against world size.
+#
+# All ranks run as threads of this process and talk to a TCPStore server on
+# localhost, so this isolates the cost of the store itself from the network.
+# The store bindings release the GIL while waiting on the socket, which lets
+# the threads block in the server concurrently just like separate processes.
+#
+# For every world size this reports
+#   - rendezvous: time until every rank has constructed its TCPStore, which
+#     includes the server waiting for all workers to check in;
+#   - barrier: one store based barrier (add to a counter, then wait on a key
+#     that the last rank to arrive sets);
+#   - multi_get: every rank fetching all ranks' addresses in one request.
+#
+
+import argparse
+import socket
+import statistics
+import threading
+import time
+from datetime import timedelta
+
+import torch.distributed as dist
+
+
+def find_free_port():
+    with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as sock:
+        sock.bind(("localhost", 0))
+        return sock.getsockname()[1]
+
+
+def run_ranks(world_size, fn):
+    """Runs fn(rank) on world_size threads and returns the wall time."""
+    errors = []
+
+    def target(rank):
+        try:
+            fn(rank)
+        except Exception as e:
+            errors.append(e)
+
+    threads = [
+        threading.Thread(target=target, args=(rank,)) for rank in range(world_size)
+    ]
+    start = time.perf_counter()
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    elapsed = time.perf_counter() - start
+    if errors:
+        raise errors[0]
+    return elapsed
+
+
+def benchmark(world_size, iterations, timeout):
+    port = find_free_port()
+    stores = [None] * world_size
+
+    def rendezvous(rank):
+        stores[rank] = dist.TCPStore(
+            "localhost", port, world_size, rank == 0, timeout)
+
+    rendezvous_time = run_ranks(world_size, rendezvous)
+
+    def barrier(iteration):
+        def fn(rank):
+            store = stores[rank]
+            prefix = "barrier/{}/".format(iteration)
+            if store.add(prefix + "count", 1) == world_size:
+                store.set(prefix + "done", "1")
+            store.wait([prefix + "done"])
+        return fn
+
+    barrier_times = [
+        run_ranks(world_size, barrier(i)) for i in range(iterations)
+    ]
+
+    def exchange(iteration):
+        keys = ["addr/{}/{}".format(iteration, rank) for rank in range(world_size)]
+
+        def fn(rank):
+            store = stores[rank]
+            store.set(keys[rank], "127.0.0.1:{}".format(rank))
+            store.multi_get(keys)
+        return fn
+
+    exchange_times = [
+        run_ranks(world_size, exchange(i)) for i in range(iterations)
+    ]
+
+    return rendezvous_time, barrier_times, exchange_times
+
+
+def main():
+    parser = argparse.ArgumentParser(description="TCPStore benchmark")
+    parser.add_argument(
+        "--world-sizes",
+        type=int,
+        nargs="+",
+        default=[8, 32, 128, 512, 1024],
+        help="world sizes to sweep over",
+    )
+    parser.add_argument(
+        "--iterations",
+        type=int,
+        default=10,
+        help="number of barrier and multi_get rounds per world size",
+    )
+    parser.add_argument(
+        "--timeout",
+        type=float,
+        default=300,
+        help="store timeout in seconds",
+    )
+    args = parser.parse_args()
+
+    timeout = timedelta(seconds=args.timeout)
+
+    print("{:>10} {:>16} {:>16} {:>16}".format(
+        "world size", "rendezvous (ms)", "barrier (ms)", "multi_get (ms)"))
+    for world_size in args.world_sizes:
+        rendezvous_time, barrier_times, exchange_times = benchmark(
+            world_size, args.iterations, timeout)
+        print("{:>10} {:>16.1f} {:>16.1f} {:>16.1f}".format(
+            world_size,
+            rendezvous_time * 1e3,
+            statistics.median(barrier_times) * 1e3,
+            statistics.median(exchange_times) * 1e3,
+        ))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,104 @@
+#include <torch/csrc/jit/api/module.h>
+#include <torch/csrc/jit/mobile/import.h>
+#include <torch/csrc/jit/mobile/interpreter.h>
+#include <torch/csrc/jit/mobile/module.h>
+#include <torch/torch.h>
+
+#include "c10/util/Flags.h"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+C10_DEFINE_int(iter, 20, "Number of timed runs of each model");
+C10_DEFINE_int(warmup_iter, 5, "Number of warmup runs of each model");
+C10_DEFINE_int(trip_count, 10000, "Number of loop iterations per run");
+
+namespace {
+
+// Per-op overhead of the lite interpreter: the switch based interpreter
+// against the threaded one, on loops of cheap scalar ops and of tiny tensor
+// ops where the interpreter dominates the run time.
+const char* kScalarModel = R"JIT(
+  def forward(self, n: int):
+      a = 0
+      b = 1
+      for i in range(n):
+          a = a + i * b
+          b = b ^ (a & 7)
+      return a
+)JIT";
+
+const char* kTensorModel = R"JIT(
+  def forward(self, x: Tensor, n: int):
+      y = x
+      for i in range(n):
+          y = torch.add(y, x, alpha=1)
+          y = torch.mul(y, 0.5)
+      return y
+)JIT";
+
+torch::jit::mobile::Module toMobile(const char* source) {
+  torch::jit::Module m("m");
+  m.define(source);
+  std::stringstream ss;
+  m._save_for_mobile(ss);
+  return torch::jit::_load_for_mobile(ss);
+}
+
+// Returns the average time per loop iteration in nanoseconds.
+double runBench(
+    torch::jit::mobile::Module& module,
+    const std::vector<c10::IValue>& inputs,
+    bool threaded) {
+  torch::jit::mobile::setThreadedInterpreterEnabled(threaded);
+  for (int i = 0; i < FLAGS_warmup_iter; ++i) {
+    module.forward(inputs);
+  }
+  typedef std::chrono::high_resolution_clock clock;
+  auto start_time = clock::now();
+  for (int i = 0; i < FLAGS_iter; ++i) {
+    module.forward(inputs);
+  }
+  auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      clock::now() - start_time)
+                      .count();
+  return static_cast<double>(duration) / FLAGS_iter / FLAGS_trip_count;
+}
+
+void compare(
+    const std::string& name,
+    torch::jit::mobile::Module& module,
+    const std::vector<c10::IValue>& inputs) {
+  double switch_ns = runBench(module, inputs, /*threaded=*/false);
+  double threaded_ns = runBench(module, inputs, /*threaded=*/true);
+  std::cout << name << ": switch " << switch_ns << " ns/iter, threaded "
+            << threaded_ns << " ns/iter, speedup " << switch_ns / threaded_ns
+            << "x" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  c10::SetUsageMessage(
+      "Compares the per-op overhead of the switch based and the threaded "
+      "lite interpreter.\n"
+      "Example usage:\n"
+      "./lite_interpreter_dispatch_benchmark --trip_count=10000 --iter=20");
+  if (!c10::ParseCommandLineFlags(&argc, &argv)) {
+    std::cout << "Failed to parse command line flags" << std::endl;
+    return -1;
+  }
+  torch::AutoNonVariableTypeMode non_var_guard{true};
+  at::set_num_threads(1);
+
+  auto scalar_model = toMobile(kScalarModel);
+  compare("scalar ops", scalar_model, {c10::IValue(FLAGS_trip_count)});
+
+  auto tensor_model = toMobile(kTensorModel);
+  compare(
+      "tensor ops",
+      tensor_model,
+      {c10::IValue(torch::ones({1})), c10::IValue(FLAGS_trip_count)});
+  return 0;
+}
@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+
+#include <c10/util/tempfile.h>
+
+#include <torch/torch.h>
+
+#include <test/cpp/api/support.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace torch::test;
+using namespace torch::serialize;
+
+namespace {
+// A checkpoint directory that is removed with all files the writers may have
+// created in it.
+struct CheckpointDirectory {
+  CheckpointDirectory(std::vector<int64_t> steps, int64_t world_size)
+      : path(c10::make_tempfile().name + "-checkpoint"),
+        steps(std::move(steps)),
+        world_size(world_size) {}
+
+  ~CheckpointDirectory() {
+    for (const auto step : steps) {
+      const auto step_path = path + "/step_" + std::to_string(step);
+      for (int64_t rank = 0; rank < world_size; rank++) {
+        const auto suffix = std::to_string(rank) + ".pt";
+        std::remove((step_path + "/shard_" + suffix).c_str());
+        std::remove((step_path + "/manifest_" + suffix).c_str());
+      }
+      ::rmdir(step_path.c_str());
+    }
+    ::rmdir(path.c_str());
+  }
+
+  std::string path;
+  std::vector<int64_t> steps;
+  int64_t world_size;
+};
+
+torch::OrderedDict<std::string, torch::Tensor> make_state() {
+  torch::OrderedDict<std::string, torch::Tensor> state;
+  state.insert("weight", torch::randn({16, 8}));
+  state.insert("bias", torch::randn({16}));
+  state.insert("steps", torch::arange(10, torch::kLong));
+  state.insert("big", torch::randn({128, 64}));
+  return state;
+}
+
+void assert_state_equal(
+    const torch::OrderedDict<std::string, torch::Tensor>& expected,
+    const torch::OrderedDict<std::string, torch::Tensor>& actual) {
+  ASSERT_EQ(expected.size(), actual.size());
+  for (const auto& item : expected) {
+    ASSERT_TRUE(actual.contains(item.key()));
+    ASSERT_TRUE(torch::equal(item.value(), actual[item.key()]));
+  }
+}
+} // namespace
+
+TEST(CheckpointTest, SaveAndLoad) {
+  torch::manual_seed(0);
+  CheckpointDirectory directory({0}, 1);
+  auto state = make_state();
+
+  CheckpointWriter writer(directory.path);
+  writer.save(0, state);
+  // Changing the tensors after save() returns does not change the checkpoint.
+  torch::OrderedDict<std::string, torch::Tensor> expected;
+  for (const auto& item : state) {
+    expected.insert(item.key(), item.value().clone());
+    item.value().fill_(0);
+  }
+  writer.wait();
+
+  ASSERT_EQ(writer.last_stats().num_written, 4);
+  ASSERT_EQ(writer.last_stats().num_skipped, 0);
+  assert_state_equal(expected, load_checkpoint(directory.path, 0));
+}
+
+TEST(CheckpointTest, SaveModule) {
+  torch::manual_seed(0);
+  CheckpointDirectory directory({3}, 1);
+  torch::nn::Sequential model(
+      torch::nn::Linear(4, 8), torch::nn::BatchNorm1d(8));
+
+  CheckpointWriter writer(directory.path);
+  writer.save(3, *model);
+  writer.wait();
+
+  auto state = model->named_parameters();
+  for (const auto& buffer : model->named_buffers()) {
+    state.insert(buffer.key(), buffer.value());
+  }
+  assert_state_equal(state, load_checkpoint(directory.path, 3));
+}
+
+TEST(CheckpointTest, Incremental) {
+  torch::manual_seed(0);
+  CheckpointDirectory directory({0, 1}, 1);
+  auto state = make_state();
+
+  CheckpointWriter writer(
+      directory.path, CheckpointWriterOptions().incremental(true));
+  writer.save(0, state);
+  writer.wait();
+  ASSERT_EQ(writer.last_stats().num_written, 4);
+
+  state["bias"].add_(1);
+  writer.save(1, state);
+  writer.wait();
+  // Only the changed tensor is written again.
+  ASSERT_EQ(writer.last_stats().num_written, 1);
+  ASSERT_EQ(writer.last_stats().num_skipped, 3);
+  ASSERT_EQ(
+      writer.last_stats().bytes_written,
+      static_cast<int64_t>(state["bias"].nbytes()));
+
+  assert_state_equal(state, load_checkpoint(directory.path, 1));
+}
+
+TEST(CheckpointTest, ReplicatedShards) {
+  torch::manual_seed(0);
+  const int64_t world_size = 2;
+  CheckpointDirectory directory({5}, world_size);
+  auto state = make_state();
+
+  const auto num_tensors = static_cast<int64_t>(state.size());
+  int64_t num_written = 0;
+  for (int64_t rank = 0; rank < world_size; rank++) {
+    CheckpointWriter writer(
+        directory.path,
+        CheckpointWriterOptions().rank(rank).world_size(world_size).replicated(
+            true));
+    writer.save(5, state);
+    writer.wait();
+    // Every rank writes only its share of the tensors.
+    ASSERT_GT(writer.last_stats().num_written, 0);
+    ASSERT_LT(writer.last_stats().num_written, num_tensors);
+    num_written += writer.last_stats().num_written;
+  }
+  ASSERT_EQ(num_written, num_tensors);
+
+  assert_state_equal(state, load_checkpoint(directory.path, 5));
+}
+
+TEST(CheckpointTest, NonReplicatedShards) {
+  torch::manual_seed(0);
+  const int64_t world_size = 2;
+  CheckpointDirectory directory({2}, world_size);
+
+  // Every rank holds a different shard of the state, under the same keys.
+  std::vector<torch::OrderedDict<std::string, torch::Tensor>> shards;
+  for (int64_t rank = 0; rank < world_size; rank++) {
+    shards.push_back(make_state());
+    CheckpointWriter writer(
+        directory.path,
+        CheckpointWriterOptions().rank(rank).world_size(world_size));
+    writer.save(2, shards.back());
+    writer.wait();
+    ASSERT_EQ(
+        writer.last_stats().num_written,
+        static_cast<int64_t>(shards.back().size()));
+  }
+
+  for (int64_t rank = 0; rank < world_size; rank++) {
+    assert_state_equal(shards[rank], load_checkpoint(directory.path, 2, rank));
+  }
+  ASSERT_THROWS_WITH(
+      load_checkpoint(directory.path, 2), "written by more than one rank");
+}
+
+TEST(CheckpointTest, IncompleteCheckpointThrows) {
+  CheckpointDirectory directory({0}, 2);
+  CheckpointWriter writer(
+      directory.path, CheckpointWriterOptions().rank(0).world_size(2));
+  writer.save(0, make_state());
+  writer.wait();
+
+  // The manifest of rank 1 is missing.
+  ASSERT_THROWS_WITH(
+      load_checkpoint(directory.path, 0), "completely written");
+}
@@ -2,17 +2,46 @@
 
 #include <torch/torch.h>
 #include <ATen/native/Pow.h>
+#include <ATen/native/TensorIterator.h>
 #include <torch/types.h>
 #include <torch/utils.h>
 #include <test/cpp/api/support.h>
 #include <iostream>
 #include <vector>
 #include <type_traits>
+#include <cmath>
 #include <cstdlib>
 
 
 struct DispatchTest : torch::test::SeedingFixture {};
 
+// The CPU capability is chosen once per process, so setting
+// ATEN_CPU_CAPABILITY at this point would not reach the kernels. Call the
+// AVX512 kernel of the stub directly, on enough elements to fill whole
+// 512-bit vectors plus a tail.
+TEST_F(DispatchTest, TestAVX512) {
+#ifdef HAVE_AVX512_CPU_DEFINITION
+  if (at::native::get_cpu_capability() < at::native::CPUCapability::AVX512) {
+    return;
+  }
+  const auto kernel = at::native::pow_tensor_tensor_stub.AVX512;
+  ASSERT_NE(kernel, nullptr);
+  for (const auto dtype : {torch::kInt, torch::kLong, torch::kFloat, torch::kDouble}) {
+    const auto vals_tensor = torch::arange(1, 38, torch::kDouble).remainder(5).add(1);
+    const auto pows_tensor = torch::arange(0, 37, torch::kDouble).remainder(7);
+    auto actual = torch::empty({37}, dtype);
+    auto iter = at::TensorIterator::binary_op(
+        actual, vals_tensor.to(dtype), pows_tensor.to(dtype));
+    kernel(iter);
+    for (int64_t i = 0; i < 37; i++) {
+      const double expected = std::pow(
+          vals_tensor[i].item<double>(), pows_tensor[i].item<double>());
+      ASSERT_NEAR(expected, actual[i].item<double>(), expected * 1e-6);
+    }
+  }
+#endif
+}
+
 TEST_F(DispatchTest, TestAVX2) {
   const std::vector<int> ints {1, 2, 3, 4};
   const std::vector<int> result {1, 4, 27, 256};
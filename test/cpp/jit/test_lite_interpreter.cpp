@@ -1,8 +1,12 @@
 #include <c10/core/TensorOptions.h>
+#include <caffe2/serialize/inline_container.h>
 #include <test/cpp/jit/test_base.h>
 #include <torch/csrc/autograd/generated/variable_factories.h>
 #include <torch/csrc/jit/api/module.h>
+#include <torch/csrc/jit/mobile/flat_bytecode.h>
 #include <torch/csrc/jit/mobile/import.h>
+#include <torch/csrc/jit/mobile/interpreter.h>
+#include <torch/csrc/jit/mobile/memory_planner.h>
 #include <torch/csrc/jit/mobile/module.h>
 #include <torch/csrc/jit/serialization/import.h>
 #include <torch/custom_class.h>
@@ -159,6 +163,189 @@ void testLiteInterpreterDict() {
   AT_ASSERT(output.toGenericDict().at("result").toTensor().item().toInt() == 2);
 }
 
+void testLiteInterpreterThreaded() {
+  Module m("m");
+  m.register_parameter("foo", torch::ones({2}), false);
+  m.define(R"JIT(
+    def forward(self, x, n: int):
+      y = x
+      total = 0
+      for i in range(n):
+          if i % 3 == 0:
+              y = y + self.foo * i
+          else:
+              y = torch.mul(y, 0.5)
+          total += i
+      while total > 10:
+          total = total // 2
+      return y, total, [total, n]
+  )JIT");
+  std::stringstream ss;
+  m._save_for_mobile(ss);
+  mobile::Module bc = _load_for_mobile(ss);
+
+  for (int64_t n : {0, 1, 7}) {
+    std::vector<IValue> inputs{torch::rand({2}), n};
+    auto ref = m.forward(inputs).toTuple()->elements();
+    for (bool threaded : {false, true, false}) {
+      mobile::setThreadedInterpreterEnabled(threaded);
+      auto res = bc.forward(inputs).toTuple()->elements();
+      AT_ASSERT(res[0].toTensor().allclose(ref[0].toTensor()));
+      AT_ASSERT(res[1].toInt() == ref[1].toInt());
+      AT_ASSERT(res[2].toIntVector() == ref[2].toIntVector());
+    }
+  }
+  mobile::setThreadedInterpreterEnabled(false);
+}
+
+void testLiteInterpreterMemoryPlanning() {
+  Module m("m");
+  m.define(R"JIT(
+    def forward(self, x):
+      a = torch.add(x, x)
+      b = torch.mul(a, x)
+      c = torch.add(b, x)
+      d = torch.mul(c, x)
+      return d + x
+  )JIT");
+  std::stringstream ss;
+  m._save_for_mobile(ss);
+  mobile::Module bc = _load_for_mobile(ss);
+
+  // a, b, c and d are planned, the returned value is not.
+  auto stats = bc.memory_plan_stats("forward");
+  AT_ASSERT(stats.candidate_values == 4);
+  AT_ASSERT(stats.arena_bytes == 0);
+
+  mobile::setMemoryPlanningEnabled(true);
+  std::vector<IValue> inputs{torch::rand({4, 4})};
+  auto ref = m.forward(inputs).toTensor();
+  // The first run profiles, the second one runs in the arena.
+  for (int i = 0; i < 2; ++i) {
+    AT_ASSERT(bc.forward(inputs).toTensor().equal(ref));
+  }
+  stats = bc.memory_plan_stats("forward");
+  AT_ASSERT(stats.planned_values == 4);
+  AT_ASSERT(stats.planned_bytes == 4 * 64);
+  // a and c, as well as b and d, share their memory.
+  AT_ASSERT(stats.arena_bytes == 2 * 64);
+
+  // Other dtypes and sizes fall back to regular allocations.
+  for (auto input : {torch::rand({4, 4}, at::kDouble), torch::rand({8, 8})}) {
+    std::vector<IValue> other_inputs{input};
+    AT_ASSERT(bc.forward(other_inputs)
+                  .toTensor()
+                  .equal(m.forward(other_inputs).toTensor()));
+  }
+  mobile::setMemoryPlanningEnabled(false);
+}
+
+void testLiteInterpreterMemoryPlanningAliasing() {
+  Module m("m");
+  m.define(R"JIT(
+    def forward(self, x):
+      a = torch.add(x, x)
+      b = torch.mul(a, x)
+      return torch.dropout(b, 0.5, False)
+  )JIT");
+  std::stringstream ss;
+  m._save_for_mobile(ss);
+  mobile::Module bc = _load_for_mobile(ss);
+
+  // dropout returns its input in eval mode, so b escapes with the result.
+  AT_ASSERT(bc.memory_plan_stats("forward").candidate_values == 1);
+
+  mobile::setMemoryPlanningEnabled(true);
+  std::vector<IValue> inputs{torch::rand({4, 4})};
+  std::vector<IValue> other_inputs{torch::rand({4, 4})};
+  auto ref = m.forward(inputs).toTensor();
+  // The first run profiles, the later ones run in the arena. A result must
+  // not change when the arena is reused.
+  bc.forward(inputs);
+  auto result = bc.forward(inputs).toTensor();
+  bc.forward(other_inputs);
+  AT_ASSERT(result.equal(ref));
+  mobile::setMemoryPlanningEnabled(false);
+}
+
+void testLiteInterpreterFlatBytecode() {
+  Module m("m");
+  m.define(R"JIT(
+    def forward(self, x):
+      y = x.view([2, 3]) * 1.5
+      if x.is_contiguous():
+        y = y + 1
+      return y.sum(dim=[0, 1], keepdim=False), "done"
+  )JIT");
+  std::stringstream ss;
+  m._save_for_mobile(ss);
+  {
+    caffe2::serialize::PyTorchStreamReader reader(&ss);
+    AT_ASSERT(reader.hasRecord(mobile::kFlatBytecodeRecord));
+    AT_ASSERT(reader.hasRecord("bytecode.pkl"));
+  }
+  ss.seekg(0);
+  mobile::Module bc = _load_for_mobile(ss);
+  auto x = torch::rand({6});
+  auto ref = m.forward({x}).toTuple()->elements();
+  auto res = bc.forward({x}).toTuple()->elements();
+  AT_ASSERT(res[0].toTensor().equal(ref[0].toTensor()));
+  AT_ASSERT(res[1].toStringRef() == "done");
+
+  // Round trip of the constant table, and the fallback to bytecode.pkl for
+  // constants the flat format can not hold.
+  using c10::ivalue::Tuple;
+  auto field = [](const std::string& name, IValue value) {
+    return Tuple::create({name, std::move(value)});
+  };
+  auto function = [&](std::vector<IValue> constants) {
+    auto table = Tuple::create(
+        {field("instructions", Tuple::create({Tuple::create({"RET", 0, 0})})),
+         field("operators", Tuple::create({Tuple::create({"aten::add", "Tensor"})})),
+         field("constants", Tuple::create(std::move(constants))),
+         field("types", Tuple::create({"List[int]"})),
+         field("register_size", 3)});
+    return Tuple::create({"__torch__.m.forward", table});
+  };
+  std::vector<IValue> constants{IValue(),
+                                true,
+                                int64_t(-7),
+                                0.25,
+                                "str",
+                                c10::Device("cpu"),
+                                c10::List<int64_t>({1, 2}),
+                                c10::List<double>({0.5}),
+                                c10::List<bool>({true, false, true})};
+  auto flat = mobile::flattenBytecode(
+      {int64_t(caffe2::serialize::kProducedBytecodeVersion), function(constants)});
+  AT_ASSERT(flat.has_value());
+  auto parsed = mobile::parseFlatBytecode(flat->data(), flat->size());
+  AT_ASSERT(parsed.first == caffe2::serialize::kProducedBytecodeVersion);
+  AT_ASSERT(parsed.second.size() == 1);
+  const auto& f = parsed.second[0];
+  AT_ASSERT(f.name == "__torch__.m.forward");
+  AT_ASSERT(f.register_size == 3);
+  AT_ASSERT(f.num_instructions == 1 && f.instructions[0].op == RET);
+  AT_ASSERT(f.operators.size() == 1 && f.operators[0].overload_name == "Tensor");
+  AT_ASSERT(f.types.size() == 1 && f.types[0] == "List[int]");
+  AT_ASSERT(f.constants.size() == constants.size());
+  for (size_t i = 0; i < constants.size(); ++i) {
+    AT_ASSERT(f.constants[i] == constants[i]);
+  }
+
+  // A corrupt function count fails before the functions are allocated.
+  std::string corrupt = *flat;
+  const uint32_t num_functions = 0xffffffff;
+  std::memcpy(&corrupt[16], &num_functions, sizeof(num_functions));
+  ASSERT_THROWS_WITH(
+      mobile::parseFlatBytecode(corrupt.data(), corrupt.size()), "truncated");
+
+  AT_ASSERT(!mobile::flattenBytecode(
+                 {int64_t(caffe2::serialize::kProducedBytecodeVersion),
+                  function({torch::ones({2})})})
+                 .has_value());
+}
+
 void testLiteInterpreterPrimOverload() {
   /*
   // temporarily disabled
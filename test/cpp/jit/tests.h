@@ -104,6 +104,10 @@ namespace jit {
   _(LiteInterpreterDuplicatedClassTypeModuleInfo) \
   _(TorchbindIValueAPI)                           \
   _(LiteInterpreterDict)                          \
+  _(LiteInterpreterFlatBytecode)                  \
+  _(LiteInterpreterThreaded)                      \
+  _(LiteInterpreterMemoryPlanning)                \
+  _(LiteInterpreterMemoryPlanningAliasing)        \
   _(MobileNamedParameters)                        \
   _(MobileSaveLoadData)                           \
   _(LiteSGD)                                      \
@@ -93,6 +93,63 @@ TEST(WireSerialize, Errors) {
       "failed bounds");
 }
 
+TEST(WireSerialize, Segments) {
+  std::string payload = "payload";
+  std::vector<at::Tensor> tensors = {
+      torch::randn({5, 5}), torch::empty({0}), torch::rand({10, 10})};
+  auto wireMessage = torch::distributed::rpc::wireSerializeSegments(
+      std::vector<char>(payload.begin(), payload.end()), tensors);
+
+  // The segments point at the tensor storages instead of copies.
+  ASSERT_EQ(wireMessage.segments.size(), tensors.size());
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    EXPECT_EQ(
+        wireMessage.segments[i].data,
+        static_cast<const char*>(tensors[i].storage().data()));
+    EXPECT_EQ(wireMessage.segments[i].size, tensors[i].nbytes());
+  }
+
+  // Header and segments together are the contiguous wire format.
+  std::string contiguous = wireMessage.header;
+  for (const auto& segment : wireMessage.segments) {
+    contiguous.append(segment.data, segment.size);
+  }
+  EXPECT_EQ(
+      contiguous,
+      torch::distributed::rpc::wireSerialize(
+          std::vector<char>(payload.begin(), payload.end()), tensors));
+
+  // Receive the segments into separate buffers.
+  auto sizes = torch::distributed::rpc::wireSegmentSizes(
+      wireMessage.header.data(), wireMessage.header.size());
+  ASSERT_EQ(sizes.size(), wireMessage.segments.size());
+  std::vector<at::Tensor> segments;
+  for (size_t i = 0; i < sizes.size(); ++i) {
+    segments.push_back(
+        torch::empty({static_cast<int64_t>(sizes[i])}, torch::kChar));
+    if (sizes[i] != 0) {
+      memcpy(segments[i].data_ptr(), wireMessage.segments[i].data, sizes[i]);
+    }
+  }
+  auto deser = torch::distributed::rpc::wireDeserializeSegments(
+      wireMessage.header.data(), wireMessage.header.size(), segments);
+  EXPECT_EQ(std::string(deser.first.begin(), deser.first.end()), payload);
+  ASSERT_EQ(deser.second.size(), tensors.size());
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    EXPECT_TRUE(torch::equal(tensors[i], deser.second[i]));
+  }
+  // The tensors are built directly over the received buffers.
+  EXPECT_EQ(deser.second[0].data_ptr(), segments[0].data_ptr());
+  EXPECT_EQ(deser.second[2].data_ptr(), segments[2].data_ptr());
+
+  // The buffers have to match the sizes in the header.
+  segments.pop_back();
+  EXPECT_THROW(
+      torch::distributed::rpc::wireDeserializeSegments(
+          wireMessage.header.data(), wireMessage.header.size(), segments),
+      std::runtime_error);
+}
+
 // Enable this once JIT Pickler supports sparse tensors.
 TEST(WireSerialize, DISABLED_Sparse) {
   at::Tensor main = at::empty({2, 3}, at::dtype<float>().layout(at::kSparse));
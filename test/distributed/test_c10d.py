@@ -273,6 +273,41 @@ class TCPStoreTest(TestCase, StoreTestBase):
             store1 = c10d.TCPStore(addr, port, 1, True)  # noqa: F841
             store2 = c10d.TCPStore(addr, port, 1, True)  # noqa: F841
 
+    def test_multi_get_set(self):
+        store = self._create_store()
+        store.multi_set(["key0", "key1"], ["value0", "value1"])
+        self.assertEqual([b"value0", b"value1"], store.multi_get(["key0", "key1"]))
+        self.assertEqual(b"value1", store.get("key1"))
+        with self.assertRaisesRegex(ValueError, "2 keys but 1 values"):
+            store.multi_set(["key0", "key1"], ["value0"])
+
+    def test_compare_set(self):
+        store = self._create_store()
+        self.assertEqual(b"expected", store.compare_set("key", "expected", "desired"))
+        self.assertEqual(b"first", store.compare_set("key", "", "first"))
+        self.assertEqual(b"first", store.compare_set("key", "other", "second"))
+        self.assertEqual(b"second", store.compare_set("key", "first", "second"))
+        self.assertEqual(b"second", store.get("key"))
+
+    def test_watch_key(self):
+        store = self._create_store()
+        seen = []
+        done = threading.Event()
+
+        def callback(value):
+            seen.append(value)
+            if len(seen) == 3:
+                done.set()
+
+        store.watch_key("key", callback)
+        store.set("key", "a")
+        store.compare_set("key", "a", "b")
+        store.multi_set(["key"], ["c"])
+        self.assertTrue(done.wait(10))
+        self.assertEqual([b"a", b"b", b"c"], seen)
+        # Joins the thread that runs the callbacks, which needs the GIL
+        del store
+
 
 class PrefixTCPStoreTest(TestCase, StoreTestBase):
     def setUp(self):
@@ -824,6 +859,36 @@ class ProcessGroupGlooTest(MultiProcessTestCase):
         inputs = [torch.tensor([i + self.rank]).cuda() for i in range(1000)]
         self._test_allreduce_stress(inputs)
 
+    def test_allreduce_chunked(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        opts = self.opts(threads=4)
+        opts.allreduce_chunk_bytes = 1000
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, opts)
+
+        # The last segment is shorter than the others.
+        for dtype in [torch.float32, torch.float64, torch.int32]:
+            x = torch.arange(2049, dtype=dtype).view(-1, 683) * (self.rank + 1)
+            pg.allreduce(x).wait()
+            expected = torch.arange(2049, dtype=dtype).view(-1, 683) * (
+                self.world_size * (self.world_size + 1) // 2)
+            self.assertEqual(expected, x)
+
+        for (op, _, output) in simple_reduce_tests(self.rank, self.world_size)[:4]:
+            x = torch.full([1000], self.rank + 1.0)
+            allreduce_opts = c10d.AllreduceOptions()
+            allreduce_opts.reduceOp = op
+            pg.allreduce([x], allreduce_opts).wait()
+            self.assertEqual(output.expand(1000), x)
+
+        # Segments of concurrent allreduces interleave on the worker threads.
+        inputs = [torch.full([1000], float(i + self.rank)) for i in range(20)]
+        works = [pg.allreduce(x) for x in inputs]
+        for i, work in enumerate(works):
+            work.wait()
+            self.assertEqual(
+                torch.full([1000], float(i * self.world_size + self.world_size * (self.world_size - 1) // 2)),
+                inputs[i])
+
     def test_allreduce_coalesced_checks(self):
         store = c10d.FileStore(self.file_name, self.world_size)
         pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, self.opts())
@@ -1332,6 +1397,36 @@ class ProcessGroupGlooTest(MultiProcessTestCase):
         inputs = [torch.tensor([i + self.rank]).cuda() for i in range(1000)]
         self._test_allgather_stress(inputs, lambda t: t.clone().cuda())
 
+    def test_allgather_base_checks(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, self.opts())
+
+        t1 = torch.zeros([1], dtype=torch.float32)
+        t2 = torch.zeros([self.world_size], dtype=torch.float64)
+        t3 = torch.zeros([self.world_size + 1], dtype=torch.float32)
+        t4 = torch.zeros([self.world_size, 2], dtype=torch.float32)
+
+        with self.assertRaisesRegex(ValueError, "must have the same type"):
+            pg._allgather_base(t2, t1)
+
+        with self.assertRaisesRegex(ValueError, "expected {}".format(self.world_size)):
+            pg._allgather_base(t3, t1)
+
+        with self.assertRaisesRegex(ValueError, "must be contiguous"):
+            pg._allgather_base(t4.t(), t1)
+
+    def test_allgather_base_basics(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, self.opts())
+
+        for n in [1, 2, 3]:
+            input = torch.arange(n) + n * self.rank
+            output = torch.full([self.world_size, n], -1, dtype=input.dtype)
+            work = pg._allgather_base(output, input)
+            work.wait()
+            self.assertEqual(
+                torch.arange(n * self.world_size).view(self.world_size, n), output)
+
     def test_allgather_coalesced_checks(self):
         store = c10d.FileStore(self.file_name, self.world_size)
         pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, self.opts())
@@ -1459,6 +1554,86 @@ class ProcessGroupGlooTest(MultiProcessTestCase):
         inputs = [torch.tensor([i + self.rank]).cuda() for i in range(1000)]
         self._test_reduce_stress(inputs)
 
+    def test_reduce_scatter_checks(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, self.opts())
+
+        t1 = torch.zeros([1], dtype=torch.float32)
+        t2 = torch.zeros([1], dtype=torch.float64)
+        t3 = torch.zeros([2], dtype=torch.float32)
+
+        with self.assertRaisesRegex(ValueError, "requires a single-element output tensor list"):
+            pg.reduce_scatter([], [[t1] * self.world_size])
+
+        with self.assertRaisesRegex(ValueError, "requires a single-element output tensor list"):
+            pg.reduce_scatter([t1, t1], [[t1] * self.world_size])
+
+        with self.assertRaisesRegex(ValueError, "requires a single-element input list"):
+            pg.reduce_scatter([t1], [])
+
+        with self.assertRaisesRegex(ValueError, "Incorrect input list size"):
+            pg.reduce_scatter([t1], [[t1] * (self.world_size + 1)])
+
+        with self.assertRaisesRegex(ValueError, "invalid tensor type"):
+            pg.reduce_scatter([t1], [[t2] * self.world_size])
+
+        with self.assertRaisesRegex(ValueError, "invalid tensor size"):
+            pg.reduce_scatter([t1], [[t3] * self.world_size])
+
+        with self.assertRaisesRegex(RuntimeError, "Cannot use ReduceOp.BAND with non-integral dtype"):
+            opts = c10d.ReduceScatterOptions()
+            opts.reduceOp = c10d.ReduceOp.BAND
+            pg.reduce_scatter([t1], [[t1] * self.world_size], opts)
+
+    def test_reduce_scatter_basics(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, self.opts())
+
+        # Rank k contributes (k + j + 1) to chunk j, so chunk r reduces over
+        # the values r + 1 .. r + world_size.
+        values = [self.rank + k + 1 for k in range(self.world_size)]
+        expected = {
+            c10d.ReduceOp.SUM: sum(values),
+            c10d.ReduceOp.PRODUCT: reduce(operator.mul, values, 1),
+            c10d.ReduceOp.MIN: min(values),
+            c10d.ReduceOp.MAX: max(values),
+        }
+        for op, value in expected.items():
+            opts = c10d.ReduceScatterOptions()
+            opts.reduceOp = op
+            inputs = [
+                torch.full([3, 5], float(self.rank + j + 1))
+                for j in range(self.world_size)
+            ]
+            output = torch.zeros([3, 5])
+            work = pg.reduce_scatter([output], [inputs], opts)
+            work.wait()
+            self.assertEqual(torch.full([3, 5], float(value)), output)
+
+    def test_reduce_scatter_stress(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, self.opts(threads=8))
+        work_handles = []
+        outputs = []
+        for i in range(100):
+            inputs = [
+                torch.tensor([i + self.rank + j]) for j in range(self.world_size)
+            ]
+            output = torch.tensor([-1])
+            outputs.append(output)
+            work_handles.append(pg.reduce_scatter([output], [inputs]))
+
+        for i, work_handle in enumerate(work_handles):
+            work_handle.wait()
+            self.assertEqual(
+                torch.tensor([
+                    (i + self.rank) * self.world_size +
+                    (self.world_size * (self.world_size - 1) // 2)
+                ]),
+                outputs[i],
+                msg=("Mismatch in iteration %d" % i),
+            )
+
     def test_send_recv_all_to_all(self):
         store = c10d.FileStore(self.file_name, self.world_size)
         pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, self.opts())
@@ -1554,6 +1729,72 @@ class ProcessGroupGlooTest(MultiProcessTestCase):
                 self.assertEqual(torch.full([10, 10], float(self.world_size)), tensor)
             del pg
 
+    def _create_hierarchical_pg(self, ranks_per_host, slot_bytes=1024):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        # Pretend that consecutive ranks share a host.
+        return c10d.ProcessGroupHierarchical(
+            c10d.PrefixStore(str(ranks_per_host), store),
+            self.rank,
+            self.world_size,
+            timeout=timedelta(seconds=5),
+            hostname="host%d" % (self.rank // ranks_per_host),
+            slot_bytes=slot_bytes)
+
+    def test_hierarchical_allreduce(self):
+        for ranks_per_host in [1, 2, self.world_size]:
+            pg = self._create_hierarchical_pg(ranks_per_host)
+            self.assertEqual(self.rank % ranks_per_host, pg.local_rank)
+            self.assertEqual(ranks_per_host, pg.local_size)
+            self.assertEqual(self.world_size // ranks_per_host, pg.num_hosts)
+
+            for (op, input, output) in simple_reduce_tests(self.rank, self.world_size)[:4]:
+                opts = c10d.AllreduceOptions()
+                opts.reduceOp = op
+                tensor = input.clone()
+                pg.allreduce([tensor], opts).wait()
+                self.assertEqual(output, tensor)
+
+            # Larger than a slot, so it is reduced in chunks.
+            tensor = torch.arange(1000, dtype=torch.float64) * (self.rank + 1)
+            pg.allreduce(tensor).wait()
+            expected = torch.arange(1000, dtype=torch.float64) * (
+                self.world_size * (self.world_size + 1) / 2)
+            self.assertEqual(expected, tensor)
+
+            # Non-contiguous input.
+            tensor = torch.full([10, 10], float(self.rank)).t()[:, :5]
+            pg.allreduce(tensor).wait()
+            self.assertEqual(
+                torch.full([10, 5], float(self.world_size * (self.world_size - 1) / 2)),
+                tensor)
+
+            tensors = [torch.ones([3, 3]), torch.ones([7], dtype=torch.float32)]
+            pg.allreduce_coalesced(tensors).wait()
+            for tensor in tensors:
+                self.assertEqual(torch.full(tensor.size(), float(self.world_size)), tensor)
+
+            pg.barrier().wait()
+            del pg
+
+    def test_hierarchical_checks(self):
+        pg = self._create_hierarchical_pg(ranks_per_host=2)
+
+        with self.assertRaisesRegex(ValueError, "requires a single-element tensor list"):
+            pg.allreduce([torch.ones(1), torch.ones(1)])
+
+        with self.assertRaisesRegex(ValueError, "unsupported reduction operation"):
+            opts = c10d.AllreduceOptions()
+            opts.reduceOp = c10d.ReduceOp.BAND
+            pg.allreduce([torch.ones(1, dtype=torch.int32)], opts)
+
+        with self.assertRaisesRegex(ValueError, "tensors must all have the same type"):
+            pg.allreduce_coalesced([torch.ones(1), torch.ones(1, dtype=torch.float64)])
+
+        with self.assertRaisesRegex(RuntimeError, "does not support broadcast"):
+            pg.broadcast([torch.ones(1)])
+
+        pg.barrier().wait()
+
 
 @requires_nccl()
 @unittest.skipIf(
@@ -2073,6 +2314,51 @@ class DistributedDataParallelTest(MultiProcessTestCase):
     def test_gloo_backend_cpu_module(self):
         self._test_gloo_backend([torch.device('cpu')], [])
 
+    @requires_gloo()
+    def test_adaptive_bucketing_coalescing(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        process_group = c10d.ProcessGroupGloo(store, self.rank, self.world_size)
+        # Same model and inputs on all ranks, so that the averaged gradients
+        # equal the local ones.
+        torch.manual_seed(0)
+        model = nn.Sequential(*[nn.Linear(8, 8) for _ in range(4)])
+        reference = copy.deepcopy(model)
+        parameters = list(model.parameters())
+        buckets = [[i] for i in range(len(parameters))]
+        # A bucket size cap of one byte puts every parameter in its own bucket.
+        reducer = dist.Reducer(
+            [parameters], buckets, process_group, bucket_bytes_cap=1)
+        reducer.enable_adaptive_bucketing(num_iterations=2)
+        # The first iteration rebuilds the buckets in ready order, the next two
+        # are measured, and the rest run with the adaptive buckets.
+        for i in range(6):
+            torch.manual_seed(i)
+            input = torch.rand([4, 8])
+            for m in (model, reference):
+                m.zero_grad()
+            output = model(input).sum()
+            reducer.prepare_for_backward(output)
+            output.backward()
+            reference(input).sum().backward()
+            for p, ref in zip(model.parameters(), reference.parameters()):
+                self.assertEqual(p.grad, ref.grad)
+
+        bucket_indices = reducer.get_bucket_indices()
+        groups = reducer.get_coalesced_groups()
+        self.assertEqual([len(bucket) for bucket in bucket_indices], [1] * len(parameters))
+        # The gradients of a layer become ready right after each other, well
+        # within the latency of an allreduce.
+        self.assertTrue(any(len(group) > 1 for group in groups))
+        self.assertEqual(sum(groups, []), list(range(len(bucket_indices))))
+
+        # All ranks follow the assignment and the groups of rank 0.
+        group_of_bucket = [i for i, group in enumerate(groups) for _ in group]
+        layout = torch.tensor(sum(bucket_indices, []) + group_of_bucket)
+        layouts = [torch.zeros_like(layout) for _ in range(self.world_size)]
+        process_group.allgather([layouts], [layout]).wait()
+        for other in layouts:
+            self.assertEqual(other, layout)
+
     @requires_gloo()
     @skip_if_not_multigpu
     def test_gloo_backend_1gpu_module_device_ids_integer_list(self):
@@ -3419,6 +3705,40 @@ class ReducerTest(TestCase):
             output.backward()
             optimizer.step()
 
+    def test_adaptive_bucketing(self):
+        batch_size = 10
+        model = ReducerModule()
+        reference = copy.deepcopy(model)
+        parameters = list(model.parameters())
+        # One bucket per parameter, in definition order.
+        buckets = [[i] for i in range(len(parameters))]
+        reducer = dist.Reducer([parameters], buckets, self.process_group)
+        reducer.enable_adaptive_bucketing(num_iterations=2)
+        loss = nn.CrossEntropyLoss()
+        # The first iteration rebuilds the buckets in ready order, the next two
+        # are measured, and the rest run with the adaptive buckets.
+        for _ in range(5):
+            input = torch.rand([batch_size, 2])
+            target = torch.LongTensor([random.randrange(4) for _ in range(batch_size)])
+            for m in (model, reference):
+                m.zero_grad()
+            output = loss(model(input), target)
+            reducer.prepare_for_backward(output)
+            output.backward()
+            loss(reference(input), target).backward()
+            for p, ref in zip(model.parameters(), reference.parameters()):
+                self.assertEqual(p.grad, ref.grad)
+
+    def test_adaptive_bucketing_checks(self):
+        model = self._create_mixed_precision_model()
+        reducer = self._create_reducer_for_models([model])
+        with self.assertRaisesRegex(RuntimeError, "positive number of iterations"):
+            reducer.enable_adaptive_bucketing(num_iterations=0)
+
+        reducer = self._create_reducer_for_models([model], find_unused_parameters=True)
+        with self.assertRaisesRegex(RuntimeError, "find_unused_parameters"):
+            reducer.enable_adaptive_bucketing()
+
     def test_ddp_comm_hook_multiple_replica_check(self):
         """
         DDP communication hook does not support single process multiple device mode.
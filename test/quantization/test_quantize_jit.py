@@ -2001,6 +2001,51 @@ class TestQuantizeJitOps(QuantizationTestCase):
                     FileCheck().check_not("quantized::mul") \
                                .run(m.graph)
 
+    @skipIfNoFBGEMM
+    def test_quantized_matmul_softmax(self):
+        class MatmulSoftmax(torch.nn.Module):
+            def __init__(self):
+                super(MatmulSoftmax, self).__init__()
+                self.linear1 = torch.nn.Linear(8, 8).float()
+                self.linear2 = torch.nn.Linear(8, 8).float()
+
+            def forward(self, x, y):
+                x = self.linear1(x)
+                y = self.linear2(y)
+                return torch.softmax(torch.bmm(x, y.transpose(1, 2)), 1)
+
+        class Attention(torch.nn.Module):
+            def __init__(self):
+                super(Attention, self).__init__()
+                self.q = torch.nn.Linear(8, 8).float()
+                self.k = torch.nn.Linear(8, 8).float()
+                self.v = torch.nn.Linear(8, 8).float()
+
+            def forward(self, x, y):
+                q = self.q(x)
+                k = self.k(y)
+                v = self.v(y)
+                weights = torch.softmax(torch.matmul(q, k.transpose(-2, -1)), -1)
+                return torch.matmul(weights, v)
+
+        data = [[torch.randn(2, 5, 8, dtype=torch.float),
+                 torch.randn(2, 6, 8, dtype=torch.float)]]
+        for tracing in [True, False]:
+            m = self.checkGraphModeOp(MatmulSoftmax(), data, "quantized::bmm", tracing)
+            FileCheck().check("quantized::softmax") \
+                       .check_not("aten::bmm") \
+                       .check_not("aten::softmax") \
+                       .run(m.graph)
+
+            # the fused op does not quantize the intermediate scores, so its
+            # numerics differ from the reference graph
+            m = self.checkGraphModeOp(Attention(), data, "quantized::scaled_dot_product_attention",
+                                      tracing, check=False)
+            FileCheck().check("quantized::scaled_dot_product_attention") \
+                       .check_not("quantized::matmul") \
+                       .check_not("quantized::softmax") \
+                       .run(m.graph)
+
     @skipIfNoFBGEMM
     def test_quantized_mul_scalar(self):
         class QuantizedMulScalar(torch.nn.Module):
@@ -880,6 +880,91 @@ class TestQuantizedOps(TestCase):
         np.testing.assert_equal(qC, qC_hat.int_repr(),
                                 "Quantized multiplication failed.")
 
+    """Tests the correctness of the quantized::softmax op."""
+    def test_qsoftmax(self):
+        softmax = torch.ops.quantized.softmax
+        output_scale = 1.0 / 256
+        for dtype, output_zero_point in [(torch.quint8, 0), (torch.qint8, -128)]:
+            for shape, dim in [((4, 10), 1), ((2, 3, 7), -1), ((2, 5, 3), 1), ((3, 1000), -1)]:
+                X = torch.randn(*shape) * 4
+                qX = torch.quantize_per_tensor(X, scale=0.05, zero_point=3, dtype=dtype)
+                Y = torch.softmax(qX.dequantize(), dim)
+                qY = torch.quantize_per_tensor(Y, output_scale, output_zero_point, dtype)
+                qY_hat = softmax(qX, dim, output_scale, output_zero_point)
+                self.assertEqual(qY_hat.q_scale(), output_scale)
+                self.assertEqual(qY_hat.q_zero_point(), output_zero_point)
+                self.assertEqual(qY.int_repr().float(), qY_hat.int_repr().float(), atol=1, rtol=0)
+
+    """Tests the correctness of the quantized::matmul and quantized::bmm ops."""
+    def test_qmatmul(self):
+        scale_C = 0.5
+        zero_point_C = 10
+        for dtype in [torch.quint8, torch.qint8]:
+            for shape_A, shape_B in [((5, 7), (7, 3)), ((2, 5, 40), (2, 40, 9)),
+                                     ((3, 1, 4, 6), (2, 6, 5)), ((4, 0), (0, 3)),
+                                     ((7,), (7, 3)), ((5, 7), (7,)), ((7,), (7,)),
+                                     ((7,), (2, 7, 3)), ((2, 5, 7), (7,))]:
+                A = torch.randn(*shape_A) * 2
+                B = torch.randn(*shape_B) * 2
+                qA = torch.quantize_per_tensor(A, scale=0.05, zero_point=2, dtype=dtype)
+                qB = torch.quantize_per_tensor(B, scale=0.03, zero_point=-1 if dtype == torch.qint8 else 130,
+                                               dtype=dtype)
+                C = torch.matmul(qA.dequantize(), qB.dequantize())
+                qC = torch.quantize_per_tensor(C, scale_C, zero_point_C, dtype)
+                qC_hat = torch.ops.quantized.matmul(qA, qB, scale_C, zero_point_C)
+                self.assertEqual(qC.int_repr().float(), qC_hat.int_repr().float(), atol=1, rtol=0)
+                if qA.dim() == 3 and qB.dim() == 3:
+                    qC_bmm = torch.ops.quantized.bmm(qA, qB, scale_C, zero_point_C)
+                    self.assertEqual(qC_hat, qC_bmm)
+
+        qA = torch.quantize_per_tensor(torch.randn(3, 4), 0.1, 0, torch.quint8)
+        with self.assertRaisesRegex(RuntimeError, "size mismatch"):
+            torch.ops.quantized.matmul(qA, qA, scale_C, zero_point_C)
+
+    """Tests the correctness of the quantized::scaled_dot_product_attention op."""
+    def test_qscaled_dot_product_attention(self):
+        attention = torch.ops.quantized.scaled_dot_product_attention
+        output_scale = 0.02
+        output_zero_point = 5
+        for dtype in [torch.quint8, torch.qint8]:
+            for B, L, S, E, Ev in [(1, 1, 1, 1, 1), (2, 5, 7, 8, 6), (3, 16, 40, 32, 32)]:
+                qQ = torch.quantize_per_tensor(torch.randn(B, L, E), 0.05, 1, dtype)
+                qK = torch.quantize_per_tensor(torch.randn(B, S, E), 0.04, 2, dtype)
+                qV = torch.quantize_per_tensor(torch.randn(B, S, Ev), 0.03, 3, dtype)
+                Q, K, V = qQ.dequantize(), qK.dequantize(), qV.dequantize()
+                scale = E ** -0.5
+                float_mask = torch.randn(L, S)
+                bool_mask = torch.zeros(B, L, S, dtype=torch.bool)
+                bool_mask[..., 0] = S > 1
+                for mask in [None, float_mask, bool_mask]:
+                    scores = torch.matmul(Q, K.transpose(-2, -1)) * scale
+                    if mask is not None:
+                        scores = scores + (mask if mask.dtype == torch.float else
+                                           torch.zeros_like(scores).masked_fill(mask, float('-inf')))
+                    out = torch.matmul(torch.softmax(scores, -1), V)
+                    qout = torch.quantize_per_tensor(out, output_scale, output_zero_point, dtype)
+                    qout_hat = attention(qQ, qK, qV, scale, output_scale, output_zero_point, mask)
+                    self.assertEqual(qout_hat.shape, (B, L, Ev))
+                    # the attention weights are rounded to 15 bits
+                    self.assertEqual(qout.dequantize(), qout_hat.dequantize(), atol=2 * output_scale, rtol=0)
+
+            # batch broadcasting and 1D query / value, following torch.matmul
+            for shape_Q, shape_K, shape_V in [((3, 1, 5, 8), (2, 7, 8), (7, 6)),
+                                              ((5, 8), (4, 7, 8), (4, 1, 7, 6)),
+                                              ((8,), (7, 8), (2, 7, 6)),
+                                              ((2, 5, 8), (2, 7, 8), (7,)),
+                                              ((8,), (3, 7, 8), (3, 7, 6))]:
+                qQ = torch.quantize_per_tensor(torch.randn(shape_Q), 0.05, 1, dtype)
+                qK = torch.quantize_per_tensor(torch.randn(shape_K), 0.04, 2, dtype)
+                qV = torch.quantize_per_tensor(torch.randn(shape_V), 0.03, 3, dtype)
+                Q, K, V = qQ.dequantize(), qK.dequantize(), qV.dequantize()
+                scale = 8 ** -0.5
+                out = torch.matmul(torch.softmax(torch.matmul(Q, K.transpose(-2, -1)) * scale, -1), V)
+                qout = torch.quantize_per_tensor(out, output_scale, output_zero_point, dtype)
+                qout_hat = attention(qQ, qK, qV, scale, output_scale, output_zero_point, None)
+                self.assertEqual(qout_hat.shape, out.shape)
+                self.assertEqual(qout.dequantize(), qout_hat.dequantize(), atol=2 * output_scale, rtol=0)
+
     """Tests channel shuffle operation on quantized tensors."""
     @given(X=hu.tensor(shapes=hu.array_shapes(min_dims=4, max_dims=4,
                                               min_side=2, max_side=32, max_numel=10**5),
@@ -2247,6 +2332,59 @@ class TestDynamicQuantizedLinear(TestCase):
         self.assertEqual(Y_fp32, Y_fp32_ref,
                          msg="torch.ops.quantized.linear_dynamic results are off")
 
+    """Tests the dynamic quantized linear ops with per-row (per-token) input qparams."""
+    @skipIfNoFBGEMM
+    @given(
+        batch_size=st.integers(1, 80),
+        input_channels=st.integers(16, 32),
+        output_channels=st.integers(4, 8),
+        use_bias=st.booleans(),
+        use_relu=st.booleans(),
+        use_channelwise=st.booleans())
+    def test_qlinear_per_token(self, batch_size, input_channels, output_channels,
+                               use_bias, use_relu, use_channelwise):
+        with override_quantized_engine('fbgemm'):
+            if use_relu:
+                qlinear_dynamic = torch.ops.quantized.linear_relu_dynamic_per_token
+            else:
+                qlinear_dynamic = torch.ops.quantized.linear_dynamic_per_token
+
+            # Build the input from uint8 values with a different scale and zero
+            # point per row, a few of them outliers. Every row spans the
+            # reduced range [0, 127], so requantizing it inside the op with its
+            # own row qparams is lossless. reduce_range also keeps the products
+            # clear of the vpmaddubsw overflow.
+            X_scales = torch.rand(batch_size, 1) * 0.1 + 0.001
+            X_scales[::7] *= 50
+            X_zps = torch.randint(0, 128, (batch_size, 1)).float()
+            X_q = torch.randint(0, 128, (batch_size, input_channels)).float()
+            X_q[:, 0] = 0
+            X_q[:, 1] = 127
+            X_dq = (X_q - X_zps) * X_scales
+
+            W = torch.randn(output_channels, input_channels)
+            b = torch.randn(output_channels) if use_bias else None
+
+            if use_channelwise:
+                W_scales = W.abs().max(dim=1)[0] / 63
+                W_q = torch.quantize_per_channel(
+                    W, W_scales.double(), torch.zeros(output_channels, dtype=torch.long),
+                    axis=0, dtype=torch.qint8)
+            else:
+                W_q = torch.quantize_per_tensor(
+                    W, W.abs().max().item() / 63, 0, torch.qint8)
+            W_prepack = torch.ops.quantized.linear_prepack(W_q, b)
+
+            Y = qlinear_dynamic(X_dq, W_prepack, True)
+            Y_ref = F.linear(X_dq, W_q.dequantize(), b)
+            if use_relu:
+                Y_ref = F.relu(Y_ref)
+            self.assertEqual(Y, Y_ref, atol=1e-2, rtol=1e-3)
+
+            # Multi-dim inputs are flattened to rows.
+            Y_3d = qlinear_dynamic(X_dq.view(1, batch_size, input_channels), W_prepack, True)
+            self.assertEqual(Y_3d.view(batch_size, output_channels), Y)
+
 class TestDynamicQuantizedRNNOp(TestCase):
     """Tests the correctness of the dynamic quantized lstm/gru."""
 
@@ -2712,6 +2850,47 @@ class TestQuantizedLinear(unittest.TestCase):
             np.testing.assert_equal(
                 W_q.q_zero_point(), W_q_origin.q_zero_point())
 
+    """Tests the block sparse quantized linear against the dense one."""
+    @given(batch_size=st.integers(1, 12),
+           out_block=st.sampled_from([1, 4]),
+           in_block=st.sampled_from([1, 4]),
+           use_channelwise=st.booleans(),
+           use_relu=st.booleans())
+    @skipIfNoFBGEMM
+    def test_qlinear_block_sparse(self, batch_size, out_block, in_block,
+                                  use_channelwise, use_relu):
+        with override_quantized_engine('fbgemm'):
+            output_channels, input_channels = 8, 16
+            W = torch.randn(output_channels, input_channels)
+            # Prune half of the blocks.
+            mask = torch.rand(output_channels // out_block,
+                              input_channels // in_block) > 0.5
+            mask = mask.repeat_interleave(out_block, 0).repeat_interleave(in_block, 1)
+            W = W * mask
+            b = torch.randn(output_channels)
+            if use_channelwise:
+                W_q = torch.quantize_per_channel(
+                    W, torch.rand(output_channels, dtype=torch.double) / 10 + 0.01,
+                    torch.zeros(output_channels, dtype=torch.long), 0, torch.qint8)
+            else:
+                W_q = torch.quantize_per_tensor(W, 0.05, 0, torch.qint8)
+            X = torch.rand(batch_size, input_channels) * 4 - 2
+            X_q = torch.quantize_per_tensor(X, 0.02, 100, torch.quint8)
+
+            dense = torch.ops.quantized.linear_prepack(W_q, b)
+            sparse = torch.ops.quantized.linear_prepack_block_sparse(
+                W_q, b, out_block, in_block)
+            self.assertEqual(torch.ops.quantized.linear_unpack(sparse)[0], W_q)
+
+            qlinear = torch.ops.quantized.linear_relu if use_relu else torch.ops.quantized.linear
+            self.assertEqual(qlinear(X_q, sparse, 0.1, 64).int_repr(),
+                             qlinear(X_q, dense, 0.1, 64).int_repr(), atol=1, rtol=0)
+
+            qlinear_dynamic = torch.ops.quantized.linear_relu_dynamic if use_relu \
+                else torch.ops.quantized.linear_dynamic
+            self.assertEqual(qlinear_dynamic(X, sparse), qlinear_dynamic(X, dense),
+                             atol=1e-3, rtol=1e-3)
+
 
 @unittest.skipIf(sys.platform == "darwin", "Known test failure on Mac.")
 class TestQuantizedEmbeddingBag(TestCase):
@@ -2745,6 +2924,8 @@ class TestQuantizedEmbeddingBag(TestCase):
         conversion_op = "FloatToFused8BitRowwiseQuantized"
         if bit_rate == 4:
             conversion_op = "FloatToFused4BitRowwiseQuantized"
+        elif bit_rate == 2:
+            conversion_op = "FloatToFused2BitRowwiseQuantized"
 
         def get_c2_weights(weights):
             workspace.ResetWorkspace()
@@ -2756,10 +2937,11 @@ class TestQuantizedEmbeddingBag(TestCase):
                 )
             )
             emb_q = workspace.FetchBlob("quantized_weights")
-            if bit_rate == 4:
+            if bit_rate in (4, 2):
                 workspace.RunOperatorOnce(
                     core.CreateOperator(
-                        "Fused4BitRowwiseQuantizedToFloat", ["quantized_weights"], ["dequantized_weights"]
+                        "Fused{}BitRowwiseQuantizedToFloat".format(bit_rate),
+                        ["quantized_weights"], ["dequantized_weights"]
                     )
                 )
                 dequantized_data = torch.from_numpy(workspace.FetchBlob("dequantized_weights"))
@@ -2794,18 +2976,36 @@ class TestQuantizedEmbeddingBag(TestCase):
 
         self._test_embedding_bag_unpack_fn(pack_fn, unpack_fn, num_embeddings, embedding_dim, bit_rate=4)
 
+    """ Tests the correctness of the embedding_bag_2bit pack/unpack op against C2 """
+    @given(num_embeddings=st.integers(10, 100),
+           embedding_dim=st.integers(5, 50).filter(lambda x: x % 8 == 0),)
+    def test_embedding_bag_2bit_unpack(self, num_embeddings, embedding_dim):
+        pack_fn = torch.ops.quantized.embedding_bag_2bit_prepack
+        unpack_fn = torch.ops.quantized.embedding_bag_2bit_unpack
+
+        self._test_embedding_bag_unpack_fn(pack_fn, unpack_fn, num_embeddings, embedding_dim, bit_rate=2)
+
     def embedding_bag_rowwise_offsets_run(
             self, bit_rate, num_embeddings,
             embedding_dim, num_offsets, enable_per_sample_weights,
-            include_last_offset, atol, rtol):
+            include_last_offset, atol, rtol, prune=False):
         pt_op = torch.ops.quantized.embedding_bag_byte_rowwise_offsets
         pt_prepack_op = torch.ops.quantized.embedding_bag_byte_prepack
         if bit_rate == 4:
             pt_op = torch.ops.quantized.embedding_bag_4bit_rowwise_offsets
             pt_prepack_op = torch.ops.quantized.embedding_bag_4bit_prepack
+        elif bit_rate == 2:
+            pt_op = torch.ops.quantized.embedding_bag_2bit_rowwise_offsets
+            pt_prepack_op = torch.ops.quantized.embedding_bag_2bit_prepack
 
         weights = torch.from_numpy((np.random.random_sample((
             num_embeddings, embedding_dim)) + 1).astype(np.float32))
+        compressed_indices_mapping = None
+        if prune:
+            # Zero out about half of the rows; the reference EmbeddingBag then
+            # sees the same values as the pruned quantized table.
+            pruned_rows = torch.rand(num_embeddings) < 0.5
+            weights[pruned_rows] = 0
 
         max_segments = 5
         max_segment_length = 20
@@ -2829,7 +3029,15 @@ class TestQuantizedEmbeddingBag(TestCase):
         indices = torch.from_numpy(np.random.randint(
             low=0, high=num_embeddings, size=num_indices, dtype=np.int64))
 
-        q_weights = pt_prepack_op(weights)
+        if prune:
+            pruned_weights, compressed_indices_mapping = \
+                torch.ops.quantized.embedding_bag_rowwise_prune(weights, 0.0)
+            self.assertEqual(pruned_weights.size(0), int((~pruned_rows).sum()))
+            self.assertEqual(compressed_indices_mapping[pruned_rows],
+                             torch.full((int(pruned_rows.sum()),), -1, dtype=torch.int32))
+            q_weights = pt_prepack_op(pruned_weights)
+        else:
+            q_weights = pt_prepack_op(weights)
         per_sample_weights = torch.from_numpy(np.random.uniform(
             low=0.01, high=0.5, size=[len(indices)]).astype(np.float32)) if \
             enable_per_sample_weights else None
@@ -2861,12 +3069,13 @@ class TestQuantizedEmbeddingBag(TestCase):
             offsets,
             mode=0,
             per_sample_weights=per_sample_weights,
+            compressed_indices_mapping=compressed_indices_mapping,
             include_last_offset=include_last_offset,
         )
         torch.testing.assert_allclose(reference_result, result, atol=atol,
                                       rtol=rtol)
 
-        if bit_rate == 8:
+        if bit_rate == 8 and not prune:
             # Test operator that accepts TorchBind packed weights.
             from torch.quantization import PerChannelMinMaxObserver
             obs = PerChannelMinMaxObserver(dtype=torch.quint8, qscheme=torch.per_channel_affine_float_qparams, ch_axis=0)
@@ -2915,6 +3124,40 @@ class TestQuantizedEmbeddingBag(TestCase):
                                                include_last_offset, atol=0.1,
                                                rtol=1e-2)
 
+    """ Tests the correctness of the embedding_bag_2bit quantized operator """
+    @given(num_embeddings=st.integers(10, 100),
+           embedding_dim=st.integers(5, 50).filter(lambda x: x % 8 == 0),
+           num_offsets=st.integers(1, 20),
+           enable_per_sample_weights=st.booleans(),
+           include_last_offset=st.booleans())
+    def test_embedding_bag_2bit_rowwise_offsets(self, num_embeddings,
+                                                embedding_dim, num_offsets,
+                                                enable_per_sample_weights,
+                                                include_last_offset):
+        self.embedding_bag_rowwise_offsets_run(2, num_embeddings,
+                                               embedding_dim, num_offsets,
+                                               enable_per_sample_weights,
+                                               include_last_offset, atol=1.0,
+                                               rtol=1e-1)
+
+    """ Tests the row-wise pruned embedding_bag quantized operators """
+    @given(bit_rate=st.sampled_from([8, 4, 2]),
+           num_embeddings=st.integers(10, 100),
+           embedding_dim=st.integers(5, 50).filter(lambda x: x % 8 == 0),
+           num_offsets=st.integers(1, 20),
+           enable_per_sample_weights=st.booleans(),
+           include_last_offset=st.booleans())
+    def test_embedding_bag_pruned_rowwise_offsets(self, bit_rate, num_embeddings,
+                                                  embedding_dim, num_offsets,
+                                                  enable_per_sample_weights,
+                                                  include_last_offset):
+        atol, rtol = {8: (0.005, 1e-3), 4: (0.1, 1e-2), 2: (1.0, 1e-1)}[bit_rate]
+        self.embedding_bag_rowwise_offsets_run(bit_rate, num_embeddings,
+                                               embedding_dim, num_offsets,
+                                               enable_per_sample_weights,
+                                               include_last_offset, atol=atol,
+                                               rtol=rtol, prune=True)
+
 
 class TestQuantizedConv(unittest.TestCase):
     def _test_qconv_unpack_impl(
@@ -3514,6 +3757,25 @@ class TestQNNPackOps(TestCase):
             self.assertEqual(qYserver, qY_hat,
                              msg="QNNPACK Sigmoid failed (FBGEMM ref)!")
 
+    """Tests the correctness of the quantized::softmax op on QNNPACK."""
+    @given(X=hu.tensor(shapes=hu.array_shapes(2, 4, 1, 32),
+                       qparams=hu.qparams(dtypes=torch.quint8)))
+    def test_qnnpack_softmax(self, X):
+        # Note: QNNPACK softargmax only supports an output scale of 1.0/256
+        #       and a zero point of 0.
+        X, (scale, zero_point, torch_type) = X
+        X = torch.from_numpy(X).to(torch.float32)
+        qX = torch.quantize_per_tensor(X, scale=scale,
+                                       zero_point=zero_point,
+                                       dtype=torch_type)
+        Y = torch.softmax(qX.dequantize(), -1)
+        qY = torch.quantize_per_tensor(Y, scale=1.0 / 256, zero_point=0,
+                                       dtype=torch.quint8)
+        with override_quantized_engine('qnnpack'):
+            qY_hat = torch.ops.quantized.softmax(qX, -1, 1.0 / 256, 0)
+            self.assertEqual(qY.int_repr().float(), qY_hat.int_repr().float(),
+                             atol=1, rtol=0, msg="QNNPACK Softmax failed (FP ref)!")
+
     @skipIfNoFBGEMM
     def test_qnnpack_sigmoid_sweep(self):
         # Input parameters
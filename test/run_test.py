@@ -52,6 +52,7 @@ TESTS = [
     'test_optim',
     'test_mobile_optimizer',
     'test_xnnpack_integration',
+    'test_block_sparse_linear',
     'test_vulkan',
     'test_quantization',
     'test_sparse',
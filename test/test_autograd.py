@@ -2952,6 +2952,46 @@ class TestAutograd(TestCase):
                 self.assertEqual(event.input_shapes, input_shape_expected)
                 last_end = event.cpu_interval.end
 
+    def test_op_metrics(self):
+        from torch.autograd import profiler
+        x = torch.randn(3, 9)
+        profiler.enable_op_metrics(record_shapes=True)
+        try:
+            profiler.reset_op_metrics()
+            for _ in range(5):
+                torch.add(x, x)
+
+            def run_in_thread():
+                for _ in range(3):
+                    torch.add(x, x)
+
+            t = threading.Thread(target=run_in_thread)
+            t.start()
+            t.join()
+        finally:
+            profiler.disable_op_metrics()
+
+        self.assertFalse(torch.autograd._op_metrics_enabled())
+        adds = [m for m in profiler.op_metrics_snapshot() if m.name == 'aten::add']
+        # Both threads are merged into one entry. The call of the CPU kernel
+        # from the autograd kernel is not counted separately, and the entry
+        # has the backend key rather than the autograd one.
+        self.assertEqual(len(adds), 1)
+        m = adds[0]
+        self.assertEqual(m.dispatch_key, 'CPU')
+        self.assertEqual(m.shapes, '[4, 16], [4, 16], -')
+        self.assertEqual(m.count, 8)
+        self.assertEqual(sum(m.latency_histogram), m.count)
+        self.assertTrue(m.total_ns >= 0)
+
+        # Calls made while disabled are not counted.
+        torch.add(x, x)
+        adds_after = [m for m in profiler.op_metrics_snapshot() if m.name == 'aten::add']
+        self.assertEqual([m.count for m in adds_after], [m.count for m in adds])
+
+        profiler.reset_op_metrics()
+        self.assertEqual(profiler.op_metrics_snapshot(), [])
+
     def test_profiler_no_cuda(self):
         print("")
         layer = torch.nn.Linear(20, 30)
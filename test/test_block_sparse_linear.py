@@ -0,0 +1,92 @@
+import io
+
+import torch
+from torch.nn import functional as F
+from torch.testing import FileCheck
+from torch.testing._internal.common_utils import TestCase, run_tests
+from hypothesis import given
+from hypothesis import strategies as st
+
+
+def _block_prune(weight, out_block, in_block, keep=0.3):
+    rows, cols = weight.shape
+    mask = torch.rand(rows // out_block, cols // in_block) < keep
+    mask = mask.repeat_interleave(out_block, 0).repeat_interleave(in_block, 1)
+    return weight * mask
+
+
+class TestBlockSparseLinear(TestCase):
+    @given(batch_size=st.integers(0, 20),
+           out_block=st.sampled_from([1, 2, 4]),
+           in_block=st.sampled_from([1, 4, 8]),
+           use_bias=st.booleans())
+    def test_linear(self, batch_size, out_block, in_block, use_bias):
+        weight = _block_prune(torch.randn(8, 16), out_block, in_block)
+        bias = torch.randn(8) if use_bias else None
+        x = torch.randn(batch_size, 3, 16)
+        packed = torch.ops.sparse.linear_block_sparse_prepack(weight, bias, out_block, in_block)
+        torch.testing.assert_allclose(
+            torch.ops.sparse.linear_block_sparse_run(x, packed),
+            F.linear(x, weight, bias), rtol=1e-4, atol=1e-4)
+
+    def test_block_sparsity(self):
+        weight = torch.zeros(4, 8)
+        weight[0, 0] = 1
+        weight[3, 7] = 1
+        self.assertEqual(torch.ops.sparse.block_sparsity(weight, 1, 4), 6 / 8)
+        self.assertEqual(torch.ops.sparse.block_sparsity(weight, 2, 4), 2 / 4)
+        self.assertEqual(torch.ops.sparse.block_sparsity(weight, 4, 8), 0.)
+        with self.assertRaisesRegex(RuntimeError, "can not be cut"):
+            torch.ops.sparse.block_sparsity(weight, 3, 4)
+
+    def test_serialization(self):
+        class M(torch.nn.Module):
+            def __init__(self, weight, bias):
+                super(M, self).__init__()
+                self.packed = torch.ops.sparse.linear_block_sparse_prepack(weight, bias, 4, 4)
+
+            def forward(self, x):
+                return torch.ops.sparse.linear_block_sparse_run(x, self.packed)
+
+        weight = _block_prune(torch.randn(8, 16), 4, 4)
+        bias = torch.randn(8)
+        m = torch.jit.script(M(weight, bias))
+        buffer = io.BytesIO()
+        torch.jit.save(m, buffer)
+        buffer.seek(0)
+        loaded = torch.jit.load(buffer)
+        x = torch.randn(5, 16)
+        torch.testing.assert_allclose(loaded(x), F.linear(x, weight, bias))
+
+    def test_rewrite_pass(self):
+        class M(torch.nn.Module):
+            def __init__(self):
+                super(M, self).__init__()
+                self.sparse = torch.nn.Linear(16, 8)
+                self.dense = torch.nn.Linear(8, 4)
+                with torch.no_grad():
+                    self.sparse.weight.copy_(_block_prune(self.sparse.weight, 1, 4, keep=0.2))
+
+            def forward(self, x):
+                return self.dense(F.relu(self.sparse(x)))
+
+        m = M().eval()
+        x = torch.randn(6, 16)
+        ref = m(x)
+
+        # Freezing decomposes the linears into aten::addmm / aten::matmul,
+        # only the ones of the pruned layer get swapped.
+        frozen = torch._C._freeze_module(torch.jit.script(m)._c)
+        torch._C._jit_pass_insert_block_sparse_linear_ops(frozen, 0.99, 1, 4)
+        FileCheck().check_not("sparse::linear_block_sparse_run") \
+                   .run(frozen._get_method("forward").graph)
+
+        torch._C._jit_pass_insert_block_sparse_linear_ops(frozen, 0.5, 1, 4)
+        graph = frozen._get_method("forward").graph
+        FileCheck().check("sparse::linear_block_sparse_run") \
+                   .check_not("sparse::linear_block_sparse_prepack") \
+                   .run(graph)
+        torch.testing.assert_allclose(frozen._get_method("forward")(x), ref)
+
+if __name__ == "__main__":
+    run_tests()
@@ -12,7 +12,7 @@ aten_native_yaml = os.path.join(path, '../aten/src/ATen/native/native_functions.
 all_operators_with_namedtuple_return = {
     'max', 'min', 'median', 'mode', 'kthvalue', 'svd', 'symeig', 'eig',
     'qr', 'geqrf', 'solve', 'slogdet', 'sort', 'topk', 'lstsq',
-    'triangular_solve', 'cummax', 'cummin'
+    'triangular_solve', 'cummax', 'cummin', 'cdist_topk'
 }
 
 
@@ -64,11 +64,13 @@ class TestNamedTupleAPI(unittest.TestCase):
             op(operators=['symeig', 'eig'], input=(True,), names=('eigenvalues', 'eigenvectors'), hasout=True),
             op(operators=['triangular_solve'], input=(a,), names=('solution', 'cloned_coefficient'), hasout=True),
             op(operators=['lstsq'], input=(a,), names=('solution', 'QR'), hasout=True),
+            op(operators=['cdist_topk'], input=(a, 2), names=('values', 'indices'), hasout=False),
         ]
 
         for op in operators:
             for f in op.operators:
-                ret = getattr(a, f)(*op.input)
+                # function-only operators are called as torch.<op>(a, ...)
+                ret = getattr(a, f)(*op.input) if hasattr(a, f) else getattr(torch, f)(a, *op.input)
                 for i, name in enumerate(op.names):
                     self.assertIs(getattr(ret, name), ret[i])
                 if op.hasout:
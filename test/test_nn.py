@@ -5194,6 +5194,33 @@ class TestNN(NNTestCase):
             output_cpu = rnn(input.cpu(), hx)
             self.assertEqual(output_cuda, output_cpu)
 
+    @repeat_test_for_types([torch.float, torch.double])
+    def test_cpu_rnn_fused_inference(self, dtype=torch.float):
+        # Without autograd, CPU LSTM and GRU layers run through fused cells
+        # (see NOTE [ Fused CPU RNN cells ]); compare against the unfused
+        # path, which is taken when gradients are required.
+        input_size = 10
+        hidden_size = 7
+        seq_length = 5
+        for module, num_layers, bias, bidirectional, batch_first, batch in product(
+                (nn.GRU, nn.LSTM), (1, 2), (True, False), (True, False), (True, False), (1, 3)):
+            rnn = module(input_size, hidden_size, num_layers, bias=bias,
+                         bidirectional=bidirectional, batch_first=batch_first).to(dtype)
+            num_directions = 2 if bidirectional else 1
+            if batch_first:
+                inp = torch.randn(batch, seq_length, input_size, dtype=dtype)
+            else:
+                inp = torch.randn(seq_length, batch, input_size, dtype=dtype)
+            hx = torch.randn(num_layers * num_directions, batch, hidden_size, dtype=dtype)
+            if module is nn.LSTM:
+                hx = (hx, torch.randn_like(hx))
+
+            expected_output, expected_hy = rnn(inp, hx)
+            with torch.no_grad():
+                output, hy = rnn(inp, hx)
+            self.assertEqual(output, expected_output)
+            self.assertEqual(hy, expected_hy)
+
     @unittest.skipIf(not TEST_CUDA, 'CUDA not available')
     @repeat_test_for_types(NO_HALF_TENSORTYPES)
     def test_cuda_rnn_fused(self, dtype=torch.float):
@@ -8,7 +8,7 @@ from torch.testing._internal.common_utils import \
     (TestCase, run_tests, TEST_NUMPY, TEST_LIBROSA)
 from torch.testing._internal.common_device_type import \
     (instantiate_device_type_tests, dtypes, onlyOnCPUAndCUDA, precisionOverride,
-     skipCPUIfNoMkl, skipCUDAIfRocm, deviceCountAtLeast, onlyCUDA)
+     skipCUDAIfRocm, deviceCountAtLeast, onlyCUDA, onlyCPU)
 
 if TEST_NUMPY:
     import numpy as np
@@ -25,7 +25,6 @@ import torch.fft
 class TestFFT(TestCase):
     exact_dtype = True
 
-    @skipCPUIfNoMkl
     @skipCUDAIfRocm
     def test_fft_function_clobbered(self, device):
         t = torch.randn((100, 2), device=device)
@@ -40,7 +39,6 @@ class TestFFT(TestCase):
         with self.assertRaisesRegex(TypeError, "'module' object is not callable"):
             torch.fft(t, 1)
 
-    @skipCPUIfNoMkl
     @skipCUDAIfRocm
     @unittest.skipIf(not TEST_NUMPY, 'NumPy not found')
     @precisionOverride({torch.complex64: 1e-4})
@@ -70,7 +68,6 @@ class TestFFT(TestCase):
 
     # Note: NumPy will throw a ValueError for an empty input
     @skipCUDAIfRocm
-    @skipCPUIfNoMkl
     @onlyOnCPUAndCUDA
     @dtypes(torch.complex64, torch.complex128)
     def test_empty_fft(self, device, dtype):
@@ -184,7 +181,6 @@ class TestFFT(TestCase):
         _test_complex((50,), 2, lambda x: x.as_strided([5, 5, 2], [4, 3, 1]))
 
     @skipCUDAIfRocm
-    @skipCPUIfNoMkl
     @onlyOnCPUAndCUDA
     @dtypes(torch.double)
     def test_fft_ifft_rfft_irfft(self, device, dtype):
@@ -263,9 +259,66 @@ class TestFFT(TestCase):
                             self.assertEqual(torch.backends.cuda.cufft_plan_cache.max_size, 10)  # default is cuda:0
                         self.assertEqual(torch.backends.cuda.cufft_plan_cache.max_size, 11)  # default is cuda:1
 
+    @onlyCPU
+    @dtypes(torch.double)
+    def test_cpu_fft_plan_cache(self, device, dtype):
+        @contextmanager
+        def plan_cache_max_size(n):
+            original = torch._fft_cpu_get_plan_cache_max_size()
+            torch._fft_cpu_set_plan_cache_max_size(n)
+            yield
+            torch._fft_cpu_set_plan_cache_max_size(original)
+
+        with plan_cache_max_size(max(1, torch._fft_cpu_get_plan_cache_size() - 10)):
+            self._test_fft_ifft_rfft_irfft(device, dtype)
+
+        with plan_cache_max_size(0):
+            self._test_fft_ifft_rfft_irfft(device, dtype)
+            self.assertEqual(torch._fft_cpu_get_plan_cache_size(), 0)
+
+        torch._fft_cpu_clear_plan_cache()
+        self.assertEqual(torch._fft_cpu_get_plan_cache_size(), 0)
+
+        # check that still works after clearing cache
+        with plan_cache_max_size(10):
+            self._test_fft_ifft_rfft_irfft(device, dtype)
+            self.assertLessEqual(torch._fft_cpu_get_plan_cache_size(), 10)
+
+            # repeated same-shape transforms reuse the cached plan
+            x = torch.randn(4, 3, 16, device=device, dtype=dtype)
+            x.rfft(1)
+            size = torch._fft_cpu_get_plan_cache_size()
+            self.assertEqual(x.rfft(1), x.clone().rfft(1))
+            self.assertEqual(torch._fft_cpu_get_plan_cache_size(), size)
+
+        with self.assertRaisesRegex(RuntimeError, r"must be non-negative"):
+            torch._fft_cpu_set_plan_cache_max_size(-1)
+
+    @onlyCPU
+    @dtypes(torch.float, torch.double)
+    def test_fft_pocketfft_sizes(self, device, dtype):
+        # lengths exercising the radix-2/3/4 butterflies, the generic
+        # butterfly and Bluestein's algorithm for large primes
+        for n in (1, 2, 3, 5, 6, 7, 12, 30, 64, 97, 210, 1009):
+            x = torch.randn(3, n, 2, device=device, dtype=dtype)
+            k = torch.arange(n, device=device, dtype=dtype)
+            angle = -2 * math.pi * torch.ger(k, k).remainder(n) / n
+            cos, sin = angle.cos(), angle.sin()
+            re = x[..., 0].matmul(cos) - x[..., 1].matmul(sin)
+            im = x[..., 0].matmul(sin) + x[..., 1].matmul(cos)
+            atol = 1e-4 * n if dtype == torch.float else 1e-10 * n
+            self.assertEqual(x.fft(1), torch.stack([re, im], -1), atol=atol, rtol=0)
+
+            # real-to-complex and back, on an odd/even and strided input
+            xr = x[..., 0]
+            expected = torch.stack([xr.matmul(cos), xr.matmul(sin)], -1)
+            res = xr.rfft(1)
+            self.assertEqual(res, expected.narrow(1, 0, n // 2 + 1), atol=atol, rtol=0)
+            self.assertEqual(xr.rfft(1, onesided=False), expected, atol=atol, rtol=0)
+            self.assertEqual(res.irfft(1, signal_sizes=(n,)), xr, atol=atol, rtol=0)
+
     # passes on ROCm w/ python 2.7, fails w/ python 3.6
     @skipCUDAIfRocm
-    @skipCPUIfNoMkl
     @dtypes(torch.double)
     def test_stft(self, device, dtype):
         if not TEST_LIBROSA:
@@ -327,7 +380,6 @@ class TestFFT(TestCase):
         _test((10,), 5, 4, win_sizes=(1, 1), expected_error=RuntimeError)
 
     @skipCUDAIfRocm
-    @skipCPUIfNoMkl
     def test_fft_input_modification(self, device):
         # FFT functions should not modify their input (gh-34551)
 
@@ -348,7 +400,6 @@ class TestFFT(TestCase):
         self.assertEqual(half_spectrum, half_spectrum_copy)
 
     @onlyOnCPUAndCUDA
-    @skipCPUIfNoMkl
     @dtypes(torch.double)
     def test_istft_round_trip_simple_cases(self, device, dtype):
         """stft -> istft should recover the original signale"""
@@ -361,7 +412,6 @@ class TestFFT(TestCase):
         _test(torch.zeros(4, dtype=dtype, device=device), 4, 4)
 
     @onlyOnCPUAndCUDA
-    @skipCPUIfNoMkl
     @dtypes(torch.double)
     def test_istft_round_trip_various_params(self, device, dtype):
         """stft -> istft should recover the original signale"""
@@ -464,7 +514,6 @@ class TestFFT(TestCase):
 
     @onlyOnCPUAndCUDA
     @skipCUDAIfRocm
-    @skipCPUIfNoMkl
     @dtypes(torch.double)
     def test_istft_of_sine(self, device, dtype):
         def _test(amplitude, L, n):
@@ -499,7 +548,6 @@ class TestFFT(TestCase):
 
     @onlyOnCPUAndCUDA
     @skipCUDAIfRocm
-    @skipCPUIfNoMkl
     @dtypes(torch.double)
     def test_istft_linearity(self, device, dtype):
         num_trials = 100
@@ -564,7 +612,6 @@ class TestFFT(TestCase):
             _test(data_size, kwargs)
 
     @onlyOnCPUAndCUDA
-    @skipCPUIfNoMkl
     @skipCUDAIfRocm
     def test_batch_istft(self, device):
         original = torch.tensor([
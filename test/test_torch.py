@@ -7998,6 +7998,36 @@ class TestTorchDeviceType(TestCase):
         run_test((4, 4), (2, 1, 3, 4, 2))  # broadcasting A
         run_test((1, 3, 1, 4, 4), (2, 1, 3, 4, 5))  # broadcasting A & b
 
+    @onlyCPU
+    @skipCPUIfNoLapack
+    @unittest.skipIf(not TEST_NUMPY, "NumPy not found")
+    @dtypes(torch.float, torch.double)
+    def test_solve_inverse_small_batched(self, device, dtype):
+        # many small matrices are factorized without LAPACK and split across threads,
+        # sizes above the small matrix threshold go through LAPACK
+        from numpy.linalg import solve, inv
+        from torch.testing._internal.common_utils import random_fullrank_matrix_distinct_singular_value
+        for n in [1, 2, 3, 6, 12, 16, 17, 24]:
+            A = random_fullrank_matrix_distinct_singular_value(n, 1000, dtype=torch.double, device=device)
+            b = torch.randn(1000, n, 2, dtype=torch.double, device=device)
+            x_exp = torch.from_numpy(solve(A.numpy(), b.numpy())).to(dtype)
+            inv_exp = torch.from_numpy(inv(A.numpy())).to(dtype)
+            A, b = A.to(dtype), b.to(dtype)
+            x, lu = torch.solve(b, A)
+            self.assertEqual(x, x_exp, atol=1e-3 if dtype == torch.float else 1e-8, rtol=0)
+            self.assertEqual(torch.inverse(A), inv_exp, atol=1e-3 if dtype == torch.float else 1e-8, rtol=0)
+            # the returned LU factorization matches lu()
+            self.assertEqual(lu, torch.lu(A)[0])
+
+        # the first singular matrix in the batch is reported
+        A = torch.randn(100, 3, 3, dtype=dtype, device=device)
+        A[57] = 0
+        A[80] = 0
+        with self.assertRaisesRegex(RuntimeError, 'For batch 57: U\\(1,1\\) is zero'):
+            torch.inverse(A)
+        with self.assertRaisesRegex(RuntimeError, 'For batch 57: U\\(1,1\\) is zero'):
+            torch.solve(torch.randn(100, 3, 1, dtype=dtype, device=device), A)
+
     def cholesky_solve_test_helper(self, A_dims, b_dims, upper, device, dtype):
         from torch.testing._internal.common_utils import random_symmetric_pd_matrix
 
@@ -11863,6 +11893,36 @@ class TestTorchDeviceType(TestCase):
                             expected = self._brute_cdist(x, y, p=p)
                             self.assertEqual(expected, actual)
 
+    @onlyCPU
+    @dtypes(torch.float, torch.double)
+    def test_cdist_topk(self, device, dtype):
+        for batch in [(), (3,), (2, 2)]:
+            for r1, r2, m in [(5, 7, 3), (40, 300, 17), (1, 1, 1)]:
+                x = torch.randn(*batch, r1, m, device=device, dtype=dtype)
+                y = torch.randn(*batch, r2, m, device=device, dtype=dtype)
+                for p in [0, 1, 2, 3, 1.5, float('inf')]:
+                    dist = torch.cdist(x, y, p=p, compute_mode='donot_use_mm_for_euclid_dist')
+                    for largest in [False, True]:
+                        for k in {0, 1, min(r2, 4), r2}:
+                            values, indices = torch.cdist_topk(x, y, k, p=p, largest=largest)
+                            expected, _ = dist.topk(k, largest=largest)
+                            self.assertEqual(values.shape, batch + (r1, k))
+                            self.assertEqual(indices.shape, batch + (r1, k))
+                            self.assertEqual(values, expected)
+                            # p=0 distances tie too often for the indices to be unique
+                            self.assertEqual(dist.gather(-1, indices), values)
+
+        # zero columns: all distances are zero
+        values, indices = torch.cdist_topk(torch.randn(4, 0, device=device, dtype=dtype),
+                                           torch.randn(6, 0, device=device, dtype=dtype), 3)
+        self.assertEqual(values, torch.zeros(4, 3, device=device, dtype=dtype))
+        self.assertEqual(indices, torch.arange(3, device=device).expand(4, 3))
+
+        x = torch.randn(4, 3, device=device, dtype=dtype)
+        y = torch.randn(6, 3, device=device, dtype=dtype)
+        self.assertRaisesRegex(RuntimeError, "k", lambda: torch.cdist_topk(x, y, 7))
+        self.assertRaisesRegex(RuntimeError, "p value", lambda: torch.cdist_topk(x, y, 2, p=-1))
+
     @tf32_on_and_off(0.005)
     def test_cdist_large(self, device):
         for cm in ['use_mm_for_euclid_dist_if_necessary', 'use_mm_for_euclid_dist', 'donot_use_mm_for_euclid_dist']:
@@ -12545,6 +12605,54 @@ class TestTorchDeviceType(TestCase):
             expanded = torch.randn(1, 5, 1, 2, device=device).expand(3, 5, 7, 2)
             test_against_np(expanded)
 
+            # large enough to be split across threads
+            test_against_np(torch.randn(1000000, device=device), bins=7)
+            test_against_np(torch.randn(300000, device=device), bins=100000)
+
+    @onlyCPU
+    @unittest.skipIf(not TEST_NUMPY, "NumPy not found")
+    @dtypes(torch.float, torch.double)
+    def test_histogramdd(self, device, dtype):
+        def test_against_np(x, bins, range=None, weight=None):
+            actual = torch.histogramdd(x, bins, range=range, weight=weight)
+            np_bins = [b.numpy() if torch.is_tensor(b) else b for b in bins]
+            np_range = None if range is None else list(zip(range[::2], range[1::2]))
+            expected = np.histogramdd(x.numpy(), bins=np_bins, range=np_range,
+                                      weights=None if weight is None else weight.numpy())[0]
+            self.assertEqual(actual, torch.from_numpy(expected).to(dtype))
+
+        x = torch.randn(1000, 3, device=device, dtype=dtype)
+        w = torch.rand(1000, device=device, dtype=dtype)
+        test_against_np(x, [4, 5, 6])
+        test_against_np(x, [4, 5, 6], weight=w)
+        test_against_np(x, [3, 1, 2], range=[-1., 1., 0., 2., -3., 0.5], weight=w)
+        edges = [torch.tensor([-1., 0., 0.5, 2.], dtype=dtype), torch.tensor([-3., 3.], dtype=dtype),
+                 torch.linspace(-2, 2, 9, dtype=dtype)]
+        test_against_np(x, edges)
+        test_against_np(x, edges, weight=w)
+        # large enough to be split across threads
+        test_against_np(torch.randn(300000, 2, device=device, dtype=dtype), [10, 10])
+
+        # batched: one histogram per batch
+        xb = torch.randn(4, 500, 2, device=device, dtype=dtype)
+        wb = torch.rand(4, 500, device=device, dtype=dtype)
+        r = [-2., 2., -1., 3.]
+        actual = torch.histogramdd(xb, [3, 4], range=r, weight=wb)
+        self.assertEqual(actual.shape, (4, 3, 4))
+        for i in range(4):
+            self.assertEqual(actual[i], torch.histogramdd(xb[i], [3, 4], range=r, weight=wb[i]))
+
+        # histc agrees with the 1-d case
+        y = torch.randn(1000, device=device, dtype=dtype)
+        self.assertEqual(torch.histogramdd(y.unsqueeze(1), [10]), torch.histc(y, bins=10))
+
+        with self.assertRaisesRegex(RuntimeError, 'expected bins for each of the 3 dimensions'):
+            torch.histogramdd(x, [4, 5])
+        with self.assertRaisesRegex(RuntimeError, 'must be strictly increasing'):
+            torch.histogramdd(x[:, :1], [torch.tensor([0., 2., 1.], dtype=dtype)])
+        with self.assertRaisesRegex(RuntimeError, 'expected weight of shape'):
+            torch.histogramdd(x, [4, 5, 6], weight=w[:10])
+
     def test_bool_tensor_comparison_ops(self, device):
         a = torch.tensor([True, False, True, False, True, False], dtype=torch.bool, device=device)
         b = torch.tensor([True, False, True, True, True, True], dtype=torch.bool, device=device)
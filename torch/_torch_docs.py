@@ -1121,6 +1121,50 @@ Example::
              -0.5790,  0.1497]])
 """.format(**common_args))
 
+add_docstr(torch.cdist_topk,
+           r"""
+cdist_topk(x1, x2, k, p=2, largest=False) -> (Tensor, Tensor)
+
+For each row vector of :attr:`x1`, returns the :attr:`k` smallest p-norm
+distances to the row vectors of :attr:`x2`, and the indices of those rows of
+:attr:`x2`. If :attr:`largest` is ``True``, the :attr:`k` largest distances are
+returned instead.
+
+This is equivalent to ``torch.cdist(x1, x2, p).topk(k, largest=largest)``, but
+the full distance matrix is never materialized: distances are computed in
+cache sized tiles and only the best :attr:`k` of each row are kept. Results
+are sorted, ties are broken by the smaller index.
+
+.. note:: This function is only implemented for CPU tensors and does not
+          support autograd.
+
+Args:
+    x1 (Tensor): input tensor of shape :math:`B \times P \times M`
+    x2 (Tensor): input tensor of shape :math:`B \times R \times M`
+    k (int): number of distances to return for each row of :attr:`x1`,
+        at most :math:`R`
+    p (float, optional): p value for the p-norm distance
+        :math:`\in [0, \infty]`. Default: 2
+    largest (bool, optional): return the largest instead of the smallest
+        distances. Default: ``False``
+
+Returns:
+    A namedtuple of (values, indices), both of shape :math:`B \times P \times k`
+
+Example::
+
+    >>> a = torch.tensor([[0.9041,  0.0196], [-0.3108, -2.4423], [-0.4821,  1.059]])
+    >>> b = torch.tensor([[-2.1763, -0.4713], [-0.6986,  1.3702], [0.5, 0.5]])
+    >>> torch.cdist_topk(a, b, k=2)
+    torch.return_types.cdist_topk(
+    values=tensor([[0.6278, 2.0959],
+            [2.7138, 3.0520],
+            [0.3791, 1.1300]]),
+    indices=tensor([[2, 1],
+            [0, 2],
+            [1, 2]]))
+""")
+
 add_docstr(torch.ceil,
            r"""
 ceil(input, out=None) -> Tensor
@@ -2846,6 +2890,52 @@ Example::
     tensor([ 0.,  2.,  1.,  0.])
 """.format(**common_args))
 
+add_docstr(torch.histogramdd,
+           r"""
+histogramdd(input, bins, range=None, weight=None) -> Tensor
+
+Computes the multi-dimensional histogram of samples.
+
+:attr:`input` is either a tensor of shape :math:`(N, D)` holding :math:`N`
+samples of :math:`D` values each, or a batch of such samples of shape
+:math:`(B, N, D)`, in which case a separate histogram is computed for each
+of the :math:`B` batches.
+
+If :attr:`bins` is a sequence of :math:`D` ints, dimension :math:`d` is divided
+into ``bins[d]`` equal width bins between ``range[2 * d]`` and
+``range[2 * d + 1]``. If :attr:`range` is not given, the minimum and maximum
+values of each dimension over all samples are used. If :attr:`bins` is a
+sequence of :math:`D` 1-D tensors, they are the strictly increasing bin edges
+of each dimension.
+
+Every bin includes its left edge, the last bin of each dimension also includes
+its right edge. Samples outside of the bins are ignored.
+
+.. note:: This function is only implemented for CPU tensors.
+
+Args:
+    {input}
+    bins (int... or Tensor...): number of bins or bin edges of each dimension
+    range (float..., optional): lower and upper end of the bins of each
+        dimension, as :math:`(min_0, max_0, min_1, max_1, ...)`
+    weight (Tensor, optional): weight of each sample, of shape
+        :math:`(N)` or :math:`(B, N)`. Default: each sample has weight 1
+
+Returns:
+    Tensor: Histogram of shape ``(*bins)``, or ``(B, *bins)`` for batched
+    inputs, with the dtype of :attr:`input`
+
+Example::
+
+    >>> x = torch.tensor([[0., 0.], [1., 1.], [2., 0.], [2., 2.]])
+    >>> torch.histogramdd(x, bins=[2, 2], range=[0., 2., 0., 2.])
+    tensor([[1., 0.],
+            [1., 2.]])
+    >>> torch.histogramdd(x, bins=[torch.tensor([0., 1., 3.]), torch.tensor([0., 3.])])
+    tensor([[1.],
+            [3.]])
+""".format(**common_args))
+
 add_docstr(torch.hypot,
            r"""
 hypot(input, other, *, out=None) -> Tensor
@@ -453,6 +453,46 @@ class record_function(ContextDecorator):
         return profiled_future
 
 
+def enable_op_metrics(record_shapes=False, sampling_prob=1.0):
+    """Starts aggregating per-operator call counts and latency histograms.
+
+    Unlike :class:`profile`, which records an event per call, the op metrics
+    observer only keeps a count and a log-bucketed latency histogram per
+    (operator, dispatch key), and is cheap enough to leave enabled. Every
+    thread updates its own shard without locking; the shards are merged by
+    :func:`op_metrics_snapshot`.
+
+    Arguments:
+        record_shapes (bool, optional): if set, the metrics are also keyed by
+            the input shapes, with each size rounded up to a power of two.
+            This boxes the inputs of every call and adds to the overhead.
+            Default: ``False``
+        sampling_prob (float, optional): fraction of the calls to observe.
+            Default: ``1.0``
+    """
+    torch.autograd._enable_op_metrics(record_shapes, sampling_prob)
+
+
+def disable_op_metrics():
+    """Stops the op metrics observer. Collected metrics are kept."""
+    torch.autograd._disable_op_metrics()
+
+
+def op_metrics_snapshot():
+    """Returns the op metrics of all threads since the last reset.
+
+    Each entry has ``name``, ``dispatch_key``, ``shapes``, ``count``,
+    ``total_ns`` and ``latency_histogram``, where bucket ``i`` of the
+    histogram counts the calls that took [2^i, 2^(i+1)) nanoseconds.
+    """
+    return torch.autograd._op_metrics_snapshot()
+
+
+def reset_op_metrics():
+    """Clears the op metrics collected so far."""
+    torch.autograd._reset_op_metrics()
+
+
 class emit_nvtx(object):
     """Context manager that makes every autograd operation emit an NVTX range.
 
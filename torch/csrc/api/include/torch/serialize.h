@@ -1,6 +1,7 @@
 #pragma once
 
 #include <torch/serialize/archive.h>
+#include <torch/serialize/checkpoint.h>
 #include <torch/serialize/tensor.h>
 #include <torch/csrc/WindowsTorchApiMacro.h>
 
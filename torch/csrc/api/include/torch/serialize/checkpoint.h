@@ -0,0 +1,185 @@
+#pragma once
+
+#include <c10/util/Exception.h>
+#include <torch/arg.h>
+#include <torch/csrc/WindowsTorchApiMacro.h>
+#include <torch/ordered_dict.h>
+#include <torch/types.h>
+
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace torch {
+namespace nn {
+class Module;
+} // namespace nn
+} // namespace torch
+
+namespace torch {
+namespace serialize {
+
+/// Options for a `CheckpointWriter`.
+struct TORCH_API CheckpointWriterOptions {
+  /// The rank of this process among the processes that write the checkpoint.
+  TORCH_ARG(int64_t, rank) = 0;
+
+  /// The number of processes that write the checkpoint.
+  TORCH_ARG(int64_t, world_size) = 1;
+
+  /// Whether every rank saves the same, full state. If true, the tensors are
+  /// split across ranks by size and every rank only writes its share.
+  /// Otherwise every rank writes all tensors it is given, which is what you
+  /// want if every rank holds a different shard of the state.
+  TORCH_ARG(bool, replicated) = false;
+
+  /// Whether to skip tensors whose content did not change since the previous
+  /// checkpoint of this writer. The manifest then refers to the archive of the
+  /// earlier checkpoint, which must be kept around.
+  TORCH_ARG(bool, incremental) = false;
+};
+
+/// Statistics about the last checkpoint written by a `CheckpointWriter`.
+struct TORCH_API CheckpointStats {
+  /// Number of tensors written to the archive of this rank.
+  int64_t num_written = 0;
+  /// Number of tensors skipped because they did not change (incremental mode)
+  /// or because another rank writes them (replicated mode).
+  int64_t num_skipped = 0;
+  /// Number of tensor bytes written to the archive of this rank.
+  int64_t bytes_written = 0;
+  /// Time `save()` spent copying tensors into staging buffers. This is the
+  /// time the caller is blocked for.
+  std::chrono::microseconds snapshot_time{0};
+  /// Time the background thread spent hashing and writing.
+  std::chrono::microseconds write_time{0};
+};
+
+/// Writes checkpoints of tensors in the background.
+///
+/// `save()` copies the tensors into staging buffers, which are reused across
+/// checkpoints, and returns. A background thread then writes the copies into a
+/// `PyTorchStreamWriter` archive, so training can continue while the
+/// checkpoint is written. Only one checkpoint is written at a time: `save()`
+/// first waits for the previous checkpoint to be written.
+///
+/// Every rank writes into `<directory>/step_<step>/`:
+///
+/// - `shard_<rank>.pt`, an archive with the raw bytes of its tensors, and
+/// - `manifest_<rank>.pt`, a small pickled list of the tensors of this rank
+///   and the archive record that holds each of them.
+///
+/// The manifest is written last, so a checkpoint is complete once the
+/// manifests of all ranks exist. Use `load_checkpoint()` to read it back, or
+/// the overload that takes a rank to read back the shard of one rank.
+///
+/// \rst
+/// .. code-block:: cpp
+///
+///   torch::serialize::CheckpointWriter writer(
+///       "checkpoints",
+///       torch::serialize::CheckpointWriterOptions().incremental(true));
+///   for (int64_t step = 0; step < num_steps; ++step) {
+///     train_step(model);
+///     if (step % 1000 == 0) {
+///       writer.save(step, *model);
+///     }
+///   }
+///   writer.wait();
+/// \endrst
+class TORCH_API CheckpointWriter {
+ public:
+  explicit CheckpointWriter(
+      std::string directory,
+      CheckpointWriterOptions options = {});
+
+  /// Waits for the checkpoint in progress. Errors are logged, not thrown; call
+  /// `wait()` to see them.
+  ~CheckpointWriter();
+
+  CheckpointWriter(const CheckpointWriter&) = delete;
+  CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+  /// Snapshots `tensors` and writes them as the checkpoint of `step` in the
+  /// background. Throws the error of the previous checkpoint, if any.
+  void save(int64_t step, const OrderedDict<std::string, Tensor>& tensors);
+
+  /// Snapshots the parameters and buffers of `module`, keyed by their
+  /// qualified names.
+  void save(int64_t step, const nn::Module& module);
+
+  /// Blocks until the checkpoint in progress is written. Throws if writing it
+  /// failed.
+  void wait();
+
+  /// Statistics of the last checkpoint that was completely written. Call
+  /// `wait()` first to get those of the checkpoint in progress.
+  CheckpointStats last_stats() const {
+    std::lock_guard<std::mutex> guard(stats_mutex_);
+    return stats_;
+  }
+
+  const CheckpointWriterOptions& options() const noexcept {
+    return options_;
+  }
+
+ private:
+  struct Entry {
+    std::string file;
+    std::string record;
+    c10::ScalarType dtype;
+    std::vector<int64_t> sizes;
+    uint64_t hash;
+  };
+
+  struct Snapshot {
+    std::string key;
+    Tensor staging;
+  };
+
+  // Runs on the background thread. Publishes stats once the checkpoint is
+  // written.
+  void write(
+      int64_t step,
+      std::vector<Snapshot> snapshots,
+      CheckpointStats stats);
+
+  const std::string directory_;
+  const CheckpointWriterOptions options_;
+
+  // Staging buffers, reused across checkpoints if the size and dtype match.
+  std::unordered_map<std::string, Tensor> staging_;
+
+  // Entries of the last checkpoint, used to skip unchanged tensors.
+  std::unordered_map<std::string, Entry> previous_;
+
+  std::thread thread_;
+  std::exception_ptr error_;
+
+  // Written by the background thread, so guarded by stats_mutex_.
+  mutable std::mutex stats_mutex_;
+  CheckpointStats stats_;
+};
+
+/// Loads the checkpoint of `step` written by `CheckpointWriter`s of all
+/// ranks into `directory`. The tensors are returned on CPU, ordered by rank.
+/// Throws if two ranks wrote a tensor under the same key, as the ranks of a
+/// non-replicated checkpoint usually do; load those one rank at a time.
+TORCH_API OrderedDict<std::string, Tensor> load_checkpoint(
+    const std::string& directory,
+    int64_t step);
+
+/// Loads the tensors that `rank` wrote to the checkpoint of `step` in
+/// `directory`, e.g. to restore the shard of one rank of a non-replicated
+/// checkpoint. The tensors are returned on CPU.
+TORCH_API OrderedDict<std::string, Tensor> load_checkpoint(
+    const std::string& directory,
+    int64_t step,
+    int64_t rank);
+
+} // namespace serialize
+} // namespace torch
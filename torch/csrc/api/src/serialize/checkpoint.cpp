@@ -0,0 +1,378 @@
+#include <torch/serialize/checkpoint.h>
+
+#include <torch/nn/module.h>
+#include <torch/serialize.h>
+#include <torch/utils.h>
+
+#include <c10/util/Exception.h>
+#include <caffe2/serialize/inline_container.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace torch {
+namespace serialize {
+namespace {
+
+// Bumped when the layout of the manifest changes.
+constexpr int64_t kManifestVersion = 1;
+
+void make_directory(const std::string& path) {
+#ifdef _WIN32
+  const int ret = _mkdir(path.c_str());
+#else
+  const int ret = mkdir(path.c_str(), 0777);
+#endif
+  TORCH_CHECK(
+      ret == 0 || errno == EEXIST,
+      "Failed to create directory ",
+      path,
+      ": ",
+      std::strerror(errno));
+}
+
+std::string step_directory(int64_t step) {
+  return "step_" + c10::to_string(step);
+}
+
+std::string manifest_path(
+    const std::string& directory,
+    int64_t step,
+    int64_t rank) {
+  return directory + "/" + step_directory(step) + "/manifest_" +
+      c10::to_string(rank) + ".pt";
+}
+
+// A 64 bit multiply-xorshift hash over 8 byte words. It only detects changed
+// tensors for incremental checkpoints and is not a cryptographic hash.
+uint64_t hash_bytes(const void* data, size_t size) {
+  constexpr uint64_t kMul = 0x9ddfea08eb382d69ULL;
+  const char* bytes = static_cast<const char*>(data);
+  uint64_t hash = size * kMul;
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, bytes + i, sizeof(word));
+    hash = (hash ^ word) * kMul;
+    hash ^= hash >> 47;
+  }
+  if (i < size) {
+    uint64_t word = 0;
+    std::memcpy(&word, bytes + i, size - i);
+    hash = (hash ^ word) * kMul;
+    hash ^= hash >> 47;
+  }
+  return hash;
+}
+
+std::vector<c10::IValue> read_manifest(
+    const std::string& directory,
+    int64_t step,
+    int64_t rank) {
+  const auto path = manifest_path(directory, step, rank);
+  std::ifstream stream(path, std::ios::binary);
+  TORCH_CHECK(
+      stream,
+      "Could not open checkpoint manifest ",
+      path,
+      ". Was the checkpoint of step ",
+      step,
+      " completely written?");
+  std::vector<char> data(
+      (std::istreambuf_iterator<char>(stream)),
+      std::istreambuf_iterator<char>());
+
+  auto manifest = pickle_load(data).toTuple()->elements();
+  TORCH_CHECK(
+      manifest.size() == 5 && manifest[0].toInt() == kManifestVersion,
+      "Unsupported checkpoint manifest ",
+      path);
+  return manifest;
+}
+
+} // namespace
+
+CheckpointWriter::CheckpointWriter(
+    std::string directory,
+    CheckpointWriterOptions options)
+    : directory_(std::move(directory)), options_(std::move(options)) {
+  TORCH_CHECK(
+      options_.world_size() > 0 && options_.rank() >= 0 &&
+          options_.rank() < options_.world_size(),
+      "Invalid rank ",
+      options_.rank(),
+      " for world size ",
+      options_.world_size());
+}
+
+CheckpointWriter::~CheckpointWriter() {
+  try {
+    wait();
+  } catch (const std::exception& e) {
+    TORCH_WARN("Writing checkpoint failed: ", e.what());
+  }
+}
+
+void CheckpointWriter::save(
+    int64_t step,
+    const OrderedDict<std::string, Tensor>& tensors) {
+  wait();
+  const auto start = std::chrono::steady_clock::now();
+  CheckpointStats stats;
+
+  // In replicated mode, every rank computes the same assignment of tensors to
+  // ranks: largest tensors first, each to the rank with the fewest bytes.
+  std::vector<bool> owned(tensors.size(), true);
+  if (options_.replicated() && options_.world_size() > 1) {
+    std::vector<size_t> order(tensors.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      return tensors[a].value().nbytes() > tensors[b].value().nbytes();
+    });
+    std::vector<size_t> bytes(options_.world_size(), 0);
+    for (const auto index : order) {
+      const auto rank = std::min_element(bytes.begin(), bytes.end()) -
+          bytes.begin();
+      bytes[rank] += tensors[index].value().nbytes();
+      owned[index] = rank == options_.rank();
+    }
+  }
+
+  NoGradGuard guard;
+  std::vector<Snapshot> snapshots;
+  for (size_t i = 0; i < tensors.size(); i++) {
+    const auto& key = tensors[i].key();
+    const auto& tensor = tensors[i].value();
+    TORCH_CHECK(
+        tensor.defined() && tensor.layout() == kStrided,
+        "Checkpoints only support defined, dense tensors, but '",
+        key,
+        "' is not");
+    if (!owned[i]) {
+      stats.num_skipped++;
+      continue;
+    }
+
+    auto& staging = staging_[key];
+    if (!staging.defined() || staging.scalar_type() != tensor.scalar_type() ||
+        staging.sizes() != tensor.sizes()) {
+      staging = torch::empty(tensor.sizes(), tensor.scalar_type());
+    }
+    staging.copy_(tensor);
+    snapshots.push_back({key, staging});
+  }
+  stats.snapshot_time = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
+
+  thread_ = std::thread(
+      [this, step, snapshots = std::move(snapshots), stats]() mutable {
+        try {
+          write(step, std::move(snapshots), stats);
+        } catch (...) {
+          error_ = std::current_exception();
+        }
+      });
+}
+
+void CheckpointWriter::save(int64_t step, const nn::Module& module) {
+  OrderedDict<std::string, Tensor> tensors(/*key_description=*/"Tensor");
+  for (const auto& parameter : module.named_parameters()) {
+    tensors.insert(parameter.key(), parameter.value());
+  }
+  for (const auto& buffer : module.named_buffers()) {
+    tensors.insert(buffer.key(), buffer.value());
+  }
+  save(step, tensors);
+}
+
+void CheckpointWriter::wait() {
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  if (error_) {
+    auto error = error_;
+    error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+void CheckpointWriter::write(
+    int64_t step,
+    std::vector<Snapshot> snapshots,
+    CheckpointStats stats) {
+  const auto start = std::chrono::steady_clock::now();
+  make_directory(directory_);
+  make_directory(directory_ + "/" + step_directory(step));
+  const auto file = step_directory(step) + "/shard_" +
+      c10::to_string(options_.rank()) + ".pt";
+
+  // The archive is only created if at least one tensor changed.
+  std::unique_ptr<caffe2::serialize::PyTorchStreamWriter> archive;
+  std::unordered_map<std::string, Entry> entries;
+  std::vector<c10::IValue> manifest_entries;
+  for (const auto& snapshot : snapshots) {
+    const auto& staging = snapshot.staging;
+    Entry entry{file,
+                /*record=*/"",
+                staging.scalar_type(),
+                staging.sizes().vec(),
+                hash_bytes(staging.data_ptr(), staging.nbytes())};
+
+    auto previous = previous_.find(snapshot.key);
+    if (options_.incremental() && previous != previous_.end() &&
+        previous->second.hash == entry.hash &&
+        previous->second.dtype == entry.dtype &&
+        previous->second.sizes == entry.sizes) {
+      entry = previous->second;
+      stats.num_skipped++;
+    } else {
+      if (!archive) {
+        archive = std::make_unique<caffe2::serialize::PyTorchStreamWriter>(
+            directory_ + "/" + file);
+      }
+      entry.record = "data/" + c10::to_string(stats.num_written);
+      archive->writeRecord(entry.record, staging.data_ptr(), staging.nbytes());
+      stats.num_written++;
+      stats.bytes_written += staging.nbytes();
+    }
+
+    manifest_entries.emplace_back(c10::ivalue::Tuple::create(
+        {snapshot.key,
+         entry.file,
+         entry.record,
+         static_cast<int64_t>(entry.dtype),
+         entry.sizes,
+         static_cast<int64_t>(entry.hash)}));
+    entries.emplace(snapshot.key, std::move(entry));
+  }
+  if (archive) {
+    archive->writeEndOfFile();
+  }
+
+  // Write the manifest last, and atomically, so that it only exists once the
+  // archive is complete.
+  const auto data = pickle_save(c10::ivalue::Tuple::create(
+      {kManifestVersion,
+       options_.world_size(),
+       options_.rank(),
+       step,
+       c10::ivalue::Tuple::create(std::move(manifest_entries))}));
+  const auto path = manifest_path(directory_, step, options_.rank());
+  const auto tmp_path = path + ".tmp";
+  {
+    std::ofstream stream(tmp_path, std::ios::binary);
+    stream.write(data.data(), data.size());
+    TORCH_CHECK(stream, "Failed to write checkpoint manifest ", tmp_path);
+  }
+  TORCH_CHECK(
+      std::rename(tmp_path.c_str(), path.c_str()) == 0,
+      "Failed to rename ",
+      tmp_path,
+      " to ",
+      path,
+      ": ",
+      std::strerror(errno));
+
+  previous_ = std::move(entries);
+  stats.write_time = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
+  std::lock_guard<std::mutex> guard(stats_mutex_);
+  stats_ = stats;
+}
+
+namespace {
+
+using RecordReaders = std::unordered_map<
+    std::string,
+    std::unique_ptr<caffe2::serialize::PyTorchStreamReader>>;
+
+// Reads the tensors of one rank's manifest into tensors.
+void load_manifest(
+    const std::string& directory,
+    const std::vector<c10::IValue>& manifest,
+    RecordReaders& readers,
+    OrderedDict<std::string, Tensor>& tensors) {
+  for (const auto& value : manifest[4].toTuple()->elements()) {
+    const auto& entry = value.toTuple()->elements();
+    const auto& key = entry[0].toStringRef();
+    TORCH_CHECK(
+        !tensors.contains(key),
+        "Tensor '",
+        key,
+        "' was written by more than one rank. Load the checkpoint of each ",
+        "rank separately with load_checkpoint(directory, step, rank)");
+    const auto& file = entry[1].toStringRef();
+    auto& reader = readers[file];
+    if (!reader) {
+      reader = std::make_unique<caffe2::serialize::PyTorchStreamReader>(
+          directory + "/" + file);
+    }
+
+    at::DataPtr data;
+    size_t size;
+    std::tie(data, size) = reader->getRecord(entry[2].toStringRef());
+    auto tensor = torch::empty(
+        entry[4].toIntVector(), static_cast<c10::ScalarType>(entry[3].toInt()));
+    TORCH_CHECK(
+        size == tensor.nbytes(),
+        "Checkpoint record of '",
+        key,
+        "' has ",
+        size,
+        " bytes, expected ",
+        tensor.nbytes());
+    if (size > 0) {
+      std::memcpy(tensor.data_ptr(), data.get(), size);
+    }
+    tensors.insert(key, std::move(tensor));
+  }
+}
+
+} // namespace
+
+OrderedDict<std::string, Tensor> load_checkpoint(
+    const std::string& directory,
+    int64_t step) {
+  OrderedDict<std::string, Tensor> tensors(/*key_description=*/"Tensor");
+  RecordReaders readers;
+  auto manifest = read_manifest(directory, step, /*rank=*/0);
+  const auto world_size = manifest[1].toInt();
+  for (int64_t rank = 0; rank < world_size; rank++) {
+    if (rank > 0) {
+      manifest = read_manifest(directory, step, rank);
+    }
+    load_manifest(directory, manifest, readers, tensors);
+  }
+  return tensors;
+}
+
+OrderedDict<std::string, Tensor> load_checkpoint(
+    const std::string& directory,
+    int64_t step,
+    int64_t rank) {
+  OrderedDict<std::string, Tensor> tensors(/*key_description=*/"Tensor");
+  RecordReaders readers;
+  load_manifest(
+      directory, read_manifest(directory, step, rank), readers, tensors);
+  return tensors;
+}
+
+} // namespace serialize
+} // namespace torch
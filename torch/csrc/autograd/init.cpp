@@ -4,6 +4,7 @@
 #include <torch/csrc/utils/pybind.h>
 #include <torch/csrc/autograd/grad_mode.h>
 #include <ATen/autocast_mode.h>
+#include <torch/csrc/autograd/op_metrics.h>
 #include <torch/csrc/autograd/profiler.h>
 #include <torch/csrc/autograd/python_function.h>
 #include <torch/csrc/autograd/function.h>
@@ -77,6 +78,30 @@ PyObject* THPAutograd_initExtension(PyObject* _unused, PyObject *unused) {
     at::clearCallbacks();
   });
 
+  py::class_<OpMetrics>(m, "OpMetrics")
+      .def_readonly("name", &OpMetrics::name)
+      .def_property_readonly("dispatch_key", [](const OpMetrics& metrics) {
+        return c10::toString(metrics.dispatch_key);
+      })
+      .def_readonly("shapes", &OpMetrics::shapes)
+      .def_readonly("count", &OpMetrics::count)
+      .def_readonly("total_ns", &OpMetrics::total_ns)
+      .def_property_readonly("latency_histogram", [](const OpMetrics& metrics) {
+        return std::vector<uint64_t>(
+            metrics.latency_histogram.begin(), metrics.latency_histogram.end());
+      });
+
+  m.def("_enable_op_metrics", [](bool record_shapes, double sampling_prob) {
+    OpMetricsConfig config;
+    config.record_shapes = record_shapes;
+    config.sampling_prob = sampling_prob;
+    enableOpMetrics(config);
+  });
+  m.def("_disable_op_metrics", disableOpMetrics);
+  m.def("_op_metrics_enabled", opMetricsEnabled);
+  m.def("_op_metrics_snapshot", opMetricsSnapshot);
+  m.def("_reset_op_metrics", resetOpMetrics);
+
   Py_RETURN_TRUE;
 }
 
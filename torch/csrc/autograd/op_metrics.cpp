@@ -0,0 +1,340 @@
+#include <torch/csrc/autograd/op_metrics.h>
+#include <torch/csrc/autograd/profiler.h>
+#include <torch/csrc/utils/hash.h>
+
+#include <ATen/core/operator_name.h>
+#include <c10/util/llvmMathExtras.h>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <tuple>
+#include <unordered_map>
+
+namespace torch { namespace autograd { namespace profiler {
+
+namespace {
+
+struct Counters {
+  uint64_t count = 0;
+  uint64_t total_ns = 0;
+  std::array<uint64_t, kOpLatencyBuckets> histogram{};
+};
+
+// The metrics of one (operator, dispatch key, shapes) of one thread. The
+// owning thread is the only writer of the live counters, so it updates them
+// with plain relaxed loads and stores. Readers load them and subtract the
+// counters at the last reset, which they keep in base under the registry
+// mutex. Calls find their entry by the address of the operator name, the name
+// itself is only copied once when the entry is created.
+struct Entry {
+  Entry(const c10::OperatorName* op, c10::DispatchKey dispatch_key, std::string shapes)
+      : op(op), name(op->name), dispatch_key(dispatch_key), shapes(std::move(shapes)) {
+    for (auto& bucket : histogram) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  void add(uint64_t ns) {
+    auto bump = [](std::atomic<uint64_t>& counter, uint64_t value) {
+      counter.store(
+          counter.load(std::memory_order_relaxed) + value,
+          std::memory_order_relaxed);
+    };
+    size_t bucket = ns == 0 ? 0 : llvm::Log2_64(ns);
+    bump(histogram[std::min(bucket, kOpLatencyBuckets - 1)], 1);
+    bump(total_ns, ns);
+    bump(count, 1);
+  }
+
+  Counters load() const {
+    Counters counters;
+    counters.count = count.load(std::memory_order_relaxed);
+    counters.total_ns = total_ns.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < kOpLatencyBuckets; ++i) {
+      counters.histogram[i] = histogram[i].load(std::memory_order_relaxed);
+    }
+    return counters;
+  }
+
+  const c10::OperatorName* const op;
+  const std::string name;
+  const c10::DispatchKey dispatch_key;
+  const std::string shapes;
+  std::atomic<uint64_t> count{0};
+  std::atomic<uint64_t> total_ns{0};
+  std::array<std::atomic<uint64_t>, kOpLatencyBuckets> histogram;
+  Counters base;
+  Entry* next = nullptr;
+};
+
+// The entries of one thread, in a list that the owning thread pushes to and
+// readers walk without locking.
+struct Shard {
+  ~Shard() {
+    Entry* entry = head.load();
+    while (entry) {
+      Entry* next = entry->next;
+      delete entry;
+      entry = next;
+    }
+  }
+
+  void push(Entry* entry) {
+    entry->next = head.load(std::memory_order_relaxed);
+    head.store(entry, std::memory_order_release);
+  }
+
+  std::atomic<Entry*> head{nullptr};
+};
+
+using MetricsKey = std::tuple<std::string, int, std::string>;
+
+MetricsKey metricsKey(const Entry& entry) {
+  return std::make_tuple(
+      entry.name, static_cast<int>(entry.dispatch_key), entry.shapes);
+}
+
+// Adds the counters of entry since the last reset to the metrics under its
+// key in merged.
+void mergeEntry(const Entry& entry, std::map<MetricsKey, OpMetrics>& merged) {
+  Counters counters = entry.load();
+  if (counters.count == entry.base.count) {
+    return;
+  }
+  auto key = metricsKey(entry);
+  auto it = merged.find(key);
+  if (it == merged.end()) {
+    OpMetrics metrics;
+    metrics.name = entry.name;
+    metrics.dispatch_key = entry.dispatch_key;
+    metrics.shapes = entry.shapes;
+    it = merged.emplace(std::move(key), std::move(metrics)).first;
+  }
+  auto& metrics = it->second;
+  metrics.count += counters.count - entry.base.count;
+  metrics.total_ns += counters.total_ns - entry.base.total_ns;
+  for (size_t i = 0; i < kOpLatencyBuckets; ++i) {
+    metrics.latency_histogram[i] +=
+        counters.histogram[i] - entry.base.histogram[i];
+  }
+}
+
+// The shards of the live threads. When a thread exits, its metrics since the
+// last reset are merged into retired and its shard is freed, so that thread
+// churn does not grow the registry.
+struct Registry {
+  std::mutex mutex;
+  std::vector<std::shared_ptr<Shard>> shards;
+  std::map<MetricsKey, OpMetrics> retired;
+};
+
+Registry& registry() {
+  static Registry registry;
+  return registry;
+}
+
+// State of the observing thread: its shard, an index of the shard entries by
+// the hash of their key, and the start times of the calls in progress.
+struct ThreadState {
+  ThreadState() : shard(std::make_shared<Shard>()) {
+    auto& r = registry();
+    std::lock_guard<std::mutex> guard(r.mutex);
+    r.shards.push_back(shard);
+  }
+
+  ~ThreadState() {
+    auto& r = registry();
+    std::lock_guard<std::mutex> guard(r.mutex);
+    for (Entry* entry = shard->head.load(std::memory_order_relaxed); entry;
+         entry = entry->next) {
+      mergeEntry(*entry, r.retired);
+    }
+    r.shards.erase(std::find(r.shards.begin(), r.shards.end(), shard));
+  }
+
+  Entry* find(
+      const c10::OperatorName* op,
+      c10::DispatchKey dispatch_key,
+      std::string shapes);
+
+  std::shared_ptr<Shard> shard;
+  std::unordered_multimap<size_t, Entry*> index;
+  struct Start {
+    at::RecordFunctionHandle handle;
+    const c10::OperatorName* op;
+    int64_t time;
+  };
+  std::vector<Start> starts;
+};
+
+ThreadState& threadState() {
+  static thread_local ThreadState state;
+  return state;
+}
+
+size_t hashKey(
+    const c10::OperatorName* op,
+    c10::DispatchKey dispatch_key,
+    const std::string& shapes) {
+  size_t hash = std::hash<const void*>()(op);
+  hash = torch::hash_combine(hash, static_cast<size_t>(dispatch_key));
+  if (!shapes.empty()) {
+    hash = torch::hash_combine(hash, std::hash<std::string>()(shapes));
+  }
+  return hash;
+}
+
+Entry* ThreadState::find(
+    const c10::OperatorName* op,
+    c10::DispatchKey dispatch_key,
+    std::string shapes) {
+  size_t hash = hashKey(op, dispatch_key, shapes);
+  auto range = index.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    Entry* entry = it->second;
+    if (entry->op == op && entry->dispatch_key == dispatch_key &&
+        entry->shapes == shapes) {
+      return entry;
+    }
+  }
+  auto entry = new Entry(op, dispatch_key, std::move(shapes));
+  shard->push(entry);
+  index.emplace(hash, entry);
+  return entry;
+}
+
+std::string bucketedShapes(const std::vector<c10::IValue>& inputs) {
+  std::ostringstream ss;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    if (i > 0) {
+      ss << ", ";
+    }
+    const auto& input = inputs[i];
+    if (!input.isTensor() || !input.toTensor().defined()) {
+      ss << "-";
+      continue;
+    }
+    ss << "[";
+    const auto sizes = input.toTensor().sizes();
+    for (size_t d = 0; d < sizes.size(); ++d) {
+      if (d > 0) {
+        ss << ", ";
+      }
+      ss << llvm::PowerOf2Ceil(static_cast<uint64_t>(sizes[d]));
+    }
+    ss << "]";
+  }
+  return ss.str();
+}
+
+void onStart(const at::RecordFunction& fn) {
+  // Only operator calls are counted, not the other function scopes such as
+  // autograd nodes.
+  const c10::OperatorName* op = fn.operatorName();
+  if (!op) {
+    return;
+  }
+  auto& starts = threadState().starts;
+  // The autograd kernel of an op calls the same op again for the backend.
+  // Both calls are recorded with the backend key, only count the outer one.
+  // Its end finds no start and is dropped.
+  if (!starts.empty() && starts.back().op == op) {
+    return;
+  }
+  starts.push_back({fn.handle(), op, getTime()});
+}
+
+void onEnd(const at::RecordFunction& fn, bool record_shapes) {
+  if (!fn.operatorName()) {
+    return;
+  }
+  int64_t end = getTime();
+  auto& state = threadState();
+  // Calls end in the reverse order of their start, but a start whose end ran
+  // on another thread is left behind and dropped here.
+  auto& starts = state.starts;
+  for (size_t i = starts.size(); i > 0; --i) {
+    if (starts[i - 1].handle == fn.handle()) {
+      int64_t start = starts[i - 1].time;
+      starts.resize(i - 1);
+      auto entry = state.find(
+          fn.operatorName(),
+          fn.dispatchKey(),
+          record_shapes ? bucketedShapes(fn.inputs()) : std::string());
+      entry->add(static_cast<uint64_t>(std::max<int64_t>(end - start, 0)));
+      return;
+    }
+  }
+}
+
+std::mutex config_mutex;
+at::CallbackHandle callback_handle = 0;
+
+} // namespace
+
+void enableOpMetrics(const OpMetricsConfig& config) {
+  std::lock_guard<std::mutex> guard(config_mutex);
+  if (callback_handle) {
+    at::removeCallback(callback_handle);
+  }
+  bool record_shapes = config.record_shapes;
+  callback_handle = at::addGlobalCallback(
+      at::RecordFunctionCallback(
+          &onStart,
+          [record_shapes](const at::RecordFunction& fn) {
+            onEnd(fn, record_shapes);
+          })
+          .needsInputs(record_shapes)
+          .needsIds(true)
+          .samplingProb(config.sampling_prob)
+          .scopes({at::RecordScope::FUNCTION}));
+}
+
+void disableOpMetrics() {
+  std::lock_guard<std::mutex> guard(config_mutex);
+  if (callback_handle) {
+    at::removeCallback(callback_handle);
+    callback_handle = 0;
+  }
+}
+
+bool opMetricsEnabled() {
+  std::lock_guard<std::mutex> guard(config_mutex);
+  return callback_handle != 0;
+}
+
+std::vector<OpMetrics> opMetricsSnapshot() {
+  auto& r = registry();
+  std::lock_guard<std::mutex> guard(r.mutex);
+  std::map<MetricsKey, OpMetrics> merged = r.retired;
+  for (const auto& shard : r.shards) {
+    for (Entry* entry = shard->head.load(std::memory_order_acquire); entry;
+         entry = entry->next) {
+      mergeEntry(*entry, merged);
+    }
+  }
+  std::vector<OpMetrics> result;
+  result.reserve(merged.size());
+  for (auto& kv : merged) {
+    result.push_back(std::move(kv.second));
+  }
+  return result;
+}
+
+void resetOpMetrics() {
+  auto& r = registry();
+  std::lock_guard<std::mutex> guard(r.mutex);
+  for (const auto& shard : r.shards) {
+    for (Entry* entry = shard->head.load(std::memory_order_acquire); entry;
+         entry = entry->next) {
+      entry->base = entry->load();
+    }
+  }
+  r.retired.clear();
+}
+
+}}} // namespace torch::autograd::profiler
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <ATen/record_function.h>
+#include <torch/csrc/WindowsTorchApiMacro.h>
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace torch { namespace autograd { namespace profiler {
+
+// Aggregated operator metrics, cheap enough to leave on in production.
+// Unlike the profiler, which records an event per call, the op metrics
+// observer only keeps a call count and a latency histogram per operator and
+// backend dispatch key. Every thread adds to its own shard without locking,
+// the shards are merged when a snapshot is taken and when their thread exits.
+
+// Number of latency histogram buckets, bucket i counting the calls that took
+// [2^i, 2^(i+1)) ns. Bucket 0 also counts calls under 1 ns, and the last
+// bucket all calls longer than its lower bound.
+constexpr size_t kOpLatencyBuckets = 40;
+
+struct TORCH_API OpMetricsConfig {
+  // Also key the metrics by the input shapes, each size rounded up to a
+  // power of two. Requires boxing the inputs of every call.
+  bool record_shapes = false;
+  // Fraction of the calls that are observed.
+  double sampling_prob = 1.0;
+};
+
+struct TORCH_API OpMetrics {
+  std::string name;
+  c10::DispatchKey dispatch_key = c10::DispatchKey::Undefined;
+  // Bucketed input shapes, e.g. "[4, 16], -" for a 3x9 tensor and a scalar.
+  // Empty unless OpMetricsConfig::record_shapes is set.
+  std::string shapes;
+  // Number of sampled calls.
+  uint64_t count = 0;
+  uint64_t total_ns = 0;
+  std::array<uint64_t, kOpLatencyBuckets> latency_histogram{};
+};
+
+TORCH_API void enableOpMetrics(const OpMetricsConfig& config = OpMetricsConfig());
+TORCH_API void disableOpMetrics();
+TORCH_API bool opMetricsEnabled();
+
+// Metrics of all threads since the last reset, sorted by name, dispatch key
+// and shapes.
+TORCH_API std::vector<OpMetrics> opMetricsSnapshot();
+TORCH_API void resetOpMetrics();
+
+}}} // namespace torch::autograd::profiler
@@ -1,6 +1,7 @@
 #include <torch/csrc/distributed/autograd/context/container.h>
 #include <c10/util/Exception.h>
 #include <torch/csrc/distributed/autograd/rpc_messages/cleanup_autograd_context_req.h>
+#include <torch/csrc/distributed/autograd/rpc_messages/cleanup_autograd_contexts_req.h>
 
 namespace torch {
 namespace distributed {
@@ -26,7 +27,12 @@ DistAutogradContainer::DistAutogradContainer(uint32_t num_shards)
       autograd_contexts_(num_shards),
       num_shards_(num_shards),
       next_autograd_message_id_(0),
-      max_id_(0) {
+      max_id_(0),
+      release_context_batcher_(
+          [this](
+              rpc::worker_id_t worker_id, std::vector<int64_t> context_ids) {
+            sendReleaseContextsRpc(worker_id, std::move(context_ids));
+          }) {
   // num_shards has to be a power of 2 for the modulo trick in 'getShard'
   // to work.
   TORCH_INTERNAL_ASSERT((num_shards & (num_shards - 1)) == 0);
@@ -224,6 +230,16 @@ void DistAutogradContainer::sendReleaseContextRpc(
   // ungraceful shutdown, where we are shutting down RPC and also processing
   // this message in a separate thread concurrently. In this case, don't throw
   // here.
+  std::vector<rpc::worker_id_t> unbatchedWorkerIds;
+  for (const auto& worker_id : workerIds) {
+    if (!release_context_batcher_.enqueue(worker_id, context_id)) {
+      unbatchedWorkerIds.push_back(worker_id);
+    }
+  }
+  if (unbatchedWorkerIds.empty()) {
+    return;
+  }
+
   std::shared_ptr<rpc::RpcAgent> agent;
   try {
     agent = rpc::RpcAgent::getCurrentRpcAgent();
@@ -238,7 +254,7 @@ void DistAutogradContainer::sendReleaseContextRpc(
 
   rpc::RpcRetryOptions options;
   options.maxRetries = kNumCleanupContextRetries;
-  for (const auto& worker_id : workerIds) {
+  for (const auto& worker_id : unbatchedWorkerIds) {
     try {
       auto cleanupFuture = agent->sendWithRetries(
           agent->getWorkerInfo(worker_id),
@@ -265,6 +281,51 @@ void DistAutogradContainer::sendReleaseContextRpc(
   }
 }
 
+void DistAutogradContainer::sendReleaseContextsRpc(
+    rpc::worker_id_t worker_id,
+    std::vector<int64_t> context_ids) {
+  // Same best-effort semantics as sendReleaseContextRpc. This runs on the
+  // batcher's flush thread, so it must not throw.
+  try {
+    auto agent = rpc::RpcAgent::getCurrentRpcAgent();
+    TORCH_INTERNAL_ASSERT(agent, "RPC Agent should be set.");
+
+    rpc::RpcRetryOptions options;
+    options.maxRetries = kNumCleanupContextRetries;
+    auto cleanupFuture = agent->sendWithRetries(
+        agent->getWorkerInfo(worker_id),
+        CleanupAutogradContextsReq(std::move(context_ids)).toMessage(),
+        options);
+
+    cleanupFuture->addCallback(
+        [worker_id](const rpc::FutureMessage& cleanupFuture) {
+          if (cleanupFuture.hasError()) {
+            LOG(ERROR) << "Could not release Dist Autograd Contexts on node "
+                       << worker_id << ": " << cleanupFuture.error()->what();
+          }
+        });
+  } catch (const std::exception& e) {
+    LOG(INFO)
+        << "Failed to send RPC to clear Dist Autograd contexts to worker id: "
+        << worker_id << " : " << e.what();
+  }
+}
+
+void DistAutogradContainer::setReleaseContextBatching(
+    std::chrono::milliseconds flushInterval,
+    size_t maxBatchSize) {
+  release_context_batcher_.configure(flushInterval, maxBatchSize);
+}
+
+void DistAutogradContainer::flushReleaseContextRpcs() {
+  release_context_batcher_.flush();
+}
+
+rpc::MessageBatcher<int64_t>::Stats DistAutogradContainer::
+    releaseContextBatchingStats() const {
+  return release_context_batcher_.stats();
+}
+
 void DistAutogradContainer::eraseContextIdAndReset(
     DistAutogradContainer::ContextsShard& shard,
     int64_t context_id) {
@@ -4,6 +4,7 @@
 #include <unordered_map>
 
 #include <torch/csrc/distributed/autograd/context/context.h>
+#include <torch/csrc/distributed/rpc/message_batcher.h>
 
 namespace torch {
 namespace distributed {
@@ -92,6 +93,20 @@ class TORCH_API DistAutogradContainer {
   // Returns the current thread local context id for this thread.
   static int64_t currentContextId();
 
+  // Batch the RPCs that tell other workers to clean up their contexts, per
+  // worker. A batch is sent when it holds maxBatchSize context ids, or every
+  // flushInterval. A zero flushInterval sends one RPC per context right away,
+  // which is the default.
+  void setReleaseContextBatching(
+      std::chrono::milliseconds flushInterval,
+      size_t maxBatchSize);
+
+  // Sends all batched context cleanup RPCs now.
+  void flushReleaseContextRpcs();
+
+  // Queue depth and flush statistics of the batched context cleanup RPCs.
+  rpc::MessageBatcher<int64_t>::Stats releaseContextBatchingStats() const;
+
  private:
   // Number of shards for the map storing autograd contexts. We'd like this
   // to be a power of 2 and we don't expect a value much higher than the
@@ -126,11 +141,17 @@ class TORCH_API DistAutogradContainer {
   ContextsShard& getShard(int64_t context_id);
 
   // Sends an RPC to the workers that have a context corresponding to passed in
-  // context_id. This function should be called with the lock.
+  // context_id, or adds context_id to their batches if batching is enabled.
+  // This function should be called without the lock.
   void sendReleaseContextRpc(
       const std::unordered_set<rpc::worker_id_t>& workerIds,
       int64_t context_id);
 
+  // Sends one batch of context ids to clean up to worker_id.
+  void sendReleaseContextsRpc(
+      rpc::worker_id_t worker_id,
+      std::vector<int64_t> context_ids);
+
   // Erase context_id from the autograd context map, and reset the thread local
   // current context id if it corresponds to the passed in context id. This
   // function should be called with the lock.
@@ -160,6 +181,9 @@ class TORCH_API DistAutogradContainer {
 
   // Maximum allowed value for autograd_context_id or autograd_message_id.
   int64_t max_id_;
+
+  // Batches of context ids to clean up, keyed by worker id.
+  rpc::MessageBatcher<int64_t> release_context_batcher_;
 };
 
 } // namespace autograd
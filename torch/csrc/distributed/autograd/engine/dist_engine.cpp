@@ -26,6 +26,12 @@ using torch::autograd::variable_list;
 
 static constexpr char* kNumBackwardPasses = "num_current_backward_passes";
 static constexpr char* kNumAutogradContexts = "num_autograd_contexts";
+static constexpr char* kNumQueuedContextCleanups =
+    "num_queued_context_cleanups";
+static constexpr char* kNumContextCleanupFlushes =
+    "num_context_cleanup_flushes";
+static constexpr char* kContextCleanupFlushLatencyUs =
+    "avg_context_cleanup_flush_latency_us";
 
 // This hook does 3 things:
 //   1. Call pre hooks of the original AccumulateGrad to modify the input grad.
@@ -548,6 +554,14 @@ std::unordered_map<std::string, int> DistEngine::getDebugInfo() const {
   debugInfo[kNumBackwardPasses] = numBackwardPasses();
   debugInfo[kNumAutogradContexts] =
       DistAutogradContainer::getInstance().numAutogradContexts();
+
+  auto stats =
+      DistAutogradContainer::getInstance().releaseContextBatchingStats();
+  debugInfo[kNumQueuedContextCleanups] = stats.queueDepth;
+  debugInfo[kNumContextCleanupFlushes] = stats.numFlushes;
+  debugInfo[kContextCleanupFlushLatencyUs] = stats.numFlushes == 0
+      ? 0
+      : stats.totalFlushLatency.count() / stats.numFlushes;
   return debugInfo;
 }
 
@@ -1,3 +1,4 @@
+#include <pybind11/chrono.h>
 #include <torch/csrc/autograd/python_cpp_function.h>
 #include <torch/csrc/distributed/autograd/autograd.h>
 #include <torch/csrc/jit/python/pybind_utils.h>
@@ -107,6 +108,21 @@ PyObject* dist_autograd_init(PyObject* /* unused */) {
       []() { return DistEngine::getInstance().getDebugInfo(); },
       py::call_guard<py::gil_scoped_release>());
 
+  module.def(
+      "_set_context_cleanup_batching",
+      [](std::chrono::milliseconds flushInterval, size_t maxBatchSize) {
+        DistAutogradContainer::getInstance().setReleaseContextBatching(
+            flushInterval, maxBatchSize);
+      },
+      py::arg("flush_interval"),
+      py::arg("max_batch_size") = 128,
+      py::call_guard<py::gil_scoped_release>());
+
+  module.def(
+      "_flush_context_cleanup",
+      []() { DistAutogradContainer::getInstance().flushReleaseContextRpcs(); },
+      py::call_guard<py::gil_scoped_release>());
+
   py::options options;
   options.disable_function_signatures();
 
@@ -0,0 +1,46 @@
+#include <torch/csrc/distributed/autograd/rpc_messages/cleanup_autograd_contexts_req.h>
+#include <torch/csrc/distributed/rpc/rpc_agent.h>
+#include <torch/csrc/jit/serialization/pickle.h>
+
+namespace torch {
+namespace distributed {
+namespace autograd {
+
+CleanupAutogradContextsReq::CleanupAutogradContextsReq(
+    std::vector<int64_t> context_ids)
+    : context_ids_(std::move(context_ids)) {}
+
+const std::vector<int64_t>& CleanupAutogradContextsReq::getContextIds() const {
+  return context_ids_;
+}
+
+rpc::Message CleanupAutogradContextsReq::toMessageImpl() && {
+  // pickle the list of context_ids using JIT pickler.
+  std::vector<torch::Tensor> tensorTable;
+  std::vector<char> payload =
+      jit::pickle(at::IValue(context_ids_), &tensorTable);
+  return rpc::Message(
+      std::move(payload),
+      std::move(tensorTable),
+      rpc::MessageType::CLEANUP_AUTOGRAD_CONTEXTS_REQ);
+}
+
+std::unique_ptr<CleanupAutogradContextsReq> CleanupAutogradContextsReq::
+    fromMessage(const rpc::Message& message) {
+  // unpickle and get the context_ids we need to clean up
+  auto payload = static_cast<const char*>(message.payload().data());
+  auto payload_size = message.payload().size();
+  IValue ivalue_context_ids = jit::unpickle(
+      payload,
+      payload_size,
+      *rpc::RpcAgent::getCurrentRpcAgent()->getTypeResolver(),
+      &message.tensors());
+
+  // convert ivalue to a list of ints and construct request
+  return std::make_unique<CleanupAutogradContextsReq>(
+      ivalue_context_ids.toIntVector());
+}
+
+} // namespace autograd
+} // namespace distributed
+} // namespace torch
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <torch/csrc/distributed/rpc/message.h>
+#include <torch/csrc/distributed/rpc/rpc_command_base.h>
+
+#include <vector>
+
+namespace torch {
+namespace distributed {
+namespace autograd {
+
+// Used to request other workers to clean up several autograd contexts at once.
+// It is the batched version of CleanupAutogradContextReq.
+class TORCH_API CleanupAutogradContextsReq : public rpc::RpcCommandBase {
+ public:
+  explicit CleanupAutogradContextsReq(std::vector<int64_t> context_ids);
+  // Serialization and deserialization methods.
+  rpc::Message toMessageImpl() && override;
+  static std::unique_ptr<CleanupAutogradContextsReq> fromMessage(
+      const rpc::Message& message);
+
+  // Retrieve the context ids we are cleaning up with this message.
+  const std::vector<int64_t>& getContextIds() const;
+
+ private:
+  std::vector<int64_t> context_ids_;
+};
+
+} // namespace autograd
+} // namespace distributed
+} // namespace torch
@@ -17,6 +17,7 @@
 #endif
 
 #include <c10d/PrefixStore.hpp>
+#include <c10d/ProcessGroupHierarchical.hpp>
 #include <c10d/ProcessGroupRoundRobin.hpp>
 #include <c10d/TCPStore.hpp>
 #include <pybind11/chrono.h>
@@ -51,6 +52,60 @@ std::vector<std::string> split(char separator, const std::string& string) {
 template <typename T>
 using shared_ptr_class_ = py::class_<T, std::shared_ptr<T>>;
 
+#ifdef USE_C10D_GLOO
+::c10d::ProcessGroupGloo::Options defaultGlooOptions(
+    std::chrono::milliseconds timeout) {
+  ::c10d::ProcessGroupGloo::Options options;
+
+  // Use interfaces listed in "GLOO_SOCKET_IFNAME", if set.
+  char* ifnameEnv = getenv(GLOO_SOCKET_IFNAME_ENV);
+  if (ifnameEnv) {
+    for (const auto& iface : split(',', ifnameEnv)) {
+      options.devices.push_back(
+          ::c10d::ProcessGroupGloo::createDeviceForInterface(iface));
+    }
+  } else {
+    // If no hostname is specified, this function looks up
+    // the machine's hostname and returns a device instance
+    // associated with the address that the hostname resolves to.
+    options.devices.push_back(::c10d::ProcessGroupGloo::createDefaultDevice());
+  }
+
+  options.timeout = timeout;
+  options.threads = options.devices.size() * 2;
+  return options;
+}
+#endif
+
+// Holds a Python callable invoked from a thread that does not hold the GIL,
+// and releases it under the GIL as well.
+class PythonWatchCallback {
+ public:
+  explicit PythonWatchCallback(py::function fn) : fn_(std::move(fn)) {}
+
+  ~PythonWatchCallback() {
+    pybind11::gil_scoped_acquire gil;
+    fn_.dec_ref();
+    // See Note [Destructing py::object] in python_ivalue.h
+    fn_.ptr() = nullptr;
+  }
+
+  void operator()(const std::vector<uint8_t>& value) {
+    pybind11::gil_scoped_acquire gil;
+    try {
+      fn_(py::bytes(reinterpret_cast<const char*>(value.data()), value.size()));
+    } catch (py::error_already_set& e) {
+      // There is no caller to raise to; report it like an exception in a
+      // Python thread and keep watching.
+      e.restore();
+      PyErr_WriteUnraisable(fn_.ptr());
+    }
+  }
+
+ private:
+  py::function fn_;
+};
+
 // PythonStore is a pybind11 trampoline class to allow a Python
 // class to inherit from c10d.Store and implement its interface.
 class PythonStore : public ::c10d::Store {
@@ -180,7 +235,21 @@ PyObject* c10d_init(PyObject* _unused) {
           [](::c10d::Reducer& reducer, const torch::autograd::Variable& output)
               -> void { reducer.prepare_for_backward({output}); },
           py::call_guard<py::gil_scoped_release>())
-      .def("get_backward_stats", &::c10d::Reducer::get_backward_stats);
+      .def("get_backward_stats", &::c10d::Reducer::get_backward_stats)
+      .def(
+          "enable_adaptive_bucketing",
+          &::c10d::Reducer::enable_adaptive_bucketing,
+          py::arg("num_iterations") =
+              ::c10d::kDefaultAdaptiveBucketingIterations,
+          py::call_guard<py::gil_scoped_release>())
+      .def(
+          "get_bucket_indices",
+          &::c10d::Reducer::get_bucket_indices,
+          py::call_guard<py::gil_scoped_release>())
+      .def(
+          "get_coalesced_groups",
+          &::c10d::Reducer::get_coalesced_groups,
+          py::call_guard<py::gil_scoped_release>());
 
   py::enum_<::c10d::ReduceOp>(module, "ReduceOp", R"(
 An enum-like class for available reduction operations: ``SUM``, ``PRODUCT``,
@@ -307,18 +376,95 @@ They are used in specifying strategies for reduction collectives, e.g.,
 
   shared_ptr_class_<::c10d::TCPStore>(module, "TCPStore", store)
       .def(
-          py::init<
-              const std::string&,
-              int,
-              int,
-              bool,
-              std::chrono::milliseconds>(),
+          py::init([](const std::string& hostName,
+                      int port,
+                      int worldSize,
+                      bool isMaster,
+                      std::chrono::milliseconds timeout) {
+            // Callbacks passed to watch_key take the GIL on the listener
+            // thread that the destructor joins, so the GIL must not be held
+            // while the store is destroyed.
+            return std::shared_ptr<::c10d::TCPStore>(
+                new ::c10d::TCPStore(
+                    hostName, port, worldSize, isMaster, timeout),
+                [](::c10d::TCPStore* store) {
+                  if (PyGILState_Check()) {
+                    py::gil_scoped_release release;
+                    delete store;
+                  } else {
+                    delete store;
+                  }
+                });
+          }),
           py::arg("host_name"),
           py::arg("port"),
           py::arg("world_size"),
           py::arg("is_master"),
           py::arg("timeout") =
-              std::chrono::milliseconds(::c10d::Store::kDefaultTimeout));
+              std::chrono::milliseconds(::c10d::Store::kDefaultTimeout))
+      .def(
+          "multi_get",
+          [](::c10d::TCPStore& store, const std::vector<std::string>& keys) {
+            std::vector<std::vector<uint8_t>> values;
+            {
+              py::gil_scoped_release release;
+              values = store.multiGet(keys);
+            }
+            std::vector<py::bytes> result;
+            for (const auto& value : values) {
+              result.emplace_back(
+                  reinterpret_cast<const char*>(value.data()), value.size());
+            }
+            return result;
+          })
+      .def(
+          "multi_set",
+          [](::c10d::TCPStore& store,
+             const std::vector<std::string>& keys,
+             const std::vector<std::string>& values) {
+            std::vector<std::vector<uint8_t>> values_;
+            for (const auto& value : values) {
+              values_.emplace_back(value.begin(), value.end());
+            }
+            store.multiSet(keys, values_);
+          },
+          py::call_guard<py::gil_scoped_release>())
+      .def(
+          "compare_set",
+          [](::c10d::TCPStore& store,
+             const std::string& key,
+             const std::string& expected_value,
+             const std::string& desired_value) -> py::bytes {
+            std::vector<uint8_t> value;
+            {
+              py::gil_scoped_release release;
+              value = store.compareSet(
+                  key,
+                  std::vector<uint8_t>(
+                      expected_value.begin(), expected_value.end()),
+                  std::vector<uint8_t>(
+                      desired_value.begin(), desired_value.end()));
+            }
+            return py::bytes(
+                reinterpret_cast<const char*>(value.data()), value.size());
+          })
+      .def(
+          "watch_key",
+          [](::c10d::TCPStore& store,
+             const std::string& key,
+             py::function callback) {
+            auto fn = std::make_shared<PythonWatchCallback>(std::move(callback));
+            py::gil_scoped_release release;
+            store.watchKey(key, [fn](const std::vector<uint8_t>& value) {
+              (*fn)(value);
+            });
+          },
+          py::arg("key"),
+          py::arg("callback"),
+          R"(
+Calls ``callback`` with the new value, as bytes, every time ``key`` is
+updated by any client. The callback runs on a background thread of the
+store; exceptions it raises are reported and otherwise ignored.)");
 
   shared_ptr_class_<::c10d::PrefixStore>(module, "PrefixStore", store)
       .def(py::init<const std::string&, std::shared_ptr<::c10d::Store>>());
@@ -436,6 +582,14 @@ They are used in specifying strategies for reduction collectives, e.g.,
               py::arg("input_tensor"),
               py::call_guard<py::gil_scoped_release>())
 
+          .def(
+              "_allgather_base",
+              &::c10d::ProcessGroup::allgather_base,
+              py::arg("output"),
+              py::arg("input"),
+              py::arg("opts") = ::c10d::AllgatherOptions(),
+              py::call_guard<py::gil_scoped_release>())
+
           .def(
               "allgather_coalesced",
               &::c10d::ProcessGroup::allgather_coalesced,
@@ -611,7 +765,10 @@ They are used in specifying strategies for reduction collectives, e.g.,
       .def(py::init<>())
       .def_readwrite("devices", &::c10d::ProcessGroupGloo::Options::devices)
       .def_readwrite("timeout", &::c10d::ProcessGroupGloo::Options::timeout)
-      .def_readwrite("threads", &::c10d::ProcessGroupGloo::Options::threads);
+      .def_readwrite("threads", &::c10d::ProcessGroupGloo::Options::threads)
+      .def_readwrite(
+          "allreduce_chunk_bytes",
+          &::c10d::ProcessGroupGloo::Options::allreduceChunkBytes);
 
   processGroupGloo.def_static(
       "create_device",
@@ -640,32 +797,61 @@ They are used in specifying strategies for reduction collectives, e.g.,
                       int rank,
                       int size,
                       std::chrono::milliseconds timeout) {
-            ::c10d::ProcessGroupGloo::Options options;
-
-            // Use interfaces listed in "GLOO_SOCKET_IFNAME", if set.
-            char* ifnameEnv = getenv(GLOO_SOCKET_IFNAME_ENV);
-            if (ifnameEnv) {
-              for (const auto& iface : split(',', ifnameEnv)) {
-                options.devices.push_back(
-                    ::c10d::ProcessGroupGloo::createDeviceForInterface(iface));
-              }
-            } else {
-              // If no hostname is specified, this function looks up
-              // the machine's hostname and returns a device instance
-              // associated with the address that the hostname resolves to.
-              options.devices.push_back(
-                  ::c10d::ProcessGroupGloo::createDefaultDevice());
-            }
-
-            options.timeout = timeout;
-            options.threads = options.devices.size() * 2;
             return std::make_shared<::c10d::ProcessGroupGloo>(
-                store, rank, size, options);
+                store, rank, size, defaultGlooOptions(timeout));
           }),
           py::arg("store"),
           py::arg("rank"),
           py::arg("size"),
           py::arg("timeout") = std::chrono::milliseconds(10 * 1000)); // NOLINT
+
+  // The hierarchical process group is exposed with Gloo among the host
+  // leaders, which is the only inter-node backend it is tested with.
+  shared_ptr_class_<::c10d::ProcessGroupHierarchical>(
+      module, "ProcessGroupHierarchical", processGroup)
+      .def(
+          py::init([](const std::shared_ptr<::c10d::Store>& store,
+                      int rank,
+                      int size,
+                      std::chrono::milliseconds timeout,
+                      const std::string& hostname,
+                      size_t slotBytes) {
+            ::c10d::ProcessGroupHierarchical::Options options;
+            options.timeout = timeout;
+            // The inter-node Gloo group below uses the same timeout.
+            options.interNodeTimeout = timeout;
+            options.hostname = hostname;
+            options.slotBytes = slotBytes;
+            return std::make_shared<::c10d::ProcessGroupHierarchical>(
+                store,
+                rank,
+                size,
+                [timeout](
+                    const std::shared_ptr<::c10d::Store>& leaderStore,
+                    int hostIndex,
+                    int numHosts) -> std::shared_ptr<::c10d::ProcessGroup> {
+                  return std::make_shared<::c10d::ProcessGroupGloo>(
+                      leaderStore,
+                      hostIndex,
+                      numHosts,
+                      defaultGlooOptions(timeout));
+                },
+                std::move(options));
+          }),
+          py::arg("store"),
+          py::arg("rank"),
+          py::arg("size"),
+          py::arg("timeout") = std::chrono::milliseconds(10 * 1000), // NOLINT
+          py::arg("hostname") = "",
+          py::arg("slot_bytes") =
+              ::c10d::ProcessGroupHierarchical::Options().slotBytes,
+          py::call_guard<py::gil_scoped_release>())
+      .def_property_readonly(
+          "local_rank", &::c10d::ProcessGroupHierarchical::getLocalRank)
+      .def_property_readonly(
+          "local_size", &::c10d::ProcessGroupHierarchical::getLocalSize)
+      .def_property_readonly(
+          "num_hosts", &::c10d::ProcessGroupHierarchical::getNumHosts);
 #endif
 
 #ifdef USE_C10D_NCCL
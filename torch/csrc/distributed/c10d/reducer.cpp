@@ -1,8 +1,13 @@
 #include <torch/csrc/distributed/c10d/reducer.h>
 
+#include <algorithm>
 #include <functional>
+#include <limits>
+#include <numeric>
+#include <thread>
 
 #include <c10/core/DeviceGuard.h>
+#include <c10/core/Event.h>
 #include <c10/core/StreamGuard.h>
 #include <c10/util/Exception.h>
 #include <torch/csrc/autograd/engine.h>
@@ -187,6 +192,37 @@ Reducer::Reducer(
 // enables registering a Python hook and is a sub class of `CommHookInterface`.
 // `CommHookInterface` can be used to implement CPP hooks in the future.
 
+// Note [Adaptive Bucketing]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~
+// The default bucket assignment caps buckets at a fixed size. How well the
+// reduction of a bucket overlaps with the remaining backward computation
+// depends on the model and on the network, so no fixed cap is right for every
+// setup. With adaptive bucketing enabled, the reducer measures a number of
+// iterations once the buckets follow the order in which gradients become
+// ready, and then picks the assignment that finishes the last reduction
+// earliest.
+//
+// In a measured iteration, the allreduce for a bucket is waited on right
+// after it is kicked off, including the device work it queued. This costs the
+// overlap for those iterations, but it yields the duration of every
+// allreduce, and the time every gradient became ready with the time spent in
+// allreduce calls subtracted, i.e. the pure backward compute timeline. The
+// allreduce durations are fit to a linear model (latency + bytes /
+// bandwidth). Given the compute timeline and the model, the reductions are
+// simulated on a single communication lane, and dynamic programming over the
+// variables in ready order finds the split into buckets for which the last
+// reduction completes first. Buckets stay within the bucket size cap, unless
+// a single variable exceeds it.
+//
+// Replaying the new assignment on the lane, the buckets that become ready
+// while an earlier reduction is still running are put in a group, which is
+// reduced with a single allreduce_coalesced call once its last bucket is
+// ready. This saves the per-call latency for small buckets. The assignment
+// and the groups of rank 0 are broadcast to the other ranks, as with the
+// rebuilt buckets, because every rank has to issue the same collectives. If
+// the process group does not support allreduce_coalesced, it throws before
+// communicating, on every rank alike, and buckets are reduced one by one.
+
 Reducer::~Reducer() noexcept(false) {
   // Remove all hooks on variables registered by this Reducer. This is necessary
   // to make DDP failure recoverable. Otherwise, multiple Reducer instances
@@ -464,8 +500,18 @@ void Reducer::mark_variable_ready(VariableIndex index) {
   TORCH_CHECK(
       variable_index < variable_locators_.size(),
       "Out of range variable index.");
+  const auto ready_time = current_time_in_nanos();
   backward_stats_[replica_index][variable_index] =
-      current_time_in_nanos() - backward_stats_base_;
+      ready_time - backward_stats_base_;
+
+  // See Note [Adaptive Bucketing]
+  if (adaptive_bucketing_.measuring && replica_index == 0) {
+    if (adaptive_bucketing_.backward_start < 0) {
+      adaptive_bucketing_.backward_start = ready_time;
+    }
+    adaptive_bucketing_.ready_times[variable_index] += ready_time -
+        adaptive_bucketing_.backward_start - adaptive_bucketing_.comm_time;
+  }
 
   // Any time we mark a variable ready (be it in line due to unused parameters,
   // or via an autograd hook), we require a call to the finalize function. If
@@ -556,15 +602,23 @@ void Reducer::mark_variable_ready(VariableIndex index) {
       // Run callback with the current stream
       c10::OptionalStreamGuard currentStreamGuard{currentStream};
       this->finalize_backward();
+      std::vector<std::vector<size_t>> rebuilt_bucket_indices;
       // Rebuild bucket if this is the first time to rebuild
       if (!rebuilt_params_.empty()) {
-        auto rebuilt_bucket_indices = rebuildBuckets();
-        // Unlock before initialize_buckets() as initialize_buckets() requires a
-        // lock, it could result in self deadlock without unlocking here.
-        lock.unlock();
+        rebuilt_bucket_indices = rebuildBuckets();
+      } else if (adaptive_bucketing_.measuring) {
+        // See Note [Adaptive Bucketing]
+        adaptive_bucketing_.measuring = false;
+        ++adaptive_bucketing_.measured_iterations;
+        if (--adaptive_bucketing_.remaining_iterations == 0) {
+          rebuilt_bucket_indices = rebuildBucketsAdaptively();
+        }
+      }
+      // Unlock before initialize_buckets() as initialize_buckets() requires a
+      // lock, it could result in self deadlock without unlocking here.
+      lock.unlock();
+      if (!rebuilt_bucket_indices.empty()) {
         initialize_buckets(std::move(rebuilt_bucket_indices));
-      } else {
-        lock.unlock();
       }
     });
   }
@@ -574,18 +628,28 @@ void Reducer::mark_variable_ready(VariableIndex index) {
 void Reducer::mark_bucket_ready(size_t bucket_index) {
   TORCH_INTERNAL_ASSERT(bucket_index >= next_bucket_);
 
-  // Buckets are reduced in sequence. Ignore this bucket if
-  // it's not its turn to be reduced.
-  if (bucket_index > next_bucket_) {
-    return;
+  // Buckets are reduced in sequence, a group of coalesced buckets at a time
+  // (see Note [Adaptive Bucketing]). Keep going, until we either:
+  // - have kicked off reduction for all buckets, or
+  // - found a group with a bucket that's not yet ready for reduction.
+  const auto& group_ends = adaptive_bucketing_.group_ends;
+  while (next_bucket_ < buckets_.size()) {
+    size_t end = next_bucket_ + 1;
+    if (group_ends.size() == buckets_.size()) {
+      end = group_ends[next_bucket_];
+    }
+    for (size_t i = next_bucket_; i < end; i++) {
+      if (buckets_[i].pending != 0) {
+        return;
+      }
+    }
+    launch_bucket_reductions(next_bucket_, end);
+    next_bucket_ = end;
   }
+}
 
-  // Keep going, until we either:
-  // - have kicked off reduction for all buckets, or
-  // - found a bucket that's not yet ready for reduction.
-  for (; next_bucket_ < buckets_.size() && buckets_[next_bucket_].pending == 0;
-       next_bucket_++) {
-    auto& bucket = buckets_[next_bucket_];
+void Reducer::launch_bucket_reductions(size_t begin, size_t end) {
+  auto bucket_tensors = [](const Bucket& bucket) {
     std::vector<at::Tensor> tensors;
     tensors.reserve(bucket.replicas.size());
     for (const auto& replica : bucket.replicas) {
@@ -600,13 +664,71 @@ void Reducer::mark_bucket_ready(size_t bucket_index) {
       //
       tensors.push_back(replica.contents);
     }
+    return tensors;
+  };
+
+  // See Note [Adaptive Bucketing]
+  if (adaptive_bucketing_.measuring) {
+    for (size_t i = begin; i < end; i++) {
+      auto& bucket = buckets_[i];
+      auto tensors = bucket_tensors(bucket);
+      const auto start = current_time_in_nanos();
+      bucket.work = process_group_->allreduce(tensors);
+      bucket.work->wait();
+      // For device tensors, wait() only makes the current stream wait for
+      // the allreduce. Block until the stream has caught up as well.
+      const auto device = tensors[0].device();
+      if (device.type() != c10::kCPU) {
+        const c10::impl::VirtualGuardImpl guard{device.type()};
+        c10::Event event{device.type()};
+        event.record(guard.getStream(device));
+        while (!event.query()) {
+          std::this_thread::yield();
+        }
+      }
+      const auto duration = current_time_in_nanos() - start;
+      adaptive_bucketing_.comm_time += duration;
+      if (!bucket.expect_sparse_gradient) {
+        adaptive_bucketing_.allreduce_times.emplace_back(
+            tensors[0].nbytes(), duration);
+      }
+    }
+    return;
+  }
+
+  // The buckets of a coalesced group, see Note [Adaptive Bucketing].
+  if (end - begin > 1) {
+    std::vector<at::Tensor> tensors;
+    for (size_t i = begin; i < end; i++) {
+      tensors.push_back(buckets_[i].replicas[0].contents);
+    }
+    std::shared_ptr<c10d::ProcessGroup::Work> work;
+    try {
+      work = process_group_->allreduce_coalesced(tensors);
+    } catch (const std::exception&) {
+      // The process group does not support coalescing these tensors. This
+      // happens on all ranks alike. Do not try again, and reduce the buckets
+      // one by one from now on.
+      adaptive_bucketing_.group_ends.clear();
+    }
+    if (work) {
+      for (size_t i = begin; i < end; i++) {
+        buckets_[i].work = work;
+      }
+      return;
+    }
+  }
+
+  for (size_t i = begin; i < end; i++) {
+    auto& bucket = buckets_[i];
+    auto tensors = bucket_tensors(bucket);
     // See Note [DDP Communication Hook]
     // TODO(@sinannasir): merge `work` and `future_work`. Related to GH Issue
     // #41266.
-    if (comm_hook_ == nullptr) {
-      bucket.work = process_group_->allreduce(tensors);
-    } else {
+    if (comm_hook_ != nullptr) {
       bucket.future_work = comm_hook_->runHook(GradBucket(tensors));
+    } else {
+      bucket.work = process_group_->allreduce(tensors);
     }
   }
 }
@@ -825,6 +947,13 @@ void Reducer::prepare_for_backward(
   expect_autograd_hooks_ = true;
   next_bucket_ = 0;
   backward_stats_base_ = current_time_in_nanos();
+  // Measure this iteration if adaptive bucketing still needs samples. This
+  // starts once the buckets have been rebuilt in ready order.
+  // See Note [Adaptive Bucketing]
+  adaptive_bucketing_.measuring =
+      adaptive_bucketing_.remaining_iterations > 0 && has_rebuilt_bucket_;
+  adaptive_bucketing_.backward_start = -1;
+  adaptive_bucketing_.comm_time = 0;
   for (auto& bucket : buckets_) {
     for (auto& replica : bucket.replicas) {
       replica.pending = replica.variables.size();
@@ -1115,6 +1244,40 @@ void Reducer::sync_bucket_indices(
   }
 }
 
+std::vector<size_t> Reducer::sync_group_ends(
+    const std::vector<size_t>& group_ends,
+    size_t num_buckets) {
+  // num_buckets has been synced already, but on ranks != 0 the local group
+  // ends may be for a different number of buckets.
+  auto group_ends_tensor = at::zeros({(int64_t)num_buckets}, at::kInt);
+  auto group_ends_accessor = group_ends_tensor.accessor<int, 1>();
+  for (size_t i = 0; i < std::min(num_buckets, group_ends.size()); i++) {
+    group_ends_accessor[i] = group_ends[i];
+  }
+
+  at::TensorOptions options;
+  options = options.dtype(at::kInt);
+  options = options.device(replicas_[0][0].device());
+  auto group_ends_tensor_device = at::empty({(int64_t)num_buckets}, options);
+  group_ends_tensor_device.copy_(group_ends_tensor, /*non_blocking=*/true);
+  std::vector<at::Tensor> group_ends_tensor_list = {group_ends_tensor_device};
+  process_group_->broadcast(group_ends_tensor_list)->wait();
+  group_ends_tensor.copy_(
+      group_ends_tensor_list.front(), /*non_blocking=*/false);
+
+  std::vector<size_t> synced_group_ends;
+  synced_group_ends.reserve(num_buckets);
+  bool coalesced = false;
+  for (size_t i = 0; i < num_buckets; i++) {
+    synced_group_ends.push_back(group_ends_accessor[i]);
+    coalesced = coalesced || synced_group_ends.back() != i + 1;
+  }
+  if (!coalesced) {
+    synced_group_ends.clear();
+  }
+  return synced_group_ends;
+}
+
 std::vector<std::vector<size_t>> Reducer::rebuildBuckets() {
   TORCH_INTERNAL_ASSERT(
       rebuilt_params_.size() == rebuilt_param_indices_.size(),
@@ -1144,10 +1307,215 @@ std::vector<std::vector<size_t>> Reducer::rebuildBuckets() {
   return rebuilt_bucket_indices;
 }
 
+std::vector<std::vector<size_t>> Reducer::rebuildBucketsAdaptively() {
+  auto& state = adaptive_bucketing_;
+  TORCH_INTERNAL_ASSERT(state.measured_iterations > 0);
+  const auto variable_count = replicas_[0].size();
+
+  // Fit the allreduce durations to latency + bytes / bandwidth.
+  double latency = 0;
+  double time_per_byte = 0;
+  {
+    double n = state.allreduce_times.size();
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (const auto& sample : state.allreduce_times) {
+      const double x = sample.first;
+      const double y = sample.second;
+      sx += x;
+      sy += y;
+      sxx += x * x;
+      sxy += x * y;
+    }
+    const double denominator = n * sxx - sx * sx;
+    if (n >= 2 && denominator > 0) {
+      time_per_byte = (n * sxy - sx * sy) / denominator;
+      latency = std::max(0.0, (sy - time_per_byte * sx) / n);
+    }
+    if (time_per_byte <= 0) {
+      // All measured buckets had the same size, or the durations did not
+      // grow with the size. Take them as pure latency, which yields buckets
+      // as large as the cap allows.
+      time_per_byte = 0;
+      latency = n > 0 ? sy / n : 0;
+    }
+  }
+
+  // Variables in the order their gradients become ready. Ready times are
+  // made non-decreasing, so that the time a bucket becomes ready is the
+  // ready time of its last variable.
+  std::vector<size_t> order(variable_count);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return state.ready_times[a] < state.ready_times[b];
+  });
+  std::vector<double> ready(variable_count);
+  std::vector<size_t> bytes(variable_count);
+  double latest = 0;
+  for (size_t i = 0; i < variable_count; i++) {
+    const auto& variable = replicas_[0][order[i]];
+    latest = std::max(
+        latest,
+        static_cast<double>(state.ready_times[order[i]]) /
+            state.measured_iterations);
+    ready[i] = latest;
+    bytes[i] = variable.numel() * variable.element_size();
+  }
+
+  // finish[j] is the earliest time the reduction of the first j variables
+  // can complete, where the last bucket starts at variable start[j].
+  // Reductions run one at a time, each starting when its bucket is ready
+  // and the previous reduction has completed.
+  std::vector<double> finish(
+      variable_count + 1, std::numeric_limits<double>::infinity());
+  std::vector<size_t> start(variable_count + 1, 0);
+  finish[0] = 0;
+  for (size_t j = 1; j <= variable_count; j++) {
+    const auto last = order[j - 1];
+    const auto& last_variable = replicas_[0][last];
+    size_t bucket_bytes = 0;
+    // Grow the bucket ending in variable j - 1 backwards. On ties prefer
+    // the larger bucket.
+    for (size_t i = j; i-- > 0;) {
+      const auto variable_index = order[i];
+      const auto& variable = replicas_[0][variable_index];
+      // Variables that expect a sparse gradient have their own bucket, the
+      // others can only share a bucket with the same type and device, up
+      // to the bucket size cap.
+      if (i + 1 < j &&
+          (expect_sparse_gradients_[0][last] ||
+           expect_sparse_gradients_[0][variable_index] ||
+           !variable.options().type_equal(last_variable.options()) ||
+           bucket_bytes + bytes[i] >
+               static_cast<size_t>(bucket_bytes_cap_))) {
+        break;
+      }
+      bucket_bytes += bytes[i];
+      const double completion = std::max(finish[i], ready[j - 1]) +
+          latency + time_per_byte * bucket_bytes;
+      if (completion <= finish[j]) {
+        finish[j] = completion;
+        start[j] = i;
+      }
+    }
+  }
+
+  std::vector<std::vector<size_t>> bucket_indices;
+  for (size_t j = variable_count; j > 0; j = start[j]) {
+    bucket_indices.emplace_back(
+        order.begin() + start[j], order.begin() + j);
+  }
+  std::reverse(bucket_indices.begin(), bucket_indices.end());
+
+  // Replay the assignment on the communication lane, and group the buckets
+  // that become ready before the lane is free. Buckets can only be coalesced
+  // if they hold a single replica, are dense, and have the same type.
+  const auto num_buckets = bucket_indices.size();
+  std::vector<size_t> group_ends(num_buckets);
+  {
+    std::vector<double> bucket_ready(num_buckets, 0);
+    std::vector<size_t> bucket_bytes(num_buckets, 0);
+    for (size_t b = 0; b < num_buckets; b++) {
+      for (const auto variable_index : bucket_indices[b]) {
+        const auto& variable = replicas_[0][variable_index];
+        bucket_ready[b] = std::max(
+            bucket_ready[b],
+            static_cast<double>(state.ready_times[variable_index]) /
+                state.measured_iterations);
+        bucket_bytes[b] += variable.numel() * variable.element_size();
+      }
+    }
+    auto coalescable = [&](size_t first, size_t other) {
+      const auto& first_indices = bucket_indices[first];
+      const auto& other_indices = bucket_indices[other];
+      return replicas_.size() == 1 &&
+          !expect_sparse_gradients_[0][first_indices[0]] &&
+          !expect_sparse_gradients_[0][other_indices[0]] &&
+          replicas_[0][other_indices[0]].options().type_equal(
+              replicas_[0][first_indices[0]].options());
+    };
+    double lane_free = 0;
+    for (size_t begin = 0; begin < num_buckets;) {
+      const double group_start = std::max(lane_free, bucket_ready[begin]);
+      size_t group_bytes = bucket_bytes[begin];
+      size_t end = begin + 1;
+      while (end < num_buckets && bucket_ready[end] <= group_start &&
+             coalescable(begin, end)) {
+        group_bytes += bucket_bytes[end];
+        end++;
+      }
+      lane_free = group_start + latency + time_per_byte * group_bytes;
+      std::fill(group_ends.begin() + begin, group_ends.begin() + end, end);
+      begin = end;
+    }
+  }
+
+  // The assignment and the groups have to be the same on all ranks.
+  // Broadcast the ones of rank 0 like for the rebuilt buckets.
+  sync_bucket_indices(bucket_indices);
+  state.group_ends = sync_group_ends(group_ends, bucket_indices.size());
+
+  state.ready_times.clear();
+  state.allreduce_times.clear();
+  return bucket_indices;
+}
+
+// See Note [Adaptive Bucketing]
+void Reducer::enable_adaptive_bucketing(int64_t num_iterations) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  TORCH_CHECK(
+      num_iterations > 0,
+      "Expected a positive number of iterations to measure, got ",
+      num_iterations,
+      ".");
+  TORCH_CHECK(
+      !expect_autograd_hooks_,
+      "`enable_adaptive_bucketing` must NOT be called during autograd execution.");
+  TORCH_CHECK(
+      !find_unused_parameters_,
+      "Adaptive bucketing relies on gradients becoming ready in the same ",
+      "order every iteration, and does not support find_unused_parameters.");
+  TORCH_CHECK(
+      comm_hook_ == nullptr,
+      "Adaptive bucketing cannot be used with a communication hook.");
+  adaptive_bucketing_ = AdaptiveBucketing();
+  adaptive_bucketing_.enabled = true;
+  adaptive_bucketing_.remaining_iterations = num_iterations;
+  adaptive_bucketing_.ready_times.assign(replicas_[0].size(), 0);
+}
+
+std::vector<std::vector<size_t>> Reducer::get_bucket_indices() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<std::vector<size_t>> bucket_indices;
+  bucket_indices.reserve(buckets_.size());
+  for (const auto& bucket : buckets_) {
+    bucket_indices.push_back(bucket.variable_indices);
+  }
+  return bucket_indices;
+}
+
+std::vector<std::vector<size_t>> Reducer::get_coalesced_groups() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<std::vector<size_t>> groups;
+  const auto& group_ends = adaptive_bucketing_.group_ends;
+  if (group_ends.size() != buckets_.size()) {
+    return groups;
+  }
+  for (size_t begin = 0; begin < group_ends.size(); begin = group_ends[begin]) {
+    groups.emplace_back();
+    for (size_t i = begin; i < group_ends[begin]; i++) {
+      groups.back().push_back(i);
+    }
+  }
+  return groups;
+}
+
 // See Note [DDP Communication Hook]
 void Reducer::register_comm_hook(std::unique_ptr<CommHookInterface> iface) {
   TORCH_CHECK(
       comm_hook_ == nullptr, "register_comm_hook can only be called once.");
+  TORCH_CHECK(
+      !adaptive_bucketing_.enabled,
+      "Communication hook cannot be used with adaptive bucketing.");
   // TODO(@sinannasir): Single process multiple device mode support for DDP
   // communication hook. Related to GH Issue #42542.
   TORCH_CHECK(
@@ -17,6 +17,7 @@ namespace c10d {
 
 constexpr int kDefaultFirstBucketBytes = int(1024 * 1024);
 constexpr int kDefaultBucketBytesCap = int(25 * 1024 * 1024);
+constexpr int kDefaultAdaptiveBucketingIterations = 10;
 
 class Reducer {
  public:
@@ -59,6 +60,20 @@ class Reducer {
   // be called once before calling backward.
   void register_comm_hook(std::unique_ptr<CommHookInterface> iface);
 
+  // Replaces the size based bucket assignment by one derived from the
+  // measured backward compute and allreduce times of the next
+  // `num_iterations` iterations, and coalesces the allreduce calls of
+  // buckets that become ready together if the process group supports it.
+  // See Note [Adaptive Bucketing]. Must be called before backward.
+  void enable_adaptive_bucketing(
+      int64_t num_iterations = kDefaultAdaptiveBucketingIterations);
+
+  // Returns the variable indices of every bucket, and the bucket indices of
+  // every group of buckets that is reduced with a single allreduce_coalesced
+  // call. The latter is empty unless adaptive bucketing has completed.
+  std::vector<std::vector<size_t>> get_bucket_indices();
+  std::vector<std::vector<size_t>> get_coalesced_groups();
+
  protected:
   // Forward declaration.
   struct Bucket;
@@ -119,6 +134,10 @@ class Reducer {
 
   void mark_bucket_ready(size_t bucket_index);
 
+  // Kicks off the reduction of the buckets in [begin, end), which are all
+  // ready. See Note [Adaptive Bucketing].
+  void launch_bucket_reductions(size_t begin, size_t end);
+
   void finalize_bucket_dense(Bucket& replica);
 
   void finalize_backward();
@@ -126,6 +145,13 @@ class Reducer {
   // Broadcast rebuilt buckets from rank 0 to other ranks before initializing
   // the buckets
   void sync_bucket_indices(std::vector<std::vector<size_t>>& bucket_indices);
+
+  // Broadcast the coalesced groups of the adaptive assignment from rank 0,
+  // see Note [Adaptive Bucketing]. Returns an empty vector if no buckets are
+  // coalesced.
+  std::vector<size_t> sync_group_ends(
+      const std::vector<size_t>& group_ends,
+      size_t num_buckets);
   // Rebuild buckets based on rebuilt_params_ and rebuilt_param_indices_
   // TODO this function makes broadcast communication call and
   // could be overlapped with next forward() call, thus
@@ -137,6 +163,11 @@ class Reducer {
   // the performance cost is negligible.
   std::vector<std::vector<size_t>> rebuildBuckets();
 
+  // Compute the bucket assignment with the shortest expected backward pass
+  // from the timings collected in the measured iterations, and sync it across
+  // ranks. See Note [Adaptive Bucketing].
+  std::vector<std::vector<size_t>> rebuildBucketsAdaptively();
+
   using GradCallback =
       torch::distributed::autograd::DistAutogradContext::GradCallback;
   void runGradCallbackForVariable(
@@ -248,6 +279,34 @@ class Reducer {
   std::vector<int64_t> rebuilt_param_indices_;
   const int64_t bucket_bytes_cap_;
 
+  // State of adaptive bucketing, see Note [Adaptive Bucketing].
+  struct AdaptiveBucketing {
+    // Whether enable_adaptive_bucketing() has been called.
+    bool enabled = false;
+    // Number of iterations still to be measured.
+    int64_t remaining_iterations = 0;
+    // Number of iterations measured so far.
+    int64_t measured_iterations = 0;
+    // Whether the current iteration is being measured.
+    bool measuring = false;
+    // For every bucket of the adaptive assignment, the index one past the
+    // last bucket of the coalesced group it belongs to. Computed by rank 0
+    // and broadcast with the assignment, so that all ranks issue the same
+    // collectives. Empty while buckets are reduced one by one, and cleared if
+    // the process group rejects allreduce_coalesced.
+    std::vector<size_t> group_ends;
+    // Time the first gradient of the measured iteration became ready, and
+    // the time spent in allreduce calls so far in this iteration.
+    int64_t backward_start = -1;
+    int64_t comm_time = 0;
+    // Sum over the measured iterations of the time each variable's gradient
+    // became ready, excluding the time spent in allreduce calls.
+    std::vector<int64_t> ready_times;
+    // Size in bytes and duration of every allreduce that was measured.
+    std::vector<std::pair<size_t, int64_t>> allreduce_times;
+  };
+  AdaptiveBucketing adaptive_bucketing_;
+
   struct RpcContext {
     using ContextPtr = torch::distributed::autograd::ContextPtr;
     // The shared_ptr is to hold the context instance.
@@ -399,33 +399,64 @@ PyObject* rpc_init(PyObject* /* unused */) {
                   :meth:`~torch.distributed.rpc.rpc_async` if necessary.
               init_method (str, optional): The URL to initialize
                   ``ProcessGroupGloo`` (default: ``env://``).
+              send_coalescing_bytes (int, optional): Messages to the same
+                  destination are packed into frames of up to this many bytes
+                  (default: 65536). A larger message is sent on its own, and
+                  0 sends every message on its own.
+              send_coalescing_delay (float, optional): How long, in seconds,
+                  a message may wait for other messages to the same
+                  destination to fill up its frame (default: 0). With no
+                  delay, only messages that are queued while the previous
+                  frame is being sent are packed together.
       )")
       .def(
-          py::init<int, float, std::string>(),
+          py::init<int, float, std::string, int64_t, float>(),
           py::arg("num_send_recv_threads") = kDefaultNumSendRecvThreads,
           py::arg("rpc_timeout") = kDefaultRpcTimeoutSeconds,
-          py::arg("init_method") = kDefaultInitMethod)
+          py::arg("init_method") = kDefaultInitMethod,
+          py::arg("send_coalescing_bytes") = kDefaultSendCoalescingBytes,
+          py::arg("send_coalescing_delay") = kDefaultSendCoalescingDelay)
       .def_readwrite(
           "num_send_recv_threads",
           &ProcessGroupRpcBackendOptions::numSendRecvThreads,
           R"(
               The number of threads in the thread-pool used by ProcessGroupAgent.
+          )")
+      .def_readwrite(
+          "send_coalescing_bytes",
+          &ProcessGroupRpcBackendOptions::sendCoalescingBytes,
+          R"(
+              The maximum size of a frame of coalesced messages.
+          )")
+      .def_readwrite(
+          "send_coalescing_delay",
+          &ProcessGroupRpcBackendOptions::sendCoalescingDelay,
+          R"(
+              How long, in seconds, a message may wait to be coalesced.
           )");
 
   module.attr("_DEFAULT_NUM_SEND_RECV_THREADS") =
       py::cast(kDefaultNumSendRecvThreads);
+  module.attr("_DEFAULT_SEND_COALESCING_BYTES") =
+      py::cast(kDefaultSendCoalescingBytes);
+  module.attr("_DEFAULT_SEND_COALESCING_DELAY") =
+      py::cast(kDefaultSendCoalescingDelay);
 
   shared_ptr_class_<ProcessGroupAgent>(module, "ProcessGroupAgent", rpcAgent)
       .def(py::init([](std::string workerName,
                        const std::shared_ptr<::c10d::ProcessGroup>& pg,
                        int numSendRecvThreads,
-                       std::chrono::milliseconds rpcTimeout) {
+                       std::chrono::milliseconds rpcTimeout,
+                       int64_t sendCoalescingBytes,
+                       std::chrono::microseconds sendCoalescingDelay) {
         return std::make_unique<ProcessGroupAgent>(
             std::move(workerName),
             pg,
             numSendRecvThreads,
             rpcTimeout,
-            std::make_unique<RequestCallbackImpl>());
+            std::make_unique<RequestCallbackImpl>(),
+            sendCoalescingBytes,
+            sendCoalescingDelay);
       }))
       .def(
           "get_worker_info",
@@ -589,6 +620,16 @@ PyObject* rpc_init(PyObject* /* unused */) {
     RRefContext::getInstance().destroyInstance(ignoreRRefLeak).clear();
   });
 
+  module.def(
+      "_set_rref_user_delete_batching",
+      [](std::chrono::milliseconds flushInterval, size_t maxBatchSize) {
+        RRefContext::getInstance().setUserDeleteBatching(
+            flushInterval, maxBatchSize);
+      },
+      py::arg("flush_interval"),
+      py::arg("max_batch_size") = 128,
+      py::call_guard<py::gil_scoped_release>());
+
   module.def("_rref_context_get_debug_info", []() {
     return RRefContext::getInstance().getDebugInfo();
   });
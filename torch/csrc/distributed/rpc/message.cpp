@@ -86,11 +86,13 @@ bool Message::isRequest() const {
       MessageType::RREF_USER_DELETE == type_ ||
       MessageType::RREF_CHILD_ACCEPT == type_ ||
       MessageType::RREF_FORK_REQUEST == type_ ||
+      MessageType::RREF_USER_DELETE_BATCH == type_ ||
       // Autograd message
       MessageType::BACKWARD_AUTOGRAD_REQ == type_ ||
       MessageType::FORWARD_AUTOGRAD_REQ == type_ ||
       // Cleanup Autograd context request
       MessageType::CLEANUP_AUTOGRAD_CONTEXT_REQ == type_ ||
+      MessageType::CLEANUP_AUTOGRAD_CONTEXTS_REQ == type_ ||
       // Run with profiling request
       MessageType::RUN_WITH_PROFILING_REQ == type_;
 }
@@ -56,6 +56,11 @@ enum MessageType {
   RUN_WITH_PROFILING_REQ = 21,
   RUN_WITH_PROFILING_RESP = 22,
 
+  // Batched versions of RREF_USER_DELETE and CLEANUP_AUTOGRAD_CONTEXT_REQ,
+  // acked with RREF_ACK and CLEANUP_AUTOGRAD_CONTEXT_RESP respectively.
+  RREF_USER_DELETE_BATCH = 23,
+  CLEANUP_AUTOGRAD_CONTEXTS_REQ = 24,
+
   // Other internal message types
   EXCEPTION = 55,
   UNKNOWN = 60
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <c10/util/Exception.h>
+#include <torch/csrc/distributed/rpc/types.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace torch {
+namespace distributed {
+namespace rpc {
+
+// Groups small control messages (e.g., RRef deletes, autograd context
+// cleanups) by destination worker, so that they can be sent as one message per
+// destination instead of one message per item.
+//
+// A batch is sent when it reaches maxBatchSize items, on the calling thread,
+// or by a background thread that flushes all batches every flushInterval. The
+// background thread is started on the first enqueue. Batching is disabled
+// when flushInterval is zero, which is the default. In that case, or after
+// stop(), enqueue() returns false and the caller is expected to send the item
+// itself.
+//
+// NB: Only messages that can be delayed without changing the protocol should
+// go through the batcher, because an item can wait up to flushInterval before
+// it is sent.
+template <typename T>
+class MessageBatcher {
+ public:
+  // Sends one batch to worker dst. Invoked without holding any lock of the
+  // batcher. Must not throw.
+  using SendFn = std::function<void(worker_id_t dst, std::vector<T> items)>;
+
+  struct Stats {
+    // Number of items waiting to be sent.
+    size_t queueDepth = 0;
+    // Number of batches sent, and the number of items in those batches.
+    int64_t numFlushes = 0;
+    int64_t numFlushedItems = 0;
+    // Time the oldest item of a batch waited before the batch was sent.
+    std::chrono::microseconds lastFlushLatency{0};
+    std::chrono::microseconds totalFlushLatency{0};
+  };
+
+  explicit MessageBatcher(SendFn sendFn) : sendFn_(std::move(sendFn)) {}
+
+  ~MessageBatcher() {
+    stop();
+  }
+
+  MessageBatcher(const MessageBatcher&) = delete;
+  MessageBatcher& operator=(const MessageBatcher&) = delete;
+
+  void configure(std::chrono::milliseconds flushInterval, size_t maxBatchSize) {
+    TORCH_CHECK(
+        flushInterval.count() >= 0, "flush interval must be non-negative");
+    TORCH_CHECK(maxBatchSize > 0, "max batch size must be positive");
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      flushInterval_ = flushInterval;
+      maxBatchSize_ = maxBatchSize;
+      // Re-arms a stopped batcher, e.g., when RPC is initialized again in
+      // the same process.
+      stop_ = false;
+    }
+    // Wake up the flush thread, so that it picks up the new interval.
+    flushCV_.notify_one();
+    // Nothing is enqueued once batching is disabled, send what is left.
+    if (flushInterval.count() == 0) {
+      flush();
+    }
+  }
+
+  bool enabled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return flushInterval_.count() > 0;
+  }
+
+  // Adds item to the batch of worker dst. Returns false, without taking the
+  // item, if batching is disabled or the batcher was stopped.
+  bool enqueue(worker_id_t dst, T item) {
+    std::vector<T> full;
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (flushInterval_.count() == 0 || stop_) {
+      return false;
+    }
+    if (!flushThread_.joinable()) {
+      flushThread_ = std::thread(&MessageBatcher::flushLoop, this);
+    }
+    auto& batch = batches_[dst];
+    if (batch.items.empty()) {
+      batch.firstEnqueueTime = std::chrono::steady_clock::now();
+    }
+    batch.items.emplace_back(std::move(item));
+    ++queueDepth_;
+    if (batch.items.size() >= maxBatchSize_) {
+      full = takeBatch(batch);
+    }
+    lock.unlock();
+
+    if (!full.empty()) {
+      sendFn_(dst, std::move(full));
+    }
+    return true;
+  }
+
+  // Sends all queued batches on the calling thread.
+  void flush() {
+    for (auto& entry : takeAllBatches()) {
+      sendFn_(entry.first, std::move(entry.second));
+    }
+  }
+
+  // Stops the flush thread and drops all queued items. Returns the number of
+  // dropped items. Until configure() is called again, enqueue() returns false
+  // and callers send items unbatched, even if a flush interval is set.
+  // Must not be called concurrently with configure().
+  size_t stop() {
+    std::thread flushThread;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+      flushThread.swap(flushThread_);
+    }
+    flushCV_.notify_one();
+    if (flushThread.joinable()) {
+      flushThread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto dropped = queueDepth_;
+    batches_.clear();
+    queueDepth_ = 0;
+    return dropped;
+  }
+
+  Stats stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto stats = stats_;
+    stats.queueDepth = queueDepth_;
+    return stats;
+  }
+
+ private:
+  struct Batch {
+    std::vector<T> items;
+    std::chrono::steady_clock::time_point firstEnqueueTime;
+  };
+
+  // Takes the items out of batch and records the flush. Must be called with
+  // mutex_ held.
+  std::vector<T> takeBatch(Batch& batch) {
+    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - batch.firstEnqueueTime);
+    ++stats_.numFlushes;
+    stats_.numFlushedItems += batch.items.size();
+    stats_.lastFlushLatency = latency;
+    stats_.totalFlushLatency += latency;
+    queueDepth_ -= batch.items.size();
+
+    std::vector<T> items;
+    items.swap(batch.items);
+    return items;
+  }
+
+  std::vector<std::pair<worker_id_t, std::vector<T>>> takeAllBatches() {
+    std::vector<std::pair<worker_id_t, std::vector<T>>> batches;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : batches_) {
+      if (!entry.second.items.empty()) {
+        batches.emplace_back(entry.first, takeBatch(entry.second));
+      }
+    }
+    return batches;
+  }
+
+  void flushLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+      if (flushInterval_.count() > 0) {
+        flushCV_.wait_for(lock, flushInterval_);
+      } else {
+        flushCV_.wait(
+            lock, [this] { return stop_ || flushInterval_.count() > 0; });
+      }
+      if (stop_) {
+        break;
+      }
+      lock.unlock();
+      flush();
+      lock.lock();
+    }
+  }
+
+  const SendFn sendFn_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable flushCV_;
+  std::thread flushThread_;
+  bool stop_ = false;
+
+  std::chrono::milliseconds flushInterval_{0};
+  size_t maxBatchSize_ = 1;
+
+  std::unordered_map<worker_id_t, Batch> batches_;
+  size_t queueDepth_ = 0;
+  Stats stats_;
+};
+
+} // namespace rpc
+} // namespace distributed
+} // namespace torch
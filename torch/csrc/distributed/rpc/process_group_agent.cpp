@@ -99,7 +99,9 @@ ProcessGroupAgent::ProcessGroupAgent(
     std::shared_ptr<c10d::ProcessGroup> pg,
     int numSendRecvThreads,
     std::chrono::milliseconds rpcTimeout,
-    std::unique_ptr<RequestCallback> cb)
+    std::unique_ptr<RequestCallback> cb,
+    int64_t sendCoalescingBytes,
+    std::chrono::microseconds sendCoalescingDelay)
     : RpcAgent(
           WorkerInfo(std::move(workerName), (int64_t)pg->getRank()),
           std::move(cb),
@@ -109,6 +111,9 @@ ProcessGroupAgent::ProcessGroupAgent(
       recvCounts_(pg_->getSize()),
       nextId_(0),
       sendMutexes_(pg_->getSize()),
+      sendQueues_(pg_->getSize()),
+      sendCoalescingBytes_(static_cast<size_t>(sendCoalescingBytes)),
+      sendCoalescingDelay_(sendCoalescingDelay),
       threadPool_(numSendRecvThreads),
       timeoutThreadEnabled_{false} {
   // initialize metric info counters
@@ -268,6 +273,12 @@ void ProcessGroupAgent::shutdownImpl() {
     }
   }
   listenerThread_.join();
+  // Stop holding back messages for coalescing, so that threads waiting for a
+  // frame to fill up send it right away.
+  for (auto& queue : sendQueues_) {
+    std::lock_guard<std::mutex> lock(queue.mutex_);
+    queue.cv_.notify_all();
+  }
   // Abort any pending sends to any destination rank that have not been
   // completed.
   {
@@ -389,39 +400,138 @@ std::shared_ptr<FutureMessage> ProcessGroupAgent::send(
   return future;
 }
 
-void ProcessGroupAgent::handleSend(const SendWork& work) {
-  auto serializedPayload = std::make_unique<std::string>(std::move(
-      wireSerialize(work.message_.payload(), work.message_.tensors())));
+ProcessGroupAgent::QueuedSend::QueuedSend(
+    SendWork&& work,
+    WireMessage&& wireMessage,
+    steady_clock_time_point deadline)
+    : work_(std::move(work)),
+      wireMessage_(std::move(wireMessage)),
+      size_(wireMessage_.header.size()),
+      deadline_(deadline) {
+  for (const auto& segment : wireMessage_.segments) {
+    size_ += segment.size;
+  }
+}
+
+bool ProcessGroupAgent::queueSend(QueuedSend&& queuedSend) {
+  auto& queue = sendQueues_[queuedSend.work_.to_.id_];
+  std::lock_guard<std::mutex> lock(queue.mutex_);
+  queue.size_ += queuedSend.size_;
+  queue.messages_.push_back(std::move(queuedSend));
+  if (queue.size_ >= sendCoalescingBytes_) {
+    queue.cv_.notify_one();
+  }
+  if (queue.flushing_) {
+    return false;
+  }
+  queue.flushing_ = true;
+  return true;
+}
+
+void ProcessGroupAgent::flushSendQueue(worker_id_t dst) {
+  auto& queue = sendQueues_[dst];
+  while (true) {
+    std::vector<QueuedSend> frame;
+    {
+      std::unique_lock<std::mutex> lock(queue.mutex_);
+      if (queue.messages_.empty()) {
+        queue.flushing_ = false;
+        return;
+      }
+      // Hold the frame back until it is full or its oldest message has used up
+      // the latency budget.
+      queue.cv_.wait_until(lock, queue.messages_.front().deadline_, [&] {
+        return queue.size_ >= sendCoalescingBytes_ || !rpcAgentRunning_.load();
+      });
+      size_t frameSize = 0;
+      while (!queue.messages_.empty() &&
+             (frame.empty() ||
+              frameSize + queue.messages_.front().size_ <=
+                  sendCoalescingBytes_)) {
+        frameSize += queue.messages_.front().size_;
+        frame.push_back(std::move(queue.messages_.front()));
+        queue.messages_.pop_front();
+      }
+      queue.size_ -= frameSize;
+    }
+
+    try {
+      sendFrame(dst, frame);
+    } catch (std::exception& e) {
+      for (const auto& queuedSend : frame) {
+        handleSendError(queuedSend.work_, e);
+      }
+    }
+  }
+}
+
+void ProcessGroupAgent::sendFrame(
+    worker_id_t dst,
+    std::vector<QueuedSend>& frame) {
+  // The frame header starts with the type, id and header size of every
+  // message, followed by the headers of the messages.
+  constexpr size_t kEntrySize = 3;
+  size_t frameHeaderSize = frame.size() * kEntrySize * sizeof(int64_t);
+  for (const auto& queuedSend : frame) {
+    frameHeaderSize += queuedSend.wireMessage_.header.size();
+  }
+  auto frameHeader =
+      torch::empty({static_cast<int64_t>(frameHeaderSize)}, {torch::kChar});
+  auto* entries = static_cast<int64_t*>(frameHeader.data_ptr());
+  auto* headers =
+      static_cast<char*>(frameHeader.data_ptr()) +
+      frame.size() * kEntrySize * sizeof(int64_t);
+  for (const auto& queuedSend : frame) {
+    const auto& header = queuedSend.wireMessage_.header;
+    *entries++ = (int64_t)queuedSend.work_.message_.type();
+    *entries++ = (int64_t)queuedSend.work_.message_.id();
+    *entries++ = (int64_t)header.size();
+    memcpy(headers, header.data(), header.size());
+    headers += header.size();
+  }
 
   std::vector<torch::Tensor> preamble = {torch::tensor(
       {(int64_t)pg_->getRank(),
-       (int64_t)serializedPayload->length(),
-       (int64_t)work.message_.type(),
-       (int64_t)work.message_.id()},
+       (int64_t)frame.size(),
+       (int64_t)frameHeaderSize},
       {torch::kInt64})};
 
+  std::vector<std::vector<torch::Tensor>> payloads;
+  payloads.push_back({frameHeader});
+  // The tensor data is not copied into the frame. It is sent straight from the
+  // tensor storages, one send per storage after the frame header.
+  for (auto& queuedSend : frame) {
+    for (auto& segment : queuedSend.wireMessage_.segments) {
+      // Empty segments are not sent, the receiver knows their size anyway.
+      if (segment.size == 0) {
+        continue;
+      }
+      // The deleter holds on to the owner until the send has completed.
+      auto owner = segment.owner;
+      payloads.push_back({torch::from_blob(
+          // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+          const_cast<char*>(segment.data),
+          segment.size,
+          [owner](void*) {},
+          {torch::kChar})});
+    }
+  }
+
   // ProcessGroup is not thread-safe when sending with the same tag,
   // hence the lock
   std::vector<std::shared_ptr<c10d::ProcessGroup::Work>> pendingSends;
-  const auto dst = work.to_.id_;
-
-  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
-  auto serializedPayloadData = const_cast<char*>(serializedPayload->data());
-  auto serializedPayloadSize = serializedPayload->size();
-  std::string* deleteWhenDone = serializedPayload.release();
-  std::vector<torch::Tensor> payload = {torch::from_blob(
-      reinterpret_cast<void*>(serializedPayloadData),
-      serializedPayloadSize,
-      [deleteWhenDone](void*) { delete deleteWhenDone; },
-      {torch::kChar})};
-  pendingSends.reserve(2);
+  pendingSends.reserve(1 + payloads.size());
 
-  sendCounts_.increment(dst);
+  for (size_t i = 0; i < frame.size(); ++i) {
+    sendCounts_.increment(dst);
+  }
 
   {
     std::lock_guard<std::mutex> guard(sendMutexes_[dst]);
     pendingSends.emplace_back(pg_->send(preamble, dst, dst /* channelTag */));
-    pendingSends.emplace_back(pg_->send(payload, dst, dst /* channelTag */));
+    for (auto& payload : payloads) {
+      pendingSends.emplace_back(pg_->send(payload, dst, dst /* channelTag */));
+    }
   }
   // Write pendingSends to a global map so that they can be interrupted by
   // ::shutdown().
@@ -451,6 +561,39 @@ void ProcessGroupAgent::handleSend(const SendWork& work) {
   }
 }
 
+void ProcessGroupAgent::handleSendError(
+    const SendWork& work,
+    const std::exception& e) {
+  auto errorStr = c10::str(
+      "Encountered exception in ProcessGroupAgent::enqueueSend: ",
+      e.what(),
+      " on node: ",
+      RpcAgent::getWorkerInfo().id_);
+  auto exceptionMsg =
+      rpc::createExceptionResponse(errorStr, work.message_.id());
+  if (work.message_.isRequest()) {
+    // Mark the future with corresponding to this request with an error.
+    markFutureWithError(exceptionMsg);
+  } else if (work.message_.isResponse()) {
+    // Try sending the error along, in a frame of its own so that it does not
+    // wait behind the messages queued in the meantime.
+    try {
+      auto wireMessage = wireSerializeSegments(
+          exceptionMsg.payload(), exceptionMsg.tensors());
+      std::vector<QueuedSend> frame;
+      frame.emplace_back(
+          SendWork(work.to_, std::move(exceptionMsg)),
+          std::move(wireMessage),
+          std::chrono::steady_clock::now());
+      sendFrame(work.to_.id_, frame);
+    } catch (std::exception& sendError) {
+      LOG(ERROR) << "Failed to send the error response for message "
+                 << work.message_.id() << " to node " << work.to_.id_ << ": "
+                 << sendError.what();
+    }
+  }
+}
+
 void ProcessGroupAgent::sendToSelf(Message&& message) {
   threadPool_.run(std::bind(
       [this](const Message& message) {
@@ -458,9 +601,21 @@ void ProcessGroupAgent::sendToSelf(Message&& message) {
         // data outlives the scope of this function. It's shared_ptr<> due
         // to c++11 lambda capture limitations with unique_ptr<>.
         std::unique_ptr<std::string> payload;
+        std::vector<torch::Tensor> segments;
         try {
+          auto wireMessage =
+              wireSerializeSegments(message.payload(), message.tensors());
           payload = std::make_unique<std::string>(
-              wireSerialize(message.payload(), message.tensors()));
+              std::move(wireMessage.header));
+          // The receiver must not share memory with the sender, so this is
+          // the one copy of the tensor data a local message needs.
+          for (const auto& segment : wireMessage.segments) {
+            segments.push_back(torch::empty(
+                {static_cast<int64_t>(segment.size)}, {torch::kChar}));
+            if (segment.size != 0) {
+              memcpy(segments.back().data_ptr(), segment.data, segment.size);
+            }
+          }
           // only increment sendCounts when the message is indeed added into
           // local recv.
           sendCounts_.increment(pg_->getRank());
@@ -479,7 +634,8 @@ void ProcessGroupAgent::sendToSelf(Message&& message) {
                 (void*)data,
                 len,
                 [delete_when_done](void*) { delete delete_when_done; },
-                {torch::kChar})));
+                {torch::kChar}),
+            std::move(segments)));
       },
       std::move(message)));
 }
@@ -487,24 +643,25 @@ void ProcessGroupAgent::sendToSelf(Message&& message) {
 void ProcessGroupAgent::enqueueSend(SendWork work) {
   // NB: this can be changed to use a native move capture when moved to C++14
   threadPool_.run(std::bind(
-      [this](const SendWork& work) {
+      [this](SendWork& work) {
+        const auto dst = work.to_.id_;
+        // The tensor data is not copied into the serialized message, the
+        // segments point into the tensor storages.
+        WireMessage wireMessage;
         try {
-          handleSend(work);
+          wireMessage = wireSerializeSegments(
+              work.message_.payload(), work.message_.tensors());
         } catch (std::exception& e) {
-          auto errorStr = c10::str(
-              "Encountered exception in ProcessGroupAgent::enqueueSend: ",
-              e.what(),
-              " on node: ",
-              RpcAgent::getWorkerInfo().id_);
-          auto exceptionMsg =
-              rpc::createExceptionResponse(errorStr, work.message_.id());
-          if (work.message_.isRequest()) {
-            // Mark the future with corresponding to this request with an error.
-            markFutureWithError(exceptionMsg);
-          } else if (work.message_.isResponse()) {
-            // Try sending the error along.
-            handleSend(SendWork(work.to_, std::move(exceptionMsg)));
-          }
+          handleSendError(work, e);
+          return;
+        }
+        // The first thread to find the queue idle sends everything that
+        // accumulates in it, the others return right away.
+        if (queueSend(QueuedSend(
+                std::move(work),
+                std::move(wireMessage),
+                std::chrono::steady_clock::now() + sendCoalescingDelay_))) {
+          flushSendQueue(dst);
         }
       },
       std::move(work)));
@@ -512,7 +669,8 @@ void ProcessGroupAgent::enqueueSend(SendWork work) {
 
 bool ProcessGroupAgent::handleRecv(RecvWork& work) {
   torch::Tensor& payload = work.payload_;
-  auto data = wireDeserialize(payload.storage().data(), payload.numel());
+  auto data = wireDeserializeSegments(
+      payload.data_ptr(), payload.numel(), work.segments_);
   Message message(
       std::move(data.first), std::move(data.second), work.type_, work.id_);
   if (message.isRequest()) {
@@ -715,8 +873,8 @@ void ProcessGroupAgent::listenLoop() {
 
 void ProcessGroupAgent::listenLoopInternal() {
   while (rpcAgentRunning_.load()) {
-    // rank, tensor size, message type
-    std::vector<torch::Tensor> preamble = {torch::empty({4}, {torch::kInt64})};
+    // rank, number of messages, frame header size
+    std::vector<torch::Tensor> preamble = {torch::empty({3}, {torch::kInt64})};
     auto work = pg_->recvAnysource(preamble, pg_->getRank());
     {
       // Write class variable so it can be aborted by shutdown()
@@ -731,24 +889,68 @@ void ProcessGroupAgent::listenLoopInternal() {
     int64_t* preamble_items = preamble.front().storage().data<int64_t>();
 
     auto srcRank = preamble_items[0];
-    auto size = preamble_items[1];
-    MessageType type = MessageType(preamble_items[2]);
-    int64_t id = preamble_items[3];
-
-    std::vector<torch::Tensor> tensors = {torch::empty({size}, {torch::kChar})};
-    work = pg_->recv(tensors, srcRank, pg_->getRank());
-    {
-      // Write class variable so it can be aborted by shutdown()
-      std::lock_guard<std::mutex> guard(recvWorkMutex_);
-      recvWork_ = work;
-    }
+    auto numMessages = preamble_items[1];
+    auto frameHeaderSize = preamble_items[2];
+
+    auto recv = [&](torch::Tensor& tensor) {
+      std::vector<torch::Tensor> tensors = {tensor};
+      auto work = pg_->recv(tensors, srcRank, pg_->getRank());
+      {
+        // Write class variable so it can be aborted by shutdown()
+        std::lock_guard<std::mutex> guard(recvWorkMutex_);
+        recvWork_ = work;
+      }
+      return rpcAgentRunning_.load() && work->wait() /* not aborted */;
+    };
 
-    if (!rpcAgentRunning_.load() || !work->wait() /* aborted */) {
+    auto frameHeader = torch::empty({frameHeaderSize}, {torch::kChar});
+    if (!recv(frameHeader)) {
       return;
     }
 
-    enqueueRecv(
-        RecvWork(allWorkerInfo_[srcRank], type, id, std::move(tensors[0])));
+    // Split the frame back into its messages, see sendFrame().
+    constexpr int64_t kEntryBytes = 3 * sizeof(int64_t);
+    TORCH_CHECK(
+        numMessages > 0 && numMessages <= frameHeaderSize / kEntryBytes,
+        "Received a malformed frame of ",
+        numMessages,
+        " messages from rank ",
+        srcRank);
+    int64_t offset = numMessages * kEntryBytes;
+    const auto* entries = static_cast<const int64_t*>(frameHeader.data_ptr());
+    for (int64_t i = 0; i < numMessages; ++i) {
+      MessageType type = MessageType(entries[3 * i]);
+      int64_t id = entries[3 * i + 1];
+      int64_t size = entries[3 * i + 2];
+      TORCH_CHECK(
+          size >= 0 && offset + size <= frameHeaderSize,
+          "Received a malformed frame of ",
+          numMessages,
+          " messages from rank ",
+          srcRank);
+      // The message headers stay views into the frame header.
+      auto header = frameHeader.narrow(0, offset, size);
+      offset += size;
+
+      // The tensor data follows in one message per tensor storage. Receive it
+      // into separate buffers that become the storages of the tensors.
+      std::vector<torch::Tensor> segments;
+      for (auto segmentSize : wireSegmentSizes(header.data_ptr(), size)) {
+        segments.push_back(
+            torch::empty({static_cast<int64_t>(segmentSize)}, {torch::kChar}));
+        // Empty segments are not sent.
+        if (segmentSize != 0 && !recv(segments.back())) {
+          return;
+        }
+      }
+
+      enqueueRecv(RecvWork(
+          allWorkerInfo_[srcRank],
+          type,
+          id,
+          std::move(header),
+          std::move(segments)));
+    }
   }
 }
 
@@ -4,8 +4,10 @@
 #include <c10d/ProcessGroup.hpp>
 #include <torch/csrc/distributed/rpc/request_callback.h>
 #include <torch/csrc/distributed/rpc/rpc_agent.h>
+#include <torch/csrc/distributed/rpc/utils.h>
 
 #include <atomic>
+#include <deque>
 #include <thread>
 
 namespace torch {
@@ -13,22 +15,43 @@ namespace distributed {
 namespace rpc {
 
 constexpr auto kDefaultNumSendRecvThreads = 4;
+// Messages to the same destination are packed into one frame of at most this
+// many bytes. A single larger message is sent in a frame of its own.
+constexpr int64_t kDefaultSendCoalescingBytes = 64 * 1024;
+// How long, in seconds, a message may wait for more messages to share its
+// frame. With no delay, only the messages that queue up while the previous
+// frame to the same destination is being sent are coalesced.
+constexpr float kDefaultSendCoalescingDelay = 0;
 
 struct ProcessGroupRpcBackendOptions : public RpcBackendOptions {
   ProcessGroupRpcBackendOptions(
       int num_send_recv_threads,
       float rpc_timeout,
-      std::string init_method)
+      std::string init_method,
+      int64_t send_coalescing_bytes = kDefaultSendCoalescingBytes,
+      float send_coalescing_delay = kDefaultSendCoalescingDelay)
       : RpcBackendOptions(rpc_timeout, init_method),
-        numSendRecvThreads(num_send_recv_threads) {
+        numSendRecvThreads(num_send_recv_threads),
+        sendCoalescingBytes(send_coalescing_bytes),
+        sendCoalescingDelay(send_coalescing_delay) {
     TORCH_CHECK(
         num_send_recv_threads > 0,
         "Cannot create ProcessGroup RPC backend with ",
         num_send_recv_threads,
         " threads in the thread-pool.");
+    TORCH_CHECK(
+        send_coalescing_bytes >= 0,
+        "send_coalescing_bytes must be non-negative, got ",
+        send_coalescing_bytes);
+    TORCH_CHECK(
+        send_coalescing_delay >= 0,
+        "send_coalescing_delay must be non-negative, got ",
+        send_coalescing_delay);
   }
 
   int numSendRecvThreads;
+  int64_t sendCoalescingBytes;
+  float sendCoalescingDelay;
 };
 
 // SendWork and RecvWork will be put into a task queue, and later picked up by
@@ -41,20 +64,28 @@ struct SendWork {
   Message message_;
 };
 
-// SendWork wraps a Message and RecvWork wraps a Tensor. The difference here is
+// SendWork wraps a Message and RecvWork wraps Tensors. The difference here is
 // to allow us to run serialization/deserialization in the worker threads.
+// The payload holds the header of the wire format and segments the tensor
+// data received into separate buffers, see wireSerializeSegments().
 struct RecvWork {
   RecvWork(
       const WorkerInfo& from,
       MessageType type,
       int64_t id,
-      torch::Tensor&& payload)
-      : from_(from), type_(type), id_(id), payload_(payload) {}
+      torch::Tensor&& payload,
+      std::vector<torch::Tensor>&& segments)
+      : from_(from),
+        type_(type),
+        id_(id),
+        payload_(payload),
+        segments_(std::move(segments)) {}
 
   const WorkerInfo& from_;
   const MessageType type_;
   const int64_t id_;
   torch::Tensor payload_;
+  std::vector<torch::Tensor> segments_;
 };
 
 class TORCH_API ProcessGroupAgent : public RpcAgent {
@@ -64,7 +95,10 @@ class TORCH_API ProcessGroupAgent : public RpcAgent {
       std::shared_ptr<c10d::ProcessGroup> pg,
       int numSendRecvThreads,
       std::chrono::milliseconds rpcTimeout,
-      std::unique_ptr<RequestCallback> cb);
+      std::unique_ptr<RequestCallback> cb,
+      int64_t sendCoalescingBytes = kDefaultSendCoalescingBytes,
+      std::chrono::microseconds sendCoalescingDelay =
+          std::chrono::microseconds(0));
 
   const WorkerInfo& getWorkerInfo(const std::string& workerName) const override;
 
@@ -87,7 +121,8 @@ class TORCH_API ProcessGroupAgent : public RpcAgent {
  protected:
   // This method wraps the destination information and the message into a
   // SendWork object, and put the SendWork into a queue. Another thread will
-  // consume SendWork from the queue and send it out.
+  // consume SendWork from the queue, add it to the send queue of the
+  // destination and send it out, possibly in a frame with other messages.
   std::shared_ptr<FutureMessage> send(
       const WorkerInfo& to,
       Message&& message,
@@ -95,7 +130,7 @@ class TORCH_API ProcessGroupAgent : public RpcAgent {
 
   // put SendWork into a queue and notify the worker thread
   virtual void enqueueSend(SendWork work);
-  // Bypass handleSend() logic and send a message to self rank
+  // Bypass the send queues and send a message to self rank
   virtual void sendToSelf(Message&& message);
 
  private:
@@ -110,6 +145,32 @@ class TORCH_API ProcessGroupAgent : public RpcAgent {
     std::mutex mutex_;
   };
 
+  // A message that has been serialized for the wire and waits in a SendQueue
+  // to be packed into a frame.
+  struct QueuedSend {
+    QueuedSend(
+        SendWork&& work,
+        WireMessage&& wireMessage,
+        steady_clock_time_point deadline);
+
+    SendWork work_;
+    WireMessage wireMessage_;
+    // Header and tensor bytes this message adds to a frame.
+    size_t size_;
+    // Latest time the frame carrying this message should be sent.
+    steady_clock_time_point deadline_;
+  };
+
+  // Messages waiting to be sent to one destination. At most one thread at a
+  // time, the one that found flushing_ unset, drains the queue.
+  struct SendQueue {
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<QueuedSend> messages_;
+    size_t size_{0};
+    bool flushing_{false};
+  };
+
   // TODO: this class should inherit from a MetricsTracker, and can be extended
   // to track num_sends, recvs, average size of messages, etc.
   struct AverageMetricsTracker {
@@ -147,10 +208,18 @@ class TORCH_API ProcessGroupAgent : public RpcAgent {
   };
 
   void collectNames();
-  // handle a SendWork request. This serializes the payload inside the work
-  // object, and sends the message to the receiver using the underlying
-  // ProcessGroup.
-  void handleSend(const SendWork& work);
+  // Add a serialized message to the send queue of its destination. Returns
+  // true if the caller has to drain the queue with flushSendQueue().
+  bool queueSend(QueuedSend&& queuedSend);
+  // Send the queued messages to dst, packing them into frames of at most
+  // sendCoalescingBytes_, until the queue is empty.
+  void flushSendQueue(worker_id_t dst);
+  // Send one frame holding the given messages to dst using the underlying
+  // ProcessGroup, and wait until the send has completed.
+  void sendFrame(worker_id_t dst, std::vector<QueuedSend>& frame);
+  // Fail the future of a request that could not be sent, or send the error
+  // back in place of a response that could not be sent.
+  void handleSendError(const SendWork& work, const std::exception& e);
   // put RecvWork into a queue and notify the worker thread
   void enqueueRecv(RecvWork work);
   // handle a RecvWork request. Return true if we should increment recvCounts,
@@ -224,6 +293,11 @@ class TORCH_API ProcessGroupAgent : public RpcAgent {
   // one mutex per ProcessGroup rank, as ProcessGroup::send is not thread-safe
   // when using the same tag.
   std::vector<std::mutex> sendMutexes_;
+  // one queue per ProcessGroup rank that coalesces outgoing messages.
+  std::vector<SendQueue> sendQueues_;
+  // Byte and latency budget of a frame, see ProcessGroupRpcBackendOptions.
+  const size_t sendCoalescingBytes_;
+  const std::chrono::microseconds sendCoalescingDelay_;
   std::thread listenerThread_;
   // A thread to poll existing futures and check for timed out ones.
   std::thread futureTimeoutThread_;
@@ -3,6 +3,7 @@
 #include <torch/csrc/distributed/autograd/engine/dist_engine.h>
 #include <torch/csrc/distributed/autograd/rpc_messages/cleanup_autograd_context_req.h>
 #include <torch/csrc/distributed/autograd/rpc_messages/cleanup_autograd_context_resp.h>
+#include <torch/csrc/distributed/autograd/rpc_messages/cleanup_autograd_contexts_req.h>
 #include <torch/csrc/distributed/autograd/rpc_messages/propagate_gradients_req.h>
 #include <torch/csrc/distributed/autograd/rpc_messages/propagate_gradients_resp.h>
 #include <torch/csrc/distributed/autograd/rpc_messages/rpc_with_autograd.h>
@@ -348,6 +349,16 @@ void RequestCallbackNoPython::processRpc(
       markComplete(std::move(RRefAck()).toMessage());
       return;
     }
+    case MessageType::RREF_USER_DELETE_BATCH: {
+      auto& rudb = static_cast<RRefUserDeleteBatch&>(rpc);
+      auto& ctx = RRefContext::getInstance();
+      for (const auto& fork : rudb.forks()) {
+        auto deletedRRef = ctx.delForkOfOwner(fork.first, fork.second);
+        handleRRefDelete(deletedRRef);
+      }
+      markComplete(std::move(RRefAck()).toMessage());
+      return;
+    }
     case MessageType::RREF_CHILD_ACCEPT: {
       auto& rca = static_cast<RRefChildAccept&>(rpc);
       auto& ctx = RRefContext::getInstance();
@@ -479,6 +490,15 @@ void RequestCallbackNoPython::processRpc(
       markComplete(std::move(CleanupAutogradContextResp()).toMessage());
       return;
     }
+    case MessageType::CLEANUP_AUTOGRAD_CONTEXTS_REQ: {
+      auto& cleanupContextsReq = static_cast<CleanupAutogradContextsReq&>(rpc);
+      auto& container = DistAutogradContainer::getInstance();
+      for (auto cleanupContextId : cleanupContextsReq.getContextIds()) {
+        container.releaseContextIfPresent(cleanupContextId);
+      }
+      markComplete(std::move(CleanupAutogradContextResp()).toMessage());
+      return;
+    }
     case MessageType::RUN_WITH_PROFILING_REQ: {
       auto& rpcWithProfilingReq = static_cast<RpcWithProfilingReq&>(rpc);
       auto wrappedMsgType = rpcWithProfilingReq.wrappedMessageType();
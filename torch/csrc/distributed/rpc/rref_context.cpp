@@ -75,6 +75,11 @@ const std::string kNumOwnerRRefs = "num_owner_rrefs";
 const std::string kNumPendingFutures = "num_pending_futures";
 const std::string kNumPendingUsers = "num_pending_users";
 const std::string kNumForks = "num_forks";
+const std::string kNumQueuedUserDeletes = "num_queued_user_deletes";
+const std::string kNumUserDeleteFlushes = "num_user_delete_flushes";
+const std::string kNumFlushedUserDeletes = "num_flushed_user_deletes";
+const std::string kUserDeleteFlushLatencyUs =
+    "avg_user_delete_flush_latency_us";
 
 RRefContext& RRefContext::getInstance() {
   // Leaky singleton to avoid module destructor races.
@@ -89,6 +94,8 @@ std::vector<c10::intrusive_ptr<RRef>> RRefContext::destroyInstance(
     std::lock_guard<std::mutex> lock(ctx.destroyedMutex_);
     ctx.destroyed_ = true;
   }
+  // Deletes that are still queued can't be sent anymore.
+  ctx.numPendingFutures_ -= ctx.userDeleteBatcher_.stop();
   ctx.checkRRefLeaks(ignoreRRefLeak);
   std::vector<c10::intrusive_ptr<RRef>> deletedRRefs;
   for (auto& entry : ctx.owners_) {
@@ -110,7 +117,13 @@ void RRefContext::handleException(const FutureMessage& fm) {
 }
 
 RRefContext::RRefContext(std::shared_ptr<RpcAgent> agent)
-    : agent_(std::move(agent)), destroyed_(false) {}
+    : agent_(std::move(agent)),
+      userDeleteBatcher_(
+          [this](
+              worker_id_t owner, std::vector<std::pair<RRefId, ForkId>> forks) {
+            sendUserDeleteBatch(owner, std::move(forks));
+          }),
+      destroyed_(false) {}
 
 RRefContext::~RRefContext() {
   if (!owners_.empty()) {
@@ -134,6 +147,15 @@ std::unordered_map<std::string, std::string> RRefContext::getDebugInfo() {
   info[kNumPendingFutures] = c10::to_string(numPendingFutures_.load());
   info[kNumPendingUsers] = c10::to_string(numPendingUsers);
   info[kNumForks] = c10::to_string(numForks);
+
+  auto stats = userDeleteBatcher_.stats();
+  info[kNumQueuedUserDeletes] = c10::to_string(stats.queueDepth);
+  info[kNumUserDeleteFlushes] = c10::to_string(stats.numFlushes);
+  info[kNumFlushedUserDeletes] = c10::to_string(stats.numFlushedItems);
+  info[kUserDeleteFlushLatencyUs] = c10::to_string(
+      stats.numFlushes == 0
+          ? 0
+          : stats.totalFlushLatency.count() / stats.numFlushes);
   return info;
 }
 
@@ -202,13 +224,28 @@ void RRefContext::delUser(
     const worker_id_t owner,
     const RRefId& rrefId,
     const ForkId& forkId) {
+  bool destroyed;
   {
     std::lock_guard<std::mutex> lock(destroyedMutex_);
-    if (!destroyed_) {
+    destroyed = destroyed_;
+    if (!destroyed) {
+      ++numPendingFutures_;
+    }
+  }
+  // NB: enqueue() may send a full batch on this thread, and
+  // sendUserDeleteBatch() acquires destroyedMutex_, so it must not be held
+  // here. If the context is destroyed in between, the batcher is stopped and
+  // either drops the delete or hands it to sendUserDeleteBatch(), which
+  // checks destroyed_ again.
+  if (!destroyed &&
+      !userDeleteBatcher_.enqueue(owner, std::make_pair(rrefId, forkId))) {
+    std::lock_guard<std::mutex> lock(destroyedMutex_);
+    if (destroyed_) {
+      --numPendingFutures_;
+    } else {
       // Sending an RRefUserDelete causes the receiver to run delForkOfOwner,
       // which is now idempotent. See the comment at RRefContext::delForkOfOwner
       // for more details.
-      ++numPendingFutures_;
       auto fm = agent_->sendWithRetries(
           agent_->getWorkerInfo(owner),
           RRefUserDelete(rrefId, forkId).toMessage());
@@ -224,6 +261,39 @@ void RRefContext::delUser(
   confirmedUsers_.erase(forkId);
 }
 
+void RRefContext::sendUserDeleteBatch(
+    worker_id_t owner,
+    std::vector<std::pair<RRefId, ForkId>> forks) {
+  const int64_t numForks = forks.size();
+  // This may run on the batcher's flush thread after destroyInstance().
+  std::lock_guard<std::mutex> lock(destroyedMutex_);
+  if (destroyed_) {
+    numPendingFutures_ -= numForks;
+    return;
+  }
+  try {
+    auto fm = agent_->sendWithRetries(
+        agent_->getWorkerInfo(owner),
+        RRefUserDeleteBatch(std::move(forks)).toMessage());
+
+    fm->addCallback([this, numForks](const FutureMessage& fm) {
+      numPendingFutures_ -= numForks;
+      handleException(fm);
+    });
+  } catch (const std::exception& e) {
+    // This runs on the batcher's flush thread, which must not throw.
+    LOG(ERROR) << "Failed to send " << numForks
+               << " UserRRef deletes to worker " << owner << ": " << e.what();
+    numPendingFutures_ -= numForks;
+  }
+}
+
+void RRefContext::setUserDeleteBatching(
+    std::chrono::milliseconds flushInterval,
+    size_t maxBatchSize) {
+  userDeleteBatcher_.configure(flushInterval, maxBatchSize);
+}
+
 void RRefContext::delAllUsersAndUnforkedOwners(
     std::chrono::milliseconds timeoutMillis) {
   // First, wait for all pending UserRRefs to be confirmed,
@@ -255,6 +325,9 @@ void RRefContext::delAllUsersAndUnforkedOwners(
     // tryDel() below will re-acquire lock, lock must be released here.
     rref_ptr->tryDel();
   }
+  // Don't wait for the flush interval, other workers are waiting for these
+  // deletes to release their OwnerRRefs.
+  userDeleteBatcher_.flush();
 
   // If an rref in the owners_ map has never been forked, we will never get a
   // corresponding message from the forking node(s) telling us to delete the
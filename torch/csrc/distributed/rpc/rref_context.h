@@ -2,6 +2,7 @@
 
 #include <c10/util/Optional.h>
 #include <torch/csrc/distributed/rpc/message.h>
+#include <torch/csrc/distributed/rpc/message_batcher.h>
 #include <torch/csrc/distributed/rpc/rpc_agent.h>
 #include <torch/csrc/distributed/rpc/rref_impl.h>
 #include <torch/csrc/distributed/rpc/types.h>
@@ -207,6 +208,16 @@ class TORCH_API RRefContext {
       const ForkId& forkId);
   void delAllUsersAndUnforkedOwners(std::chrono::milliseconds timeoutMillis);
 
+  // Batch RREF_USER_DELETE messages per owner. Deletes are sent when an
+  // owner's batch holds maxBatchSize deletes, or every flushInterval. A zero
+  // flushInterval sends every delete right away, which is the default.
+  // NB: Only deletes are batched. Fork requests and child accepts are not
+  // delayed, as pending UserRRefs block user functions until they are
+  // confirmed.
+  void setUserDeleteBatching(
+      std::chrono::milliseconds flushInterval,
+      size_t maxBatchSize);
+
   std::unordered_map<std::string, std::string> getDebugInfo();
 
  private:
@@ -234,6 +245,11 @@ class TORCH_API RRefContext {
 
   void finishForkRequest(const ForkId& forkId, worker_id_t parent);
 
+  // Sends one RREF_USER_DELETE_BATCH message to owner.
+  void sendUserDeleteBatch(
+      worker_id_t owner,
+      std::vector<std::pair<RRefId, ForkId>> forks);
+
   // If there is any leak on any RRef, this method will throw an error.
   void checkRRefLeaks(bool ignoreRRefLeak);
 
@@ -299,8 +315,13 @@ class TORCH_API RRefContext {
   // lagging a bit behind what it is intended to be, while it waits for these
   // requests to complete. To allow syncing when needed, we store the count of
   // these pending requests, so that users can wait for it to reach zero.
+  // Deletes waiting in userDeleteBatcher_ are counted as pending futures as
+  // well.
   std::atomic<int64_t> numPendingFutures_{0};
 
+  // Batches of RREF_USER_DELETE messages, keyed by owner.
+  MessageBatcher<std::pair<RRefId, ForkId>> userDeleteBatcher_;
+
   std::mutex destroyedMutex_;
   bool destroyed_;
 
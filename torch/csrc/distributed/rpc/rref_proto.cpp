@@ -161,6 +161,37 @@ std::unique_ptr<RRefUserDelete> RRefUserDelete::fromMessage(
       RRefUserDelete(pair.first, pair.second));
 }
 
+const std::vector<std::pair<RRefId, ForkId>>& RRefUserDeleteBatch::forks()
+    const {
+  return forks_;
+}
+
+Message RRefUserDeleteBatch::toMessageImpl() && {
+  std::vector<at::IValue> ivalues;
+  ivalues.reserve(forks_.size() * 2);
+  for (const auto& fork : forks_) {
+    ivalues.emplace_back(fork.first.toIValue());
+    ivalues.emplace_back(fork.second.toIValue());
+  }
+  return fromIValues(std::move(ivalues), MessageType::RREF_USER_DELETE_BATCH);
+}
+
+std::unique_ptr<RRefUserDeleteBatch> RRefUserDeleteBatch::fromMessage(
+    const Message& message) {
+  auto ivalues = toIValues(message, MessageType::RREF_USER_DELETE_BATCH);
+  TORCH_INTERNAL_ASSERT(
+      ivalues.size() % 2 == 0,
+      "RRefUserDeleteBatch expects pairs of IValues from message.");
+
+  std::vector<std::pair<RRefId, ForkId>> forks;
+  forks.reserve(ivalues.size() / 2);
+  for (size_t i = 0; i < ivalues.size(); i += 2) {
+    forks.emplace_back(
+        RRefId::fromIValue(ivalues[i]), ForkId::fromIValue(ivalues[i + 1]));
+  }
+  return std::make_unique<RRefUserDeleteBatch>(std::move(forks));
+}
+
 std::unique_ptr<RemoteRet> RemoteRet::fromMessage(const Message& message) {
   auto pair = ForkMessageBase::fromMessage(message, MessageType::REMOTE_RET);
   return std::make_unique<RemoteRet>(pair.first, pair.second);
@@ -123,6 +123,23 @@ class TORCH_API RRefUserDelete final : public ForkMessageBase {
   static std::unique_ptr<RRefUserDelete> fromMessage(const Message& message);
 };
 
+// Batched version of RRefUserDelete. A worker uses this message to notify an
+// owner about several deleted UserRRefs at once.
+class TORCH_API RRefUserDeleteBatch final : public RpcCommandBase {
+ public:
+  explicit RRefUserDeleteBatch(std::vector<std::pair<RRefId, ForkId>> forks)
+      : forks_(std::move(forks)) {}
+
+  const std::vector<std::pair<RRefId, ForkId>>& forks() const;
+
+  Message toMessageImpl() && override;
+  static std::unique_ptr<RRefUserDeleteBatch> fromMessage(
+      const Message& message);
+
+ private:
+  const std::vector<std::pair<RRefId, ForkId>> forks_;
+};
+
 class TORCH_API RemoteRet final : public ForkMessageBase {
  public:
   RemoteRet(const RRefId& rrefId, const ForkId& forkId)
@@ -132,8 +132,11 @@ MessageType FaultyProcessGroupAgent::messageStringToType(
       {"RREF_FORK_REQUEST", MessageType::RREF_FORK_REQUEST},
       {"RREF_CHILD_ACCEPT", MessageType::RREF_CHILD_ACCEPT},
       {"RREF_USER_DELETE", MessageType::RREF_USER_DELETE},
+      {"RREF_USER_DELETE_BATCH", MessageType::RREF_USER_DELETE_BATCH},
       {"CLEANUP_AUTOGRAD_CONTEXT_REQ",
        MessageType::CLEANUP_AUTOGRAD_CONTEXT_REQ},
+      {"CLEANUP_AUTOGRAD_CONTEXTS_REQ",
+       MessageType::CLEANUP_AUTOGRAD_CONTEXTS_REQ},
       {"PYTHON_REMOTE_CALL", MessageType::PYTHON_REMOTE_CALL},
       {"SCRIPT_REMOTE_CALL", MessageType::SCRIPT_REMOTE_CALL},
       {"PYTHON_CALL", MessageType::PYTHON_CALL},
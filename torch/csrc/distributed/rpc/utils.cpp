@@ -4,6 +4,7 @@
 #include <torch/csrc/autograd/profiler.h>
 #include <torch/csrc/distributed/autograd/rpc_messages/cleanup_autograd_context_req.h>
 #include <torch/csrc/distributed/autograd/rpc_messages/cleanup_autograd_context_resp.h>
+#include <torch/csrc/distributed/autograd/rpc_messages/cleanup_autograd_contexts_req.h>
 #include <torch/csrc/distributed/autograd/rpc_messages/propagate_gradients_req.h>
 #include <torch/csrc/distributed/autograd/rpc_messages/propagate_gradients_resp.h>
 #include <torch/csrc/distributed/autograd/rpc_messages/rpc_with_autograd.h>
@@ -134,6 +135,9 @@ std::unique_ptr<RpcCommandBase> deserializeRequest(const Message& request) {
     case MessageType::RREF_FORK_REQUEST: {
       return RRefForkRequest::fromMessage(request);
     }
+    case MessageType::RREF_USER_DELETE_BATCH: {
+      return RRefUserDeleteBatch::fromMessage(request);
+    }
     case MessageType::FORWARD_AUTOGRAD_REQ: {
       return autograd::RpcWithAutograd::fromMessage(request);
     }
@@ -143,6 +147,9 @@ std::unique_ptr<RpcCommandBase> deserializeRequest(const Message& request) {
     case MessageType::CLEANUP_AUTOGRAD_CONTEXT_REQ: {
       return autograd::CleanupAutogradContextReq::fromMessage(request);
     }
+    case MessageType::CLEANUP_AUTOGRAD_CONTEXTS_REQ: {
+      return autograd::CleanupAutogradContextsReq::fromMessage(request);
+    }
     case MessageType::RUN_WITH_PROFILING_REQ: {
       return autograd::RpcWithProfilingReq::fromMessage(request);
     }
@@ -259,11 +266,11 @@ namespace {
 //
 // Note that per the header comments, the format is subject to change,
 // and is best used for rpcs, rather than persistent disk storage.
-std::unordered_map<std::string, std::pair<const char*, size_t>>
-parseWireSections(const void* data, size_t data_size) {
-  const char* ptr = static_cast<const char*>(data);
-  const char* endp = ptr + data_size;
-
+// Parses the section table at the start of a wire message and advances ptr
+// past it. Returns the name and size of every section in order.
+std::vector<std::pair<std::string, size_t>> parseWireHeader(
+    const char*& ptr,
+    const char* endp) {
   std::vector<std::pair<std::string, size_t>> headerEnts;
   bool ok = false;
   while (ptr != endp) {
@@ -299,6 +306,15 @@ parseWireSections(const void* data, size_t data_size) {
   if (!ok) {
     throw std::runtime_error("failed parse");
   }
+  return headerEnts;
+}
+
+std::unordered_map<std::string, std::pair<const char*, size_t>>
+parseWireSections(const void* data, size_t data_size) {
+  const char* ptr = static_cast<const char*>(data);
+  const char* endp = ptr + data_size;
+
+  auto headerEnts = parseWireHeader(ptr, endp);
 
   std::unordered_map<std::string, std::pair<const char*, size_t>> out;
   for (const auto& headerEnt : headerEnts) {
@@ -313,6 +329,61 @@ parseWireSections(const void* data, size_t data_size) {
 
 static const char* kMeta = "meta";
 static const char* kPayload = "payload";
+
+// Rebuilds the payload and the tensors from the "payload" and "meta"
+// sections. The data of every tensor section is obtained from
+// sectionReadFunc.
+std::pair<std::vector<char>, std::vector<at::Tensor>> deserializeWireSections(
+    const std::unordered_map<std::string, std::pair<const char*, size_t>>&
+        sections,
+    const std::function<at::DataPtr(const std::string&)>& sectionReadFunc) {
+  std::vector<char> payload;
+  auto payloadIt = sections.find(kPayload);
+  if (payloadIt != sections.end() && payloadIt->second.second != 0) {
+    payload.assign(
+        payloadIt->second.first,
+        payloadIt->second.first + payloadIt->second.second);
+  }
+
+  std::vector<at::Tensor> tensors;
+  auto metaIt = sections.find(kMeta);
+  if (metaIt != sections.end()) {
+    const auto& metaData = metaIt->second;
+    size_t metaDataPos = 0;
+    auto metaDataReadFunc = [&](char* buf, size_t n) -> size_t {
+      if (metaDataPos >= metaData.second || n == 0) {
+        return 0;
+      }
+      size_t toCopy = std::min(metaDataPos + n, metaData.second) - metaDataPos;
+      memcpy(buf, metaData.first + metaDataPos, toCopy);
+      metaDataPos += toCopy;
+      return toCopy;
+    };
+
+    // No need to pass typeResolver here, as it always processes string and
+    // tensors only
+    torch::jit::Unpickler unpickler(
+        metaDataReadFunc, nullptr, nullptr, sectionReadFunc, {});
+    auto ival = unpickler.parse_ivalue();
+    for (auto&& t : ival.toTensorList()) {
+      tensors.emplace_back(std::move(t));
+    }
+  }
+  return {std::move(payload), std::move(tensors)};
+}
+
+// A DataPtr to the memory of a tensor that keeps its storage alive.
+at::DataPtr shareStorage(const at::Tensor& tensor) {
+  if (tensor.numel() == 0) {
+    return at::getCPUAllocator()->allocate(0);
+  }
+  auto ctx = new c10::Storage(tensor.storage());
+  return at::DataPtr(
+      tensor.data_ptr(),
+      ctx,
+      [](void* ctx) { delete static_cast<c10::Storage*>(ctx); },
+      tensor.device());
+}
 }; // namespace
 
 c10::List<at::Tensor> cloneSparseTensors(
@@ -339,7 +410,7 @@ c10::List<at::Tensor> cloneSparseTensors(
   return pTensors;
 }
 
-std::string wireSerialize(
+WireMessage wireSerializeSegments(
     const std::vector<char>& payload,
     const std::vector<at::Tensor>& tensors) {
   for (const auto& tensor : tensors) {
@@ -353,15 +424,14 @@ std::string wireSerialize(
 
   struct Ent {
     std::string name;
-    const char* data;
     size_t size;
   };
   std::vector<Ent> entries;
   std::string metaEntry;
-  std::vector<at::Tensor> tensorData;
+  WireMessage out;
 
   if (!payload.empty()) {
-    entries.push_back({kPayload, payload.data(), payload.size()});
+    entries.push_back({kPayload, payload.size()});
   }
 
   if (!tensors.empty()) {
@@ -372,39 +442,51 @@ std::string wireSerialize(
     pickler.protocol();
     pickler.pushIValue(cloneSparseTensors(tensors));
     pickler.stop();
-    tensorData = pickler.tensorData();
-    entries.push_back({kMeta, metaEntry.data(), metaEntry.size()});
+    entries.push_back({kMeta, metaEntry.size()});
+    const auto& tensorData = pickler.tensorData();
     for (size_t i = 0; i < tensorData.size(); i++) {
-      // Construct WritableTensorData for each tensor in the pickler tensorData
-      // Since tensorData is in function scope, and getWritableTensorData just
-      // record the tensors, the data() pointers stay valid for CPU tensors
+      // Construct WritableTensorData for each tensor in the pickler tensorData.
+      // For CPU tensors it refers to the storage of the tensor itself, so
+      // keeping the tensor as the owner keeps the data() pointer valid.
       // Note that RPC serde doesn't support CUDA tensors yet, if we should
       // support CUDA tensor, we need to be careful since getWritableTensorData
-      // converts CUDA tensor to cpu and data() might get destructed as we go
-      // out of scope of this loop.
+      // converts CUDA tensor to cpu and the owner would have to be the copy.
       auto writeableTensorData = jit::getWriteableTensorData(tensorData[i]);
-      entries.push_back({c10::to_string(i),
-                         writeableTensorData.data(),
-                         writeableTensorData.sizeInBytes()});
+      entries.push_back({c10::to_string(i), writeableTensorData.sizeInBytes()});
+      out.segments.push_back({writeableTensorData.data(),
+                              writeableTensorData.sizeInBytes(),
+                              tensorData[i]});
     }
   }
 
-  std::string header;
-  size_t tot = 0;
+  auto& header = out.header;
   for (const auto& e : entries) {
-    tot += e.size;
     header.append(e.name)
         .append(" ")
         .append(c10::to_string(e.size))
         .append("\n");
   }
   header.push_back('\n');
+  header.reserve(header.size() + payload.size() + metaEntry.size());
+  header.append(payload.data(), payload.size());
+  header.append(metaEntry);
+  return out;
+}
+
+std::string wireSerialize(
+    const std::vector<char>& payload,
+    const std::vector<at::Tensor>& tensors) {
+  auto wireMessage = wireSerializeSegments(payload, tensors);
+  size_t tot = wireMessage.header.size();
+  for (const auto& segment : wireMessage.segments) {
+    tot += segment.size;
+  }
 
   std::string out;
-  out.reserve(header.size() + tot);
-  out.append(header);
-  for (const auto& e : entries) {
-    out.append(e.data, e.size);
+  out.reserve(tot);
+  out.append(wireMessage.header);
+  for (const auto& segment : wireMessage.segments) {
+    out.append(segment.data, segment.size);
   }
   return out;
 }
@@ -413,52 +495,74 @@ std::pair<std::vector<char>, std::vector<at::Tensor>> wireDeserialize(
     const void* data,
     size_t data_size) {
   auto sections = parseWireSections(data, data_size);
+  auto sectionReadFunc = [&](const std::string& ename) -> at::DataPtr {
+    auto it = sections.find(ename);
+    if (it == sections.end()) {
+      throw std::runtime_error("Couldn't find entity " + ename);
+    }
+    const auto& idat = it->second;
+    auto dptr = at::getCPUAllocator()->allocate(idat.second);
+    if (idat.second != 0) {
+      memcpy(dptr.get(), idat.first, idat.second);
+    }
+    return dptr;
+  };
+  return deserializeWireSections(sections, sectionReadFunc);
+}
 
-  std::vector<char> payload;
-  auto payloadIt = sections.find(kPayload);
-  if (payloadIt != sections.end() && payloadIt->second.second != 0) {
-    payload.assign(
-        payloadIt->second.first,
-        payloadIt->second.first + payloadIt->second.second);
+std::vector<size_t> wireSegmentSizes(const void* header, size_t headerSize) {
+  const char* ptr = static_cast<const char*>(header);
+  auto headerEnts = parseWireHeader(ptr, ptr + headerSize);
+  std::vector<size_t> sizes;
+  for (const auto& headerEnt : headerEnts) {
+    if (headerEnt.first != kPayload && headerEnt.first != kMeta) {
+      sizes.push_back(headerEnt.second);
+    }
   }
+  return sizes;
+}
 
-  std::vector<at::Tensor> tensors;
-  auto metaIt = sections.find(kMeta);
-  if (metaIt != sections.end()) {
-    const auto& metaData = metaIt->second;
-    size_t metaDataPos = 0;
-    auto metaDataReadFunc = [&](char* buf, size_t n) -> size_t {
-      if (metaDataPos >= metaData.second || n == 0) {
-        return 0;
-      }
-      size_t toCopy = std::min(metaDataPos + n, metaData.second) - metaDataPos;
-      memcpy(buf, metaData.first + metaDataPos, toCopy);
-      metaDataPos += toCopy;
-      return toCopy;
-    };
-    auto sectionReadFunc = [&](const std::string& ename) -> at::DataPtr {
-      auto it = sections.find(ename);
-      if (it == sections.end()) {
-        throw std::runtime_error("Couldn't find entity " + ename);
+std::pair<std::vector<char>, std::vector<at::Tensor>> wireDeserializeSegments(
+    const void* header,
+    size_t headerSize,
+    const std::vector<at::Tensor>& segments) {
+  const char* ptr = static_cast<const char*>(header);
+  const char* endp = ptr + headerSize;
+  auto headerEnts = parseWireHeader(ptr, endp);
+
+  // The payload and the metadata follow the section table in the header,
+  // every other section is one of the segments, in order.
+  std::unordered_map<std::string, std::pair<const char*, size_t>> sections;
+  std::unordered_map<std::string, size_t> segmentIndices;
+  for (const auto& headerEnt : headerEnts) {
+    if (headerEnt.first == kPayload || headerEnt.first == kMeta) {
+      if (headerEnt.second > static_cast<size_t>(endp - ptr)) {
+        throw std::runtime_error("failed bounds");
       }
-      const auto& idat = it->second;
-      auto dptr = at::getCPUAllocator()->allocate(idat.second);
-      if (idat.second != 0) {
-        memcpy(dptr.get(), idat.first, idat.second);
+      sections[headerEnt.first] = {ptr, headerEnt.second};
+      ptr += headerEnt.second;
+    } else {
+      const auto index = segmentIndices.size();
+      if (index >= segments.size() ||
+          segments[index].nbytes() != headerEnt.second) {
+        throw std::runtime_error("failed bounds");
       }
-      return dptr;
-    };
-
-    // No need to pass typeResolver here, as it always processes string and
-    // tensors only
-    torch::jit::Unpickler unpickler(
-        metaDataReadFunc, nullptr, nullptr, sectionReadFunc, {});
-    auto ival = unpickler.parse_ivalue();
-    for (auto&& t : ival.toTensorList()) {
-      tensors.emplace_back(std::move(t));
+      segmentIndices[headerEnt.first] = index;
     }
   }
-  return {std::move(payload), std::move(tensors)};
+  if (ptr != endp || segmentIndices.size() != segments.size()) {
+    throw std::runtime_error("failed bounds");
+  }
+
+  // Tensors are created directly over the received segments.
+  auto sectionReadFunc = [&](const std::string& ename) -> at::DataPtr {
+    auto it = segmentIndices.find(ename);
+    if (it == segmentIndices.end()) {
+      throw std::runtime_error("Couldn't find entity " + ename);
+    }
+    return shareStorage(segments[it->second]);
+  };
+  return deserializeWireSections(sections, sectionReadFunc);
 }
 
 #ifdef USE_TENSORPIPE
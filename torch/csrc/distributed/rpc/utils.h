@@ -53,6 +53,41 @@ TORCH_API std::pair<std::vector<char>, std::vector<at::Tensor>> wireDeserialize(
     const void* data,
     size_t data_size);
 
+// The wire format split for vectored I/O. The header holds the section table,
+// the payload and the pickled tensor metadata, while the tensor data is not
+// copied but referenced by one segment per tensor storage. Sending the header
+// followed by the data of all segments yields what wireSerialize() produces.
+struct WireSegment {
+  const char* data;
+  size_t size;
+  // Keeps the memory data points to alive.
+  at::Tensor owner;
+};
+
+struct WireMessage {
+  std::string header;
+  std::vector<WireSegment> segments;
+};
+
+TORCH_API WireMessage wireSerializeSegments(
+    const std::vector<char>& payload,
+    const std::vector<at::Tensor>& tensors);
+
+// The sizes of the segments that belong to a header produced by
+// wireSerializeSegments(), so a receiver can allocate them up front.
+TORCH_API std::vector<size_t> wireSegmentSizes(
+    const void* header,
+    size_t headerSize);
+
+// Inverse of wireSerializeSegments(). The segments are 1-D byte tensors with
+// the sizes given by wireSegmentSizes(). The resulting tensors are created
+// directly over their memory instead of copying it out.
+TORCH_API std::pair<std::vector<char>, std::vector<at::Tensor>>
+wireDeserializeSegments(
+    const void* header,
+    size_t headerSize,
+    const std::vector<at::Tensor>& segments);
+
 // We use vector<char> as the type of blobs because it's what rpc::Message uses
 // for its payload, even though it has the disadvantage that it cannot be
 // allocated with uninitialized memory: it is always zeroed out.
@@ -0,0 +1,368 @@
+#include <torch/csrc/jit/mobile/flat_bytecode.h>
+
+#include <torch/csrc/jit/serialization/import_export_constants.h>
+
+#include <cstring>
+
+namespace torch {
+namespace jit {
+
+OpCode parseOpCode(const char* str);
+
+namespace mobile {
+
+namespace {
+
+static_assert(
+    sizeof(Instruction) == 8 && alignof(Instruction) <= 4,
+    "The flat bytecode format stores instructions as 8 byte records");
+
+enum class FlatConstantTag : uint8_t {
+  None = 0,
+  Bool = 1, // u8
+  Int = 2, // i64
+  Double = 3, // f64
+  String = 4, // str
+  Device = 5, // str, as printed by c10::Device
+  IntList = 6, // u32 n, i64[n]
+  DoubleList = 7, // u32 n, f64[n]
+  BoolList = 8, // u32 n, u8[n] padded to 4
+};
+
+class FlatWriter {
+ public:
+  template <typename T>
+  void write(T value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    buffer_.append(bytes, sizeof(T));
+  }
+
+  void writeBytes(const void* data, size_t size) {
+    buffer_.append(static_cast<const char*>(data), size);
+  }
+
+  void writeString(const std::string& str) {
+    write<uint32_t>(str.size());
+    buffer_.append(str);
+    pad();
+  }
+
+  void pad() {
+    buffer_.append((4 - buffer_.size() % 4) % 4, '\0');
+  }
+
+  std::string release() {
+    return std::move(buffer_);
+  }
+
+ private:
+  std::string buffer_;
+};
+
+class FlatReader {
+ public:
+  FlatReader(const char* data, size_t size) : data_(data), size_(size) {}
+
+  template <typename T>
+  T read() {
+    T value;
+    std::memcpy(&value, take(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  const char* take(size_t size) {
+    TORCH_CHECK(
+        size <= size_ - pos_, "Flat bytecode section is truncated");
+    const char* ptr = data_ + pos_;
+    pos_ += size;
+    return ptr;
+  }
+
+  // Reads the number of records of a table whose records take at least
+  // record_size bytes each, so that a corrupt count fails before anything is
+  // allocated for it.
+  uint32_t readCount(size_t record_size) {
+    auto count = read<uint32_t>();
+    TORCH_CHECK(
+        count <= (size_ - pos_) / record_size,
+        "Flat bytecode section is truncated");
+    return count;
+  }
+
+  std::string readString() {
+    auto size = read<uint32_t>();
+    std::string str(take(size), size);
+    skipPadding();
+    return str;
+  }
+
+  void skipPadding() {
+    take((4 - pos_ % 4) % 4);
+  }
+
+  bool done() const {
+    return pos_ == size_;
+  }
+
+ private:
+  const char* data_;
+  size_t size_;
+  size_t pos_ = 0;
+};
+
+c10::IValue expectField(
+    const c10::IValue& tup,
+    const std::string& expected_name,
+    size_t entry) {
+  auto row = tup.toTuple()->elements().at(entry).toTuple();
+  TORCH_INTERNAL_ASSERT(
+      row->elements().at(0).toStringRef() == expected_name,
+      "Expected ",
+      expected_name,
+      " found ",
+      row->elements().at(0).toStringRef());
+  return row->elements().at(1);
+}
+
+bool writeConstant(FlatWriter& writer, const c10::IValue& constant) {
+  auto tag = [&](FlatConstantTag t) {
+    writer.write<uint8_t>(static_cast<uint8_t>(t));
+    writer.pad();
+  };
+  if (constant.isNone()) {
+    tag(FlatConstantTag::None);
+  } else if (constant.isBool()) {
+    tag(FlatConstantTag::Bool);
+    writer.write<uint8_t>(constant.toBool());
+    writer.pad();
+  } else if (constant.isInt()) {
+    tag(FlatConstantTag::Int);
+    writer.write<int64_t>(constant.toInt());
+  } else if (constant.isDouble()) {
+    tag(FlatConstantTag::Double);
+    writer.write<double>(constant.toDouble());
+  } else if (constant.isString()) {
+    tag(FlatConstantTag::String);
+    writer.writeString(constant.toStringRef());
+  } else if (constant.isDevice()) {
+    tag(FlatConstantTag::Device);
+    writer.writeString(constant.toDevice().str());
+  } else if (constant.isIntList()) {
+    tag(FlatConstantTag::IntList);
+    auto list = constant.toIntVector();
+    writer.write<uint32_t>(list.size());
+    writer.writeBytes(list.data(), list.size() * sizeof(int64_t));
+  } else if (constant.isDoubleList()) {
+    tag(FlatConstantTag::DoubleList);
+    auto list = constant.toDoubleVector();
+    writer.write<uint32_t>(list.size());
+    writer.writeBytes(list.data(), list.size() * sizeof(double));
+  } else if (constant.isBoolList()) {
+    tag(FlatConstantTag::BoolList);
+    auto list = constant.toBoolList();
+    writer.write<uint32_t>(list.size());
+    for (bool b : list) {
+      writer.write<uint8_t>(b);
+    }
+    writer.pad();
+  } else {
+    return false;
+  }
+  return true;
+}
+
+c10::IValue readConstant(FlatReader& reader) {
+  auto tag = static_cast<FlatConstantTag>(reader.read<uint8_t>());
+  reader.skipPadding();
+  switch (tag) {
+    case FlatConstantTag::None:
+      return c10::IValue();
+    case FlatConstantTag::Bool: {
+      bool value = reader.read<uint8_t>();
+      reader.skipPadding();
+      return value;
+    }
+    case FlatConstantTag::Int:
+      return reader.read<int64_t>();
+    case FlatConstantTag::Double:
+      return reader.read<double>();
+    case FlatConstantTag::String:
+      return reader.readString();
+    case FlatConstantTag::Device:
+      return c10::Device(reader.readString());
+    case FlatConstantTag::IntList: {
+      auto size = reader.readCount(sizeof(int64_t));
+      c10::List<int64_t> list;
+      list.reserve(size);
+      for (uint32_t i = 0; i < size; ++i) {
+        list.push_back(reader.read<int64_t>());
+      }
+      return list;
+    }
+    case FlatConstantTag::DoubleList: {
+      auto size = reader.readCount(sizeof(double));
+      c10::List<double> list;
+      list.reserve(size);
+      for (uint32_t i = 0; i < size; ++i) {
+        list.push_back(reader.read<double>());
+      }
+      return list;
+    }
+    case FlatConstantTag::BoolList: {
+      auto size = reader.readCount(sizeof(uint8_t));
+      c10::List<bool> list;
+      list.reserve(size);
+      for (uint32_t i = 0; i < size; ++i) {
+        list.push_back(reader.read<uint8_t>());
+      }
+      reader.skipPadding();
+      return list;
+    }
+  }
+  TORCH_CHECK(
+      false,
+      "Unknown constant tag ",
+      static_cast<int>(tag),
+      " in flat bytecode section");
+}
+
+} // namespace
+
+bool flatBytecodeSupported() {
+  const uint16_t one = 1;
+  uint8_t first_byte;
+  std::memcpy(&first_byte, &one, 1);
+  return first_byte == 1;
+}
+
+c10::optional<std::string> flattenBytecode(
+    const std::vector<c10::IValue>& bytecode) {
+  TORCH_CHECK(
+      !bytecode.empty() && bytecode[0].isInt(),
+      "Expected the bytecode version as the first element");
+  if (!flatBytecodeSupported()) {
+    return c10::nullopt;
+  }
+  FlatWriter writer;
+  writer.writeBytes(kFlatBytecodeMagic, sizeof(kFlatBytecodeMagic));
+  writer.write<uint32_t>(kFlatBytecodeFormatVersion);
+  writer.write<int64_t>(bytecode[0].toInt());
+  writer.write<uint32_t>(bytecode.size() - 1);
+
+  for (size_t i = 1; i < bytecode.size(); ++i) {
+    const auto& m_tuple = bytecode[i].toTuple()->elements();
+    const c10::IValue& table = m_tuple[1];
+    writer.writeString(m_tuple[0].toStringRef());
+    writer.write<uint32_t>(
+        expectField(table, "register_size", BYTECODE_INDEX_REGISTER_SIZE)
+            .toInt());
+
+    const auto& ins_list =
+        expectField(table, "instructions", BYTECODE_INDEX_INSTRUCTION)
+            .toTuple()
+            ->elements();
+    writer.write<uint32_t>(ins_list.size());
+    for (const auto& ins : ins_list) {
+      const auto& ins_item = ins.toTuple()->elements();
+      Instruction inst(
+          parseOpCode(ins_item[0].toStringRef().c_str()),
+          ins_item[1].toInt(),
+          ins_item[2].toInt());
+      writer.writeBytes(&inst, sizeof(inst));
+    }
+
+    const auto& ops_list =
+        expectField(table, "operators", BYTECODE_INDEX_OPERATOR)
+            .toTuple()
+            ->elements();
+    writer.write<uint32_t>(ops_list.size());
+    for (const auto& op : ops_list) {
+      const auto& op_item = op.toTuple()->elements();
+      writer.writeString(op_item[0].toStringRef());
+      writer.writeString(op_item[1].toStringRef());
+    }
+
+    const auto& consts_list =
+        expectField(table, "constants", BYTECODE_INDEX_CONSTANT)
+            .toTuple()
+            ->elements();
+    writer.write<uint32_t>(consts_list.size());
+    for (const auto& constant : consts_list) {
+      if (!writeConstant(writer, constant)) {
+        return c10::nullopt;
+      }
+    }
+
+    const auto& types_list =
+        expectField(table, "types", BYTECODE_INDEX_TYPE).toTuple()->elements();
+    writer.write<uint32_t>(types_list.size());
+    for (const auto& t : types_list) {
+      writer.writeString(t.toStringRef());
+    }
+  }
+  return writer.release();
+}
+
+std::pair<int64_t, std::vector<FlatFunctionView>> parseFlatBytecode(
+    const char* data,
+    size_t size) {
+  TORCH_CHECK(
+      flatBytecodeSupported(),
+      "Flat bytecode sections can only be read on little endian hosts");
+  TORCH_CHECK(
+      reinterpret_cast<uintptr_t>(data) % alignof(Instruction) == 0,
+      "Flat bytecode section is not aligned");
+  FlatReader reader(data, size);
+  TORCH_CHECK(
+      std::memcmp(
+          reader.take(sizeof(kFlatBytecodeMagic)),
+          kFlatBytecodeMagic,
+          sizeof(kFlatBytecodeMagic)) == 0,
+      "Bad magic in flat bytecode section");
+  auto format_version = reader.read<uint32_t>();
+  TORCH_CHECK(
+      format_version == kFlatBytecodeFormatVersion,
+      "Unsupported flat bytecode format version ",
+      format_version);
+  auto model_version = reader.read<int64_t>();
+  // A function is at least its name and register size, and the four table
+  // sizes.
+  auto num_functions = reader.readCount(6 * sizeof(uint32_t));
+
+  std::vector<FlatFunctionView> functions(num_functions);
+  for (auto& function : functions) {
+    function.name = reader.readString();
+    function.register_size = reader.read<uint32_t>();
+
+    function.num_instructions = reader.readCount(sizeof(Instruction));
+    function.instructions = reinterpret_cast<const Instruction*>(
+        reader.take(function.num_instructions * sizeof(Instruction)));
+
+    auto num_operators = reader.readCount(2 * sizeof(uint32_t));
+    function.operators.reserve(num_operators);
+    for (uint32_t i = 0; i < num_operators; ++i) {
+      auto name = reader.readString();
+      auto overload_name = reader.readString();
+      function.operators.emplace_back(
+          std::move(name), std::move(overload_name));
+    }
+
+    auto num_constants = reader.readCount(sizeof(uint32_t));
+    function.constants.reserve(num_constants);
+    for (uint32_t i = 0; i < num_constants; ++i) {
+      function.constants.push_back(readConstant(reader));
+    }
+
+    auto num_types = reader.readCount(sizeof(uint32_t));
+    function.types.reserve(num_types);
+    for (uint32_t i = 0; i < num_types; ++i) {
+      function.types.push_back(reader.readString());
+    }
+  }
+  TORCH_CHECK(reader.done(), "Trailing bytes in flat bytecode section");
+  return std::make_pair(model_version, std::move(functions));
+}
+
+} // namespace mobile
+} // namespace jit
+} // namespace torch
@@ -0,0 +1,68 @@
+#pragma once
+#include <ATen/core/ivalue.h>
+#include <ATen/core/operator_name.h>
+#include <torch/csrc/jit/runtime/instruction.h>
+
+#include <string>
+#include <vector>
+
+namespace torch {
+namespace jit {
+namespace mobile {
+
+// The flat bytecode section (bytecode.flat) holds the same tables as
+// bytecode.pkl in a layout that is read in place, without the Unpickler and
+// without building an IValue per instruction. All integers are little endian
+// and every table starts at a 4 byte aligned offset. Since the section is read
+// in place, big endian hosts neither write nor read it and use bytecode.pkl:
+//
+//   header:   char[4] magic "PTBC", u32 format version, i64 bytecode version,
+//             u32 number of functions
+//   function: str name, u32 register size,
+//             u32 n, Instruction[n] (op u8, unused u8, N u16, X i32),
+//             u32 n, (str name, str overload name)[n],
+//             u32 n, constant[n],
+//             u32 n, str type[n]
+//   str:      u32 length, bytes, zero padding up to a multiple of 4
+//   constant: u8 tag, 3 bytes padding, payload (see FlatConstantTag)
+//
+// Only the constants the lite interpreter emits for plain models (None,
+// scalars, strings, devices and lists of scalars) are supported. When a
+// method has any other constant no flat section is written and the loader
+// reads bytecode.pkl as before.
+
+constexpr char kFlatBytecodeMagic[4] = {'P', 'T', 'B', 'C'};
+constexpr uint32_t kFlatBytecodeFormatVersion = 1;
+constexpr const char* kFlatBytecodeRecord = "bytecode.flat";
+
+// A function of a flat bytecode section. instructions points into the
+// section, which must outlive the view.
+struct FlatFunctionView {
+  std::string name;
+  int64_t register_size = 0;
+  const Instruction* instructions = nullptr;
+  size_t num_instructions = 0;
+  std::vector<c10::OperatorName> operators;
+  std::vector<c10::IValue> constants;
+  std::vector<std::string> types;
+};
+
+// Whether the host can read and write flat bytecode sections, i.e. whether it
+// is little endian.
+TORCH_API bool flatBytecodeSupported();
+
+// Flattens the bytecode tuple elements written to bytecode.pkl (the version
+// number followed by one tuple per function). Returns nullopt if a constant
+// can not be represented in the flat format or the host is big endian.
+TORCH_API c10::optional<std::string> flattenBytecode(
+    const std::vector<c10::IValue>& bytecode);
+
+// Parses a flat bytecode section of size bytes starting at data, which must be
+// 4 byte aligned, and returns its bytecode version and functions.
+TORCH_API std::pair<int64_t, std::vector<FlatFunctionView>> parseFlatBytecode(
+    const char* data,
+    size_t size);
+
+} // namespace mobile
+} // namespace jit
+} // namespace torch
@@ -11,6 +11,12 @@ namespace jit {
 
 char const* toString(OpCode op);
 namespace mobile {
+namespace {
+#define COUNT_OPCODE(op, _) +1
+constexpr int kNumOpCodes = 0 FORALL_OPCODES(COUNT_OPCODE);
+#undef COUNT_OPCODE
+} // namespace
+
 Function::Function(c10::QualifiedName name)
     : name_(name), code_(std::make_shared<Code>()) {}
 
@@ -27,6 +33,27 @@ void Function::append_instruction(OpCode op, int X, int N) {
   code_->instructions_.emplace_back(op, X, N);
 }
 
+void Function::append_instructions(
+    const Instruction* instructions,
+    size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    OpCode op = instructions[i].op;
+    TORCH_CHECK(
+        op < kNumOpCodes, "Unknown opcode ", static_cast<int>(op), " at ", i);
+    TORCH_CHECK(
+        op != CREATE_OBJECT,
+        "CREATE_OBJECT is not supported in mobile module. ",
+        "Workaround: instead of using arbitrary class type (class Foo()), ",
+        "define a pytorch class (class Foo(torch.nn.Module)).");
+    TORCH_CHECK(
+        isOpSupportedInMobile(op),
+        toString(op),
+        " is not supported in mobile module.");
+  }
+  code_->instructions_.insert(
+      code_->instructions_.end(), instructions, instructions + size);
+}
+
 bool Function::append_operator(
     const std::string& name,
     const std::string& overload_name) {
@@ -35,21 +62,23 @@ bool Function::append_operator(
   auto opname = code_->op_names_.back();
 
   auto opname_c10 = opname;
-  std::function<void(Stack&)> fn;
+  Operation fn;
 
+  // Bind the operation once at load time, so that running an OP does not go
+  // through the operator registry or copy its Operation.
   auto jit_op = findOperatorFor(opname);
   if (jit_op) {
-    fn = [jit_op](Stack& stack) { jit_op->getOperation()(&stack); };
+    fn = jit_op->getOperation();
   } else {
     auto op = c10::Dispatcher::singleton().findSchema(opname_c10);
     if (op.has_value()) {
-      fn = [op](Stack& stack) { op->callBoxed(&stack); };
+      fn = [op](Stack* stack) { op->callBoxed(stack); };
     } else {
       return false;
     }
   }
 
-  code_->operators_.emplace_back(fn);
+  code_->operators_.emplace_back(std::move(fn));
   return true;
 }
 
@@ -79,6 +108,17 @@ void Function::set_register_size(size_t size) {
   code_->register_size_ = size;
 }
 
+void Function::plan_memory() {
+  code_->memory_planner_ = MemoryPlanner::create(*code_);
+}
+
+MemoryPlanStats Function::memory_plan_stats() const {
+  if (!code_->memory_planner_) {
+    return MemoryPlanStats();
+  }
+  return code_->memory_planner_->stats();
+}
+
 std::string Function::get_module_debug_info(size_t pc) const {
   TORCH_CHECK(
       pc < pc_to_module_debug_info_.size(),
@@ -1,5 +1,6 @@
 #pragma once
 #include <ATen/core/ivalue.h>
+#include <torch/csrc/jit/mobile/memory_planner.h>
 //#include <aten/src/Aten/core/operator_name.h>
 #include <vector>
 
@@ -7,6 +8,7 @@ namespace torch {
 namespace jit {
 using Stack = std::vector<c10::IValue>;
 enum OpCode : uint8_t;
+struct Instruction;
 
 namespace mobile {
 struct Code;
@@ -18,6 +20,7 @@ class Function {
   const std::string& name() const;
   const c10::QualifiedName& qualname() const;
   void append_instruction(OpCode op, int X, int N);
+  void append_instructions(const Instruction* instructions, size_t size);
   bool append_operator(
       const std::string& name,
       const std::string& overload_name);
@@ -27,6 +30,12 @@ class Function {
   void append_type(const c10::TypePtr& type);
 
   void set_register_size(size_t size);
+  // Runs the liveness analysis of the memory planner. Called once all the
+  // instructions, operators and the register size are set.
+  void plan_memory();
+  // The memory plan of the function. The sizes are known once it has run
+  // with memory planning enabled.
+  MemoryPlanStats memory_plan_stats() const;
 
   std::string get_module_debug_info(size_t pc) const;
 
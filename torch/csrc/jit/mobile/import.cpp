@@ -2,6 +2,7 @@
 #include <ATen/core/ivalue.h>
 #include <caffe2/serialize/inline_container.h>
 #include <torch/csrc/jit/api/compilation_unit.h>
+#include <torch/csrc/jit/mobile/flat_bytecode.h>
 #include <torch/csrc/jit/mobile/observer.h>
 #include <torch/csrc/jit/mobile/type_parser.h>
 #include <torch/csrc/jit/runtime/instruction.h>
@@ -35,6 +36,10 @@
 //   ('__torch__.m.forward',
 //     (('module_debug_info', (top(A).foo(B).forward)))))
 
+// When the model was exported with a flat bytecode section (bytecode.flat, see
+// flat_bytecode.h), the methods are loaded from it instead, which skips the
+// unpickling of bytecode.pkl.
+
 // Note that currently the backward compatibility is not supported by bytecode.
 // This format and process need to be revisted and redesigned if we want to
 // support backward compatibility in future.
@@ -87,6 +92,16 @@ void print_unsupported_ops_and_throw(
   TORCH_CHECK(false, "Following ops cannot be found:", error_message);
 }
 
+void checkBytecodeVersion(int64_t model_version) {
+  TORCH_CHECK(
+      model_version == caffe2::serialize::kProducedBytecodeVersion,
+      "Lite Interpreter verson number does not match. ",
+      "The code version is ",
+      caffe2::serialize::kProducedBytecodeVersion,
+      " but the model version is ",
+      model_version);
+}
+
 void parseMethods(
     const std::vector<IValue>& vals,
     const c10::optional<std::vector<IValue>>& debug_info_vals,
@@ -101,13 +116,7 @@ void parseMethods(
     model_version = vals[0].toInt();
     method_i_start = 1;
   }
-  TORCH_CHECK(
-      model_version == caffe2::serialize::kProducedBytecodeVersion,
-      "Lite Interpreter verson number does not match. ",
-      "The code version is ",
-      caffe2::serialize::kProducedBytecodeVersion,
-      " but the model version is ",
-      model_version);
+  checkBytecodeVersion(model_version);
 
   bool has_debug_info = debug_info_vals.has_value();
   if (has_debug_info) {
@@ -209,6 +218,84 @@ void parseMethods(
     }
 
     function->set_register_size(register_size);
+    function->plan_memory();
+
+    mcu.register_function(std::move(function));
+  }
+}
+
+// Same as parseMethods, for a flat bytecode section. The instructions are
+// copied in bulk and only the operator, constant and type tables are
+// materialized.
+void parseFlatMethods(
+    const char* data,
+    size_t size,
+    const c10::optional<std::vector<IValue>>& debug_info_vals,
+    mobile::CompilationUnit& mcu) {
+  auto flat = mobile::parseFlatBytecode(data, size);
+  checkBytecodeVersion(flat.first);
+  auto& functions = flat.second;
+
+  bool has_debug_info = debug_info_vals.has_value();
+  if (has_debug_info) {
+    TORCH_CHECK(
+        debug_info_vals->size() == functions.size() + 1,
+        "The numbers of bytecode values and debug info values do not match.");
+  }
+
+  for (size_t i = 0; i < functions.size(); ++i) {
+    auto& flat_function = functions[i];
+    auto function = std::unique_ptr<mobile::Function>(
+        new mobile::Function(c10::QualifiedName(flat_function.name)));
+    function->append_instructions(
+        flat_function.instructions, flat_function.num_instructions);
+
+    function->set_module_debug_info_list_size(flat_function.num_instructions);
+    if (has_debug_info) {
+      const auto& debug_info_m_tuple =
+          (*debug_info_vals)[i + 1].toTuple()->elements();
+      TORCH_CHECK(
+          debug_info_m_tuple[0].toStringRef() == flat_function.name,
+          "The function names in the bytecode table and the debug info table do not match.");
+      const auto& module_debug_info_list =
+          expect_field(
+              debug_info_m_tuple[1],
+              "module_debug_info",
+              BYTECODE_INDEX_MODULE_DEBUG_INFO)
+              .toTuple()
+              ->elements();
+      TORCH_CHECK(
+          module_debug_info_list.size() == flat_function.operators.size(),
+          "The numbers of operators and module info strings do not match.");
+      for (size_t pc = 0; pc < flat_function.num_instructions; ++pc) {
+        const auto& inst = flat_function.instructions[pc];
+        if (inst.op == OP) {
+          function->set_module_info(
+              module_debug_info_list[inst.X].toStringRef(), pc);
+        }
+      }
+    }
+
+    std::unordered_set<std::string> unsupported_op_names;
+    for (const auto& op : flat_function.operators) {
+      if (!function->append_operator(op.name, op.overload_name)) {
+        unsupported_op_names.emplace(operator_str(op.name, op.overload_name));
+      }
+    }
+    if (!unsupported_op_names.empty()) {
+      print_unsupported_ops_and_throw(unsupported_op_names);
+    }
+
+    for (auto& constant : flat_function.constants) {
+      function->append_constant(std::move(constant));
+    }
+
+    for (const auto& t : flat_function.types) {
+      function->append_type(c10::parseType(t));
+    }
+
+    function->set_register_size(flat_function.register_size);
+    function->plan_memory();
 
     mcu.register_function(std::move(function));
   }
@@ -239,13 +326,26 @@ mobile::Module BytecodeDeserializer::deserialize(
     c10::optional<at::Device> device) {
   device_ = device;
   auto mcu = std::make_shared<mobile::CompilationUnit>();
-  auto bvals = readArchive("bytecode", mcu).toTuple()->elements();
 
   c10::optional<std::vector<IValue>> debug_info_bvals;
   if (reader_->hasRecord("mobile_debug.pkl")) {
     debug_info_bvals = readArchive("mobile_debug", mcu).toTuple()->elements();
   }
-  parseMethods(bvals, debug_info_bvals, *mcu);
+  if (mobile::flatBytecodeSupported() &&
+      reader_->hasRecord(mobile::kFlatBytecodeRecord)) {
+    at::DataPtr flat_ptr;
+    size_t flat_size;
+    std::tie(flat_ptr, flat_size) =
+        reader_->getRecord(mobile::kFlatBytecodeRecord);
+    parseFlatMethods(
+        static_cast<const char*>(flat_ptr.get()),
+        flat_size,
+        debug_info_bvals,
+        *mcu);
+  } else {
+    auto bvals = readArchive("bytecode", mcu).toTuple()->elements();
+    parseMethods(bvals, debug_info_bvals, *mcu);
+  }
 
   return mobile::Module(readArchive("data", mcu).toObject(), mcu);
 }
@@ -8,19 +8,258 @@
 #include <ATen/record_function.h>
 #include <torch/csrc/jit/mobile/observer.h>
 
+#include <atomic>
+#include <limits>
+#include <unordered_set>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define MOBILE_INTERPRETER_COMPUTED_GOTO
+#endif
+
 namespace torch {
 namespace jit {
 char const* toString(OpCode op);
 std::ostream& operator<<(std::ostream& out, Instruction inst);
 namespace mobile {
+
+namespace {
+
+std::atomic<bool> threaded_interpreter_enabled{false};
+
+// Performs one step of a LOOP instruction over the N loop values on top of
+// the stack. Returns whether to run the loop body once more.
+bool loopStep(Stack& stack, size_t N) {
+  // stack: iteration_count, max_iter, cond, loop_carried_deps...
+  auto frame = stack.end() - (N + 1);
+  int64_t trip_count = frame[0].toInt();
+  int64_t max_trip_count = frame[1].toInt();
+  bool cond = frame[2].toBool();
+  if (trip_count < max_trip_count && cond) {
+    frame[2] = trip_count;
+    frame[0] = trip_count + 1;
+    return true;
+  }
+  size_t n_loop_carried = N - 2;
+  for (size_t i = 0; i < n_loop_carried; ++i) {
+    frame[i] = std::move(frame[i + 3]);
+  }
+  drop(stack, 3); // iteration_count, max_iter, cond
+  return false;
+}
+
+} // namespace
+
+void setThreadedInterpreterEnabled(bool enabled) {
+  threaded_interpreter_enabled = enabled;
+}
+
+bool threadedInterpreterEnabled() {
+  return threaded_interpreter_enabled;
+}
+
+// The opcodes of the threaded interpreter. The control flow and stack
+// opcodes mirror OpCode, REG_OP is an OP fused with the LOAD / MOVE / LOADC
+// that push its arguments and the STORE of its result, and OTHER runs the
+// original instruction through InterpreterState::runOther.
+#define FORALL_THREADED_OPCODES(_) \
+  _(OP)                            \
+  _(OPN)                           \
+  _(REG_OP)                        \
+  _(LOAD)                          \
+  _(MOVE)                          \
+  _(STORE)                         \
+  _(STOREN)                        \
+  _(DROP)                          \
+  _(DROPR)                         \
+  _(LOADC)                         \
+  _(JF)                            \
+  _(JMP)                           \
+  _(LOOP)                          \
+  _(RET)                           \
+  _(OTHER)
+
+enum class ThreadedOpCode : uint8_t {
+#define DEFINE_OP(op) op,
+  FORALL_THREADED_OPCODES(DEFINE_OP)
+#undef DEFINE_OP
+};
+
+struct ThreadedInstruction {
+  ThreadedOpCode op;
+  uint16_t N;
+  int32_t X;
+  // The index of the original instruction, of the OP for a REG_OP.
+  uint32_t pc;
+  // REG_OP only: its pushes are args[args_begin, args_begin + N), and it
+  // stores its result to register out_reg unless out_reg is 0.
+  uint32_t args_begin;
+  int32_t out_reg;
+};
+
+struct ThreadedCode {
+  std::vector<ThreadedInstruction> instructions;
+  std::vector<Instruction> args;
+};
+
+namespace {
+
+bool isPush(OpCode op) {
+  return op == LOAD || op == MOVE || op == LOADC;
+}
+
+ThreadedOpCode threadedOpCode(OpCode op) {
+  switch (op) {
+#define MAP_OP(op)  \
+  case op:          \
+    return ThreadedOpCode::op;
+    MAP_OP(OP)
+    MAP_OP(OPN)
+    MAP_OP(LOAD)
+    MAP_OP(MOVE)
+    MAP_OP(STORE)
+    MAP_OP(STOREN)
+    MAP_OP(DROP)
+    MAP_OP(DROPR)
+    MAP_OP(LOADC)
+    MAP_OP(JF)
+    MAP_OP(JMP)
+    MAP_OP(LOOP)
+    MAP_OP(RET)
+#undef MAP_OP
+    default:
+      return ThreadedOpCode::OTHER;
+  }
+}
+
+// Translates the instructions of code for the threaded interpreter. A run of
+// LOAD / MOVE / LOADC followed by an OP and optionally a STORE becomes one
+// REG_OP, as long as no jump lands inside of it. Jump offsets are rebased on
+// the translated instructions.
+std::shared_ptr<ThreadedCode> buildThreadedCode(const Code& code) {
+  const auto& instructions = code.instructions_;
+  const size_t size = instructions.size();
+  std::unordered_set<size_t> jump_targets;
+  for (size_t pc = 0; pc < size; ++pc) {
+    const auto& inst = instructions[pc];
+    if (inst.op == JF || inst.op == JMP || inst.op == LOOP) {
+      jump_targets.insert(pc + inst.X);
+    }
+  }
+  auto can_fuse = [&](size_t pc) { return !jump_targets.count(pc); };
+
+  auto threaded = std::make_shared<ThreadedCode>();
+  std::vector<size_t> new_pc(size + 1, 0);
+  size_t pc = 0;
+  while (pc < size) {
+    new_pc[pc] = threaded->instructions.size();
+    const auto& inst = instructions[pc];
+
+    size_t op_pc = pc;
+    while (op_pc < size && isPush(instructions[op_pc].op) &&
+           (op_pc == pc || can_fuse(op_pc))) {
+      ++op_pc;
+    }
+    const bool has_op = op_pc < size && instructions[op_pc].op == OP &&
+        (op_pc == pc || can_fuse(op_pc));
+    const bool has_store = has_op && op_pc + 1 < size &&
+        instructions[op_pc + 1].op == STORE && can_fuse(op_pc + 1);
+    if (has_op && (op_pc > pc || has_store) &&
+        op_pc - pc <= std::numeric_limits<uint16_t>::max()) {
+      ThreadedInstruction fused;
+      fused.op = ThreadedOpCode::REG_OP;
+      fused.N = static_cast<uint16_t>(op_pc - pc);
+      fused.X = instructions[op_pc].X;
+      fused.pc = op_pc;
+      fused.args_begin = threaded->args.size();
+      fused.out_reg = has_store ? instructions[op_pc + 1].X : 0;
+      threaded->args.insert(
+          threaded->args.end(),
+          instructions.begin() + pc,
+          instructions.begin() + op_pc);
+      threaded->instructions.push_back(fused);
+      pc = op_pc + (has_store ? 2 : 1);
+      continue;
+    }
+
+    ThreadedInstruction single;
+    single.op = threadedOpCode(inst.op);
+    single.N = inst.N;
+    single.X = inst.X;
+    single.pc = pc;
+    single.args_begin = 0;
+    single.out_reg = 0;
+    threaded->instructions.push_back(single);
+    ++pc;
+  }
+  new_pc[size] = threaded->instructions.size();
+
+  for (size_t i = 0; i < threaded->instructions.size(); ++i) {
+    auto& inst = threaded->instructions[i];
+    if (inst.op == ThreadedOpCode::JF || inst.op == ThreadedOpCode::JMP ||
+        inst.op == ThreadedOpCode::LOOP) {
+      size_t target = inst.pc + instructions[inst.pc].X;
+      TORCH_INTERNAL_ASSERT(target <= size, "Jump out of the function");
+      inst.X = static_cast<int32_t>(new_pc[target]) - static_cast<int32_t>(i);
+    }
+  }
+  return threaded;
+}
+
+} // namespace
+
 InterpreterState::InterpreterState(std::shared_ptr<Code> code)
     : code_(std::move(code)) {
+  if (code_->memory_planner_ && memoryPlanningEnabled()) {
+    planned_run_ = code_->memory_planner_->beginRun();
+  }
   registers_.resize(code_->register_size_);
 }
 
 using namespace at;
 
 bool InterpreterState::run(Stack& stack) {
+  if (threadedInterpreterEnabled()) {
+    std::call_once(code_->threaded_code_once_, [this]() {
+      code_->threaded_code_ = buildThreadedCode(*code_);
+    });
+    return runThreaded(stack);
+  }
+  return runSwitch(stack);
+}
+
+void InterpreterState::callOperator(
+    size_t pc,
+    size_t op_index,
+    Stack& stack) {
+  if (at::hasGlobalCallbacks()) {
+    if (auto debug_info = c10::ThreadLocalDebugInfo::get(
+            c10::DebugInfoKind::MOBILE_RUNTIME_INFO)) {
+      if (auto* mobile_debug_info =
+              dynamic_cast<MobileDebugInfo*>(debug_info.get())) {
+        mobile_debug_info->setOpIdx(pc);
+      }
+    }
+  }
+
+  // TODO(iliacher): remove the workaround after RecordFunction is in
+  // Dispatcher
+  bool prev_value = isRecordFunctionEnabled();
+  if (!prev_value) {
+    // enable only for the RecordFunction
+    enableRecordFunction(true);
+  }
+  RECORD_FUNCTION(code_->op_names_[op_index].name, stack);
+  if (!prev_value) {
+    enableRecordFunction(false);
+  }
+  if (planned_run_ &&
+      planned_run_->callOperator(pc, code_->operators_[op_index], stack)) {
+    return;
+  }
+  code_->operators_[op_index](&stack);
+}
+
+bool InterpreterState::runSwitch(Stack& stack) {
   size_t pc = 0;
   while (true) {
     Instruction inst = code_->instructions_[pc];
@@ -35,42 +274,12 @@ bool InterpreterState::run(Stack& stack) {
     //    std::cout << std::endl;
     switch (inst.op) {
       case OP: {
-        if (at::hasGlobalCallbacks()) {
-          if (auto debug_info = c10::ThreadLocalDebugInfo::get(
-                  c10::DebugInfoKind::MOBILE_RUNTIME_INFO)) {
-            if (auto* mobile_debug_info =
-                    dynamic_cast<MobileDebugInfo*>(debug_info.get())) {
-              mobile_debug_info->setOpIdx(pc);
-            }
-          }
-        }
-
-        // TODO(iliacher): remove the workaround after RecordFunction is in
-        // Dispatcher
-        bool prev_value = isRecordFunctionEnabled();
-        if (!prev_value) {
-          // enable only for the RecordFunction
-          enableRecordFunction(true);
-        }
-        RECORD_FUNCTION(code_->op_names_[inst.X].name, stack);
-        if (!prev_value) {
-          enableRecordFunction(false);
-        }
-        code_->operators_[inst.X](stack);
+        callOperator(pc, inst.X, stack);
         ++pc;
       } break;
       case OPN: {
         stack.push_back(inst.N);
-        code_->operators_[inst.X](stack);
-        ++pc;
-      } break;
-      case INTERFACE_CALL: {
-        torch::jit::Function& method =
-            peek(stack, 0, inst.N)
-                .toObject()
-                ->type()
-                ->getMethod(code_->constants_[inst.X].toStringRef());
-        method.run(stack);
+        code_->operators_[inst.X](&stack);
         ++pc;
       } break;
       case LOAD:
@@ -103,86 +312,20 @@ bool InterpreterState::run(Stack& stack) {
         stack.emplace_back(code_->constants_[inst.X]);
         ++pc;
         break;
-      case GET_ATTR: {
-        auto userObj = pop(stack).toObject();
-        auto value = userObj->getSlot(inst.X);
-        push(stack, std::move(value));
-        ++pc;
-      } break;
-      case SET_ATTR: {
-        auto v = pop(stack);
-        auto userObj = pop(stack).toObject();
-        // Mobile only: since the number of slots is not known, resize the
-        // numAttributes before setSlot.
-        while (userObj->type()->numAttributes() <= inst.X) {
-          std::stringstream ss;
-          ss << userObj->type()->numAttributes();
-          userObj->type()->addAttribute(ss.str(), c10::NoneType::create());
-        }
-        userObj->setSlot(inst.X, std::move(v));
-        ++pc;
-      } break;
       case JF:
         pc += (pop(stack).toBool()) ? 1 : inst.X;
         break;
       case JMP:
         pc += inst.X;
         break;
-      case LOOP: {
-        // stack: iteration_count, max_iter, cond, loop_carried_deps...
-        auto frame = stack.end() - (inst.N + 1);
-        int64_t trip_count = frame[0].toInt();
-        int64_t max_trip_count = frame[1].toInt();
-        bool cond = frame[2].toBool();
-        if (trip_count < max_trip_count && cond) {
-          frame[2] = trip_count;
-          frame[0] = trip_count + 1;
-          ++pc;
-        } else {
-          size_t n_loop_carried = inst.N - 2;
-          for (size_t i = 0; i < n_loop_carried; ++i) {
-            frame[i] = std::move(frame[i + 3]);
-          }
-          drop(stack, 3); // iteration_count, max_iter, cond
-          pc += inst.X;
-        }
-      } break;
+      case LOOP:
+        pc += loopStep(stack, inst.N) ? 1 : inst.X;
+        break;
       case RET:
         return false;
-      case LIST_CONSTRUCT: {
-        auto type = code_->types_[inst.X]->expect<at::ListType>();
-        listConstruct(stack, type, inst.N);
-        ++pc;
-      } break;
-      case LIST_UNPACK: {
-        listUnpack(stack, inst.X);
-        ++pc;
-      } break;
-      case TUPLE_CONSTRUCT: {
-        tupleConstruct(stack, inst.X);
-        ++pc;
-      } break;
-      case TUPLE_SLICE: {
-        tupleSlice(stack, inst.X, inst.X + inst.N);
-        ++pc;
-      } break;
-      case DICT_CONSTRUCT: {
-        auto type = code_->types_[inst.X]->expect<at::DictType>();
-        dictConstruct(stack, type, inst.N);
-        ++pc;
-      } break;
-      case NAMED_TUPLE_CONSTRUCT: {
-        auto type = code_->types_[inst.X]->expect<at::TupleType>();
-        namedTupleConstruct(stack, type, inst.N);
-        ++pc;
-      } break;
-      case WARN: {
-        drop(stack, 1);
-        TORCH_WARN(pop(stack).toStringRef());
-        ++pc;
-      } break;
       default:
-        AT_ERROR(toString(inst.op), " is invalid.");
+        runOther(inst, stack);
+        ++pc;
     }
     //  for (auto val : stack) {
     //    if (val.isTensor()) {
@@ -195,6 +338,179 @@ bool InterpreterState::run(Stack& stack) {
   return false;
 }
 
+bool InterpreterState::runThreaded(Stack& stack) {
+  const ThreadedCode& threaded = *code_->threaded_code_;
+  const ThreadedInstruction* ip = threaded.instructions.data();
+
+#ifdef MOBILE_INTERPRETER_COMPUTED_GOTO
+  static const void* const dispatch_table[] = {
+#define DEFINE_LABEL(op) &&label_##op,
+      FORALL_THREADED_OPCODES(DEFINE_LABEL)
+#undef DEFINE_LABEL
+  };
+#define TARGET(op) label_##op:
+#define DISPATCH() goto* dispatch_table[static_cast<size_t>(ip->op)]
+  DISPATCH();
+#else
+#define TARGET(op) case ThreadedOpCode::op:
+#define DISPATCH() continue
+  while (true) {
+    switch (ip->op) {
+#endif
+
+  TARGET(OP) {
+    callOperator(ip->pc, ip->X, stack);
+    ++ip;
+    DISPATCH();
+  }
+  TARGET(OPN) {
+    stack.push_back(ip->N);
+    code_->operators_[ip->X](&stack);
+    ++ip;
+    DISPATCH();
+  }
+  TARGET(REG_OP) {
+    const Instruction* arg = threaded.args.data() + ip->args_begin;
+    for (const Instruction* end = arg + ip->N; arg != end; ++arg) {
+      if (arg->op == LOAD) {
+        stack.emplace_back(reg(arg->X));
+      } else if (arg->op == MOVE) {
+        stack.emplace_back(std::move(reg(arg->X)));
+      } else {
+        stack.emplace_back(code_->constants_[arg->X]);
+      }
+    }
+    callOperator(ip->pc, ip->X, stack);
+    if (ip->out_reg) {
+      reg(ip->out_reg) = pop(stack);
+    }
+    ++ip;
+    DISPATCH();
+  }
+  TARGET(LOAD) {
+    stack.emplace_back(reg(ip->X));
+    ++ip;
+    DISPATCH();
+  }
+  TARGET(MOVE) {
+    stack.emplace_back(std::move(reg(ip->X)));
+    ++ip;
+    DISPATCH();
+  }
+  TARGET(STORE) {
+    reg(ip->X) = pop(stack);
+    ++ip;
+    DISPATCH();
+  }
+  TARGET(STOREN) {
+    for (size_t i = ip->N; i > 0; --i) {
+      reg(ip->X + i - 1) = pop(stack);
+    }
+    ++ip;
+    DISPATCH();
+  }
+  TARGET(DROP) {
+    pop(stack);
+    ++ip;
+    DISPATCH();
+  }
+  TARGET(DROPR) {
+    reg(ip->X) = IValue();
+    ++ip;
+    DISPATCH();
+  }
+  TARGET(LOADC) {
+    stack.emplace_back(code_->constants_[ip->X]);
+    ++ip;
+    DISPATCH();
+  }
+  TARGET(JF) {
+    ip += (pop(stack).toBool()) ? 1 : ip->X;
+    DISPATCH();
+  }
+  TARGET(JMP) {
+    ip += ip->X;
+    DISPATCH();
+  }
+  TARGET(LOOP) {
+    ip += loopStep(stack, ip->N) ? 1 : ip->X;
+    DISPATCH();
+  }
+  TARGET(RET) {
+    return false;
+  }
+  TARGET(OTHER) {
+    runOther(code_->instructions_[ip->pc], stack);
+    ++ip;
+    DISPATCH();
+  }
+
+#ifndef MOBILE_INTERPRETER_COMPUTED_GOTO
+    }
+  }
+#endif
+#undef TARGET
+#undef DISPATCH
+  return false;
+}
+
+void InterpreterState::runOther(Instruction inst, Stack& stack) {
+  switch (inst.op) {
+    case INTERFACE_CALL: {
+      torch::jit::Function& method =
+          peek(stack, 0, inst.N)
+              .toObject()
+              ->type()
+              ->getMethod(code_->constants_[inst.X].toStringRef());
+      method.run(stack);
+    } break;
+    case GET_ATTR: {
+      auto userObj = pop(stack).toObject();
+      auto value = userObj->getSlot(inst.X);
+      push(stack, std::move(value));
+    } break;
+    case SET_ATTR: {
+      auto v = pop(stack);
+      auto userObj = pop(stack).toObject();
+      // Mobile only: since the number of slots is not known, resize the
+      // numAttributes before setSlot.
+      while (userObj->type()->numAttributes() <= inst.X) {
+        std::stringstream ss;
+        ss << userObj->type()->numAttributes();
+        userObj->type()->addAttribute(ss.str(), c10::NoneType::create());
+      }
+      userObj->setSlot(inst.X, std::move(v));
+    } break;
+    case LIST_CONSTRUCT: {
+      auto type = code_->types_[inst.X]->expect<at::ListType>();
+      listConstruct(stack, type, inst.N);
+    } break;
+    case LIST_UNPACK: {
+      listUnpack(stack, inst.X);
+    } break;
+    case TUPLE_CONSTRUCT: {
+      tupleConstruct(stack, inst.X);
+    } break;
+    case TUPLE_SLICE: {
+      tupleSlice(stack, inst.X, inst.X + inst.N);
+    } break;
+    case DICT_CONSTRUCT: {
+      auto type = code_->types_[inst.X]->expect<at::DictType>();
+      dictConstruct(stack, type, inst.N);
+    } break;
+    case NAMED_TUPLE_CONSTRUCT: {
+      auto type = code_->types_[inst.X]->expect<at::TupleType>();
+      namedTupleConstruct(stack, type, inst.N);
+    } break;
+    case WARN: {
+      drop(stack, 1);
+      TORCH_WARN(pop(stack).toStringRef());
+    } break;
+    default:
+      AT_ERROR(toString(inst.op), " is invalid.");
+  }
+}
+
 IValue& InterpreterState::reg(size_t reg) {
   return *(registers_.end() - reg);
 }
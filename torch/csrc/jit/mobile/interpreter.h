@@ -2,28 +2,53 @@
 #include <ATen/core/dispatch/Dispatcher.h>
 #include <ATen/core/ivalue.h>
 #include <ATen/core/operator_name.h>
+#include <ATen/core/stack.h>
+#include <torch/csrc/jit/mobile/memory_planner.h>
 #include <torch/csrc/jit/runtime/instruction.h>
 
+#include <mutex>
+
 namespace torch {
 namespace jit {
 namespace mobile {
 using Stack = std::vector<c10::IValue>;
+struct ThreadedCode;
+
 struct Code {
   std::vector<Instruction> instructions_;
   std::vector<c10::OperatorName> op_names_;
-  std::vector<std::function<void(Stack&)>> operators_;
+  std::vector<Operation> operators_;
   std::vector<c10::IValue> constants_;
   std::vector<c10::TypePtr> types_;
   size_t register_size_; // Aggregated output size.
+  // instructions_ translated for the threaded interpreter, built on the first
+  // threaded run.
+  std::once_flag threaded_code_once_;
+  std::shared_ptr<ThreadedCode> threaded_code_;
+  // Made at load time by Function::plan_memory, null if no value is planned.
+  std::shared_ptr<MemoryPlanner> memory_planner_;
 };
 
+// Whether InterpreterState::run uses the threaded interpreter, which runs a
+// peephole fused copy of the instructions with direct threaded dispatch
+// (computed goto) where the compiler supports it. Off by default.
+TORCH_API void setThreadedInterpreterEnabled(bool enabled);
+TORCH_API bool threadedInterpreterEnabled();
+
 struct InterpreterState {
   TORCH_API explicit InterpreterState(std::shared_ptr<Code> code);
   TORCH_API bool run(Stack& stack);
 
  private:
+  bool runSwitch(Stack& stack);
+  bool runThreaded(Stack& stack);
+  void callOperator(size_t pc, size_t op_index, Stack& stack);
+  void runOther(Instruction inst, Stack& stack);
   std::shared_ptr<Code> code_;
   c10::IValue& reg(size_t reg);
+  // Declared before registers_ so that the registers, which may point into
+  // the arena of the run, are destroyed first.
+  std::unique_ptr<PlannedRun> planned_run_;
   std::vector<c10::IValue> registers_;
 };
 
@@ -0,0 +1,581 @@
+#include <torch/csrc/jit/mobile/memory_planner.h>
+
+#include <ATen/core/dispatch/Dispatcher.h>
+#include <c10/core/CPUAllocator.h>
+#include <torch/csrc/jit/mobile/interpreter.h>
+#include <torch/csrc/jit/runtime/operator.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+
+namespace torch {
+namespace jit {
+namespace mobile {
+
+namespace {
+
+std::atomic<bool> memory_planning_enabled{false};
+
+constexpr size_t kArenaAlignment = 64;
+
+size_t alignSize(size_t nbytes) {
+  return (nbytes + kArenaAlignment - 1) / kArenaAlignment * kArenaAlignment;
+}
+
+// Looks up the schema and the operation of an operator the same way as
+// Function::append_operator.
+c10::optional<std::pair<c10::FunctionSchema, Operation>> findOperator(
+    const c10::OperatorName& opname) {
+  if (auto jit_op = findOperatorFor(opname)) {
+    return std::make_pair(jit_op->schema(), jit_op->getOperation());
+  }
+  auto op = c10::Dispatcher::singleton().findSchema(opname);
+  if (op.has_value()) {
+    return std::make_pair(
+        op->schema(), Operation([op](Stack* stack) { op->callBoxed(stack); }));
+  }
+  return c10::nullopt;
+}
+
+// Whether the OP returns one fresh tensor.
+bool returnsFreshTensor(const c10::FunctionSchema& schema) {
+  if (schema.is_vararg() || schema.is_varret() || schema.is_mutable() ||
+      schema.returns().size() != 1) {
+    return false;
+  }
+  const auto& ret = schema.returns()[0];
+  return ret.type()->kind() == c10::TypeKind::TensorType && !ret.alias_info();
+}
+
+// Whether out is the out= variant of schema: the same arguments followed by
+// the tensor it writes to.
+bool isOutVariant(
+    const c10::FunctionSchema& out,
+    const c10::FunctionSchema& schema) {
+  const auto& args = schema.arguments();
+  const auto& out_args = out.arguments();
+  if (out_args.size() != args.size() + 1 || out.returns().size() != 1) {
+    return false;
+  }
+  for (size_t i = 0; i < args.size(); ++i) {
+    if (out_args[i].name() != args[i].name() ||
+        *out_args[i].type() != *args[i].type() || out_args[i].alias_info()) {
+      return false;
+    }
+  }
+  const auto& out_arg = out_args.back();
+  return out_arg.type()->kind() == c10::TypeKind::TensorType &&
+      out_arg.alias_info() && out_arg.alias_info()->isWrite();
+}
+
+Operation findOutVariant(const c10::FunctionSchema& schema) {
+  if (!returnsFreshTensor(schema)) {
+    return nullptr;
+  }
+  const auto& name = schema.operator_name();
+  std::vector<std::string> overload_names;
+  if (!name.overload_name.empty()) {
+    overload_names.push_back(name.overload_name + "_out");
+  }
+  overload_names.emplace_back("out");
+  for (const auto& overload_name : overload_names) {
+    auto out = findOperator(c10::OperatorName(name.name, overload_name));
+    if (out && isOutVariant(out->first, schema)) {
+      return out->second;
+    }
+  }
+  return nullptr;
+}
+
+bool isPrimitive(const c10::TypePtr& type) {
+  switch (type->kind()) {
+    case c10::TypeKind::TensorType:
+    case c10::TypeKind::IntType:
+    case c10::TypeKind::FloatType:
+    case c10::TypeKind::BoolType:
+    case c10::TypeKind::NumberType:
+    case c10::TypeKind::NoneType:
+    case c10::TypeKind::StringType:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Whether the OP may hold on to its arguments after it returns, other than by
+// returning them as a Tensor: by an alias annotation, or by keeping them in a
+// non-primitive value it returns.
+bool mayRetainArgument(const c10::FunctionSchema& schema, size_t i) {
+  if (schema.arguments()[i].alias_info()) {
+    return true;
+  }
+  for (const auto& ret : schema.returns()) {
+    const auto& type = ret.type();
+    if (isPrimitive(type)) {
+      continue;
+    }
+    auto list = type->cast<c10::ListType>();
+    if (!list || list->getElementType()->kind() == c10::TypeKind::TensorType ||
+        !isPrimitive(list->getElementType())) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Whether the arguments of a planned OP let its out= variant produce a
+// tensor of dtype: CPU tensors of that dtype that do not require grad, and no
+// scalar that would promote the result to another dtype.
+bool argumentsMatch(const c10::IValue* args, size_t n, c10::ScalarType dtype) {
+  bool has_tensor = false;
+  for (size_t i = 0; i < n; ++i) {
+    const auto& arg = args[i];
+    if (arg.isTensor()) {
+      const auto& t = arg.toTensor();
+      if (!t.defined() || !t.device().is_cpu() || t.layout() != at::kStrided ||
+          t.scalar_type() != dtype || t.requires_grad()) {
+        return false;
+      }
+      has_tensor = true;
+    } else if (arg.isDouble() && c10::isIntegralType(dtype, true)) {
+      return false;
+    } else if (arg.isInt() && dtype == at::kBool) {
+      return false;
+    }
+  }
+  return has_tensor;
+}
+
+struct RegisterInfo {
+  size_t defs = 0;
+  // The pc of the OP whose result is stored to the register, or -1 when it
+  // is assigned anything else.
+  int64_t op_pc = -1;
+  bool escaped = false;
+  // Registers whose tensors a value stored to this register may alias.
+  std::vector<size_t> aliases;
+  size_t first_use = std::numeric_limits<size_t>::max();
+  size_t last_use = 0;
+};
+
+// A value on the stack during the liveness analysis.
+struct StackEntry {
+  enum Kind { Unknown, Register, Result, Derived } kind;
+  // The register of a Register, the pc of the OP of a Result.
+  size_t index;
+  // The registers a Derived value may alias.
+  std::vector<size_t> aliases;
+};
+
+} // namespace
+
+void setMemoryPlanningEnabled(bool enabled) {
+  memory_planning_enabled = enabled;
+}
+
+bool memoryPlanningEnabled() {
+  return memory_planning_enabled;
+}
+
+std::shared_ptr<MemoryPlanner> MemoryPlanner::create(const Code& code) {
+  const auto& instructions = code.instructions_;
+  const size_t size = instructions.size();
+
+  std::vector<c10::optional<c10::FunctionSchema>> schemas;
+  std::vector<Operation> out_ops;
+  for (const auto& opname : code.op_names_) {
+    auto op = findOperator(opname);
+    schemas.push_back(op ? c10::optional<c10::FunctionSchema>(op->first)
+                         : c10::nullopt);
+    out_ops.push_back(op ? findOutVariant(op->first) : nullptr);
+  }
+
+  std::vector<bool> jump_targets(size + 1, false);
+  // Loops as [first, last] pc of their body, from the backward jumps.
+  std::vector<std::pair<size_t, size_t>> loops;
+  for (size_t pc = 0; pc < size; ++pc) {
+    const auto& inst = instructions[pc];
+    if (inst.op == JF || inst.op == JMP || inst.op == LOOP) {
+      int64_t target = static_cast<int64_t>(pc) + inst.X;
+      if (target < 0 || target > static_cast<int64_t>(size)) {
+        return nullptr;
+      }
+      jump_targets[target] = true;
+      if (target <= static_cast<int64_t>(pc)) {
+        loops.emplace_back(target, pc);
+      }
+    }
+  }
+
+  // Simulates the stack over the instructions. Only the top of the stack is
+  // tracked: anything that is not a plain register or OP dataflow makes the
+  // tracked entries escape and starts over with an empty stack.
+  std::vector<RegisterInfo> regs(code.register_size_ + 1);
+  std::vector<StackEntry> stack;
+  std::function<void(size_t)> escapeRegister = [&](size_t r) {
+    if (!regs[r].escaped) {
+      regs[r].escaped = true;
+      for (auto alias : regs[r].aliases) {
+        escapeRegister(alias);
+      }
+    }
+  };
+  auto escape = [&](const StackEntry& entry) {
+    if (entry.kind == StackEntry::Register) {
+      escapeRegister(entry.index);
+    } else if (entry.kind == StackEntry::Derived) {
+      for (auto alias : entry.aliases) {
+        escapeRegister(alias);
+      }
+    }
+  };
+  auto escapeAll = [&]() {
+    for (const auto& entry : stack) {
+      escape(entry);
+    }
+    stack.clear();
+  };
+  auto popEntry = [&]() {
+    if (stack.empty()) {
+      return StackEntry{StackEntry::Unknown, 0, {}};
+    }
+    auto entry = stack.back();
+    stack.pop_back();
+    return entry;
+  };
+  auto validRegister = [&](int64_t r) {
+    return r >= 1 && r <= static_cast<int64_t>(code.register_size_);
+  };
+
+  for (size_t pc = 0; pc < size; ++pc) {
+    const auto& inst = instructions[pc];
+    if (jump_targets[pc]) {
+      escapeAll();
+    }
+    switch (inst.op) {
+      case LOAD:
+      case MOVE: {
+        if (!validRegister(inst.X)) {
+          return nullptr;
+        }
+        auto& reg = regs[inst.X];
+        reg.first_use = std::min(reg.first_use, pc);
+        reg.last_use = std::max(reg.last_use, pc);
+        stack.push_back(
+            {StackEntry::Register, static_cast<size_t>(inst.X), {}});
+      } break;
+      case LOADC:
+        stack.push_back({StackEntry::Unknown, 0, {}});
+        break;
+      case STORE: {
+        if (!validRegister(inst.X)) {
+          return nullptr;
+        }
+        auto entry = popEntry();
+        auto& reg = regs[inst.X];
+        if (entry.kind == StackEntry::Derived) {
+          // The register escapes with the tensors it may alias.
+          reg.aliases.insert(
+              reg.aliases.end(), entry.aliases.begin(), entry.aliases.end());
+        } else {
+          escape(entry);
+        }
+        ++reg.defs;
+        reg.op_pc = entry.kind == StackEntry::Result
+            ? static_cast<int64_t>(entry.index)
+            : -1;
+        reg.first_use = std::min(reg.first_use, pc);
+        reg.last_use = std::max(reg.last_use, pc);
+      } break;
+      case STOREN:
+        for (size_t i = inst.N; i > 0; --i) {
+          if (!validRegister(inst.X + i - 1)) {
+            return nullptr;
+          }
+          escape(popEntry());
+          auto& reg = regs[inst.X + i - 1];
+          ++reg.defs;
+          reg.op_pc = -1;
+        }
+        break;
+      case DROP:
+        popEntry();
+        break;
+      case DROPR:
+        break;
+      case OP: {
+        if (inst.X < 0 || static_cast<size_t>(inst.X) >= schemas.size() ||
+            !schemas[inst.X] || schemas[inst.X]->is_vararg()) {
+          escapeAll();
+          break;
+        }
+        const auto& schema = *schemas[inst.X];
+        // Schemas do not annotate every OP that returns an input, e.g.,
+        // aten::dropout returns it in eval mode and aten::type_as when the
+        // type matches. So the results of an OP without out= variant may
+        // alias all its arguments that were not retained otherwise.
+        std::vector<size_t> aliases;
+        for (size_t i = schema.arguments().size(); i > 0; --i) {
+          auto entry = popEntry();
+          if (mayRetainArgument(schema, i - 1)) {
+            escape(entry);
+            continue;
+          }
+          if (entry.kind == StackEntry::Register) {
+            entry.aliases.push_back(entry.index);
+          }
+          for (auto alias : entry.aliases) {
+            // An argument is live until its OP has run, so that the OP does
+            // not write its result over it.
+            regs[alias].last_use = std::max(regs[alias].last_use, pc);
+            aliases.push_back(alias);
+          }
+        }
+        if (out_ops[inst.X]) {
+          stack.push_back({StackEntry::Result, pc, {}});
+        } else {
+          for (const auto& ret : schema.returns()) {
+            const auto kind = ret.type()->kind();
+            if (kind != c10::TypeKind::TensorType && isPrimitive(ret.type())) {
+              stack.push_back({StackEntry::Unknown, 0, {}});
+            } else {
+              stack.push_back({StackEntry::Derived, 0, aliases});
+            }
+          }
+        }
+      } break;
+      default:
+        escapeAll();
+    }
+  }
+
+  // The tensors of a value must stay live as long as the registers that may
+  // alias them.
+  bool extended = true;
+  while (extended) {
+    extended = false;
+    for (const auto& reg : regs) {
+      for (auto alias : reg.aliases) {
+        auto& other = regs[alias];
+        if (other.first_use > reg.first_use || other.last_use < reg.last_use) {
+          other.first_use = std::min(other.first_use, reg.first_use);
+          other.last_use = std::max(other.last_use, reg.last_use);
+          extended = true;
+        }
+      }
+    }
+  }
+
+  std::vector<Value> values;
+  for (const auto& reg : regs) {
+    if (reg.defs != 1 || reg.op_pc < 0 || reg.escaped) {
+      continue;
+    }
+    const auto& op = instructions[reg.op_pc];
+    Value value;
+    value.op_pc = reg.op_pc;
+    value.num_args = schemas[op.X]->arguments().size();
+    value.out_op = out_ops[op.X];
+    value.begin = std::min(value.op_pc, reg.first_use);
+    value.end = std::max(value.op_pc, reg.last_use);
+    values.push_back(std::move(value));
+  }
+  if (values.empty()) {
+    return nullptr;
+  }
+
+  // A value that is live across the back edge of a loop stays live for the
+  // whole loop. Only a value defined and last used within one iteration keeps
+  // its interval.
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (auto& value : values) {
+      for (const auto& loop : loops) {
+        bool overlaps = value.begin <= loop.second && loop.first <= value.end;
+        bool in_iteration = loop.first <= value.begin &&
+            value.end <= loop.second && value.begin == value.op_pc;
+        if (overlaps && !in_iteration &&
+            (value.begin > loop.first || value.end < loop.second)) {
+          value.begin = std::min(value.begin, loop.first);
+          value.end = std::max(value.end, loop.second);
+          changed = true;
+        }
+      }
+    }
+  }
+
+  return std::shared_ptr<MemoryPlanner>(
+      new MemoryPlanner(std::move(values), size));
+}
+
+MemoryPlanner::MemoryPlanner(std::vector<Value> values, size_t num_instructions)
+    : values_(std::move(values)), value_at_pc_(num_instructions, -1) {
+  for (size_t i = 0; i < values_.size(); ++i) {
+    value_at_pc_[values_[i].op_pc] = i;
+  }
+}
+
+std::unique_ptr<PlannedRun> MemoryPlanner::beginRun() {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (!planned_) {
+      if (profiling_) {
+        return nullptr;
+      }
+      profiling_ = true;
+      return std::unique_ptr<PlannedRun>(
+          new PlannedRun(shared_from_this(), at::DataPtr()));
+    }
+    if (arena_bytes_ == 0) {
+      return nullptr;
+    }
+    if (!free_arenas_.empty()) {
+      auto arena = std::move(free_arenas_.back());
+      free_arenas_.pop_back();
+      return std::unique_ptr<PlannedRun>(
+          new PlannedRun(shared_from_this(), std::move(arena)));
+    }
+  }
+  return std::unique_ptr<PlannedRun>(new PlannedRun(
+      shared_from_this(), c10::GetCPUAllocator()->allocate(arena_bytes_)));
+}
+
+void MemoryPlanner::finishProfiling() {
+  std::vector<Value*> order;
+  for (auto& value : values_) {
+    value.enabled = value.enabled && value.seen && value.nbytes > 0;
+    if (value.enabled) {
+      order.push_back(&value);
+    }
+  }
+  std::stable_sort(order.begin(), order.end(), [](Value* a, Value* b) {
+    return a->nbytes > b->nbytes;
+  });
+
+  // Greedy first fit, largest values first.
+  size_t arena_bytes = 0;
+  size_t planned_bytes = 0;
+  std::vector<Value*> placed;
+  for (Value* value : order) {
+    std::vector<Value*> live;
+    for (Value* other : placed) {
+      if (other->begin <= value->end && value->begin <= other->end) {
+        live.push_back(other);
+      }
+    }
+    std::sort(live.begin(), live.end(), [](Value* a, Value* b) {
+      return a->offset < b->offset;
+    });
+    size_t nbytes = alignSize(value->nbytes);
+    size_t offset = 0;
+    for (Value* other : live) {
+      if (offset + nbytes <= other->offset) {
+        break;
+      }
+      offset = std::max(offset, other->offset + alignSize(other->nbytes));
+    }
+    value->offset = offset;
+    placed.push_back(value);
+    arena_bytes = std::max(arena_bytes, offset + nbytes);
+    planned_bytes += nbytes;
+  }
+
+  std::lock_guard<std::mutex> guard(mutex_);
+  arena_bytes_ = arena_bytes;
+  planned_bytes_ = planned_bytes;
+  planned_values_ = placed.size();
+  planned_ = true;
+  profiling_ = false;
+}
+
+void MemoryPlanner::releaseArena(at::DataPtr arena) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  free_arenas_.push_back(std::move(arena));
+}
+
+MemoryPlanStats MemoryPlanner::stats() const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  MemoryPlanStats stats;
+  stats.candidate_values = values_.size();
+  stats.planned_values = planned_values_;
+  stats.planned_bytes = planned_bytes_;
+  stats.arena_bytes = arena_bytes_;
+  return stats;
+}
+
+PlannedRun::PlannedRun(
+    std::shared_ptr<MemoryPlanner> planner,
+    at::DataPtr arena)
+    : planner_(std::move(planner)), arena_(std::move(arena)) {}
+
+PlannedRun::~PlannedRun() {
+  if (profiling()) {
+    planner_->finishProfiling();
+  } else {
+    planner_->releaseArena(std::move(arena_));
+  }
+}
+
+bool PlannedRun::callOperator(size_t pc, const Operation& fn, Stack& stack) {
+  int64_t index = planner_->value_at_pc_[pc];
+  if (index < 0) {
+    return false;
+  }
+  auto& value = planner_->values_[index];
+  const c10::IValue* args = stack.data() + stack.size() - value.num_args;
+
+  if (profiling()) {
+    // The value is planned with the dtype of its first tensor argument.
+    c10::ScalarType dtype = c10::ScalarType::Undefined;
+    for (size_t i = 0; i < value.num_args; ++i) {
+      if (args[i].isTensor() && args[i].toTensor().defined()) {
+        dtype = args[i].toTensor().scalar_type();
+        break;
+      }
+    }
+    bool matches = dtype != c10::ScalarType::Undefined &&
+        argumentsMatch(args, value.num_args, dtype);
+    fn(&stack);
+    value.seen = true;
+    const auto& result = stack.back();
+    if (!matches || !result.isTensor()) {
+      value.enabled = false;
+      return true;
+    }
+    const auto& t = result.toTensor();
+    if (!t.device().is_cpu() || t.layout() != at::kStrided ||
+        !t.is_contiguous() || t.scalar_type() != dtype ||
+        (value.dtype != c10::ScalarType::Undefined && value.dtype != dtype)) {
+      value.enabled = false;
+      return true;
+    }
+    value.dtype = dtype;
+    value.nbytes = std::max(value.nbytes, t.nbytes());
+    return true;
+  }
+
+  if (!value.enabled || !argumentsMatch(args, value.num_args, value.dtype)) {
+    return false;
+  }
+  // The out= variant resizes the tensor to the size of the result. It
+  // allocates new memory if that is larger than the profiled size.
+  c10::Storage storage(
+      c10::Storage::use_byte_size_t(),
+      value.nbytes,
+      at::DataPtr(static_cast<char*>(arena_.get()) + value.offset, at::kCPU),
+      c10::GetCPUAllocator(),
+      /*resizable=*/true);
+  stack.emplace_back(at::detail::make_tensor<c10::TensorImpl>(
+      std::move(storage),
+      c10::DispatchKey::CPU,
+      c10::scalarTypeToTypeMeta(value.dtype)));
+  value.out_op(&stack);
+  return true;
+}
+
+} // namespace mobile
+} // namespace jit
+} // namespace torch
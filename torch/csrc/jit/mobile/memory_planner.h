@@ -0,0 +1,116 @@
+#pragma once
+#include <ATen/core/ivalue.h>
+#include <ATen/core/stack.h>
+#include <c10/core/Allocator.h>
+
+#include <mutex>
+#include <vector>
+
+namespace torch {
+namespace jit {
+namespace mobile {
+using Stack = std::vector<c10::IValue>;
+struct Code;
+
+// Memory planning for the lite interpreter. At load time a liveness analysis
+// over the bytecode of a function finds the tensors that are defined by an OP
+// with an out= variant, stored to a register that is assigned once and only
+// read by OPs that do not alias or retain them. The first run with planning
+// enabled profiles the size of these values, after which they are assigned
+// offsets in one arena, reusing the memory of values whose live intervals do
+// not overlap. Later runs check out an arena and call the out= variant of the
+// OP on a tensor placed at the planned offset.
+//
+// Values whose OP the profiling run did not reach, whose size grows in a later
+// run, or whose arguments do not match the profiled dtype fall back to the
+// regular allocation.
+
+struct MemoryPlanStats {
+  // Values found by the liveness analysis.
+  size_t candidate_values = 0;
+  // Values placed in the arena by the profiling run.
+  size_t planned_values = 0;
+  // Sum of the sizes of the planned values, without reuse.
+  size_t planned_bytes = 0;
+  // Size of the arena, the peak memory of the planned values.
+  size_t arena_bytes = 0;
+};
+
+// Whether mobile functions run with their memory plan. Off by default.
+TORCH_API void setMemoryPlanningEnabled(bool enabled);
+TORCH_API bool memoryPlanningEnabled();
+
+class PlannedRun;
+
+class TORCH_API MemoryPlanner : public std::enable_shared_from_this<MemoryPlanner> {
+ public:
+  // Runs the liveness analysis over the instructions and operators of code.
+  // Returns nullptr if no value can be planned.
+  static std::shared_ptr<MemoryPlanner> create(const Code& code);
+
+  // Starts a run of the function. Returns a profiling run if the plan has not
+  // been made yet, a planned run once it is, and nullptr while another thread
+  // is profiling or if no value made it into the plan.
+  std::unique_ptr<PlannedRun> beginRun();
+
+  MemoryPlanStats stats() const;
+
+ private:
+  friend class PlannedRun;
+
+  struct Value {
+    size_t op_pc;
+    size_t num_args;
+    Operation out_op;
+    // Live interval [begin, end] over instruction indices.
+    size_t begin;
+    size_t end;
+    // Filled in by the profiling run.
+    bool seen = false;
+    bool enabled = true;
+    size_t nbytes = 0;
+    c10::ScalarType dtype = c10::ScalarType::Undefined;
+    size_t offset = 0;
+  };
+
+  MemoryPlanner(std::vector<Value> values, size_t num_instructions);
+  void finishProfiling();
+  void releaseArena(at::DataPtr arena);
+
+  std::vector<Value> values_;
+  // The index in values_ of the value defined by the OP at each pc, or -1.
+  std::vector<int64_t> value_at_pc_;
+
+  mutable std::mutex mutex_;
+  bool profiling_ = false;
+  bool planned_ = false;
+  size_t arena_bytes_ = 0;
+  size_t planned_bytes_ = 0;
+  size_t planned_values_ = 0;
+  std::vector<at::DataPtr> free_arenas_;
+};
+
+// The state of one InterpreterState::run with memory planning. Returns the
+// arena to the planner when destroyed, so it must outlive the registers of the
+// run.
+class TORCH_API PlannedRun {
+ public:
+  PlannedRun(std::shared_ptr<MemoryPlanner> planner, at::DataPtr arena);
+  ~PlannedRun();
+
+  // Runs the OP at pc with its arguments on top of stack. Returns false if
+  // the caller should run the OP itself, fn being the functional operator.
+  bool callOperator(size_t pc, const Operation& fn, Stack& stack);
+
+ private:
+  bool profiling() const {
+    return !arena_;
+  }
+
+  std::shared_ptr<MemoryPlanner> planner_;
+  at::DataPtr arena_;
+};
+
+} // namespace mobile
+} // namespace jit
+} // namespace torch
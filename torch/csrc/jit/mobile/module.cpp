@@ -134,6 +134,13 @@ std::string Module::get_forward_method_debug_info(size_t pc) const {
   return find_method("forward")->get_module_debug_info(pc);
 }
 
+MemoryPlanStats Module::memory_plan_stats(
+    const std::string& method_name) const {
+  auto m = find_method(method_name);
+  TORCH_CHECK(m != nullptr, "Method '", method_name, "' is not defined.");
+  return m->memory_plan_stats();
+}
+
 } // namespace mobile
 } // namespace jit
 } // namespace torch
@@ -43,6 +43,10 @@ class TORCH_API Module {
   const std::vector<at::Tensor> parameters() const;
   const std::map<std::string, at::Tensor> named_parameters() const;
   std::string get_forward_method_debug_info(size_t pc) const;
+  // The memory plan of a method, including the estimated peak memory of its
+  // planned values (arena_bytes) once it has run with memory planning
+  // enabled.
+  MemoryPlanStats memory_plan_stats(const std::string& method_name) const;
 
  private:
   c10::intrusive_ptr<c10::ivalue::Object> object_;
@@ -0,0 +1,187 @@
+#include <ATen/native/BlockSparseLinear.h>
+
+#include <torch/csrc/jit/ir/constants.h>
+#include <torch/csrc/jit/passes/block_sparse_linear.h>
+#include <torch/csrc/jit/passes/constant_pooling.h>
+#include <torch/csrc/jit/passes/dead_code_elimination.h>
+#include <torch/csrc/jit/passes/prepack_folding.h>
+
+#include <stack>
+
+namespace torch {
+namespace jit {
+
+namespace {
+
+// Whether the constant weight can be cut into out_block x in_block blocks and
+// has enough zero blocks for the block-sparse kernels to pay off.
+bool isSparseEnough(
+    const at::Tensor& weight,
+    double sparsity_threshold,
+    int64_t out_block,
+    int64_t in_block) {
+  if (weight.dim() != 2 || weight.size(0) % out_block != 0 ||
+      weight.size(1) % in_block != 0 || weight.numel() == 0) {
+    return false;
+  }
+  return at::native::block_sparsity(weight, out_block, in_block) >=
+      sparsity_threshold;
+}
+
+c10::optional<at::Tensor> constantTensor(Value* v) {
+  auto ival = toIValue(v);
+  if (!ival || !ival->isTensor()) {
+    return c10::nullopt;
+  }
+  return ival->toTensor();
+}
+
+bool isIntConstant(Value* v, int64_t value) {
+  auto ival = toIValue(v);
+  return ival && ival->isInt() && ival->toInt() == value;
+}
+
+// A linear op of the graph: out = input * weight^T + bias, with a constant
+// weight. weight_value is null when the graph only holds the transposed
+// weight, and bias is null when there is none.
+struct LinearMatch {
+  Node* node;
+  Value* input;
+  at::Tensor weight;
+  Value* weight_value;
+  Value* bias;
+};
+
+// Freezing inlines F.linear, so besides aten::linear this matches the
+// aten::addmm and aten::matmul it decomposes into, whose transposed weight
+// has been constant folded.
+c10::optional<LinearMatch> matchLinear(Node* n) {
+  if (n->kind() == aten::linear) {
+    auto w = constantTensor(n->input(1));
+    if (w) {
+      return LinearMatch{n, n->input(0), *w, n->input(1), n->input(2)};
+    }
+  } else if (n->kind() == aten::addmm) {
+    auto w_t = constantTensor(n->input(2));
+    auto bias = constantTensor(n->input(0));
+    if (w_t && w_t->dim() == 2 && bias && bias->dim() == 1 &&
+        bias->size(0) == w_t->size(1) && isIntConstant(n->input(3), 1) &&
+        isIntConstant(n->input(4), 1)) {
+      return LinearMatch{n, n->input(1), w_t->t(), nullptr, n->input(0)};
+    }
+  } else if (n->kind() == aten::matmul) {
+    auto w_t = constantTensor(n->input(1));
+    if (w_t && w_t->dim() == 2) {
+      return LinearMatch{n, n->input(0), w_t->t(), nullptr, nullptr};
+    }
+  }
+  return c10::nullopt;
+}
+
+void swapLinear(
+    const LinearMatch& match,
+    int64_t out_block,
+    int64_t in_block,
+    const std::shared_ptr<Graph>& graph) {
+  Node* n = match.node;
+  WithInsertPoint guard(n);
+  Value* weight = match.weight_value
+      ? match.weight_value
+      : graph->insertConstant(match.weight.contiguous());
+  Value* bias = match.bias ? match.bias : graph->insertConstant(IValue());
+  Value* ob = graph->insertConstant(out_block);
+  Value* ib = graph->insertConstant(in_block);
+  Value* packed = graph->insert(
+      Symbol::fromQualString("sparse::linear_block_sparse_prepack"),
+      {weight, bias, ob, ib});
+  Value* out = graph->insert(
+      Symbol::fromQualString("sparse::linear_block_sparse_run"),
+      {match.input, packed});
+  out->setType(n->output()->type());
+  n->output()->replaceAllUsesWith(out);
+}
+
+void swapQuantizedLinearPrepack(
+    Node* n,
+    int64_t out_block,
+    int64_t in_block,
+    const std::shared_ptr<Graph>& graph) {
+  WithInsertPoint guard(n);
+  Value* ob = graph->insertConstant(out_block);
+  Value* ib = graph->insertConstant(in_block);
+  Value* packed = graph->insert(
+      Symbol::fromQualString("quantized::linear_prepack_block_sparse"),
+      {n->input(0), n->input(1), ob, ib});
+  n->output()->replaceAllUsesWith(packed);
+}
+
+} // namespace
+
+void insertBlockSparseLinearOps(
+    std::shared_ptr<Graph>& graph,
+    double sparsity_threshold,
+    int64_t out_block,
+    int64_t in_block) {
+  const auto linear_prepack =
+      Symbol::fromQualString("quantized::linear_prepack");
+
+  std::vector<LinearMatch> linears;
+  std::vector<Node*> prepacks;
+  std::stack<Block*> blocks_to_visit;
+  blocks_to_visit.push(graph->block());
+  while (!blocks_to_visit.empty()) {
+    Block* b = blocks_to_visit.top();
+    blocks_to_visit.pop();
+    for (Node* n : b->nodes()) {
+      if (n->kind() == linear_prepack) {
+        auto w = constantTensor(n->input(0));
+        if (w && w->scalar_type() == at::kQInt8 &&
+            isSparseEnough(*w, sparsity_threshold, out_block, in_block)) {
+          prepacks.push_back(n);
+        }
+      } else if (auto match = matchLinear(n)) {
+        if (match->weight.scalar_type() == at::kFloat &&
+            isSparseEnough(
+                match->weight, sparsity_threshold, out_block, in_block)) {
+          linears.push_back(*match);
+        }
+      }
+      for (Block* subblock : n->blocks()) {
+        blocks_to_visit.push(subblock);
+      }
+    }
+  }
+
+  for (const auto& match : linears) {
+    swapLinear(match, out_block, in_block, graph);
+    match.node->destroy();
+  }
+  for (Node* n : prepacks) {
+    swapQuantizedLinearPrepack(n, out_block, in_block, graph);
+    n->destroy();
+  }
+  EliminateDeadCode(graph);
+  ConstantPooling(graph);
+}
+
+void insertBlockSparseLinearOps(
+    script::Module& module,
+    double sparsity_threshold,
+    int64_t out_block,
+    int64_t in_block) {
+  for (auto& method : module.get_methods()) {
+    auto graph = method.graph();
+    insertBlockSparseLinearOps(graph, sparsity_threshold, out_block, in_block);
+  }
+  PrePackingOpsFilterFn filter_fn = [](const Node* n) -> bool {
+    return (
+        n->kind() ==
+            Symbol::fromQualString("sparse::linear_block_sparse_prepack") ||
+        n->kind() ==
+            Symbol::fromQualString("quantized::linear_prepack_block_sparse"));
+  };
+  PrePackingOpsFolder(module, filter_fn, "block_sparse_folding");
+}
+
+} // namespace jit
+} // namespace torch
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <torch/csrc/jit/api/module.h>
+#include <torch/csrc/jit/ir/ir.h>
+
+namespace torch {
+namespace jit {
+
+// Replaces the linear ops of a frozen module whose constant weight has at
+// least sparsity_threshold of its out_block x in_block blocks entirely zero:
+//  - aten::linear with a float weight becomes
+//    sparse::linear_block_sparse_prepack + sparse::linear_block_sparse_run
+//  - quantized::linear_prepack becomes quantized::linear_prepack_block_sparse
+// The prepack ops are then folded into attributes of the module.
+TORCH_API void insertBlockSparseLinearOps(
+    std::shared_ptr<Graph>& graph,
+    double sparsity_threshold,
+    int64_t out_block = 1,
+    int64_t in_block = 4);
+TORCH_API void insertBlockSparseLinearOps(
+    script::Module& module,
+    double sparsity_threshold,
+    int64_t out_block = 1,
+    int64_t in_block = 4);
+
+} // namespace jit
+} // namespace torch
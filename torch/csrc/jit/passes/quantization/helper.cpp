@@ -200,7 +200,7 @@ std::vector<std::string> _tensor_info_funcs = {"size", "len", "dim", "numel"};
 
 // Aten functions whose output will be quantized or not quantized depending
 // on input tensor
-std::vector<std::string> _propagate_quant_single_input_ops = {"cat"};
+std::vector<std::string> _propagate_quant_single_input_ops = {"cat", "softmax"};
 
 // Rules are slightly different for binary ops like `aten::add`, for these ops,
 // if both of the inputs are Tensor, we'll quantize the output only if both of
@@ -210,7 +210,9 @@ std::vector<std::string> _propagate_quant_single_input_ops = {"cat"};
 std::vector<std::string> _propagate_quant_binary_ops = {"add",
                                                         "add_",
                                                         "mul",
-                                                        "mul_"};
+                                                        "mul_",
+                                                        "matmul",
+                                                        "bmm"};
 
 // Check if `use` is an aten function of name `func_name` and if value
 // `v` is the nth argument (if provided) of the function.
@@ -294,12 +294,15 @@ Node* insertEmbeddingBagOps(Node* observer, const std::string& op_name) {
   if (op_name == "embedding_bag_4bit") {
     prepack_fn = "quantized::embedding_bag_4bit_prepack";
     quant_fn = "quantized::embedding_bag_4bit_rowwise_offsets";
+  } else if (op_name == "embedding_bag_2bit") {
+    prepack_fn = "quantized::embedding_bag_2bit_prepack";
+    quant_fn = "quantized::embedding_bag_2bit_rowwise_offsets";
   } else if (op_name == "embedding_bag_byte") {
     prepack_fn = "quantized::embedding_bag_byte_prepack";
     quant_fn = "quantized::embedding_bag_byte_rowwise_offsets";
   } else {
     TORCH_INTERNAL_ASSERT(
-        "Graph Mode Quantization currently supports 4-bit and 8-bit embedding bag quantization.");
+        "Graph Mode Quantization currently supports 2-bit, 4-bit and 8-bit embedding bag quantization.");
   }
 
   std::vector<Value*> prepack_inputs = {observer_out};
@@ -334,12 +337,17 @@ Node* insertEmbeddingBagOps(Node* observer, const std::string& op_name) {
       /* mode */ zero,
       /* sparse */ embedding_bag_inputs[8],
       /* per_sample_weights_ */ embedding_bag_inputs[9]};
-
-  if (op_name == "embedding_bag_4bit") {
-    // 4-bit op has an extra input compressed_indices_mapping
-    qembedding_bag_inputs.push_back(none);
+  // The byte op takes compressed_indices_mapping last, the 4-bit and 2-bit
+  // ops before include_last_offset.
+  if (op_name == "embedding_bag_byte") {
+    qembedding_bag_inputs.push_back(
+        /* include_last_offset */ embedding_bag_inputs[10]);
+    qembedding_bag_inputs.push_back(/* compressed_indices_mapping */ none);
+  } else {
+    qembedding_bag_inputs.push_back(/* compressed_indices_mapping */ none);
+    qembedding_bag_inputs.push_back(
+        /* include_last_offset */ embedding_bag_inputs[10]);
   }
-  qembedding_bag_inputs.push_back(embedding_bag_inputs[10]);
 
   Node* qembedding_bag =
       g->create(Symbol::fromQualString(quant_fn), qembedding_bag_inputs);
@@ -230,6 +230,30 @@ bool input_b_is_scalar(
   return isScalar(b_scalar);
 }
 
+// filter that checks the optional %dtype of aten::softmax is None
+bool softmax_dtype_is_none(
+    const Match& match,
+    const std::unordered_map<std::string, Value*>& vmap) {
+  const auto& match_vmap = match.values_map;
+  return match_vmap.at(vmap.at("dtype"))->mustBeNone();
+}
+
+// filter that checks the key of an attention block is transposed on its last
+// two dimensions and the softmax is taken over the last dimension, which is
+// what quantized::scaled_dot_product_attention computes. Ranks are not known
+// here; the op follows the aten::matmul rules for 1D inputs and batch
+// broadcasting, so any shapes the float block accepts are fine
+bool is_attention_block(
+    const Match& match,
+    const std::unordered_map<std::string, Value*>& vmap) {
+  const bool transposed =
+      (is_int_constant(match, vmap, "dim0", -2) &&
+       is_int_constant(match, vmap, "dim1", -1)) ||
+      (is_int_constant(match, vmap, "dim0", -1) &&
+       is_int_constant(match, vmap, "dim1", -2));
+  return transposed && is_int_constant(match, vmap, "softmax_dim", -1);
+}
+
 // Patterns for ops that require observation for output quantization parameters
 // Example:
 //
@@ -691,6 +715,70 @@ graph(%a_quant, %b_quant, %scale, %zero_point, %dtype):
          %r = quantized::mul_relu(%a_quant, %b_quant, %scale, %zero_point)
          return (%r) )";
 
+  // aten::matmul
+  std::string matmul = R"(
+graph(%a_quant, %b_quant, %scale, %zero_point, %dtype):
+         %a_dequant = aten::dequantize(%a_quant)
+         %b_dequant = aten::dequantize(%b_quant)
+         %r_matmul = aten::matmul(%a_dequant, %b_dequant)
+         %r = aten::quantize_per_tensor(%r_matmul, %scale, %zero_point, %dtype)
+         return (%r) )";
+
+  // quantized::matmul
+  std::string quantized_matmul = R"(
+graph(%a_quant, %b_quant, %scale, %zero_point, %dtype):
+         %r = quantized::matmul(%a_quant, %b_quant, %scale, %zero_point)
+         return (%r) )";
+
+  // aten::bmm
+  std::string bmm = R"(
+graph(%a_quant, %b_quant, %scale, %zero_point, %dtype):
+         %a_dequant = aten::dequantize(%a_quant)
+         %b_dequant = aten::dequantize(%b_quant)
+         %r_bmm = aten::bmm(%a_dequant, %b_dequant)
+         %r = aten::quantize_per_tensor(%r_bmm, %scale, %zero_point, %dtype)
+         return (%r) )";
+
+  // quantized::bmm
+  std::string quantized_bmm = R"(
+graph(%a_quant, %b_quant, %scale, %zero_point, %dtype):
+         %r = quantized::bmm(%a_quant, %b_quant, %scale, %zero_point)
+         return (%r) )";
+
+  // aten::softmax
+  std::string softmax = R"(
+graph(%a_quant, %dim, %dtype, %scale, %zero_point, %qdtype):
+         %a_dequant = aten::dequantize(%a_quant)
+         %r_softmax = aten::softmax(%a_dequant, %dim, %dtype)
+         %r = aten::quantize_per_tensor(%r_softmax, %scale, %zero_point, %qdtype)
+         return (%r) )";
+
+  // quantized::softmax
+  std::string quantized_softmax = R"(
+graph(%a_quant, %dim, %dtype, %scale, %zero_point, %qdtype):
+         %r = quantized::softmax(%a_quant, %dim, %scale, %zero_point)
+         return (%r) )";
+
+  // quantized::scaled_dot_product_attention -- fusing the
+  // quantized::matmul - quantized::softmax - quantized::matmul sequence of an
+  // attention block, which removes the quantization of the scores and of the
+  // attention weights. The scaling of the scores is expected to be folded into
+  // the query, as in nn.MultiheadAttention.
+  std::string attention = R"(
+graph(%q, %k, %v, %dim0, %dim1, %s_scale, %s_zero_point, %softmax_dim, %w_scale, %w_zero_point, %scale, %zero_point):
+         %k_t = aten::transpose(%k, %dim0, %dim1)
+         %scores = quantized::matmul(%q, %k_t, %s_scale, %s_zero_point)
+         %weights = quantized::softmax(%scores, %softmax_dim, %w_scale, %w_zero_point)
+         %r = quantized::matmul(%weights, %v, %scale, %zero_point)
+         return (%r) )";
+
+  std::string quantized_attention = R"(
+graph(%q, %k, %v, %dim0, %dim1, %s_scale, %s_zero_point, %softmax_dim, %w_scale, %w_zero_point, %scale, %zero_point):
+         %sm_scale : float = prim::Constant[value=1.]()
+         %attn_mask : NoneType = prim::Constant()
+         %r = quantized::scaled_dot_product_attention(%q, %k, %v, %sm_scale, %scale, %zero_point, %attn_mask)
+         return (%r) )";
+
   // quantized::mul_scalar_relu -- fusing quantized::mul_scalar
   // and aten::relu
   auto quantized_mul_scalar_relu_pattern = R"(
@@ -953,6 +1041,9 @@ graph(%a_quant, %alpha, %scale, %input_scale, %r_scale, %r_zero_point, %r_dtype)
       {"quantized::mul_relu", inplace_mul_inplace_relu, quantized_mul_relu},
       {"quantized::mul", mul, quantized_mul},
       {"quantized::mul", inplace_mul, quantized_mul},
+      {"quantized::matmul", matmul, quantized_matmul},
+      {"quantized::bmm", bmm, quantized_bmm},
+      {"quantized::softmax", softmax, quantized_softmax, {softmax_dtype_is_none}},
       hardswish,
       hardswish_,
       layer_norm,
@@ -986,6 +1077,12 @@ graph(%a_quant, %alpha, %scale, %input_scale, %r_scale, %r_zero_point, %r_dtype)
       sigmoid_,
       tanh,
       tanh_,
+      // note that this must come after the quantized::matmul and
+      // quantized::softmax patterns
+      {"quantized::scaled_dot_product_attention",
+       attention,
+       quantized_attention,
+       {is_attention_block}},
   };
 }
 
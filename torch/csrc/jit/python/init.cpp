@@ -7,6 +7,7 @@
 #include <torch/csrc/jit/frontend/ir_emitter.h>
 #include <torch/csrc/jit/frontend/tracer.h>
 #include <torch/csrc/jit/ir/irparser.h>
+#include <torch/csrc/jit/passes/block_sparse_linear.h>
 #include <torch/csrc/jit/passes/canonicalize.h>
 #include <torch/csrc/jit/passes/canonicalize_graph_fuser_ops.h>
 #include <torch/csrc/jit/passes/common_subexpression_elimination.h>
@@ -578,6 +579,19 @@ void initJITBindings(PyObject* module) {
       .def(
           "_jit_pass_fold_prepacking_ops",
           [](script::Module& module) { return FoldPrePackingOps(module); })
+      .def(
+          "_jit_pass_insert_block_sparse_linear_ops",
+          [](script::Module& module,
+             double sparsity_threshold,
+             int64_t out_block,
+             int64_t in_block) {
+            return insertBlockSparseLinearOps(
+                module, sparsity_threshold, out_block, in_block);
+          },
+          py::arg("module"),
+          py::arg("sparsity_threshold"),
+          py::arg("out_block") = 1,
+          py::arg("in_block") = 4)
       .def(
           "_jit_pass_optimize_for_mobile",
           [](script::Module& module,
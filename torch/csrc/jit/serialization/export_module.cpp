@@ -4,6 +4,7 @@
 #include <torch/csrc/jit/ir/attributes.h>
 #include <torch/csrc/jit/ir/ir.h>
 #include <torch/csrc/jit/ir/type_hashing.h>
+#include <torch/csrc/jit/mobile/flat_bytecode.h>
 #include <torch/csrc/jit/passes/inliner.h>
 #include <torch/csrc/jit/passes/reconstruct_scopes.h>
 #include <torch/csrc/jit/runtime/instruction.h>
@@ -388,6 +389,12 @@ class ScriptModuleSerializer {
 
     moduleMethodsTuple(
         module, elements, debug_info_elements, save_mobile_debug_info);
+    // The flat copy of the bytecode lets the lite interpreter skip the
+    // unpickling of bytecode.pkl, which stays for older runtimes.
+    if (auto flat = mobile::flattenBytecode(elements)) {
+      writer_.writeRecord(
+          mobile::kFlatBytecodeRecord, flat->data(), flat->size());
+    }
     auto telements = Tup(std::move(elements));
     writeArchive("bytecode", telements);
     if (save_mobile_debug_info) {
@@ -7,6 +7,7 @@ import threading
 from typing import Generic, TypeVar
 
 import torch
+import torch.distributed.autograd as dist_autograd
 
 from . import (
     PyRRef,
@@ -272,6 +273,9 @@ def shutdown(graceful=True):
     if graceful:
         _wait_all_workers()
         _delete_all_user_and_unforked_owner_rrefs()
+        # Send batched autograd context cleanups before waiting for all
+        # outstanding work to finish.
+        dist_autograd._flush_context_cleanup()
         _get_current_rpc_agent().join()
     try:
         # This raises a `TORCH_CHECK()` exception on RRef leak detected.
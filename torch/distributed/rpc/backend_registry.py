@@ -100,6 +100,8 @@ def _process_group_construct_rpc_backend_options_handler(
     rpc_timeout,
     init_method,
     num_send_recv_threads=rpc_constants.DEFAULT_NUM_SEND_RECV_THREADS,
+    send_coalescing_bytes=rpc_constants.DEFAULT_SEND_COALESCING_BYTES,
+    send_coalescing_delay=rpc_constants.DEFAULT_SEND_COALESCING_DELAY,
     **kwargs
 ):
     from . import ProcessGroupRpcBackendOptions
@@ -107,7 +109,9 @@ def _process_group_construct_rpc_backend_options_handler(
     return ProcessGroupRpcBackendOptions(
         rpc_timeout=rpc_timeout,
         init_method=init_method,
-        num_send_recv_threads=num_send_recv_threads
+        num_send_recv_threads=num_send_recv_threads,
+        send_coalescing_bytes=send_coalescing_bytes,
+        send_coalescing_delay=send_coalescing_delay,
     )
 
 def _init_process_group(store, rank, world_size):
@@ -145,6 +149,8 @@ def _process_group_init_backend_handler(
         group,
         rpc_backend_options.num_send_recv_threads,
         timedelta(seconds=rpc_backend_options.rpc_timeout),
+        rpc_backend_options.send_coalescing_bytes,
+        timedelta(seconds=rpc_backend_options.send_coalescing_delay),
     )
 
 
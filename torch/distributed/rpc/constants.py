@@ -5,6 +5,8 @@ from . import (
     _DEFAULT_NUM_SEND_RECV_THREADS,
     _DEFAULT_NUM_WORKER_THREADS,
     _DEFAULT_RPC_TIMEOUT_SEC,
+    _DEFAULT_SEND_COALESCING_BYTES,
+    _DEFAULT_SEND_COALESCING_DELAY,
     _UNSET_RPC_TIMEOUT,
 )
 
@@ -15,6 +17,8 @@ DEFAULT_INIT_METHOD = _DEFAULT_INIT_METHOD
 
 # For ProcessGroupAgent.
 DEFAULT_NUM_SEND_RECV_THREADS = _DEFAULT_NUM_SEND_RECV_THREADS
+DEFAULT_SEND_COALESCING_BYTES = _DEFAULT_SEND_COALESCING_BYTES
+DEFAULT_SEND_COALESCING_DELAY = _DEFAULT_SEND_COALESCING_DELAY
 # For TensorPipeAgent.
 DEFAULT_NUM_WORKER_THREADS = _DEFAULT_NUM_WORKER_THREADS
 # Ensure that we don't time out when there are long periods of time without
@@ -7,7 +7,14 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+#include <algorithm>
 #include <chrono>
+#include <condition_variable>
 #include <cstdio>
 #include <functional>
 #include <iostream>
@@ -38,6 +45,28 @@ typename std::result_of<F()>::type syscall(F fn) {
   }
 }
 
+// The first record of the file holds its generation, which is bumped every
+// time the file is compacted. The key has no regular prefix, so it cannot
+// collide with user keys.
+const std::string kGenerationKey = "generation/";
+
+constexpr off_t kDefaultCompactionThreshold = 64 * 1024;
+
+// Delays between polls of the file double up to this value.
+constexpr std::chrono::milliseconds kMaxBackoff(32);
+
+class Backoff {
+ public:
+  std::chrono::milliseconds next() {
+    auto delay = delay_;
+    delay_ = std::min(delay_ * 2, kMaxBackoff);
+    return delay;
+  }
+
+ protected:
+  std::chrono::milliseconds delay_{1};
+};
+
 // For a comprehensive overview of file locking methods,
 // see: https://gavv.github.io/blog/file-locks/.
 // We stick to flock(2) here because we don't care about
@@ -91,6 +120,7 @@ class File {
       int flags,
       std::chrono::milliseconds timeout) {
     const auto start = std::chrono::steady_clock::now();
+    Backoff backoff;
     while (true) {
       fd_ = syscall(std::bind(::open, path.c_str(), flags, 0644));
       // Only retry when the file doesn't exist, since we are waiting for the
@@ -104,7 +134,8 @@ class File {
       if (timeout != c10d::Store::kNoTimeout && elapsed > timeout) {
         break;
       }
-      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      /* sleep override */
+      std::this_thread::sleep_for(backoff.next());
     }
     SYSASSERT(fd_, "open(" + path + ")");
   }
@@ -140,6 +171,11 @@ class File {
     return size;
   }
 
+  void truncate(off_t length) {
+    auto rv = syscall(std::bind(::ftruncate, fd_, length));
+    SYSASSERT(rv, "ftruncate");
+  }
+
   void write(const void* buf, size_t count) {
     while (count > 0) {
       auto rv = syscall(std::bind(::write, fd_, buf, count));
@@ -191,11 +227,35 @@ class File {
   int fd_;
 };
 
+off_t recordSize(const std::string& key, const std::vector<uint8_t>& value) {
+  return 2 * sizeof(uint32_t) + key.size() + value.size();
+}
+
+int64_t readGeneration(File& file) {
+  std::string key;
+  std::vector<uint8_t> value;
+  file.seek(0, SEEK_SET);
+  file.read(key);
+  file.read(value);
+  if (key != kGenerationKey) {
+    throw std::runtime_error("FileStore file has no generation header");
+  }
+  return std::stoll(std::string(value.begin(), value.end()));
+}
+
 off_t refresh(
     File& file,
     off_t pos,
-    std::unordered_map<std::string, std::vector<uint8_t>>& cache) {
+    std::unordered_map<std::string, std::vector<uint8_t>>& cache,
+    int64_t& generation,
+    off_t& liveBytes) {
   auto size = file.size();
+  // A compaction rewrites the file from the start, after which pos no longer
+  // points at a record. All keys are still in the compacted file, so reading
+  // it from the start brings the cache up to date.
+  if (pos > 0 && (size < pos || readGeneration(file) != generation)) {
+    pos = 0;
+  }
   if (size != pos) {
     std::string tmpKey;
     std::vector<uint8_t> tmpValue;
@@ -203,7 +263,19 @@ off_t refresh(
     while (size > pos) {
       file.read(tmpKey);
       file.read(tmpValue);
-      cache[tmpKey] = std::move(tmpValue);
+      if (tmpKey == kGenerationKey) {
+        generation =
+            std::stoll(std::string(tmpValue.begin(), tmpValue.end()));
+      } else {
+        auto it = cache.find(tmpKey);
+        if (it != cache.end()) {
+          liveBytes -= recordSize(it->first, it->second);
+          it->second = std::move(tmpValue);
+        } else {
+          it = cache.emplace(tmpKey, std::move(tmpValue)).first;
+        }
+        liveBytes += recordSize(it->first, it->second);
+      }
       pos = file.tell();
     }
   }
@@ -211,15 +283,220 @@ off_t refresh(
   return pos;
 }
 
+// Appends a record to the file. Must be called with the exclusive lock held.
+template <typename T>
+void append(File& file, const std::string& key, const T& value) {
+  // Always seek to the end to write
+  if (file.seek(0, SEEK_END) == 0) {
+    file.write(kGenerationKey);
+    file.write(std::to_string(0));
+  }
+  file.write(key);
+  file.write(value);
+}
+
+template <typename T>
+void appendToBuffer(std::vector<uint8_t>& buf, const T& data) {
+  uint32_t len = data.size();
+  assert(data.size() <= std::numeric_limits<decltype(len)>::max());
+  auto lenBytes = reinterpret_cast<const uint8_t*>(&len);
+  buf.insert(buf.end(), lenBytes, lenBytes + sizeof(len));
+  buf.insert(buf.end(), data.begin(), data.end());
+}
+
+// Rewrites the file with only the latest record of every key, if the file
+// is large enough and mostly made of outdated records. Must be called with
+// the exclusive lock held. Returns the new position in the file.
+off_t compactIfNeeded(
+    File& file,
+    off_t pos,
+    std::unordered_map<std::string, std::vector<uint8_t>>& cache,
+    int64_t& generation,
+    off_t& liveBytes,
+    off_t threshold) {
+  if (file.size() < threshold) {
+    return pos;
+  }
+  pos = refresh(file, pos, cache, generation, liveBytes);
+  if (pos < 2 * liveBytes) {
+    return pos;
+  }
+
+  // Write everything at once; readers hold the shared lock while they read,
+  // so they never see the file in between.
+  std::vector<uint8_t> buf;
+  buf.reserve(liveBytes + 64);
+  appendToBuffer(buf, kGenerationKey);
+  appendToBuffer(buf, std::to_string(generation + 1));
+  for (const auto& entry : cache) {
+    appendToBuffer(buf, entry.first);
+    appendToBuffer(buf, entry.second);
+  }
+  file.truncate(0);
+  file.seek(0, SEEK_SET);
+  file.write(buf.data(), buf.size());
+  file.seek(0, SEEK_SET);
+  generation++;
+  return buf.size();
+}
+
 } // namespace
 
+// Waits for writes to the file. With inotify(7), get() and wait() wake up as
+// soon as another process writes to the file instead of polling it. inotify
+// does not see writes made on other hosts of a shared filesystem (such as
+// NFS), so every wait is still bounded by an exponential backoff, which is
+// all that is left where inotify is not available.
+//
+// There is one watcher per store, because closing an inotify instance takes
+// milliseconds. Threads of the same store share it: one of them polls the
+// inotify descriptor and the others wait for it to count a change.
+class FileStore::Watcher {
+ public:
+  explicit Watcher(const std::string& path) : path_(path) {}
+
+  ~Watcher() {
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+  }
+
+  Watcher(const Watcher& that) = delete;
+
+  Watcher& operator=(const Watcher& that) = delete;
+
+  // Number of changes seen so far. Read it before checking the file, and
+  // pass it to wait(), so that no change after the check is missed.
+  uint64_t changes() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return changes_;
+  }
+
+  // Starts watching the file, if it is not watched yet, and returns true in
+  // that case. The caller must then check the file again before calling
+  // wait(), because writes made before the watch was added are not reported.
+  bool start() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (started_) {
+      return false;
+    }
+    started_ = true;
+#ifdef __linux__
+    fd_ = syscall(std::bind(::inotify_init1, IN_NONBLOCK | IN_CLOEXEC));
+    if (fd_ >= 0 && ::inotify_add_watch(fd_, path_.c_str(), IN_MODIFY) < 0) {
+      ::close(fd_);
+      fd_ = -1;
+    }
+#endif
+    return true;
+  }
+
+  // Blocks until the file changed after `seen` changes, or for the next
+  // backoff delay. Returns false, without blocking, if the deadline passed.
+  bool wait(
+      uint64_t seen,
+      Backoff& backoff,
+      const std::chrono::milliseconds& timeout,
+      const std::chrono::steady_clock::time_point& deadline) {
+    auto delay = backoff.next();
+    if (timeout != Store::kNoTimeout) {
+      const auto now = std::chrono::steady_clock::now();
+      if (now >= deadline) {
+        return false;
+      }
+      delay = std::min(
+          delay,
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              deadline - now) +
+              std::chrono::milliseconds(1));
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (changes_ != seen) {
+      return true;
+    }
+    if (fd_ < 0) {
+      lock.unlock();
+      /* sleep override */
+      std::this_thread::sleep_for(delay);
+      return true;
+    }
+    if (polling_) {
+      // Woken up when the polling thread is done, changed or not.
+      cv_.wait_for(lock, delay);
+      return true;
+    }
+#ifdef __linux__
+    polling_ = true;
+    const auto fd = fd_;
+    lock.unlock();
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    auto rv =
+        syscall(std::bind(::poll, &pfd, 1, static_cast<int>(delay.count())));
+    const auto removed = rv > 0 && drain(fd);
+    lock.lock();
+    polling_ = false;
+    if (rv > 0) {
+      changes_++;
+    }
+    if (removed) {
+      // The file was removed, and the watch with it. Watch it again once
+      // it is recreated.
+      ::close(fd_);
+      fd_ = -1;
+      started_ = false;
+    }
+    cv_.notify_all();
+    SYSASSERT(rv, "poll");
+#endif
+    return true;
+  }
+
+ protected:
+#ifdef __linux__
+  // Discards the pending events; waking up is all that matters. Returns true
+  // if the watch was removed.
+  static bool drain(int fd) {
+    alignas(struct inotify_event) char buf[4096];
+    auto removed = false;
+    while (true) {
+      auto rv = syscall(std::bind(::read, fd, buf, sizeof(buf)));
+      if (rv <= 0) {
+        // EAGAIN: no more events.
+        return removed;
+      }
+      for (auto p = buf; p < buf + rv;) {
+        auto event = reinterpret_cast<const struct inotify_event*>(p);
+        removed |= (event->mask & IN_IGNORED) != 0;
+        p += sizeof(struct inotify_event) + event->len;
+      }
+    }
+  }
+#endif
+
+  const std::string path_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool started_{false};
+  bool polling_{false};
+  uint64_t changes_{0};
+  int fd_{-1};
+};
+
 FileStore::FileStore(const std::string& path, int numWorkers)
     : Store(),
       path_(path),
       pos_(0),
+      generation_(0),
+      liveBytes_(0),
+      compactionThreshold_(kDefaultCompactionThreshold),
       numWorkers_(numWorkers),
       cleanupKey_("cleanup/"),
-      regularPrefix_("/") {
+      regularPrefix_("/"),
+      watcher_(new Watcher(path)) {
   if (numWorkers_ < 1) {
     throw std::runtime_error(
         "Number of workers for FileStore should be greater than zero");
@@ -237,41 +514,45 @@ FileStore::~FileStore() {
   }
 }
 
+void FileStore::setCompactionThreshold(off_t bytes) {
+  std::unique_lock<std::mutex> l(activeFileOpLock_);
+  compactionThreshold_ = bytes;
+}
+
 void FileStore::set(const std::string& key, const std::vector<uint8_t>& value) {
   std::string regKey = regularPrefix_ + key;
   std::unique_lock<std::mutex> l(activeFileOpLock_);
   File file(path_, O_RDWR | O_CREAT, timeout_);
   auto lock = file.lockExclusive();
-  file.seek(0, SEEK_END);
-  file.write(regKey);
-  file.write(value);
+  append(file, regKey, value);
+  pos_ = compactIfNeeded(
+      file, pos_, cache_, generation_, liveBytes_, compactionThreshold_);
 }
 
 std::vector<uint8_t> FileStore::get(const std::string& key) {
   std::string regKey = regularPrefix_ + key;
-  const auto start = std::chrono::steady_clock::now();
+  const auto deadline = std::chrono::steady_clock::now() + timeout_;
+  Backoff backoff;
   while (true) {
-    std::unique_lock<std::mutex> l(activeFileOpLock_);
-    File file(path_, O_RDONLY, timeout_);
-    auto lock = file.lockShared();
-    auto size = file.size();
-    if (cache_.count(regKey) == 0 && size == pos_) {
-      // No new entries; release the shared lock and sleep for a bit
-      lock.unlock();
-      l.unlock();
-      const auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
-          std::chrono::steady_clock::now() - start);
-      if (timeout_ != kNoTimeout && elapsed > timeout_) {
-        throw std::runtime_error("Timeout waiting for key: " + key);
+    const auto seen = watcher_->changes();
+    {
+      std::unique_lock<std::mutex> l(activeFileOpLock_);
+      File file(path_, O_RDONLY, timeout_);
+      auto lock = file.lockShared();
+      // Always refresh since even though the key exists in the cache,
+      // it might be outdated
+      pos_ = refresh(file, pos_, cache_, generation_, liveBytes_);
+      auto it = cache_.find(regKey);
+      if (it != cache_.end()) {
+        return it->second;
       }
-      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    // No such key yet; the locks are released while waiting for a write.
+    if (watcher_->start()) {
       continue;
     }
-    // Always refresh since even though the key exists in the cache,
-    // it might be outdated
-    pos_ = refresh(file, pos_, cache_);
-    if (cache_.count(regKey) != 0) {
-      return cache_[regKey];
+    if (!watcher_->wait(seen, backoff, timeout_, deadline)) {
+      throw std::runtime_error("Timeout waiting for key: " + key);
     }
   }
 }
@@ -280,21 +561,19 @@ int64_t FileStore::addHelper(const std::string& key, int64_t i) {
   std::unique_lock<std::mutex> l(activeFileOpLock_);
   File file(path_, O_RDWR | O_CREAT, timeout_);
   auto lock = file.lockExclusive();
-  pos_ = refresh(file, pos_, cache_);
+  pos_ = refresh(file, pos_, cache_, generation_, liveBytes_);
 
-  const auto& value = cache_[key];
   int64_t ti = i;
-  if (!value.empty()) {
-    auto buf = reinterpret_cast<const char*>(value.data());
-    auto len = value.size();
+  auto it = cache_.find(key);
+  if (it != cache_.end() && !it->second.empty()) {
+    auto buf = reinterpret_cast<const char*>(it->second.data());
+    auto len = it->second.size();
     ti += std::stoll(std::string(buf, len));
   }
-  // Always seek to the end to write
-  file.seek(0, SEEK_END);
-  // File cursor is at the end of the file now, and we have an
-  // exclusive lock, so we can write the new value.
-  file.write(key);
-  file.write(std::to_string(ti));
+  // We have an exclusive lock, so we can append the new value.
+  append(file, key, std::to_string(ti));
+  pos_ = compactIfNeeded(
+      file, pos_, cache_, generation_, liveBytes_, compactionThreshold_);
   return ti;
 }
 
@@ -307,7 +586,7 @@ bool FileStore::check(const std::vector<std::string>& keys) {
   std::unique_lock<std::mutex> l(activeFileOpLock_);
   File file(path_, O_RDONLY, timeout_);
   auto lock = file.lockShared();
-  pos_ = refresh(file, pos_, cache_);
+  pos_ = refresh(file, pos_, cache_, generation_, liveBytes_);
 
   for (const auto& key : keys) {
     std::string regKey = regularPrefix_ + key;
@@ -326,18 +605,19 @@ void FileStore::wait(const std::vector<std::string>& keys) {
 void FileStore::wait(
     const std::vector<std::string>& keys,
     const std::chrono::milliseconds& timeout) {
-  // Not using inotify because it doesn't work on many
-  // shared filesystems (such as NFS).
-  const auto start = std::chrono::steady_clock::now();
-  while (!check(keys)) {
-    const auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
-        std::chrono::steady_clock::now() - start);
-    if (timeout != kNoTimeout && elapsed > timeout) {
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  Backoff backoff;
+  while (true) {
+    const auto seen = watcher_->changes();
+    if (check(keys)) {
+      return;
+    }
+    if (watcher_->start()) {
+      continue;
+    }
+    if (!watcher_->wait(seen, backoff, timeout, deadline)) {
       throw std::runtime_error("Wait timeout");
     }
-
-    /* sleep override */
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
   }
 }
 
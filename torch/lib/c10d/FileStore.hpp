@@ -2,6 +2,7 @@
 
 #include <sys/types.h>
 
+#include <memory>
 #include <mutex>
 #include <unordered_map>
 
@@ -29,12 +30,25 @@ class FileStore : public Store {
       const std::vector<std::string>& keys,
       const std::chrono::milliseconds& timeout) override;
 
+  // Every set and add appends a record to the file. Once the file is at
+  // least this large, and at least twice as large as the latest records of
+  // all keys, the writer rewrites it with only the latest records.
+  void setCompactionThreshold(off_t bytes);
+
  protected:
   int64_t addHelper(const std::string& key, int64_t i);
 
   std::string path_;
   off_t pos_;
 
+  // Generation of the file that pos_ refers to. Bumped by every compaction.
+  int64_t generation_;
+
+  // Size of the latest records of all keys in cache_.
+  off_t liveBytes_;
+
+  off_t compactionThreshold_;
+
   int numWorkers_;
   const std::string cleanupKey_;
   const std::string regularPrefix_;
@@ -42,6 +56,10 @@ class FileStore : public Store {
   std::unordered_map<std::string, std::vector<uint8_t>> cache_;
 
   std::mutex activeFileOpLock_;
+
+  // Wakes up get() and wait() when the file is written to.
+  class Watcher;
+  std::unique_ptr<Watcher> watcher_;
 };
 
 } // namespace c10d
@@ -6,64 +6,91 @@
 
 #include <chrono>
 #include <cstdio>
+#include <functional>
 #include <system_error>
 
 namespace c10d {
 
-void HashStore::set(const std::string& key, const std::vector<uint8_t>& data) {
-  std::unique_lock<std::mutex> lock(m_);
-  map_[key] = data;
-  cv_.notify_all();
+constexpr size_t HashStore::kNumShards;
+
+HashStore::Shard& HashStore::shardFor(const std::string& key) {
+  return shards_[std::hash<std::string>()(key) % kNumShards];
 }
 
-std::vector<uint8_t> HashStore::get(const std::string& key) {
-  std::unique_lock<std::mutex> lock(m_);
-  auto it = map_.find(key);
-  if (it != map_.end()) {
-    return it->second;
+void HashStore::notifyLocked(Shard& shard, const std::string& key) {
+  auto it = shard.waiters.find(key);
+  if (it != shard.waiters.end()) {
+    it->second.cv.notify_all();
   }
-  // Slow path: wait up to any timeout_.
-  auto pred = [&]() { return map_.find(key) != map_.end(); };
-  if (timeout_ == kNoTimeout) {
-    cv_.wait(lock, pred);
+}
+
+std::unordered_map<std::string, std::vector<uint8_t>>::iterator HashStore::
+    waitLocked(
+        Shard& shard,
+        std::unique_lock<std::mutex>& lock,
+        const std::string& key,
+        const std::chrono::milliseconds& timeout,
+        const std::chrono::steady_clock::time_point& deadline) {
+  auto it = shard.map.find(key);
+  if (it != shard.map.end()) {
+    return it;
+  }
+
+  // Elements of an unordered_map are not moved on rehash, so the reference
+  // stays valid until the last waiter erases the entry.
+  auto& waiters = shard.waiters[key];
+  waiters.count++;
+  auto pred = [&]() {
+    it = shard.map.find(key);
+    return it != shard.map.end();
+  };
+  auto found = true;
+  if (timeout == kNoTimeout) {
+    waiters.cv.wait(lock, pred);
   } else {
-    if (!cv_.wait_for(lock, timeout_, pred)) {
-      throw std::system_error(
-          ETIMEDOUT, std::system_category(), "Wait timeout");
-    }
+    found = waiters.cv.wait_until(lock, deadline, pred);
   }
-  return map_[key];
+  if (--waiters.count == 0) {
+    shard.waiters.erase(key);
+  }
+  if (!found) {
+    throw std::system_error(ETIMEDOUT, std::system_category(), "Wait timeout");
+  }
+  return it;
+}
+
+void HashStore::set(const std::string& key, const std::vector<uint8_t>& data) {
+  auto& shard = shardFor(key);
+  std::unique_lock<std::mutex> lock(shard.m);
+  shard.map[key] = data;
+  notifyLocked(shard, key);
+}
+
+std::vector<uint8_t> HashStore::get(const std::string& key) {
+  auto& shard = shardFor(key);
+  std::unique_lock<std::mutex> lock(shard.m);
+  // Waits up to timeout_ if the key is not set yet.
+  const auto deadline = std::chrono::steady_clock::now() + timeout_;
+  return waitLocked(shard, lock, key, timeout_, deadline)->second;
 }
 
 void HashStore::wait(
     const std::vector<std::string>& keys,
     const std::chrono::milliseconds& timeout) {
-  const auto end = std::chrono::steady_clock::now() + timeout;
-  auto pred = [&]() {
-    auto done = true;
-    for (const auto& key : keys) {
-      if (map_.find(key) == map_.end()) {
-        done = false;
-        break;
-      }
-    }
-    return done;
-  };
-
-  std::unique_lock<std::mutex> lock(m_);
-  if (timeout == kNoTimeout) {
-    cv_.wait(lock, pred);
-  } else {
-    if (!cv_.wait_until(lock, end, pred)) {
-      throw std::system_error(
-          ETIMEDOUT, std::system_category(), "Wait timeout");
-    }
+  // Keys are never removed, so waiting for one key after the other is the
+  // same as waiting for all of them at once.
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  for (const auto& key : keys) {
+    auto& shard = shardFor(key);
+    std::unique_lock<std::mutex> lock(shard.m);
+    waitLocked(shard, lock, key, timeout, deadline);
   }
 }
 
 int64_t HashStore::add(const std::string& key, int64_t i) {
-  std::unique_lock<std::mutex> lock(m_);
-  const auto& value = map_[key];
+  auto& shard = shardFor(key);
+  std::unique_lock<std::mutex> lock(shard.m);
+  auto& value = shard.map[key];
   int64_t ti = i;
   if (!value.empty()) {
     auto buf = reinterpret_cast<const char*>(value.data());
@@ -73,14 +100,16 @@ int64_t HashStore::add(const std::string& key, int64_t i) {
 
   auto str = std::to_string(ti);
   const uint8_t* strB = reinterpret_cast<const uint8_t*>(str.c_str());
-  map_[key] = std::vector<uint8_t>(strB, strB + str.size());
+  value = std::vector<uint8_t>(strB, strB + str.size());
+  notifyLocked(shard, key);
   return ti;
 }
 
 bool HashStore::check(const std::vector<std::string>& keys) {
-  std::unique_lock<std::mutex> lock(m_);
   for (const auto& key : keys) {
-    if (map_.find(key) == map_.end()) {
+    auto& shard = shardFor(key);
+    std::unique_lock<std::mutex> lock(shard.m);
+    if (shard.map.find(key) == shard.map.end()) {
       return false;
     }
   }
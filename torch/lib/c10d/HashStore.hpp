@@ -2,6 +2,7 @@
 
 #include <sys/types.h>
 
+#include <array>
 #include <condition_variable>
 #include <mutex>
 #include <unordered_map>
@@ -31,9 +32,40 @@ class HashStore : public Store {
   bool check(const std::vector<std::string>& keys) override;
 
  protected:
-  std::unordered_map<std::string, std::vector<uint8_t>> map_;
-  std::mutex m_;
-  std::condition_variable cv_;
+  // Threads waiting for one key. They share a condition variable that is
+  // only notified when that key is set.
+  struct Waiters {
+    std::condition_variable cv;
+    size_t count = 0;
+  };
+
+  // Keys are spread over shards by hash, so that operations on different keys
+  // rarely contend on the same mutex, and a set only wakes up the threads
+  // waiting for that key.
+  struct Shard {
+    std::mutex m;
+    std::unordered_map<std::string, std::vector<uint8_t>> map;
+    std::unordered_map<std::string, Waiters> waiters;
+  };
+
+  static constexpr size_t kNumShards = 16;
+
+  Shard& shardFor(const std::string& key);
+
+  // Blocks until key is set or the deadline passes. Returns an iterator to
+  // the value. Must be called with the mutex of the shard held by lock.
+  std::unordered_map<std::string, std::vector<uint8_t>>::iterator waitLocked(
+      Shard& shard,
+      std::unique_lock<std::mutex>& lock,
+      const std::string& key,
+      const std::chrono::milliseconds& timeout,
+      const std::chrono::steady_clock::time_point& deadline);
+
+  // Wakes up the threads waiting for key. Must be called with the mutex of
+  // the shard held.
+  static void notifyLocked(Shard& shard, const std::string& key);
+
+  std::array<Shard, kNumShards> shards_;
 };
 
 } // namespace c10d
@@ -7,6 +7,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <array>
 #include <type_traits>
 
 #include <gloo/allgather.h>
@@ -19,6 +20,7 @@
 #include <gloo/gather.h>
 #include <gloo/reduce.h>
 #include <gloo/scatter.h>
+#include <gloo/types.h>
 
 #include <ATen/SparseTensorUtils.h>
 
@@ -195,6 +197,64 @@ ReduceFunc toFunction(const ReduceOp& r) {
   throw std::runtime_error("Unhandled ReduceOp");
 }
 
+// Reduces through ATen's CPU kernels instead of Gloo's scalar loops. These
+// kernels are written with Vec256 and dispatched on the CPU capability at
+// runtime, and they split large inputs across the intra-op thread pool.
+template <typename T, ReduceOp op>
+void vectorizedReduce(void* c, const void* a, const void* b, size_t n) {
+  const auto options =
+      at::TensorOptions().dtype(c10::CppTypeToScalarType<T>::value);
+  const auto numel = static_cast<int64_t>(n);
+  auto tc = at::from_blob(c, {numel}, options);
+  auto ta = at::from_blob(const_cast<void*>(a), {numel}, options);
+  auto tb = at::from_blob(const_cast<void*>(b), {numel}, options);
+  switch (op) {
+    case ReduceOp::SUM:
+      at::add_out(tc, ta, tb);
+      break;
+    case ReduceOp::PRODUCT:
+      at::mul_out(tc, ta, tb);
+      break;
+    case ReduceOp::MIN:
+      at::min_out(tc, ta, tb);
+      break;
+    case ReduceOp::MAX:
+      at::max_out(tc, ta, tb);
+      break;
+    default:
+      throw std::runtime_error("Unhandled ReduceOp");
+  }
+}
+
+template <
+    typename T,
+    typename std::enable_if<!std::is_same<T, gloo::float16>::value, int>::type =
+        0>
+ReduceFunc toVectorizedFunction(const ReduceOp& r) {
+  switch (r) {
+    case ReduceOp::SUM:
+      return ReduceFunc(&vectorizedReduce<T, ReduceOp::SUM>);
+    case ReduceOp::PRODUCT:
+      return ReduceFunc(&vectorizedReduce<T, ReduceOp::PRODUCT>);
+    case ReduceOp::MIN:
+      return ReduceFunc(&vectorizedReduce<T, ReduceOp::MIN>);
+    case ReduceOp::MAX:
+      return ReduceFunc(&vectorizedReduce<T, ReduceOp::MAX>);
+    default:
+      return toFunction<T>(r);
+  }
+}
+
+// ATen has no CPU kernels for half precision min and max; Gloo's functions
+// are used as is.
+template <
+    typename T,
+    typename std::enable_if<std::is_same<T, gloo::float16>::value, int>::type =
+        0>
+ReduceFunc toVectorizedFunction(const ReduceOp& r) {
+  return toFunction<T>(r);
+}
+
 template <typename T, typename O>
 void setInputs(O& opts, std::vector<at::Tensor>& tensors) {
   opts.setInputs(getDataPointers<T>(tensors), tensors[0].numel());
@@ -405,7 +465,9 @@ void ProcessGroupGloo::RecvWork::abort() {
 }
 
 ProcessGroupGloo::Options::Options()
-    : timeout(std::chrono::milliseconds(10 * 1000)), threads(2) {}
+    : timeout(std::chrono::milliseconds(10 * 1000)),
+      threads(2),
+      allreduceChunkBytes(0) {}
 
 namespace {
 
@@ -523,7 +585,8 @@ ProcessGroupGloo::ProcessGroupGloo(
     : ProcessGroup(rank, size),
       store_(new GlooStore(store)),
       stop_(false),
-      collectiveCounter_(0) {
+      collectiveCounter_(0),
+      allreduceChunkBytes_(options.allreduceChunkBytes) {
   auto& devices = options.devices;
   if (devices.empty()) {
     throw std::runtime_error("No device(s) specified");
@@ -852,6 +915,89 @@ class AsyncAllreduceCoalescedWork : public AsyncAllreduceWork {
   }
 };
 
+// Returned to the caller of a chunked allreduce. It is never queued itself;
+// it completes when the last of its segments completes.
+class ChunkedAllreduceWork : public ProcessGroup::Work {
+ public:
+  ChunkedAllreduceWork(at::Tensor tensor, size_t numSegments)
+      : tensor_(std::move(tensor)), remaining_(numSegments) {}
+
+  void segmentDone(std::exception_ptr eptr) {
+    std::unique_lock<std::mutex> lock(segmentMutex_);
+    if (eptr && !segmentException_) {
+      segmentException_ = eptr;
+    }
+    if (--remaining_ > 0) {
+      return;
+    }
+    lock.unlock();
+    finish(segmentException_);
+  }
+
+ protected:
+  // Keeps the tensor alive while segments are in flight.
+  at::Tensor tensor_;
+
+  std::mutex segmentMutex_;
+  size_t remaining_;
+  std::exception_ptr segmentException_;
+};
+
+// One segment of a chunked allreduce. Segments have their own tags, so the
+// worker threads run them concurrently, on all contexts. While one segment
+// reduces data it received, the others keep transferring.
+class AsyncAllreduceSegmentWork : public ProcessGroupGloo::AsyncWork {
+ public:
+  AsyncAllreduceSegmentWork(
+      const std::shared_ptr<gloo::Context>& context,
+      at::Tensor segment,
+      ReduceOp reduceOp,
+      uint32_t tag,
+      std::shared_ptr<ChunkedAllreduceWork> parent)
+      : context(context),
+        segment(std::move(segment)),
+        reduceOp(reduceOp),
+        tag(tag),
+        parent(std::move(parent)) {}
+
+  std::shared_ptr<gloo::Context> context;
+  at::Tensor segment;
+  const ReduceOp reduceOp;
+  const uint32_t tag;
+  std::shared_ptr<ChunkedAllreduceWork> parent;
+
+  void run() override {
+    std::exception_ptr eptr;
+    try {
+      const auto& scalarType = segment.scalar_type();
+      gloo::AllreduceOptions opts(context);
+      opts.setReduceFunction(getFunction(scalarType, reduceOp));
+      opts.setTag(tag);
+      GENERATE_ALL_TYPES(scalarType, setOutput, opts, segment);
+      gloo::allreduce(opts);
+    } catch (...) {
+      eptr = std::current_exception();
+    }
+    parent->segmentDone(eptr);
+    if (eptr) {
+      std::rethrow_exception(eptr);
+    }
+  }
+
+  template <typename T>
+  void getFunction(gloo::AllreduceOptions::Func& fn, const ReduceOp op) {
+    fn = toVectorizedFunction<T>(op);
+  }
+
+  gloo::AllreduceOptions::Func getFunction(
+      const at::ScalarType& dtype,
+      const ReduceOp op) {
+    gloo::AllreduceOptions::Func fn;
+    GENERATE_ALL_TYPES(dtype, getFunction, fn, op);
+    return fn;
+  }
+};
+
 class AsyncSparseAllreduceWork : public ProcessGroupGloo::AsyncWork {
  public:
   AsyncSparseAllreduceWork(
@@ -1280,6 +1426,32 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::allreduce(
         "(allreduce of sparse tensors only works with ReduceOp.SUM)");
   }
 
+  // Large, single, contiguous CPU tensors are reduced in segments. Every
+  // process derives the same number of segments from the tensor size, so the
+  // segments consume the same tags everywhere.
+  const auto& input = inputs[0];
+  if (allreduceChunkBytes_ > 0 && device.type() == at::kCPU &&
+      layout == c10::kStrided && inputs.size() == 1 &&
+      input.is_contiguous() && input.nbytes() > allreduceChunkBytes_) {
+    const auto flat = input.view({-1});
+    const int64_t chunkSize =
+        std::max<int64_t>(1, allreduceChunkBytes_ / input.element_size());
+    const int64_t numel = flat.numel();
+    const auto numSegments = (numel + chunkSize - 1) / chunkSize;
+    auto chunkedWork =
+        std::make_shared<ChunkedAllreduceWork>(input, numSegments);
+    for (int64_t offset = 0; offset < numel; offset += chunkSize) {
+      auto tag = nextTag();
+      enqueue(std::make_shared<AsyncAllreduceSegmentWork>(
+          getContext(tag),
+          flat.narrow(0, offset, std::min(chunkSize, numel - offset)),
+          opts.reduceOp,
+          tag,
+          chunkedWork));
+    }
+    return chunkedWork;
+  }
+
   std::shared_ptr<AsyncWork> work;
   auto tag = nextTag();
   auto context = getContext(tag);
@@ -1856,12 +2028,78 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::allgather_coalesced(
   return work;
 }
 
+namespace {
+
+class AsyncAllgatherBaseWork : public ProcessGroupGloo::AsyncWork {
+ public:
+  AsyncAllgatherBaseWork(
+      const std::shared_ptr<gloo::Context>& context,
+      at::Tensor& outputBuffer,
+      at::Tensor& inputBuffer,
+      uint32_t tag)
+      : context(context),
+        outputBuffer(outputBuffer),
+        inputBuffer(inputBuffer),
+        tag(tag) {}
+
+  std::shared_ptr<gloo::Context> context;
+  at::Tensor outputBuffer;
+  at::Tensor inputBuffer;
+  const uint32_t tag;
+
+  void run() override {
+    const auto& scalarType = inputBuffer.scalar_type();
+    gloo::AllgatherOptions opts(context);
+    opts.setTag(tag);
+
+    // The output buffer is already laid out as [size, inputBuffer.numel()],
+    // so Gloo's ring allgather can write into it directly without a flat
+    // intermediate or a copy afterwards.
+    GENERATE_ALL_TYPES(scalarType, setInput, opts, inputBuffer);
+    GENERATE_ALL_TYPES(scalarType, setOutput, opts, outputBuffer);
+    gloo::allgather(opts);
+  }
+};
+
+} // namespace
+
 std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::allgather_base(
-    at::Tensor& /*unused */,
-    at::Tensor& /*unused */,
+    at::Tensor& outputBuffer,
+    at::Tensor& inputBuffer,
     const AllgatherOptions& /*unused */) {
-  throw std::runtime_error(
-      "no support for allgather_base in Gloo process group");
+  static auto invalidArgument = [](const std::string& msg) {
+    throw std::invalid_argument("ProcessGroupGloo::allgather_base: " + msg);
+  };
+
+  if (inputBuffer.layout() != at::kStrided ||
+      outputBuffer.layout() != at::kStrided) {
+    invalidArgument("only supports dense tensors");
+  }
+  if (!inputBuffer.is_contiguous() || !outputBuffer.is_contiguous()) {
+    invalidArgument("input and output buffers must be contiguous");
+  }
+  if (!inputBuffer.options().type_equal(outputBuffer.options())) {
+    invalidArgument("input and output buffers must have the same type");
+  }
+  if (outputBuffer.numel() != inputBuffer.numel() * getSize()) {
+    std::stringstream ss;
+    ss << "output buffer has " << outputBuffer.numel()
+       << " elements, expected " << inputBuffer.numel() * getSize()
+       << " (input buffer numel times the size of the process group)";
+    invalidArgument(ss.str());
+  }
+
+  const auto& device = inputBuffer.device();
+  if (device.type() != at::kCPU) {
+    invalidArgument(c10::str("unsupported device type ", device.type()));
+  }
+
+  auto tag = nextTag();
+  auto context = getContext(tag);
+  auto work = std::make_shared<AsyncAllgatherBaseWork>(
+      std::move(context), outputBuffer, inputBuffer, tag);
+  enqueue(work);
+  return work;
 }
 
 namespace {
@@ -2254,11 +2492,153 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::scatter(
   return work;
 }
 
+namespace {
+
+// Slot prefix for the point-to-point traffic of the ring reduce-scatter.
+// Chosen outside the range used by the Gloo collective algorithms so it
+// cannot collide with them on a shared context.
+constexpr uint8_t kReduceScatterSlotPrefix = 0x7f;
+
+class AsyncReduceScatterWork : public ProcessGroupGloo::AsyncWork {
+ public:
+  AsyncReduceScatterWork(
+      const std::shared_ptr<gloo::Context>& context,
+      std::vector<at::Tensor>& outputs,
+      std::vector<std::vector<at::Tensor>>& inputs,
+      ReduceOp reduceOp,
+      uint32_t tag)
+      : context(context),
+        outputs(outputs),
+        inputs(inputs),
+        // Resolve the reduction here, so that an unsupported op throws on
+        // the calling thread, also if the group has a single rank.
+        fn(getFunction(outputs[0].scalar_type(), reduceOp)),
+        tag(tag) {}
+
+  std::shared_ptr<gloo::Context> context;
+  std::vector<at::Tensor> outputs;
+  std::vector<std::vector<at::Tensor>> inputs;
+  const ReduceFunc fn;
+  const uint32_t tag;
+
+  // Ring reduce-scatter. In step i every rank sends its running partial
+  // for chunk (rank - i - 1) to its right neighbor, receives the partial
+  // for chunk (rank - i - 2) from its left neighbor and folds its own
+  // contribution into it. After size - 1 steps the partial received last
+  // is the fully reduced chunk for this rank. Only two partials and one
+  // receive buffer of a single chunk are live at any time.
+  void run() override {
+    auto& output = outputs[0];
+    const auto count = output.numel();
+    if (count == 0) {
+      return;
+    }
+
+    const auto rank = context->rank;
+    const auto size = context->size;
+    if (size == 1) {
+      output.copy_(inputs[0][0]);
+      return;
+    }
+
+    const auto left = (rank + size - 1) % size;
+    const auto right = (rank + 1) % size;
+    const auto nbytes = count * output.element_size();
+    const auto timeout = context->getTimeout();
+    const auto slot = gloo::Slot::build(kReduceScatterSlotPrefix, tag);
+
+    std::vector<at::Tensor> chunks;
+    chunks.reserve(size);
+    for (const auto& input : inputs[0]) {
+      chunks.push_back(input.contiguous());
+    }
+
+    auto recvTensor = at::empty({count}, output.options());
+    auto recvBuf = context->createUnboundBuffer(recvTensor.data_ptr(), nbytes);
+    std::array<at::Tensor, 2> partials = {
+        at::empty({count}, output.options()),
+        at::empty({count}, output.options()),
+    };
+
+    auto send = chunks[(rank + size - 1) % size];
+    for (int i = 0; i < size - 1; i++) {
+      auto sendBuf = context->createUnboundBuffer(send.data_ptr(), nbytes);
+      sendBuf->send(right, slot);
+      recvBuf->recv(left, slot);
+      recvBuf->waitRecv(timeout);
+
+      const auto chunk = (rank + 2 * size - i - 2) % size;
+      auto& next = partials[i % 2];
+      fn(next.data_ptr(),
+         chunks[chunk].data_ptr(),
+         recvTensor.data_ptr(),
+         count);
+
+      // The partial being sent may be overwritten two steps from now, so
+      // the send has to complete before it is released.
+      sendBuf->waitSend(timeout);
+      send = next;
+    }
+
+    output.copy_(send.view(output.sizes()));
+  }
+
+  template <typename T>
+  static void getFunction(ReduceFunc& fn, const ReduceOp op) {
+    fn = toFunction<T>(op);
+  }
+
+  static ReduceFunc getFunction(
+      const at::ScalarType& dtype,
+      const ReduceOp op) {
+    ReduceFunc fn;
+    GENERATE_ALL_TYPES(dtype, getFunction, fn, op);
+    return fn;
+  }
+};
+
+} // namespace
+
 std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::reduce_scatter(
     std::vector<at::Tensor>& outputs,
     std::vector<std::vector<at::Tensor>>& inputs,
     const ReduceScatterOptions& opts) {
-  throw std::runtime_error("ProcessGroupGloo does not support reduce_scatter");
+  static auto invalidArgument = [](const std::string& msg) {
+    throw std::invalid_argument("ProcessGroupGloo::reduce_scatter: " + msg);
+  };
+
+  assertSingleElementOutput(invalidArgument, outputs);
+  assertDense(invalidArgument, outputs);
+
+  if (inputs.size() != 1) {
+    std::stringstream ss;
+    ss << "requires a single-element input list containing a list with "
+       << getSize() << " tensors";
+    invalidArgument(ss.str());
+  } else if (inputs[0].size() != static_cast<size_t>(getSize())) {
+    std::stringstream ss;
+    ss << "Incorrect input list size " << inputs[0].size()
+       << ". Input list size should be " << getSize()
+       << ", same as size of the process group.";
+    invalidArgument(ss.str());
+  }
+
+  assertDense(invalidArgument, inputs[0]);
+  const auto& options = outputs[0].options();
+  const auto& sizes = outputs[0].sizes();
+  assertTypeAndSizesMatch(invalidArgument, inputs[0], options, sizes);
+
+  const auto& device = outputs[0].device();
+  if (device.type() != at::kCPU) {
+    invalidArgument(c10::str("unsupported device type ", device.type()));
+  }
+
+  auto tag = nextTag();
+  auto context = getContext(tag);
+  auto work = std::make_shared<AsyncReduceScatterWork>(
+      std::move(context), outputs, inputs, opts.reduceOp, tag);
+  enqueue(work);
+  return work;
 }
 
 namespace {
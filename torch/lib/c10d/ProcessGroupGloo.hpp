@@ -129,6 +129,11 @@ class ProcessGroupGloo : public ProcessGroup {
     std::vector<std::shared_ptr<::gloo::transport::Device>> devices;
     std::chrono::milliseconds timeout;
     int threads;
+
+    // Dense CPU allreduces larger than this are split into segments of this
+    // many bytes, which run concurrently on the worker threads. Zero
+    // disables chunking. Must be identical across processes.
+    size_t allreduceChunkBytes;
   };
 
   // Helper functions to create a new device object.
@@ -244,6 +249,9 @@ class ProcessGroupGloo : public ProcessGroup {
   // to match up operations during concurrent execution.
   uint32_t collectiveCounter_;
 
+  // See Options::allreduceChunkBytes.
+  const size_t allreduceChunkBytes_;
+
   // Returns next collective tag to use (uses collectiveCounter_).
   uint32_t nextTag();
 
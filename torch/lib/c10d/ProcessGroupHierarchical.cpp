@@ -0,0 +1,556 @@
+#include <c10d/ProcessGroupHierarchical.hpp>
+
+#include <limits.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <system_error>
+
+#include <ATen/ATen.h>
+#include <TH/THAllocator.h>
+
+#include <c10d/PrefixStore.hpp>
+#include <c10d/Utils.hpp>
+
+namespace c10d {
+
+namespace {
+
+// Every slot starts at a multiple of this, so that the slots are cache line
+// aligned and any scalar type can be read from them.
+constexpr size_t kAlignment = 64;
+
+constexpr size_t kDefaultSlotBytes = 4 * 1024 * 1024;
+
+constexpr std::chrono::milliseconds kDefaultTimeout(10 * 1000);
+
+// Waiting in the local barrier spins for this long, then sleeps for
+// exponentially increasing intervals up to kMaxBarrierSleep, so that idle
+// processes don't keep a core busy while the leader waits on the network.
+constexpr std::chrono::microseconds kBarrierSpinTime(50);
+constexpr std::chrono::microseconds kMaxBarrierSleep(1000);
+
+// Lives at the start of the shared memory segment. The local barrier is
+// sense reversing: the last process to arrive resets the counter and bumps
+// the generation that the others are spinning on.
+struct ControlBlock {
+  std::atomic<uint32_t> arrived;
+  std::atomic<uint32_t> generation;
+  std::atomic<uint32_t> aborted;
+};
+
+static_assert(
+    sizeof(ControlBlock) <= kAlignment,
+    "ControlBlock must fit in front of the first slot");
+static_assert(
+    ATOMIC_INT_LOCK_FREE == 2,
+    "ControlBlock requires lock free atomics to be shared between processes");
+
+ControlBlock* getControlBlock(const at::DataPtr& segment) {
+  return static_cast<ControlBlock*>(segment.get());
+}
+
+#ifdef __APPLE__
+std::string getHostname() {
+  const auto hostNameMax = sysconf(_SC_HOST_NAME_MAX);
+  auto hostname = std::unique_ptr<char[]>(new char[hostNameMax + 1]());
+  if (gethostname(hostname.get(), hostNameMax) != 0) {
+    throw std::system_error(errno, std::system_category());
+  }
+  return std::string(hostname.get());
+}
+#else
+std::string getHostname() {
+  std::array<char, HOST_NAME_MAX + 1> hostname{};
+  if (gethostname(hostname.data(), HOST_NAME_MAX) != 0) {
+    throw std::system_error(errno, std::system_category());
+  }
+  return std::string(hostname.data());
+}
+#endif
+
+// Shared memory segment names have to be unique on the host. The leader's
+// pid and a counter make them unique across processes and across process
+// groups created by the same process.
+std::string newSegmentName() {
+  static std::atomic<uint64_t> counter{0};
+  return "/torch_c10d_hierarchical_" + std::to_string(getpid()) + "_" +
+      std::to_string(counter++);
+}
+
+void reduceInto(at::Tensor& output, const at::Tensor& input, ReduceOp op) {
+  switch (op) {
+    case ReduceOp::SUM:
+      output.add_(input);
+      break;
+    case ReduceOp::PRODUCT:
+      output.mul_(input);
+      break;
+    case ReduceOp::MIN:
+      at::min_out(output, output, input);
+      break;
+    case ReduceOp::MAX:
+      at::max_out(output, output, input);
+      break;
+    default:
+      throw std::invalid_argument(
+          "ProcessGroupHierarchical: unsupported reduction operation");
+  }
+}
+
+void assertAllreduceInputs(
+    std::function<void(const std::string&)> fn,
+    const std::vector<at::Tensor>& tensors,
+    ReduceOp op) {
+  assertNonEmpty(fn, tensors);
+  assertDense(fn, tensors);
+  assertCPU(fn, tensors);
+  assertLayoutMatch(fn, tensors);
+  switch (op) {
+    case ReduceOp::SUM:
+    case ReduceOp::PRODUCT:
+    case ReduceOp::MIN:
+    case ReduceOp::MAX:
+      break;
+    default:
+      fn("unsupported reduction operation");
+  }
+}
+
+} // namespace
+
+ProcessGroupHierarchical::Options::Options()
+    : timeout(kDefaultTimeout),
+      interNodeTimeout(kDefaultTimeout),
+      slotBytes(kDefaultSlotBytes) {}
+
+ProcessGroupHierarchical::ProcessGroupHierarchical(
+    const std::shared_ptr<Store>& store,
+    int rank,
+    int size,
+    CreateProcessGroupFn createInterNodeGroup,
+    Options options)
+    : ProcessGroup(rank, size),
+      options_(std::move(options)),
+      localRank_(0),
+      localSize_(1),
+      hostIndex_(0),
+      numHosts_(1),
+      stop_(false) {
+  if (options_.slotBytes == 0) {
+    throw std::invalid_argument(
+        "ProcessGroupHierarchical: slotBytes must be positive");
+  }
+  slotBytes_ = (options_.slotBytes + kAlignment - 1) / kAlignment * kAlignment;
+
+  discoverHosts(store);
+
+  if (localRank_ == 0 && numHosts_ > 1) {
+    interNodeGroup_ = createInterNodeGroup(
+        std::make_shared<PrefixStore>("internode", store),
+        hostIndex_,
+        numHosts_);
+    TORCH_CHECK(interNodeGroup_->getRank() == hostIndex_);
+    TORCH_CHECK(interNodeGroup_->getSize() == numHosts_);
+  }
+
+  if (localSize_ > 1) {
+    openSegment(store);
+  }
+
+  workerThread_ = std::thread(&ProcessGroupHierarchical::runLoop, this);
+}
+
+ProcessGroupHierarchical::~ProcessGroupHierarchical() {
+  std::unique_lock<std::mutex> lock(pgMutex_);
+  queueConsumeCV_.wait(lock, [&] { return queue_.empty(); });
+
+  // Queue is empty, signal stop
+  stop_ = true;
+
+  // Release lock to allow threads to terminate
+  lock.unlock();
+  queueProduceCV_.notify_all();
+
+  workerThread_.join();
+}
+
+void ProcessGroupHierarchical::discoverHosts(
+    const std::shared_ptr<Store>& store) {
+  const auto hostname =
+      options_.hostname.empty() ? getHostname() : options_.hostname;
+  store->set(
+      "host/" + std::to_string(rank_),
+      std::vector<uint8_t>(hostname.begin(), hostname.end()));
+
+  std::vector<std::string> keys;
+  for (int i = 0; i < size_; i++) {
+    keys.push_back("host/" + std::to_string(i));
+  }
+  store->wait(keys);
+
+  // Hosts are numbered in the order of their leaders, the lowest rank on
+  // every host.
+  std::vector<std::string> hosts;
+  localSize_ = 0;
+  for (int i = 0; i < size_; i++) {
+    const auto value = store->get(keys[i]);
+    const std::string other(value.begin(), value.end());
+    if (std::find(hosts.begin(), hosts.end(), other) == hosts.end()) {
+      hosts.push_back(other);
+    }
+    if (other == hostname) {
+      if (i == rank_) {
+        localRank_ = localSize_;
+      }
+      localSize_++;
+    }
+  }
+
+  numHosts_ = hosts.size();
+  hostIndex_ = std::find(hosts.begin(), hosts.end(), hostname) - hosts.begin();
+}
+
+void ProcessGroupHierarchical::openSegment(
+    const std::shared_ptr<Store>& store) {
+  const auto key = "segment/" + std::to_string(hostIndex_);
+  const auto bytes = kAlignment + localSize_ * slotBytes_;
+
+  if (localRank_ == 0) {
+    const auto name = newSegmentName();
+    segment_ = THRefcountedMapAllocator::makeDataPtr(
+        name.c_str(),
+        TH_ALLOCATOR_MAPPED_SHAREDMEM | TH_ALLOCATOR_MAPPED_EXCLUSIVE,
+        bytes,
+        nullptr);
+    auto control = getControlBlock(segment_);
+    new (&control->arrived) std::atomic<uint32_t>(0);
+    new (&control->generation) std::atomic<uint32_t>(0);
+    new (&control->aborted) std::atomic<uint32_t>(0);
+    store->set(key, std::vector<uint8_t>(name.begin(), name.end()));
+  } else {
+    store->wait({key});
+    const auto value = store->get(key);
+    const std::string name(value.begin(), value.end());
+    segment_ = THRefcountedMapAllocator::makeDataPtr(
+        name.c_str(),
+        TH_ALLOCATOR_MAPPED_SHAREDMEM | TH_ALLOCATOR_MAPPED_NOCREATE,
+        bytes,
+        nullptr);
+  }
+
+  // The segment is unlinked when its last user closes it. Don't return
+  // before every local process has opened it, or the leader could close it
+  // before the others found it.
+  localBarrier();
+}
+
+void ProcessGroupHierarchical::localBarrier() {
+  localBarrier(options_.timeout);
+}
+
+void ProcessGroupHierarchical::localBarrier(std::chrono::milliseconds timeout) {
+  if (localSize_ == 1) {
+    return;
+  }
+
+  auto control = getControlBlock(segment_);
+  const auto generation = control->generation.load(std::memory_order_acquire);
+  const auto arrived =
+      control->arrived.fetch_add(1, std::memory_order_acq_rel) + 1;
+  if (arrived == static_cast<uint32_t>(localSize_)) {
+    control->arrived.store(0, std::memory_order_relaxed);
+    control->generation.fetch_add(1, std::memory_order_release);
+    return;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  const auto deadline = start + timeout;
+  std::chrono::microseconds sleep(1);
+  while (control->generation.load(std::memory_order_acquire) == generation) {
+    if (control->aborted.load(std::memory_order_relaxed) != 0) {
+      throw std::runtime_error(
+          "ProcessGroupHierarchical: operation failed on another local process");
+    }
+    const auto now = std::chrono::steady_clock::now();
+    if (now > deadline) {
+      throw std::runtime_error(
+          "ProcessGroupHierarchical: timed out waiting for local processes");
+    }
+    if (now - start < kBarrierSpinTime) {
+      std::this_thread::yield();
+    } else {
+      std::this_thread::sleep_for(sleep);
+      sleep = std::min(sleep * 2, kMaxBarrierSleep);
+    }
+  }
+}
+
+void ProcessGroupHierarchical::abortLocal() {
+  if (segment_) {
+    getControlBlock(segment_)->aborted.store(1, std::memory_order_relaxed);
+  }
+}
+
+at::Tensor ProcessGroupHierarchical::slot(
+    int localRank,
+    at::ScalarType type,
+    int64_t numel) {
+  auto data =
+      static_cast<char*>(segment_.get()) + kAlignment + localRank * slotBytes_;
+  return at::from_blob(data, {numel}, at::TensorOptions().dtype(type));
+}
+
+void ProcessGroupHierarchical::runAllreduce(
+    at::Tensor& flat,
+    const AllreduceOptions& opts) {
+  // Nothing to share locally, go straight to the other hosts.
+  if (localSize_ == 1) {
+    if (interNodeGroup_) {
+      std::vector<at::Tensor> tensors = {flat};
+      interNodeGroup_->allreduce(tensors, opts)->wait();
+    }
+    return;
+  }
+
+  const int64_t chunkSize = slotBytes_ / flat.element_size();
+  const int64_t numel = flat.numel();
+  for (int64_t offset = 0; offset < numel; offset += chunkSize) {
+    runAllreduceChunk(flat, offset, std::min(chunkSize, numel - offset), opts);
+  }
+}
+
+void ProcessGroupHierarchical::runAllreduceChunk(
+    at::Tensor& flat,
+    int64_t offset,
+    int64_t numel,
+    const AllreduceOptions& opts) {
+  const auto type = flat.scalar_type();
+  auto input = flat.narrow(0, offset, numel);
+
+  // Stage 1: reduce within the host. Every process reduces its own slice of
+  // all slots into the first slot.
+  slot(localRank_, type, numel).copy_(input);
+  localBarrier();
+
+  const int64_t sliceSize = (numel + localSize_ - 1) / localSize_;
+  const int64_t sliceOffset = std::min(numel, localRank_ * sliceSize);
+  const int64_t sliceNumel = std::min(sliceSize, numel - sliceOffset);
+  if (sliceNumel > 0) {
+    auto output = slot(0, type, numel).narrow(0, sliceOffset, sliceNumel);
+    for (int i = 1; i < localSize_; i++) {
+      reduceInto(
+          output,
+          slot(i, type, numel).narrow(0, sliceOffset, sliceNumel),
+          opts.reduceOp);
+    }
+  }
+  localBarrier();
+
+  // Stage 2: reduce across hosts.
+  if (interNodeGroup_) {
+    std::vector<at::Tensor> tensors = {slot(0, type, numel)};
+    interNodeGroup_->allreduce(tensors, opts)->wait();
+  }
+  localBarrier(options_.timeout + options_.interNodeTimeout);
+
+  // Stage 3: every process reads the result. The next chunk overwrites the
+  // first slot, so wait until everybody is done reading it.
+  input.copy_(slot(0, type, numel));
+  localBarrier();
+}
+
+void ProcessGroupHierarchical::runLoop() {
+  std::unique_lock<std::mutex> lock(pgMutex_);
+
+  while (!stop_) {
+    if (queue_.empty()) {
+      queueProduceCV_.wait(lock);
+      continue;
+    }
+
+    auto workTuple = std::move(queue_.front());
+
+    queue_.pop_front();
+
+    auto& fn = std::get<0>(workTuple);
+    auto& work = std::get<1>(workTuple);
+
+    lock.unlock();
+    queueConsumeCV_.notify_one();
+
+    try {
+      fn();
+      work->finish();
+    } catch (...) {
+      abortLocal();
+      work->finish(std::current_exception());
+    }
+
+    lock.lock();
+  }
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupHierarchical::enqueue(
+    std::function<void()> fn) {
+  auto work = std::make_shared<WorkHierarchical>();
+  std::unique_lock<std::mutex> lock(pgMutex_);
+  queue_.push_back(std::make_tuple(std::move(fn), work));
+  lock.unlock();
+  queueProduceCV_.notify_one();
+  return work;
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupHierarchical::allreduce(
+    std::vector<at::Tensor>& tensors,
+    const AllreduceOptions& opts) {
+  static auto invalidArgument = [](const std::string& msg) {
+    throw std::invalid_argument("ProcessGroupHierarchical::allreduce: " + msg);
+  };
+
+  assertSingleElement(invalidArgument, tensors);
+  assertAllreduceInputs(invalidArgument, tensors, opts.reduceOp);
+
+  auto tensor = tensors[0];
+  return enqueue([this, tensor, opts]() mutable {
+    auto flat = tensor.contiguous().view({-1});
+    runAllreduce(flat, opts);
+    if (!tensor.is_contiguous()) {
+      tensor.copy_(flat.view(tensor.sizes()));
+    }
+  });
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupHierarchical::
+    allreduce_coalesced(
+        std::vector<at::Tensor>& tensors,
+        const AllreduceCoalescedOptions& opts) {
+  static auto invalidArgument = [](const std::string& msg) {
+    throw std::invalid_argument(
+        "ProcessGroupHierarchical::allreduce_coalesced: " + msg);
+  };
+
+  assertAllreduceInputs(invalidArgument, tensors, opts.reduceOp);
+  const auto& options = tensors[0].options();
+  for (const auto& tensor : tensors) {
+    if (!tensor.options().type_equal(options)) {
+      invalidArgument("tensors must all have the same type");
+    }
+  }
+
+  return enqueue([this, tensors, opts]() mutable {
+    auto flat = flattenDenseTensors(tensors);
+    runAllreduce(flat, opts);
+    int64_t offset = 0;
+    for (auto& tensor : tensors) {
+      tensor.copy_(flat.narrow(0, offset, tensor.numel()).view(tensor.sizes()));
+      offset += tensor.numel();
+    }
+  });
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupHierarchical::barrier(
+    const BarrierOptions& /* unused */) {
+  return enqueue([this]() {
+    localBarrier();
+    if (interNodeGroup_) {
+      interNodeGroup_->barrier()->wait();
+    }
+    localBarrier(options_.timeout + options_.interNodeTimeout);
+  });
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupHierarchical::broadcast(
+    std::vector<at::Tensor>& /* unused */,
+    const BroadcastOptions& /* unused */) {
+  throw std::runtime_error(
+      "ProcessGroupHierarchical does not support broadcast");
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupHierarchical::reduce(
+    std::vector<at::Tensor>& /* unused */,
+    const ReduceOptions& /* unused */) {
+  throw std::runtime_error("ProcessGroupHierarchical does not support reduce");
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupHierarchical::allgather(
+    std::vector<std::vector<at::Tensor>>& /* unused */,
+    std::vector<at::Tensor>& /* unused */,
+    const AllgatherOptions& /* unused */) {
+  throw std::runtime_error(
+      "ProcessGroupHierarchical does not support allgather");
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupHierarchical::allgather_base(
+    at::Tensor& /* unused */,
+    at::Tensor& /* unused */,
+    const AllgatherOptions& /* unused */) {
+  throw std::runtime_error(
+      "ProcessGroupHierarchical does not support allgather_base");
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupHierarchical::
+    allgather_coalesced(
+        std::vector<std::vector<at::Tensor>>& /* unused */,
+        std::vector<at::Tensor>& /* unused */,
+        const AllgatherOptions& /* unused */) {
+  throw std::runtime_error(
+      "ProcessGroupHierarchical does not support allgather_coalesced");
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupHierarchical::gather(
+    std::vector<std::vector<at::Tensor>>& /* unused */,
+    std::vector<at::Tensor>& /* unused */,
+    const GatherOptions& /* unused */) {
+  throw std::runtime_error("ProcessGroupHierarchical does not support gather");
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupHierarchical::scatter(
+    std::vector<at::Tensor>& /* unused */,
+    std::vector<std::vector<at::Tensor>>& /* unused */,
+    const ScatterOptions& /* unused */) {
+  throw std::runtime_error("ProcessGroupHierarchical does not support scatter");
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupHierarchical::reduce_scatter(
+    std::vector<at::Tensor>& /* unused */,
+    std::vector<std::vector<at::Tensor>>& /* unused */,
+    const ReduceScatterOptions& /* unused */) {
+  throw std::runtime_error(
+      "ProcessGroupHierarchical does not support reduce_scatter");
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupHierarchical::alltoall_base(
+    at::Tensor& /* unused */,
+    at::Tensor& /* unused */,
+    std::vector<int64_t>& /* unused */,
+    std::vector<int64_t>& /* unused */,
+    const AllToAllOptions& /* unused */) {
+  throw std::runtime_error(
+      "ProcessGroupHierarchical does not support alltoall_base");
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupHierarchical::send(
+    std::vector<at::Tensor>& /* unused */,
+    int /* unused */,
+    int /* unused */) {
+  throw std::runtime_error("ProcessGroupHierarchical does not support send");
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupHierarchical::recv(
+    std::vector<at::Tensor>& /* unused */,
+    int /* unused */,
+    int /* unused */) {
+  throw std::runtime_error("ProcessGroupHierarchical does not support recv");
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupHierarchical::recvAnysource(
+    std::vector<at::Tensor>& /* unused */,
+    int /* unused */) {
+  throw std::runtime_error("ProcessGroupHierarchical does not support recv");
+}
+
+} // namespace c10d
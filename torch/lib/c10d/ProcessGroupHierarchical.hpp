@@ -0,0 +1,235 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <c10/core/Allocator.h>
+
+#include <c10d/ProcessGroup.hpp>
+#include <c10d/Store.hpp>
+
+namespace c10d {
+
+// ProcessGroupHierarchical implements allreduce for jobs that run several
+// processes per host.
+//
+// Processes are grouped by hostname, which they exchange through the store.
+// The lowest rank on every host is the leader of that host. The leader
+// creates a shared memory segment with one slot per local process, and an
+// allreduce runs in three stages:
+//
+//   1. Every process copies its input into its own slot, then reduces a
+//      1/localSize slice of all slots into the first slot. The local
+//      reduction is spread over all local processes.
+//   2. The host leaders allreduce the first slot among themselves with the
+//      inter-node process group (e.g. ProcessGroupGloo).
+//   3. Every process copies the result out of the first slot.
+//
+// Only host leaders create the inter-node process group, so every host sends
+// a single copy of the data over the network, instead of one per process.
+// Tensors larger than a slot are reduced in slot sized chunks.
+//
+// Only allreduce, allreduce_coalesced and barrier are supported, for dense
+// CPU tensors. All other functions throw.
+//
+// All functions of the class are expected to be called in the same order
+// across all processes in the process group. This is the only way that we
+// can guarantee to match up the same calls among all processes.
+//
+// An error in any stage leaves the shared memory segment in an unknown state.
+// The process group can't be used after an operation fails.
+//
+class ProcessGroupHierarchical final : public ProcessGroup {
+ public:
+  class WorkHierarchical : public ProcessGroup::Work {
+   protected:
+    friend class ProcessGroupHierarchical;
+  };
+
+  // Creates the process group among the host leaders. It is called with a
+  // store that is private to the leaders, the index of this host and the
+  // number of hosts.
+  using CreateProcessGroupFn = std::function<std::shared_ptr<ProcessGroup>(
+      const std::shared_ptr<Store>& store,
+      int rank,
+      int size)>;
+
+  struct Options {
+    explicit Options();
+
+    // Time to wait for the other local processes in a stage.
+    std::chrono::milliseconds timeout;
+
+    // Timeout of the inter-node process group. The other local processes
+    // wait this much longer for the leader while it runs stage 2.
+    std::chrono::milliseconds interNodeTimeout;
+
+    // Size of the shared memory slot of every local process.
+    size_t slotBytes;
+
+    // Name used to group processes by host. Defaults to gethostname().
+    std::string hostname;
+  };
+
+  explicit ProcessGroupHierarchical(
+      const std::shared_ptr<Store>& store,
+      int rank,
+      int size,
+      CreateProcessGroupFn createInterNodeGroup,
+      Options options = Options());
+
+  ~ProcessGroupHierarchical() override;
+
+  int getLocalRank() const {
+    return localRank_;
+  }
+
+  int getLocalSize() const {
+    return localSize_;
+  }
+
+  int getNumHosts() const {
+    return numHosts_;
+  }
+
+  std::shared_ptr<ProcessGroup::Work> broadcast(
+      std::vector<at::Tensor>& tensors,
+      const BroadcastOptions& opts = BroadcastOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> allreduce(
+      std::vector<at::Tensor>& tensors,
+      const AllreduceOptions& opts = AllreduceOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> allreduce_coalesced(
+      std::vector<at::Tensor>& tensors,
+      const AllreduceCoalescedOptions& opts =
+          AllreduceCoalescedOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> reduce(
+      std::vector<at::Tensor>& tensors,
+      const ReduceOptions& opts = ReduceOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> allgather(
+      std::vector<std::vector<at::Tensor>>& outputs,
+      std::vector<at::Tensor>& inputs,
+      const AllgatherOptions& opts = AllgatherOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> allgather_base(
+      at::Tensor& outputBuffer,
+      at::Tensor& inputBuffer,
+      const AllgatherOptions& opts = AllgatherOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> allgather_coalesced(
+      std::vector<std::vector<at::Tensor>>& outputTensorLists,
+      std::vector<at::Tensor>& inputTensors,
+      const AllgatherOptions& opts = AllgatherOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> gather(
+      std::vector<std::vector<at::Tensor>>& outputs,
+      std::vector<at::Tensor>& inputs,
+      const GatherOptions& opts = GatherOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> scatter(
+      std::vector<at::Tensor>& outputs,
+      std::vector<std::vector<at::Tensor>>& inputs,
+      const ScatterOptions& opts = ScatterOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> reduce_scatter(
+      std::vector<at::Tensor>& outputs,
+      std::vector<std::vector<at::Tensor>>& inputs,
+      const ReduceScatterOptions& opts = ReduceScatterOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> alltoall_base(
+      at::Tensor& outputTensor,
+      at::Tensor& inputTensor,
+      std::vector<int64_t>& outputSplitSizes,
+      std::vector<int64_t>& inputSplitSizes,
+      const AllToAllOptions& opts = AllToAllOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> send(
+      std::vector<at::Tensor>& tensors,
+      int dstRank,
+      int tag) override;
+
+  std::shared_ptr<ProcessGroup::Work> recv(
+      std::vector<at::Tensor>& tensors,
+      int srcRank,
+      int tag) override;
+
+  std::shared_ptr<ProcessGroup::Work> recvAnysource(
+      std::vector<at::Tensor>& tensors,
+      int tag) override;
+
+  std::shared_ptr<ProcessGroup::Work> barrier(
+      const BarrierOptions& opts = BarrierOptions()) override;
+
+ private:
+  // Finds the processes on this host and the host leaders.
+  void discoverHosts(const std::shared_ptr<Store>& store);
+
+  // Creates (on the leader) or opens the shared memory segment of this host.
+  void openSegment(const std::shared_ptr<Store>& store);
+
+  // Blocks until all local processes have called it. Throws on timeout or if
+  // another local process failed. Waits for at most options_.timeout, unless
+  // a different timeout is given.
+  void localBarrier();
+  void localBarrier(std::chrono::milliseconds timeout);
+
+  // Marks the segment as failed so that the other local processes stop
+  // waiting for this one.
+  void abortLocal();
+
+  // Returns a flat view of the first `numel` elements of a slot.
+  at::Tensor slot(int localRank, at::ScalarType type, int64_t numel);
+
+  // Runs the three allreduce stages over a flat, contiguous tensor.
+  void runAllreduce(at::Tensor& flat, const AllreduceOptions& opts);
+
+  // Runs the stages for one chunk that fits in a slot.
+  void runAllreduceChunk(
+      at::Tensor& flat,
+      int64_t offset,
+      int64_t numel,
+      const AllreduceOptions& opts);
+
+  void runLoop();
+
+  std::shared_ptr<ProcessGroup::Work> enqueue(std::function<void()> fn);
+
+  const Options options_;
+
+  // Slot size rounded up to keep every slot aligned.
+  size_t slotBytes_;
+
+  int localRank_;
+  int localSize_;
+  int hostIndex_;
+  int numHosts_;
+
+  // Only set on host leaders, when there is more than one host.
+  std::shared_ptr<ProcessGroup> interNodeGroup_;
+
+  // Shared memory segment. Starts with the control block, followed by
+  // localSize_ slots of slotBytes_.
+  at::DataPtr segment_;
+
+  // Operations run on a single worker thread, in the order they are called,
+  // because all local processes have to walk through the stages in lockstep.
+  using WorkType =
+      std::tuple<std::function<void()>, std::shared_ptr<WorkHierarchical>>;
+
+  bool stop_;
+  std::mutex pgMutex_;
+  std::thread workerThread_;
+  std::deque<WorkType> queue_;
+  std::condition_variable queueProduceCV_;
+  std::condition_variable queueConsumeCV_;
+};
+
+} // namespace c10d
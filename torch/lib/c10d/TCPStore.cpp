@@ -1,33 +1,114 @@
 #include <c10d/TCPStore.hpp>
 
 #include <poll.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
 
 #include <unistd.h>
 #include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
 #include <system_error>
 
 namespace c10d {
 
 namespace {
 
-enum class QueryType : uint8_t { SET, GET, ADD, CHECK, WAIT };
+enum class QueryType : uint8_t {
+  SET,
+  GET,
+  ADD,
+  CHECK,
+  WAIT,
+  MULTI_GET,
+  MULTI_SET,
+  COMPARE_SET,
+  WATCH_KEY
+};
 
 enum class CheckResponseType : uint8_t { READY, NOT_READY };
 
 enum class WaitResponseType : uint8_t { STOP_WAITING };
 
+enum class WatchResponseType : uint8_t { KEY_WATCHED, KEY_UPDATED };
+
+constexpr int kMaxEpollEvents = 64;
+
+// Append to a message in the wire format of the tcputil send and receive
+// helpers, so that a whole response goes out with a single send call.
+template <typename T>
+void appendValue(std::vector<uint8_t>& message, const T& value) {
+  auto bytes = reinterpret_cast<const uint8_t*>(&value);
+  message.insert(message.end(), bytes, bytes + sizeof(T));
+}
+
+void appendVector(
+    std::vector<uint8_t>& message,
+    const std::vector<uint8_t>& vec) {
+  appendValue<SizeType>(message, vec.size());
+  message.insert(message.end(), vec.begin(), vec.end());
+}
+
+void appendString(std::vector<uint8_t>& message, const std::string& str) {
+  appendValue<SizeType>(message, str.size());
+  message.insert(message.end(), str.begin(), str.end());
+}
+
+std::vector<std::string> recvKeys(int socket) {
+  SizeType nargs;
+  tcputil::recvBytes<SizeType>(socket, &nargs, 1);
+  std::vector<std::string> keys(nargs);
+  for (size_t i = 0; i < nargs; i++) {
+    keys[i] = tcputil::recvString(socket);
+  }
+  return keys;
+}
+
+void sendKeys(int socket, const std::vector<std::string>& keys) {
+  SizeType nkeys = keys.size();
+  tcputil::sendBytes<SizeType>(socket, &nkeys, 1, (nkeys > 0));
+  for (size_t i = 0; i < nkeys; i++) {
+    tcputil::sendString(socket, keys[i], (i != (nkeys - 1)));
+  }
+}
+
 } // anonymous namespace
 
 // TCPStoreDaemon class methods
+TCPStoreDaemon::Connection::~Connection() {
+  ::close(socket);
+}
+
 // Simply start the daemon thread
-TCPStoreDaemon::TCPStoreDaemon(int storeListenSocket)
-    : storeListenSocket_(storeListenSocket) {
+TCPStoreDaemon::TCPStoreDaemon(int storeListenSocket, size_t numWorkerThreads)
+    : numWorkerThreads_(std::max<size_t>(numWorkerThreads, 1)),
+      storeListenSocket_(storeListenSocket) {
   // Use control pipe to signal instance destruction to the daemon thread.
   if (pipe(controlPipeFd_.data()) == -1) {
     throw std::runtime_error(
         "Failed to create the control pipe to start the "
         "TCPStoreDaemon run");
   }
+#ifdef __linux__
+  auto addToEpoll = [](int epollFd, int fd) {
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    SYSCHECK_ERR_RETURN_NEG1(::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event));
+  };
+  SYSCHECK_ERR_RETURN_NEG1(epollFd_ = ::epoll_create1(EPOLL_CLOEXEC));
+  addToEpoll(epollFd_, storeListenSocket_);
+  addToEpoll(epollFd_, controlPipeFd_[0]);
+  // Every worker also watches the control pipe to learn about shutdown
+  for (size_t i = 0; i < numWorkerThreads_; i++) {
+    int epollFd;
+    SYSCHECK_ERR_RETURN_NEG1(epollFd = ::epoll_create1(EPOLL_CLOEXEC));
+    workerEpollFds_.push_back(epollFd);
+    addToEpoll(epollFd, controlPipeFd_[0]);
+  }
+#endif
   daemonThread_ = std::thread(&TCPStoreDaemon::run, this);
 }
 
@@ -36,11 +117,16 @@ TCPStoreDaemon::~TCPStoreDaemon() {
   stop();
   // Join the thread
   join();
-  // Close unclosed sockets
-  for (auto socket : sockets_) {
-    if (socket != -1) {
-      ::close(socket);
-    }
+  // Dropping the last references closes the client sockets
+  waitingSockets_.clear();
+  keysAwaited_.clear();
+  watchingSockets_.clear();
+  connections_.clear();
+  if (epollFd_ != -1) {
+    ::close(epollFd_);
+  }
+  for (auto fd : workerEpollFds_) {
+    ::close(fd);
   }
   // Now close the rest control pipe
   for (auto fd : controlPipeFd_) {
@@ -54,6 +140,129 @@ void TCPStoreDaemon::join() {
   daemonThread_.join();
 }
 
+size_t TCPStoreDaemon::defaultNumWorkerThreads() {
+  // Requests are short, so a handful of threads is enough to overlap the
+  // socket I/O of many clients. More mostly adds contention on the store.
+  const size_t numCores = std::thread::hardware_concurrency();
+  return std::min<size_t>(std::max<size_t>(numCores, 2), 8);
+}
+
+#ifdef __linux__
+
+void TCPStoreDaemon::run() {
+  for (auto epollFd : workerEpollFds_) {
+    workerThreads_.emplace_back(&TCPStoreDaemon::runWorker, this, epollFd);
+  }
+
+  size_t nextWorker = 0;
+  std::array<struct epoll_event, 2> events;
+  bool finished = false;
+  while (!finished) {
+    int numEvents;
+    SYSCHECK_ERR_RETURN_NEG1(
+        numEvents =
+            ::epoll_wait(epollFd_, events.data(), events.size(), -1));
+
+    for (int i = 0; i < numEvents; i++) {
+      // The pipe receives an event which tells us to shutdown the daemon
+      if (events[i].data.fd == controlPipeFd_[0]) {
+        // Will be EPOLLHUP when the pipe is closed
+        if (events[i].events ^ EPOLLHUP) {
+          throw std::system_error(
+              ECONNABORTED,
+              std::system_category(),
+              "Unexpected epoll event on the control pipe's reading fd: " +
+                  std::to_string(events[i].events));
+        }
+        finished = true;
+        break;
+      }
+
+      // TCPStore's listening socket has an event and it should now be able
+      // to accept new connections.
+      if (events[i].events ^ EPOLLIN) {
+        throw std::system_error(
+            ECONNABORTED,
+            std::system_category(),
+            "Unexpected epoll event on the master's listening socket: " +
+                std::to_string(events[i].events));
+      }
+      int sockFd = std::get<0>(tcputil::accept(storeListenSocket_));
+      const auto workerEpollFd = workerEpollFds_[nextWorker];
+      nextWorker = (nextWorker + 1) % workerEpollFds_.size();
+      {
+        auto conn = std::make_shared<Connection>(sockFd);
+        conn->epollFd = workerEpollFd;
+        std::lock_guard<std::mutex> lock(mutex_);
+        connections_[sockFd] = std::move(conn);
+      }
+      struct epoll_event event = {};
+      event.events = EPOLLIN;
+      event.data.fd = sockFd;
+      SYSCHECK_ERR_RETURN_NEG1(
+          ::epoll_ctl(workerEpollFd, EPOLL_CTL_ADD, sockFd, &event));
+    }
+  }
+
+  // The workers see the closed control pipe as well
+  for (auto& thread : workerThreads_) {
+    thread.join();
+  }
+}
+
+void TCPStoreDaemon::runWorker(int epollFd) {
+  std::array<struct epoll_event, kMaxEpollEvents> events;
+  while (true) {
+    int numEvents;
+    SYSCHECK_ERR_RETURN_NEG1(
+        numEvents = ::epoll_wait(epollFd, events.data(), events.size(), -1));
+
+    for (int i = 0; i < numEvents; i++) {
+      const auto fd = events[i].data.fd;
+      if (fd == controlPipeFd_[0]) {
+        return;
+      }
+
+      ConnectionPtr conn;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = connections_.find(fd);
+        if (it == connections_.end()) {
+          continue;
+        }
+        conn = it->second;
+      }
+
+      // The client can take more of the responses queued for it
+      if (events[i].events & EPOLLOUT) {
+        std::lock_guard<std::mutex> sendLock(conn->sendMutex);
+        sendOutbox(conn);
+      }
+      if ((events[i].events & ~EPOLLOUT) == 0) {
+        continue;
+      }
+
+      // Now query the socket that has the event
+      try {
+        query(conn);
+      } catch (...) {
+        // There was an error when processing query. Probably an exception
+        // occurred in recv/send what would indicate that socket on the other
+        // side has been closed. If the closing was due to normal exit, then
+        // the store should continue executing. Otherwise, if it was
+        // different exception, other connections will get an exception once
+        // they try to use the store. We will go ahead and close this
+        // connection whenever we hit an exception here.
+        ::epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        closeConnection(conn);
+      }
+    }
+  }
+}
+
+#else
+
+// Without epoll, fall back to serving all clients from the daemon thread.
 void TCPStoreDaemon::run() {
   std::vector<struct pollfd> fds;
   fds.push_back({.fd = storeListenSocket_, .events = POLLIN});
@@ -63,8 +272,8 @@ void TCPStoreDaemon::run() {
   // receive the queries
   bool finished = false;
   while (!finished) {
-    for (size_t i = 0; i < sockets_.size(); i++) {
-      fds[i].revents = 0;
+    for (auto& fd : fds) {
+      fd.revents = 0;
     }
 
     SYSCHECK_ERR_RETURN_NEG1(::poll(fds.data(), fds.size(), -1));
@@ -80,7 +289,10 @@ void TCPStoreDaemon::run() {
                 std::to_string(fds[0].revents));
       }
       int sockFd = std::get<0>(tcputil::accept(storeListenSocket_));
-      sockets_.push_back(sockFd);
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connections_[sockFd] = std::make_shared<Connection>(sockFd);
+      }
       fds.push_back({.fd = sockFd, .events = POLLIN});
     }
     // The pipe receives an event which tells us to shutdown the daemon
@@ -104,43 +316,18 @@ void TCPStoreDaemon::run() {
         continue;
       }
 
+      ConnectionPtr conn;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        conn = connections_.at(fds[fdIdx].fd);
+      }
       // Now query the socket that has the event
       try {
-        query(fds[fdIdx].fd);
+        query(conn);
       } catch (...) {
-        // There was an error when processing query. Probably an exception
-        // occurred in recv/send what would indicate that socket on the other
-        // side has been closed. If the closing was due to normal exit, then
-        // the store should continue executing. Otherwise, if it was different
-        // exception, other connections will get an exception once they try to
-        // use the store. We will go ahead and close this connection whenever
-        // we hit an exception here.
-        ::close(fds[fdIdx].fd);
-
-        // Remove all the tracking state of the close FD
-        for (auto it = waitingSockets_.begin(); it != waitingSockets_.end();) {
-          for (auto vecIt = it->second.begin(); vecIt != it->second.end();) {
-            if (*vecIt == fds[fdIdx].fd) {
-              vecIt = it->second.erase(vecIt);
-            } else {
-              ++vecIt;
-            }
-          }
-          if (it->second.size() == 0) {
-            it = waitingSockets_.erase(it);
-          } else {
-            ++it;
-          }
-        }
-        for (auto it = keysAwaited_.begin(); it != keysAwaited_.end();) {
-          if (it->first == fds[fdIdx].fd) {
-            it = keysAwaited_.erase(it);
-          } else {
-            ++it;
-          }
-        }
+        // See runWorker in the epoll variant
+        closeConnection(conn);
         fds.erase(fds.begin() + fdIdx);
-        sockets_.erase(sockets_.begin() + fdIdx - 2);
         --fdIdx;
         continue;
       }
@@ -148,6 +335,8 @@ void TCPStoreDaemon::run() {
   }
 }
 
+#endif
+
 void TCPStoreDaemon::stop() {
   if (controlPipeFd_[1] != -1) {
     // close the write end of the pipe
@@ -156,109 +345,347 @@ void TCPStoreDaemon::stop() {
   }
 }
 
+void TCPStoreDaemon::closeConnection(const ConnectionPtr& conn) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Remove all the tracking state of the closed connection
+  for (auto* sockets : {&waitingSockets_, &watchingSockets_}) {
+    for (auto it = sockets->begin(); it != sockets->end();) {
+      auto& vec = it->second;
+      vec.erase(std::remove(vec.begin(), vec.end(), conn), vec.end());
+      if (vec.size() == 0) {
+        it = sockets->erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  keysAwaited_.erase(conn);
+  connections_.erase(conn->socket);
+}
+
 // query communicates with the worker. The format
 // of the query is as follows:
 // type of query | size of arg1 | arg1 | size of arg2 | arg2 | ...
-// or, in the case of wait
+// or, in the case of wait, check and the batched queries
 // type of query | number of args | size of arg1 | arg1 | ...
-void TCPStoreDaemon::query(int socket) {
+//
+// The arguments are received before taking the store lock; responses and
+// notifications are queued under the lock and sent after releasing it.
+void TCPStoreDaemon::query(const ConnectionPtr& conn) {
   QueryType qt;
-  tcputil::recvBytes<QueryType>(socket, &qt, 1);
+  tcputil::recvBytes<QueryType>(conn->socket, &qt, 1);
 
   if (qt == QueryType::SET) {
-    setHandler(socket);
+    setHandler(conn);
 
   } else if (qt == QueryType::ADD) {
-    addHandler(socket);
+    addHandler(conn);
 
   } else if (qt == QueryType::GET) {
-    getHandler(socket);
+    getHandler(conn);
 
   } else if (qt == QueryType::CHECK) {
-    checkHandler(socket);
+    checkHandler(conn);
 
   } else if (qt == QueryType::WAIT) {
-    waitHandler(socket);
+    waitHandler(conn);
+
+  } else if (qt == QueryType::MULTI_GET) {
+    multiGetHandler(conn);
+
+  } else if (qt == QueryType::MULTI_SET) {
+    multiSetHandler(conn);
+
+  } else if (qt == QueryType::COMPARE_SET) {
+    compareSetHandler(conn);
+
+  } else if (qt == QueryType::WATCH_KEY) {
+    watchKeyHandler(conn);
 
   } else {
     throw std::runtime_error("Unexpected query type");
   }
 }
 
-void TCPStoreDaemon::wakeupWaitingClients(const std::string& key) {
-  auto socketsToWait = waitingSockets_.find(key);
-  if (socketsToWait != waitingSockets_.end()) {
-    for (int socket : socketsToWait->second) {
-      if (--keysAwaited_[socket] == 0) {
-        tcputil::sendValue<WaitResponseType>(
-            socket, WaitResponseType::STOP_WAITING);
+void TCPStoreDaemon::enqueue(
+    const ConnectionPtr& conn,
+    std::vector<uint8_t> message,
+    std::vector<ConnectionPtr>& pending) {
+  {
+    std::lock_guard<std::mutex> lock(conn->outboxMutex);
+    conn->outbox.push_back(std::move(message));
+  }
+  pending.push_back(conn);
+}
+
+void TCPStoreDaemon::flush(const std::vector<ConnectionPtr>& pending) {
+  for (const auto& conn : pending) {
+    // Whoever holds sendMutex drains the outbox, so messages leave in the
+    // order they were queued even if several threads flush at once.
+    std::lock_guard<std::mutex> sendLock(conn->sendMutex);
+    sendOutbox(conn);
+  }
+}
+
+void TCPStoreDaemon::sendOutbox(const ConnectionPtr& conn) {
+#ifdef __linux__
+  constexpr int flags = MSG_DONTWAIT;
+#else
+  constexpr int flags = 0;
+#endif
+  if (conn->dead) {
+    return;
+  }
+  while (true) {
+    std::vector<uint8_t>* message;
+    {
+      std::lock_guard<std::mutex> lock(conn->outboxMutex);
+      if (conn->outbox.empty()) {
+        break;
+      }
+      // Appending to the deque does not move its elements
+      message = &conn->outbox.front();
+    }
+    while (conn->sentBytes < message->size()) {
+      const auto bytesSent = ::send(
+          conn->socket,
+          message->data() + conn->sentBytes,
+          message->size() - conn->sentBytes,
+          flags);
+      if (bytesSent == -1 && errno == EINTR) {
+        continue;
+      }
+      if (bytesSent == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        setWaitingForWritable(conn, true);
+        return;
+      }
+      if (bytesSent <= 0) {
+        // The client is gone. Its connection is cleaned up once the daemon
+        // sees the socket close, so stop sending to it.
+        conn->dead = true;
+        setWaitingForWritable(conn, false);
+        return;
+      }
+      conn->sentBytes += bytesSent;
+    }
+    std::lock_guard<std::mutex> lock(conn->outboxMutex);
+    conn->outbox.pop_front();
+    conn->sentBytes = 0;
+  }
+  setWaitingForWritable(conn, false);
+}
+
+void TCPStoreDaemon::setWaitingForWritable(
+    const ConnectionPtr& conn,
+    bool waiting) {
+#ifdef __linux__
+  if (conn->waitingForWritable == waiting || conn->epollFd == -1) {
+    return;
+  }
+  struct epoll_event event = {};
+  event.events = waiting ? EPOLLIN | EPOLLOUT : EPOLLIN;
+  event.data.fd = conn->socket;
+  // Fails only if the connection has already been dropped from the epoll
+  // set, in which case nothing is going to be sent to it anymore.
+  if (::epoll_ctl(conn->epollFd, EPOLL_CTL_MOD, conn->socket, &event) == 0) {
+    conn->waitingForWritable = waiting;
+  }
+#endif
+}
+
+void TCPStoreDaemon::setValue(
+    const std::string& key,
+    std::vector<uint8_t> value,
+    std::vector<ConnectionPtr>& pending) {
+  auto watchers = watchingSockets_.find(key);
+  if (watchers != watchingSockets_.end()) {
+    std::vector<uint8_t> message;
+    appendValue<WatchResponseType>(message, WatchResponseType::KEY_UPDATED);
+    appendString(message, key);
+    appendVector(message, value);
+    for (const auto& watcher : watchers->second) {
+      enqueue(watcher, message, pending);
+    }
+  }
+
+  tcpStore_[key] = std::move(value);
+
+  // On every update, wake up all clients that have been waiting
+  auto waiters = waitingSockets_.find(key);
+  if (waiters != waitingSockets_.end()) {
+    for (const auto& waiter : waiters->second) {
+      if (--keysAwaited_[waiter] == 0) {
+        keysAwaited_.erase(waiter);
+        std::vector<uint8_t> message;
+        appendValue<WaitResponseType>(
+            message, WaitResponseType::STOP_WAITING);
+        enqueue(waiter, std::move(message), pending);
       }
     }
-    waitingSockets_.erase(socketsToWait);
+    waitingSockets_.erase(waiters);
   }
 }
 
-void TCPStoreDaemon::setHandler(int socket) {
-  std::string key = tcputil::recvString(socket);
-  tcpStore_[key] = tcputil::recvVector<uint8_t>(socket);
-  // On "set", wake up all clients that have been waiting
-  wakeupWaitingClients(key);
+void TCPStoreDaemon::setHandler(const ConnectionPtr& conn) {
+  std::string key = tcputil::recvString(conn->socket);
+  auto value = tcputil::recvVector<uint8_t>(conn->socket);
+  std::vector<ConnectionPtr> pending;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    setValue(key, std::move(value), pending);
+  }
+  flush(pending);
 }
 
-void TCPStoreDaemon::addHandler(int socket) {
-  std::string key = tcputil::recvString(socket);
-  int64_t addVal = tcputil::recvValue<int64_t>(socket);
+void TCPStoreDaemon::addHandler(const ConnectionPtr& conn) {
+  std::string key = tcputil::recvString(conn->socket);
+  int64_t addVal = tcputil::recvValue<int64_t>(conn->socket);
+
+  std::vector<ConnectionPtr> pending;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto pos = tcpStore_.find(key);
+    if (pos != tcpStore_.end()) {
+      auto buf = reinterpret_cast<const char*>(pos->second.data());
+      auto len = pos->second.size();
+      addVal += std::stoll(std::string(buf, len));
+    }
+    // Now send the new value
+    std::vector<uint8_t> message;
+    appendValue<int64_t>(message, addVal);
+    enqueue(conn, std::move(message), pending);
+
+    auto addValStr = std::to_string(addVal);
+    setValue(
+        key,
+        std::vector<uint8_t>(addValStr.begin(), addValStr.end()),
+        pending);
+  }
+  flush(pending);
+}
 
-  if (tcpStore_.find(key) != tcpStore_.end()) {
-    auto buf = reinterpret_cast<const char*>(tcpStore_[key].data());
-    auto len = tcpStore_[key].size();
-    addVal += std::stoll(std::string(buf, len));
+void TCPStoreDaemon::getHandler(const ConnectionPtr& conn) {
+  std::string key = tcputil::recvString(conn->socket);
+  std::vector<ConnectionPtr> pending;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<uint8_t> message;
+    appendVector(message, tcpStore_.at(key));
+    enqueue(conn, std::move(message), pending);
   }
-  auto addValStr = std::to_string(addVal);
-  tcpStore_[key] = std::vector<uint8_t>(addValStr.begin(), addValStr.end());
-  // Now send the new value
-  tcputil::sendValue<int64_t>(socket, addVal);
-  // On "add", wake up all clients that have been waiting
-  wakeupWaitingClients(key);
+  flush(pending);
 }
 
-void TCPStoreDaemon::getHandler(int socket) const {
-  std::string key = tcputil::recvString(socket);
-  auto data = tcpStore_.at(key);
-  tcputil::sendVector<uint8_t>(socket, data);
+void TCPStoreDaemon::checkHandler(const ConnectionPtr& conn) {
+  auto keys = recvKeys(conn->socket);
+  std::vector<ConnectionPtr> pending;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Now we have received all the keys
+    std::vector<uint8_t> message;
+    appendValue<CheckResponseType>(
+        message,
+        checkKeys(keys) ? CheckResponseType::READY
+                        : CheckResponseType::NOT_READY);
+    enqueue(conn, std::move(message), pending);
+  }
+  flush(pending);
 }
 
-void TCPStoreDaemon::checkHandler(int socket) const {
-  SizeType nargs;
-  tcputil::recvBytes<SizeType>(socket, &nargs, 1);
-  std::vector<std::string> keys(nargs);
-  for (size_t i = 0; i < nargs; i++) {
-    keys[i] = tcputil::recvString(socket);
+void TCPStoreDaemon::waitHandler(const ConnectionPtr& conn) {
+  auto keys = recvKeys(conn->socket);
+  std::vector<ConnectionPtr> pending;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (checkKeys(keys)) {
+      std::vector<uint8_t> message;
+      appendValue<WaitResponseType>(message, WaitResponseType::STOP_WAITING);
+      enqueue(conn, std::move(message), pending);
+    } else {
+      // Only count the keys that are still missing, as keys that already
+      // exist might never be written again.
+      size_t numKeysAwaited = 0;
+      for (auto& key : keys) {
+        if (tcpStore_.count(key) == 0) {
+          waitingSockets_[key].push_back(conn);
+          numKeysAwaited++;
+        }
+      }
+      keysAwaited_[conn] = numKeysAwaited;
+    }
   }
-  // Now we have received all the keys
-  if (checkKeys(keys)) {
-    tcputil::sendValue<CheckResponseType>(socket, CheckResponseType::READY);
-  } else {
-    tcputil::sendValue<CheckResponseType>(socket, CheckResponseType::NOT_READY);
+  flush(pending);
+}
+
+void TCPStoreDaemon::multiGetHandler(const ConnectionPtr& conn) {
+  auto keys = recvKeys(conn->socket);
+  std::vector<ConnectionPtr> pending;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<uint8_t> message;
+    for (const auto& key : keys) {
+      appendVector(message, tcpStore_.at(key));
+    }
+    enqueue(conn, std::move(message), pending);
   }
+  flush(pending);
 }
 
-void TCPStoreDaemon::waitHandler(int socket) {
+void TCPStoreDaemon::multiSetHandler(const ConnectionPtr& conn) {
   SizeType nargs;
-  tcputil::recvBytes<SizeType>(socket, &nargs, 1);
+  tcputil::recvBytes<SizeType>(conn->socket, &nargs, 1);
   std::vector<std::string> keys(nargs);
+  std::vector<std::vector<uint8_t>> values(nargs);
   for (size_t i = 0; i < nargs; i++) {
-    keys[i] = tcputil::recvString(socket);
+    keys[i] = tcputil::recvString(conn->socket);
+    values[i] = tcputil::recvVector<uint8_t>(conn->socket);
   }
-  if (checkKeys(keys)) {
-    tcputil::sendValue<WaitResponseType>(
-        socket, WaitResponseType::STOP_WAITING);
-  } else {
-    for (auto& key : keys) {
-      waitingSockets_[key].push_back(socket);
+  std::vector<ConnectionPtr> pending;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < nargs; i++) {
+      setValue(keys[i], std::move(values[i]), pending);
+    }
+  }
+  flush(pending);
+}
+
+void TCPStoreDaemon::compareSetHandler(const ConnectionPtr& conn) {
+  std::string key = tcputil::recvString(conn->socket);
+  auto expectedValue = tcputil::recvVector<uint8_t>(conn->socket);
+  auto desiredValue = tcputil::recvVector<uint8_t>(conn->socket);
+  std::vector<ConnectionPtr> pending;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<uint8_t> message;
+    auto pos = tcpStore_.find(key);
+    const bool matches = pos == tcpStore_.end()
+        ? expectedValue.empty()
+        : pos->second == expectedValue;
+    if (matches) {
+      appendVector(message, desiredValue);
+      setValue(key, std::move(desiredValue), pending);
+    } else if (pos == tcpStore_.end()) {
+      appendVector(message, expectedValue);
+    } else {
+      appendVector(message, pos->second);
     }
-    keysAwaited_[socket] = keys.size();
+    enqueue(conn, std::move(message), pending);
   }
+  flush(pending);
+}
+
+void TCPStoreDaemon::watchKeyHandler(const ConnectionPtr& conn) {
+  std::string key = tcputil::recvString(conn->socket);
+  std::vector<ConnectionPtr> pending;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    watchingSockets_[key].push_back(conn);
+    std::vector<uint8_t> message;
+    appendValue<WatchResponseType>(message, WatchResponseType::KEY_WATCHED);
+    enqueue(conn, std::move(message), pending);
+  }
+  flush(pending);
 }
 
 bool TCPStoreDaemon::checkKeys(const std::vector<std::string>& keys) const {
@@ -299,6 +726,13 @@ TCPStore::TCPStore(
 }
 
 TCPStore::~TCPStore() {
+  if (watchListenerThread_.joinable()) {
+    // Closing the write end of the pipe stops the listener
+    ::close(watchControlPipeFd_[1]);
+    watchListenerThread_.join();
+    ::close(watchControlPipeFd_[0]);
+    ::close(watchSocket_);
+  }
   ::close(storeSocket_);
   if (isServer_) {
     // Store daemon should end because of closed connection.
@@ -364,14 +798,154 @@ int64_t TCPStore::addHelper_(const std::string& key, int64_t value) {
   return tcputil::recvValue<int64_t>(storeSocket_);
 }
 
-bool TCPStore::check(const std::vector<std::string>& keys) {
-  tcputil::sendValue<QueryType>(storeSocket_, QueryType::CHECK);
+std::vector<std::vector<uint8_t>> TCPStore::multiGet(
+    const std::vector<std::string>& keys) {
+  std::vector<std::string> regKeys;
+  regKeys.resize(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    regKeys[i] = regularPrefix_ + keys[i];
+  }
+  waitHelper_(regKeys, timeout_);
+  tcputil::sendValue<QueryType>(storeSocket_, QueryType::MULTI_GET);
+  sendKeys(storeSocket_, regKeys);
+  std::vector<std::vector<uint8_t>> values(keys.size());
+  for (auto& value : values) {
+    value = tcputil::recvVector<uint8_t>(storeSocket_);
+  }
+  return values;
+}
+
+void TCPStore::multiSet(
+    const std::vector<std::string>& keys,
+    const std::vector<std::vector<uint8_t>>& values) {
+  if (keys.size() != values.size()) {
+    throw std::invalid_argument(
+        "TCPStore::multiSet: got " + std::to_string(keys.size()) +
+        " keys but " + std::to_string(values.size()) + " values");
+  }
+  tcputil::sendValue<QueryType>(storeSocket_, QueryType::MULTI_SET);
   SizeType nkeys = keys.size();
   tcputil::sendBytes<SizeType>(storeSocket_, &nkeys, 1, (nkeys > 0));
   for (size_t i = 0; i < nkeys; i++) {
     std::string regKey = regularPrefix_ + keys[i];
-    tcputil::sendString(storeSocket_, regKey, (i != (nkeys - 1)));
+    tcputil::sendString(storeSocket_, regKey, true);
+    tcputil::sendVector<uint8_t>(storeSocket_, values[i], (i != (nkeys - 1)));
+  }
+}
+
+std::vector<uint8_t> TCPStore::compareSet(
+    const std::string& key,
+    const std::vector<uint8_t>& expectedValue,
+    const std::vector<uint8_t>& desiredValue) {
+  std::string regKey = regularPrefix_ + key;
+  tcputil::sendValue<QueryType>(storeSocket_, QueryType::COMPARE_SET);
+  tcputil::sendString(storeSocket_, regKey, true);
+  tcputil::sendVector<uint8_t>(storeSocket_, expectedValue, true);
+  tcputil::sendVector<uint8_t>(storeSocket_, desiredValue);
+  return tcputil::recvVector<uint8_t>(storeSocket_);
+}
+
+void TCPStore::watchKey(const std::string& key, WatchKeyCallback callback) {
+  std::string regKey = regularPrefix_ + key;
+  std::unique_lock<std::mutex> lock(watchMutex_);
+  if (!watchListenerThread_.joinable()) {
+    startWatchListener_();
+  }
+  auto& callbacks = watchCallbacks_[regKey];
+  callbacks.push_back(std::move(callback));
+  // The server notifies a connection once per update no matter how many
+  // callbacks it has for the key, so only the first one registers.
+  if (callbacks.size() > 1) {
+    return;
+  }
+
+  tcputil::sendValue<QueryType>(watchSocket_, QueryType::WATCH_KEY);
+  tcputil::sendString(watchSocket_, regKey);
+  // Wait for the acknowledgement, after which every update of the key is
+  // guaranteed to be reported.
+  const auto request = ++watchRequestsSent_;
+  auto acked = [this, request] { return watchRequestsAcked_ >= request; };
+  if (timeout_ == kNoTimeout) {
+    watchCV_.wait(lock, acked);
+  } else if (!watchCV_.wait_for(lock, timeout_, acked)) {
+    // Drop the callback of the failed call. Callbacks that other calls added
+    // in the meantime stay, in case the acknowledgement still arrives.
+    auto it = watchCallbacks_.find(regKey);
+    it->second.erase(it->second.begin());
+    if (it->second.empty()) {
+      watchCallbacks_.erase(it);
+    }
+    throw std::runtime_error("Socket Timeout");
+  }
+}
+
+void TCPStore::startWatchListener_() {
+  if (pipe(watchControlPipeFd_.data()) == -1) {
+    throw std::runtime_error(
+        "Failed to create the control pipe to start the "
+        "TCPStore watch listener");
+  }
+  watchSocket_ = tcputil::connect(
+      tcpStoreAddr_, tcpStorePort_, /* wait= */ true, timeout_);
+  watchListenerThread_ = std::thread(&TCPStore::runWatchListener_, this);
+}
+
+void TCPStore::runWatchListener_() {
+  std::array<struct pollfd, 2> fds = {{
+      {.fd = watchSocket_, .events = POLLIN, .revents = 0},
+      // Closed by the destructor to stop the listener
+      {.fd = watchControlPipeFd_[0], .events = POLLHUP, .revents = 0},
+  }};
+  try {
+    while (true) {
+      for (auto& fd : fds) {
+        fd.revents = 0;
+      }
+      SYSCHECK_ERR_RETURN_NEG1(::poll(fds.data(), fds.size(), -1));
+      if (fds[1].revents != 0) {
+        return;
+      }
+      if (fds[0].revents == 0) {
+        continue;
+      }
+
+      auto response = tcputil::recvValue<WatchResponseType>(watchSocket_);
+      if (response == WatchResponseType::KEY_WATCHED) {
+        std::lock_guard<std::mutex> lock(watchMutex_);
+        ++watchRequestsAcked_;
+        watchCV_.notify_all();
+      } else if (response == WatchResponseType::KEY_UPDATED) {
+        std::string key = tcputil::recvString(watchSocket_);
+        auto value = tcputil::recvVector<uint8_t>(watchSocket_);
+        std::vector<WatchKeyCallback> callbacks;
+        {
+          std::lock_guard<std::mutex> lock(watchMutex_);
+          auto it = watchCallbacks_.find(key);
+          if (it != watchCallbacks_.end()) {
+            callbacks = it->second;
+          }
+        }
+        for (const auto& callback : callbacks) {
+          callback(value);
+        }
+      } else {
+        throw std::runtime_error("Unexpected watch response type");
+      }
+    }
+  } catch (const std::exception&) {
+    // The server is gone. Nothing more will be reported and pending
+    // watchKey calls run into their timeout.
   }
+}
+
+bool TCPStore::check(const std::vector<std::string>& keys) {
+  tcputil::sendValue<QueryType>(storeSocket_, QueryType::CHECK);
+  std::vector<std::string> regKeys;
+  regKeys.resize(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    regKeys[i] = regularPrefix_ + keys[i];
+  }
+  sendKeys(storeSocket_, regKeys);
   auto checkResponse = tcputil::recvValue<CheckResponseType>(storeSocket_);
   if (checkResponse == CheckResponseType::READY) {
     return true;
@@ -412,11 +986,7 @@ void TCPStore::waitHelper_(
         sizeof(timeoutTV)));
   }
   tcputil::sendValue<QueryType>(storeSocket_, QueryType::WAIT);
-  SizeType nkeys = keys.size();
-  tcputil::sendBytes<SizeType>(storeSocket_, &nkeys, 1, (nkeys > 0));
-  for (size_t i = 0; i < nkeys; i++) {
-    tcputil::sendString(storeSocket_, keys[i], (i != (nkeys - 1)));
-  }
+  sendKeys(storeSocket_, keys);
   auto waitResponse = tcputil::recvValue<WaitResponseType>(storeSocket_);
   if (waitResponse != WaitResponseType::STOP_WAITING) {
     throw std::runtime_error("Stop_waiting response is expected");
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <thread>
 #include <unordered_map>
 
@@ -9,37 +13,108 @@
 
 namespace c10d {
 
+// The store server. On Linux the daemon thread accepts connections and
+// assigns each one round-robin to a pool of worker threads, every one of
+// which runs its own epoll loop over its clients. Different clients are
+// thus served in parallel without handing requests between threads. Socket
+// I/O happens outside of the store lock, which is only held for the map
+// update itself. Requests are read with blocking calls, as clients send
+// each one in full; responses are written without blocking, so a client
+// that stops reading only delays itself. Other platforms serve every client
+// from the daemon thread with blocking sends.
 class TCPStoreDaemon {
  public:
-  explicit TCPStoreDaemon(int storeListenSocket);
+  explicit TCPStoreDaemon(
+      int storeListenSocket,
+      size_t numWorkerThreads = defaultNumWorkerThreads());
   ~TCPStoreDaemon();
 
   void join();
 
+  static size_t defaultNumWorkerThreads();
+
  protected:
+  // A client connection. The socket is closed when the last reference is
+  // dropped, so a worker that is still notifying a waiter can never write
+  // into a descriptor that has been closed and reused in the meantime.
+  struct Connection {
+    explicit Connection(int socket) : socket(socket) {}
+    ~Connection();
+
+    const int socket;
+    // Messages queued for this client. They are appended while holding the
+    // store lock, so their order matches the order of the store updates
+    // that produced them, and are written out under sendMutex.
+    std::deque<std::vector<uint8_t>> outbox;
+    std::mutex outboxMutex;
+    std::mutex sendMutex;
+    // The fields below are guarded by sendMutex. On Linux, sends never
+    // block: what a slow client cannot take yet stays in the outbox, with
+    // sentBytes of its first message already written, and the worker
+    // owning the connection (epollFd) resumes once the socket is writable.
+    size_t sentBytes = 0;
+    int epollFd = -1;
+    bool waitingForWritable = false;
+    // Set once a send fails. Nothing more is sent, and what is queued stays
+    // in the outbox until the daemon sees the socket close and drops the
+    // connection.
+    bool dead = false;
+  };
+  using ConnectionPtr = std::shared_ptr<Connection>;
+
   void run();
+  void runWorker(int epollFd);
   void stop();
 
-  void query(int socket);
+  void query(const ConnectionPtr& conn);
+  void closeConnection(const ConnectionPtr& conn);
 
-  void setHandler(int socket);
-  void addHandler(int socket);
-  void getHandler(int socket) const;
-  void checkHandler(int socket) const;
-  void waitHandler(int socket);
+  void setHandler(const ConnectionPtr& conn);
+  void addHandler(const ConnectionPtr& conn);
+  void getHandler(const ConnectionPtr& conn);
+  void checkHandler(const ConnectionPtr& conn);
+  void waitHandler(const ConnectionPtr& conn);
+  void multiGetHandler(const ConnectionPtr& conn);
+  void multiSetHandler(const ConnectionPtr& conn);
+  void compareSetHandler(const ConnectionPtr& conn);
+  void watchKeyHandler(const ConnectionPtr& conn);
 
+  // The helpers below must be called with mutex_ held.
   bool checkKeys(const std::vector<std::string>& keys) const;
-  void wakeupWaitingClients(const std::string& key);
+  // Connections that had messages queued are appended to pending, which
+  // the caller passes to flush once it has released mutex_.
+  void setValue(
+      const std::string& key,
+      std::vector<uint8_t> value,
+      std::vector<ConnectionPtr>& pending);
+  void enqueue(
+      const ConnectionPtr& conn,
+      std::vector<uint8_t> message,
+      std::vector<ConnectionPtr>& pending);
+
+  static void flush(const std::vector<ConnectionPtr>& pending);
+  // Must be called with conn->sendMutex held.
+  static void sendOutbox(const ConnectionPtr& conn);
+  static void setWaitingForWritable(const ConnectionPtr& conn, bool waiting);
 
   std::thread daemonThread_;
+  std::vector<std::thread> workerThreads_;
+  const size_t numWorkerThreads_;
+
+  // Guards the store, the waiter and watcher state and connections_.
+  std::mutex mutex_;
   std::unordered_map<std::string, std::vector<uint8_t>> tcpStore_;
-  // From key -> the list of sockets waiting on it
-  std::unordered_map<std::string, std::vector<int>> waitingSockets_;
-  // From socket -> number of keys awaited
-  std::unordered_map<int, size_t> keysAwaited_;
+  // From key -> the list of clients waiting on it
+  std::unordered_map<std::string, std::vector<ConnectionPtr>> waitingSockets_;
+  // From client -> number of keys awaited
+  std::unordered_map<ConnectionPtr, size_t> keysAwaited_;
+  // From key -> the list of clients to notify on every update of the key
+  std::unordered_map<std::string, std::vector<ConnectionPtr>> watchingSockets_;
+  std::unordered_map<int, ConnectionPtr> connections_;
 
-  std::vector<int> sockets_;
   int storeListenSocket_;
+  int epollFd_ = -1;
+  std::vector<int> workerEpollFds_;
   std::vector<int> controlPipeFd_{-1, -1};
 };
 
@@ -69,6 +144,31 @@ class TCPStore : public Store {
       const std::vector<std::string>& keys,
       const std::chrono::milliseconds& timeout) override;
 
+  // Batched variants of get and set that need a single round trip to the
+  // server. multiGet waits for all keys like get does.
+  std::vector<std::vector<uint8_t>> multiGet(
+      const std::vector<std::string>& keys);
+
+  void multiSet(
+      const std::vector<std::string>& keys,
+      const std::vector<std::vector<uint8_t>>& values);
+
+  // Atomically replaces the value of key with desiredValue if its current
+  // value equals expectedValue, or if the key does not exist and
+  // expectedValue is empty. Returns the value of the key after the call
+  // (expectedValue if the key does not exist and was not created).
+  std::vector<uint8_t> compareSet(
+      const std::string& key,
+      const std::vector<uint8_t>& expectedValue,
+      const std::vector<uint8_t>& desiredValue);
+
+  // Invokes callback with the new value every time key is set, added to or
+  // successfully compare-and-set by any client, starting with the first
+  // update after this call returns. Callbacks run on a dedicated listener
+  // thread and must not call watchKey themselves.
+  using WatchKeyCallback = std::function<void(const std::vector<uint8_t>&)>;
+  void watchKey(const std::string& key, WatchKeyCallback callback);
+
   // Waits for all workers to join.
   void waitForWorkers();
 
@@ -82,6 +182,9 @@ class TCPStore : public Store {
       const std::vector<std::string>& keys,
       const std::chrono::milliseconds& timeout);
 
+  void startWatchListener_();
+  void runWatchListener_();
+
   bool isServer_;
   int storeSocket_ = -1;
   int masterListenSocket_ = -1;
@@ -93,6 +196,18 @@ class TCPStore : public Store {
   const std::string initKey_;
   const std::string regularPrefix_;
 
+  // Key watching uses a second connection that only ever receives
+  // notifications, read by the listener thread.
+  int watchSocket_ = -1;
+  std::thread watchListenerThread_;
+  std::vector<int> watchControlPipeFd_{-1, -1};
+  std::unordered_map<std::string, std::vector<WatchKeyCallback>>
+      watchCallbacks_;
+  std::mutex watchMutex_;
+  std::condition_variable watchCV_;
+  size_t watchRequestsSent_ = 0;
+  size_t watchRequestsAcked_ = 0;
+
   // Only needs to be launched as the server
   std::unique_ptr<TCPStoreDaemon> tcpStoreDaemon_ = nullptr;
 };
@@ -1,5 +1,6 @@
 #include <c10d/test/StoreTestCommon.hpp>
 
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include <iostream>
@@ -84,8 +85,66 @@ void testHelper(const std::string prefix = "") {
   unlink(path.c_str());
 }
 
+off_t fileSize(const std::string& path) {
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0) {
+    throw std::system_error(errno, std::system_category());
+  }
+  return st.st_size;
+}
+
+void testCompaction() {
+  auto path = tmppath();
+  std::cout << "Using temporary file: " << path << std::endl;
+
+  const off_t threshold = 1024;
+  auto writer = std::make_shared<c10d::FileStore>(path, 2);
+  auto reader = std::make_shared<c10d::FileStore>(path, 2);
+  writer->setCompactionThreshold(threshold);
+  c10d::test::set(*writer, "key", "value");
+  c10d::test::check(*reader, "key", "value");
+
+  // The reader's position refers to a file that is compacted many times.
+  const auto numIterations = 1000;
+  for (auto i = 0; i < numIterations; i++) {
+    c10d::test::set(*writer, "key", "value" + std::to_string(i));
+    writer->add("counter", 1);
+    if (fileSize(path) > 2 * threshold) {
+      throw std::runtime_error("FileStore was not compacted");
+    }
+  }
+  const auto last = "value" + std::to_string(numIterations - 1);
+  c10d::test::check(*reader, "key", last);
+  c10d::test::check(*reader, "counter", std::to_string(numIterations));
+  if (reader->add("counter", 1) != numIterations + 1) {
+    throw std::runtime_error("FileStore lost updates in compaction");
+  }
+
+  // A new instance reads the compacted file.
+  {
+    c10d::FileStore store(path, 3);
+    c10d::test::check(store, "key", last);
+  }
+
+  // Waiters wake up on writes that compact the file.
+  std::thread thread([&] {
+    for (auto i = 0; i < 100; i++) {
+      c10d::test::set(*writer, "key", "value");
+    }
+    c10d::test::set(*writer, "done", "1");
+  });
+  reader->wait({"done"}, std::chrono::seconds(10));
+  c10d::test::check(*reader, "done", "1");
+  thread.join();
+
+  writer.reset();
+  reader.reset();
+  unlink(path.c_str());
+}
+
 int main(int argc, char** argv) {
   testHelper();
   testHelper("testPrefix");
+  testCompaction();
   std::cout << "Test succeeded" << std::endl;
 }
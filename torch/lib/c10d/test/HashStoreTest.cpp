@@ -53,6 +53,43 @@ void testHelper(std::string prefix = "") {
   }
   std::string expected = std::to_string(numThreads * numIterations);
   c10d::test::check(store, "counter", expected);
+
+  // Waiters on different keys only wake up for their own key.
+  {
+    std::vector<std::thread> waiters;
+    std::vector<std::string> keys;
+    for (auto i = 0; i < numThreads; i++) {
+      keys.push_back("wait" + std::to_string(i));
+    }
+    for (auto i = 0; i < numThreads; i++) {
+      waiters.push_back(std::thread([&, i] {
+        store.wait({keys[i]}, std::chrono::seconds(10));
+        c10d::test::check(store, keys[i], "value");
+      }));
+    }
+    // Waiting for all keys returns once the last one is set.
+    std::thread waitAll([&] { store.wait(keys, std::chrono::seconds(10)); });
+    for (const auto& key : keys) {
+      c10d::test::set(store, key, "value");
+    }
+    for (auto& waiter : waiters) {
+      waiter.join();
+    }
+    waitAll.join();
+  }
+
+  // wait() throws once the timeout expires.
+  {
+    auto threw = false;
+    try {
+      store.wait({"missing"}, std::chrono::milliseconds(10));
+    } catch (const std::system_error&) {
+      threw = true;
+    }
+    if (!threw) {
+      throw std::runtime_error("Expected wait() to time out");
+    }
+  }
 }
 
 int main(int /* unused */, char** /* unused */) {
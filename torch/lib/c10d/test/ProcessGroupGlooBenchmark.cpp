@@ -0,0 +1,140 @@
+// Measures allreduce bus bandwidth of ProcessGroupGloo over loopback, with
+// and without chunking, for a range of message sizes.
+//
+// Usage: ProcessGroupGlooBenchmark [size] [chunk bytes] [max bytes]
+//
+// All ranks run as threads of this process. The bus bandwidth is the
+// algorithm bandwidth scaled by 2 * (size - 1) / size, the fraction of the
+// data every rank sends in a ring allreduce, so that numbers are comparable
+// across group sizes.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <c10d/FileStore.hpp>
+#include <c10d/ProcessGroupGloo.hpp>
+#include <c10d/test/TestUtils.hpp>
+
+using namespace c10d::test;
+
+namespace {
+
+constexpr size_t kMinBytes = 4 * 1024;
+constexpr size_t kDefaultMaxBytes = 256 * 1024 * 1024;
+constexpr size_t kDefaultChunkBytes = 4 * 1024 * 1024;
+constexpr size_t kBytesPerSize = 1024 * 1024 * 1024;
+
+struct Result {
+  size_t bytes;
+  double seconds;
+};
+
+// Returns the average time per allreduce for every message size on `rank`.
+std::vector<Result> runRank(
+    const std::string& path,
+    int rank,
+    int size,
+    size_t chunkBytes,
+    size_t maxBytes) {
+  auto store = std::make_shared<::c10d::FileStore>(path, size);
+
+  ::c10d::ProcessGroupGloo::Options options;
+  options.timeout = std::chrono::seconds(60);
+  options.threads = 4;
+  options.allreduceChunkBytes = chunkBytes;
+  options.devices.push_back(
+      ::c10d::ProcessGroupGloo::createDeviceForHostname("127.0.0.1"));
+  ::c10d::ProcessGroupGloo pg(store, rank, size, options);
+
+  std::vector<Result> results;
+  for (size_t bytes = kMinBytes; bytes <= maxBytes; bytes *= 4) {
+    std::vector<at::Tensor> tensors = {
+        at::ones({static_cast<int64_t>(bytes / sizeof(float))})};
+    // Enough iterations to move about 1GB per size, within bounds.
+    const auto iterations =
+        std::max<size_t>(5, std::min<size_t>(100, kBytesPerSize / bytes));
+
+    // Warm up connections and buffers.
+    pg.allreduce(tensors)->wait();
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+      pg.allreduce(tensors)->wait();
+    }
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    results.push_back({bytes, elapsed.count() / iterations});
+  }
+  return results;
+}
+
+void runBenchmark(
+    const std::string& path,
+    int size,
+    size_t chunkBytes,
+    size_t maxBytes) {
+  std::vector<std::vector<Result>> results(size);
+  std::vector<std::thread> threads;
+  for (auto rank = 0; rank < size; rank++) {
+    threads.emplace_back([&, rank] {
+      results[rank] = runRank(path, rank, size, chunkBytes, maxBytes);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  printf(
+      "allreduce, %d ranks, chunk bytes %zu%s\n",
+      size,
+      chunkBytes,
+      chunkBytes == 0 ? " (chunking disabled)" : "");
+  printf(
+      "%12s %12s %14s %14s\n",
+      "bytes",
+      "time (us)",
+      "algbw (GB/s)",
+      "busbw (GB/s)");
+  const double busFactor = 2.0 * (size - 1) / size;
+  for (size_t i = 0; i < results[0].size(); i++) {
+    // The slowest rank determines the completion time.
+    double seconds = 0;
+    for (const auto& rankResults : results) {
+      seconds = std::max(seconds, rankResults[i].seconds);
+    }
+    const auto bytes = results[0][i].bytes;
+    const double algbw = bytes / seconds / 1e9;
+    printf(
+        "%12zu %12.1f %14.3f %14.3f\n",
+        bytes,
+        seconds * 1e6,
+        algbw,
+        algbw * busFactor);
+  }
+  printf("\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const int size = argc > 1 ? atoi(argv[1]) : 4;
+  const size_t chunkBytes = argc > 2 ? strtoull(argv[2], nullptr, 10)
+                                     : kDefaultChunkBytes;
+  const size_t maxBytes =
+      argc > 3 ? strtoull(argv[3], nullptr, 10) : kDefaultMaxBytes;
+
+  {
+    TemporaryFile file;
+    runBenchmark(file.path, size, 0, maxBytes);
+  }
+  {
+    TemporaryFile file;
+    runBenchmark(file.path, size, chunkBytes, maxBytes);
+  }
+  return 0;
+}
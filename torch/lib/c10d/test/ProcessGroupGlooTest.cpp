@@ -339,6 +339,39 @@ void testAlltoall(const std::string& path, const at::DeviceType b) {
   }
 }
 
+void testAllgatherBase(const std::string& path) {
+  const auto size = 4;
+  const auto numel = 8;
+  auto tests = CollectiveTest::initialize(path, size);
+
+  std::vector<at::Tensor> inputs(size);
+  std::vector<at::Tensor> outputs(size);
+  for (auto rank = 0; rank < size; rank++) {
+    inputs[rank] = at::arange(numel, at::kFloat) + rank * numel;
+    outputs[rank] = at::empty({size * numel}, at::kFloat);
+  }
+
+  // Kick off work
+  std::vector<std::shared_ptr<::c10d::ProcessGroup::Work>> work(size);
+  for (auto rank = 0; rank < size; rank++) {
+    work[rank] = tests[rank].getProcessGroup().allgather_base(
+        outputs[rank], inputs[rank]);
+  }
+
+  // Wait for work to complete
+  for (auto rank = 0; rank < size; rank++) {
+    work[rank]->wait();
+  }
+
+  // Every rank ends up with the concatenation of all inputs in rank order
+  for (auto rank = 0; rank < size; rank++) {
+    auto data = outputs[rank].data_ptr<float>();
+    for (auto j = 0; j < outputs[rank].numel(); j++) {
+      EXPECT_EQ(data[j], j);
+    }
+  }
+}
+
 void testBarrier(const std::string& path) {
   const auto size = 2;
   auto tests = CollectiveTest::initialize(path, size);
@@ -507,6 +540,13 @@ TEST(ProcessGroupGlooTest, testAllToAllCPU) {
   }
 }
 
+TEST(ProcessGroupGlooTest, testAllgatherBaseCPU) {
+  {
+    TemporaryFile file;
+    testAllgatherBase(file.path);
+  }
+}
+
 TEST(ProcessGroupGlooTest, testBarrier) {
   {
     TemporaryFile file;
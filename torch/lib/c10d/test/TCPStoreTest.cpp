@@ -1,5 +1,7 @@
 #include <c10d/test/StoreTestCommon.hpp>
 
+#include <atomic>
+#include <condition_variable>
 #include <cstdlib>
 #include <iostream>
 #include <thread>
@@ -116,3 +118,210 @@ TEST(TCPStoreTest, testHelper) {
 TEST(TCPStoreTest, testHelperPrefix) {
   testHelper("testPrefix");
 }
+
+std::vector<uint8_t> toBytes(const std::string& str) {
+  return std::vector<uint8_t>(str.begin(), str.end());
+}
+
+std::shared_ptr<c10d::TCPStore> createServerStore(int numWorkers = 1) {
+  return std::make_shared<c10d::TCPStore>(
+      "127.0.0.1",
+      0,
+      numWorkers,
+      true,
+      std::chrono::seconds(30),
+      /* wait */ false);
+}
+
+TEST(TCPStoreTest, testMultiGetMultiSet) {
+  auto serverStore = createServerStore();
+  auto clientStore = std::make_unique<c10d::TCPStore>(
+      "127.0.0.1", serverStore->getPort(), 1, false);
+
+  std::vector<std::string> keys = {"key0", "key1", "key2"};
+  std::vector<std::vector<uint8_t>> values = {
+      toBytes("value0"), toBytes(""), toBytes("value2")};
+  clientStore->multiSet(keys, values);
+  EXPECT_EQ(serverStore->multiGet(keys), values);
+  c10d::test::check(*serverStore, "key2", "value2");
+  EXPECT_TRUE(serverStore->multiGet({}).empty());
+
+  // multiGet waits for keys that are not set yet
+  auto setter = std::thread([&clientStore] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    clientStore->multiSet({"late"}, {toBytes("value")});
+  });
+  EXPECT_EQ(
+      serverStore->multiGet({"key0", "late"}),
+      std::vector<std::vector<uint8_t>>({toBytes("value0"), toBytes("value")}));
+  setter.join();
+
+  EXPECT_THROW(
+      clientStore->multiSet({"key0"}, {}), std::invalid_argument);
+}
+
+TEST(TCPStoreTest, testCompareSet) {
+  auto store = createServerStore();
+  // Missing key and non-empty expected value: nothing is set
+  EXPECT_EQ(
+      store->compareSet("key", toBytes("old"), toBytes("new")),
+      toBytes("old"));
+  EXPECT_FALSE(store->check({"key"}));
+  // Missing key and empty expected value: the key is created
+  EXPECT_EQ(store->compareSet("key", {}, toBytes("v1")), toBytes("v1"));
+  // Mismatch returns the current value
+  EXPECT_EQ(
+      store->compareSet("key", toBytes("v0"), toBytes("v2")), toBytes("v1"));
+  // Match replaces it
+  EXPECT_EQ(
+      store->compareSet("key", toBytes("v1"), toBytes("v2")), toBytes("v2"));
+  c10d::test::check(*store, "key", "v2");
+}
+
+TEST(TCPStoreTest, testCompareSetElection) {
+  // Exactly one of many concurrent clients wins the election
+  const auto numThreads = 16;
+  auto serverStore = createServerStore();
+  std::vector<std::unique_ptr<c10d::TCPStore>> clientStores;
+  for (auto i = 0; i < numThreads; i++) {
+    clientStores.push_back(std::make_unique<c10d::TCPStore>(
+        "127.0.0.1", serverStore->getPort(), 1, false));
+  }
+  std::atomic<int> winners{0};
+  std::vector<std::thread> threads;
+  for (auto i = 0; i < numThreads; i++) {
+    threads.emplace_back([&clientStores, &winners, i] {
+      auto me = toBytes(std::to_string(i));
+      if (clientStores[i]->compareSet("leader", {}, me) == me) {
+        winners++;
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(winners, 1);
+}
+
+TEST(TCPStoreTest, testWatchKey) {
+  auto serverStore = createServerStore();
+  auto clientStore = std::make_unique<c10d::TCPStore>(
+      "127.0.0.1", serverStore->getPort(), 1, false);
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<std::string> seen;
+  clientStore->watchKey("key", [&](const std::vector<uint8_t>& value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    seen.emplace_back(value.begin(), value.end());
+    cv.notify_all();
+  });
+
+  // Updates through every kind of write are reported in order
+  c10d::test::set(*serverStore, "key", "a");
+  serverStore->add("other", 1);
+  serverStore->compareSet("key", toBytes("a"), toBytes("b"));
+  serverStore->compareSet("key", toBytes("a"), toBytes("c"));
+  serverStore->multiSet({"key"}, {toBytes("5")});
+  serverStore->add("key", 2);
+
+  std::unique_lock<std::mutex> lock(mutex);
+  ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds(10), [&] {
+    return seen.size() == 4;
+  }));
+  EXPECT_EQ(seen, std::vector<std::string>({"a", "b", "5", "7"}));
+}
+
+TEST(TCPStoreTest, testSlowWatcher) {
+  // A watcher that stops reading its notifications must not hold up the
+  // clients updating the key, even once the socket buffers are full.
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool released = false;
+  size_t seen = 0;
+  std::vector<uint8_t> last;
+  auto serverStore = createServerStore();
+  auto watcherStore = std::make_unique<c10d::TCPStore>(
+      "127.0.0.1", serverStore->getPort(), 1, false);
+  watcherStore->watchKey("key", [&](const std::vector<uint8_t>& value) {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&] { return released; });
+    seen++;
+    last = value;
+    cv.notify_all();
+  });
+
+  const auto numUpdates = 64;
+  std::vector<uint8_t> value(1 << 20);
+  for (auto i = 0; i < numUpdates; i++) {
+    value[0] = i;
+    serverStore->set("key", value);
+  }
+  EXPECT_EQ(serverStore->get("key"), value);
+
+  std::unique_lock<std::mutex> lock(mutex);
+  released = true;
+  cv.notify_all();
+  ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds(30), [&] {
+    return seen == numUpdates;
+  }));
+  EXPECT_EQ(last, value);
+}
+
+TEST(TCPStoreTest, testManyClientsWait) {
+  // All clients block in wait at the same time; a single set has to wake up
+  // every one of them.
+  const auto numThreads = 64;
+  auto serverStore = createServerStore();
+  std::vector<std::unique_ptr<c10d::TCPStore>> clientStores;
+  for (auto i = 0; i < numThreads; i++) {
+    clientStores.push_back(std::make_unique<c10d::TCPStore>(
+        "127.0.0.1", serverStore->getPort(), 1, false));
+  }
+  std::vector<std::thread> threads;
+  for (auto i = 0; i < numThreads; i++) {
+    threads.emplace_back([&clientStores, i] {
+      clientStores[i]->add("arrived", 1);
+      clientStores[i]->wait({"go"});
+      c10d::test::check(*clientStores[i], "go", "1");
+    });
+  }
+  while (serverStore->add("arrived", 0) < numThreads) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  c10d::test::set(*serverStore, "go", "1");
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+TEST(TCPStoreTest, testWaitMixedKeys) {
+  // Keys that are already set do not count towards the ones a wait has to
+  // see updated.
+  auto serverStore = createServerStore();
+  auto clientStore = std::make_unique<c10d::TCPStore>(
+      "127.0.0.1", serverStore->getPort(), 1, false);
+  c10d::test::set(*serverStore, "present0", "value");
+  c10d::test::set(*serverStore, "present1", "value");
+
+  // Only present keys: returns right away
+  clientStore->wait({"present0", "present1"}, std::chrono::seconds(10));
+
+  auto setter = std::thread([&serverStore] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    c10d::test::set(*serverStore, "missing0", "value");
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    c10d::test::set(*serverStore, "missing1", "value");
+  });
+  clientStore->wait(
+      {"present0", "missing0", "present1", "missing1"},
+      std::chrono::seconds(10));
+  EXPECT_TRUE(clientStore->check({"missing0", "missing1"}));
+  setter.join();
+
+  // A missing key that is never set still times out
+  EXPECT_THROW(
+      clientStore->wait(
+          {"present0", "never"}, std::chrono::milliseconds(200)),
+      std::runtime_error);
+}
@@ -780,6 +780,47 @@ class DistAutogradTest(RpcAgentTestFixture):
             rpc_args=args, func=my_py_nested_call, nested=True
         )
 
+    @dist_init
+    def test_context_cleanup_batching(self):
+        initialize_pg(self.init_method, self.rank, self.world_size)
+        # Use a long flush interval, so that cleanups stay queued until they
+        # are flushed explicitly.
+        dist_autograd._set_context_cleanup_batching(
+            timedelta(seconds=60), max_batch_size=1000
+        )
+
+        num_contexts = 3
+        dst_ranks = {rank for rank in range(self.world_size) if rank != self.rank}
+        for _ in range(num_contexts):
+            with dist_autograd.context() as context_id:
+                for dst_rank in dst_ranks:
+                    rpc.rpc_sync(
+                        worker_name(dst_rank), torch.add, args=(torch.ones(2), 1)
+                    )
+                    rpc.rpc_sync(
+                        worker_name(dst_rank), _set_rpc_done, args=(context_id, 1)
+                    )
+
+        # Other workers may flush and queue nested cleanups concurrently, hence
+        # the lower bounds.
+        debug_info = dist_autograd._get_debug_info()
+        self.assertGreaterEqual(
+            int(debug_info["num_queued_context_cleanups"]),
+            num_contexts * len(dst_ranks),
+        )
+
+        # One cleanup message per worker, instead of one per context.
+        dist_autograd._flush_context_cleanup()
+        debug_info = dist_autograd._get_debug_info()
+        self.assertGreaterEqual(
+            int(debug_info["num_context_cleanup_flushes"]), len(dst_ranks)
+        )
+        self.assertIn("avg_context_cleanup_flush_latency_us", debug_info)
+
+        # Ensure all peers have flushed their cleanups.
+        dist.barrier()
+        self.assertTrue(_all_contexts_cleaned_up())
+
     @dist_init
     def test_worker_ids_recorded(self):
         dst_ranks = {rank for rank in range(self.world_size) if rank != self.rank}
@@ -1729,8 +1770,9 @@ class DistAutogradTest(RpcAgentTestFixture):
         debug_info = dist_autograd._get_debug_info()
         assert debug_info is not None
         self.assertEqual(0, int(debug_info["num_current_backward_passes"]))
-        # only have `num_current_backward_passes` and `num_autograd contexts`
-        self.assertTrue(len(debug_info) == 2)
+        # only have `num_current_backward_passes`, `num_autograd contexts` and
+        # the three context cleanup batching metrics.
+        self.assertTrue(len(debug_info) == 5)
 
         self.assertTrue(_all_contexts_cleaned_up())
 
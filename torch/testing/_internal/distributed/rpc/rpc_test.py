@@ -2190,6 +2190,45 @@ class RpcTest(RpcAgentTestFixture):
         # barrier after check 3
         dist.barrier()
 
+    @dist_init
+    def test_rref_user_delete_batching(self):
+        from datetime import timedelta
+
+        num_rrefs = 10
+        dst = worker_name((self.rank + 1) % self.world_size)
+        # Use a long flush interval, so that only full batches are sent.
+        rpc._set_rref_user_delete_batching(
+            timedelta(seconds=60), max_batch_size=num_rrefs
+        )
+
+        rrefs = [
+            rpc.remote(dst, torch.add, args=(torch.ones(2), i))
+            for i in range(num_rrefs)
+        ]
+        for i in range(num_rrefs):
+            rrefs[i].to_here()
+        # UserRRefs are only deleted on the owner once they are confirmed.
+        wait_until_pending_futures_and_users_flushed()
+
+        del rrefs[1:]
+        info = _rref_context_get_debug_info()
+        self.assertEqual(num_rrefs - 1, int(info["num_queued_user_deletes"]))
+        self.assertEqual(0, int(info["num_user_delete_flushes"]))
+
+        # The last delete fills the batch, which is sent right away.
+        del rrefs
+        info = _rref_context_get_debug_info()
+        self.assertEqual(0, int(info["num_queued_user_deletes"]))
+        self.assertEqual(1, int(info["num_user_delete_flushes"]))
+        self.assertEqual(num_rrefs, int(info["num_flushed_user_deletes"]))
+        self.assertIn("avg_user_delete_flush_latency_us", info)
+
+        # The owner deletes all OwnerRRefs, after a single message.
+        wait_until_pending_futures_and_users_flushed()
+        dist.barrier()
+        info = _rref_context_get_debug_info()
+        self.assertEqual(0, int(info["num_owner_rrefs"]))
+
     @dist_init
     def test_disable_gil_profiling(self):
         # test that rpc.enable_gil_profilig(false) will result in
@@ -3380,6 +3419,45 @@ class ProcessGroupAgentRpcTest(RpcAgentTestFixture):
         self.assertEqual(int(info["agent.thread_pool_size"]), NUM_THREADS)
         rpc.shutdown()
 
+    @dist_init(setup_rpc=False)
+    def test_process_group_send_coalescing(self):
+        rpc_backend_options = rpc.ProcessGroupRpcBackendOptions(
+            init_method=self.rpc_backend_options.init_method,
+            num_send_recv_threads=self.rpc_backend_options.num_send_recv_threads,
+            send_coalescing_bytes=4096,
+            send_coalescing_delay=0.005,
+        )
+        self.assertEqual(rpc_backend_options.send_coalescing_bytes, 4096)
+        self.assertEqual(rpc_backend_options.send_coalescing_delay, 0.005)
+        rpc.init_rpc(
+            name=worker_name(self.rank),
+            backend=self.rpc_backend,
+            rank=self.rank,
+            world_size=self.world_size,
+            rpc_backend_options=rpc_backend_options,
+        )
+
+        dst = worker_name((self.rank + 1) % self.world_size)
+        # Many small messages share frames, the large ones exceed the frame
+        # size and are sent on their own.
+        futs = []
+        for i in range(100):
+            size = 1000 if i % 10 == 0 else 2
+            futs.append(
+                rpc.rpc_async(dst, torch.add, args=(torch.ones(size, size), i))
+            )
+        for i, fut in enumerate(futs):
+            size = 1000 if i % 10 == 0 else 2
+            self.assertEqual(fut.wait(), torch.ones(size, size) + i)
+        rpc.shutdown()
+
+    @dist_init(setup_rpc=False)
+    def test_process_group_send_coalescing_options(self):
+        with self.assertRaisesRegex(RuntimeError, "send_coalescing_bytes"):
+            rpc.ProcessGroupRpcBackendOptions(send_coalescing_bytes=-1)
+        with self.assertRaisesRegex(RuntimeError, "send_coalescing_delay"):
+            rpc.ProcessGroupRpcBackendOptions(send_coalescing_delay=-1.0)
+
     @dist_init(setup_rpc=False)
     def test_process_group_set_default_timeout(self):
         timeout = 0.5